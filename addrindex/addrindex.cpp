@@ -0,0 +1,118 @@
+/*
+ * Refer to addrindex.h for documentation on the public interfaces.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "addrindex.h"
+
+// The first 64 bits of a key as a big endian number, same order as memcmp()
+static inline uint64_t addrindex_prefix(const uint8_t * key, int key_length)
+{
+  uint64_t prefix = 0;
+  int i;
+  if (key_length >= 8) {
+    memcpy(&prefix, key, 8);
+    return __builtin_bswap64(prefix);
+  }
+  for (i = 0; i < 8; i++) {
+    prefix = (prefix << 8) | ((i < key_length) ? key[i] : 0);
+  }
+  return prefix;
+}
+
+static inline uint64_t addrindex_bucket(const struct addrindex * index, const uint8_t * key)
+{
+  if (index->bits == 0) {
+    return 0;
+  }
+  return addrindex_prefix(key, index->key_length) >> (64 - index->bits);
+}
+
+int addrindex_bits(uint64_t count, int values)
+{
+  int bits = 0;
+  while (bits < ADDRINDEX_MAX_BITS && (count >> bits) > (uint64_t)values) {
+    bits++;
+  }
+  return bits;
+}
+
+int addrindex_init(struct addrindex * index, const void * items, uint64_t count, int size, int key_length, int bits)
+{
+  uint64_t buckets, b, i;
+
+  if (bits > ADDRINDEX_MAX_BITS) {
+    bits = ADDRINDEX_MAX_BITS;
+  }
+  if (bits > key_length * 8) {
+    bits = key_length * 8;
+  }
+  if (bits < 0) {
+    bits = 0;
+  }
+  index->items = (const uint8_t *)items;
+  index->count = count;
+  index->size = size;
+  index->key_length = key_length;
+  index->bits = bits;
+  buckets = 1ULL << bits;
+  index->bytes = (buckets + 1) * sizeof(uint64_t);
+  index->offsets = (uint64_t *)malloc(index->bytes);
+  if (index->offsets == NULL) {
+    return 1;
+  }
+  // offsets[b] is the first record with a prefix >= b
+  b = 0;
+  for (i = 0; i < count; i++) {
+    uint64_t bucket = addrindex_bucket(index, index->items + i * size);
+    while (b <= bucket) {
+      index->offsets[b++] = i;
+    }
+  }
+  while (b <= buckets) {
+    index->offsets[b++] = count;
+  }
+  return 0;
+}
+
+const void * addrindex_find(const struct addrindex * index, const void * key)
+{
+  const uint8_t *k = (const uint8_t *)key;
+  const uint64_t *offset = index->offsets + addrindex_bucket(index, k);
+  uint64_t min = offset[0], max = offset[1], half;
+  int r;
+
+  if (min < max) {
+    // The whole range is a few cache lines, ask for the last one too
+    __builtin_prefetch(index->items + min * index->size);
+    __builtin_prefetch(index->items + (max * index->size) - 1);
+  }
+  while (min < max) {
+    half = min + (max - min) / 2;
+    r = memcmp(k, index->items + half * index->size, index->key_length);
+    if (r == 0) {
+      return index->items + half * index->size;
+    }
+    if (r < 0) {
+      max = half;
+    }
+    else {
+      min = half + 1;
+    }
+  }
+  return NULL;
+}
+
+int addrindex_check(const struct addrindex * index, const void * key)
+{
+  return addrindex_find(index, key) != NULL;
+}
+
+void addrindex_free(struct addrindex * index)
+{
+  free(index->offsets);
+  index->offsets = NULL;
+}
@@ -0,0 +1,100 @@
+/*
+ * Lookup index for the sorted tables of hash160 (or x coordinate) values of
+ * the address, rmd160 and xpoint modes and for the bP table of bsgs.
+ *
+ * The values are uniform, so the first bits of a value give its place in the
+ * table: a directory with the first position of every prefix of `bits` bits
+ * leaves a range of a few values to search, about 2 cache misses per lookup
+ * against one per step (~24 for 16M values) of a binary search over the
+ * whole table. The table itself is not changed, it stays sorted and it is
+ * the one saved with -S.
+ */
+
+#ifndef _ADDRINDEX_H
+#define _ADDRINDEX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADDRINDEX_MAX_BITS 28
+
+struct addrindex
+{
+  const uint8_t *items;
+  uint64_t count;
+  uint64_t *offsets;  // 2^bits + 1 positions in items
+  uint64_t bytes;     // Size of offsets
+  int size;
+  int key_length;
+  int bits;
+};
+
+
+/** ***************************************************************************
+ * Prefix bits that leave at most `values` values per prefix for a table of
+ * count uniform values, capped to ADDRINDEX_MAX_BITS.
+ *
+ */
+int addrindex_bits(uint64_t count, int values);
+
+
+/** ***************************************************************************
+ * Build the directory of a table sorted with memcmp() order of the keys.
+ *
+ * Parameters:
+ * -----------
+ *     index      - Pointer to the struct addrindex to fill.
+ *     items      - The sorted records, count * size bytes. Only a pointer is
+ *                  kept, the table must live as long as the index.
+ *     count      - Number of records.
+ *     size       - Size of each record.
+ *     key_length - Bytes of the key at the start of each record.
+ *     bits       - Prefix bits of the directory, see addrindex_bits().
+ *                  Capped to ADDRINDEX_MAX_BITS and to the key bits.
+ *
+ * Return:
+ * -------
+ *     0 - on success
+ *     1 - on failure (allocation)
+ *
+ */
+int addrindex_init(struct addrindex * index, const void * items, uint64_t count, int size, int key_length, int bits);
+
+
+/** ***************************************************************************
+ * Find the record with the given key of index->key_length bytes.
+ *
+ * Return:
+ * -------
+ *     The record, NULL if the key is not present
+ *
+ */
+const void * addrindex_find(const struct addrindex * index, const void * key);
+
+
+/** ***************************************************************************
+ * Check if the given key is in the table.
+ *
+ * Return:
+ * -------
+ *     0 - key is not present
+ *     1 - key is present
+ *
+ */
+int addrindex_check(const struct addrindex * index, const void * key);
+
+
+/** ***************************************************************************
+ * Deallocate the directory, the table is left untouched.
+ *
+ */
+void addrindex_free(struct addrindex * index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+/*
+Lookup of a hash160 in the sorted addressTable after a bloom filter hit:
+searchbinary (binary search over the whole table) against an Eytzinger
+(BFS ordered) copy of the table with prefetch of the descendants and against
+the prefix directory of addrindex with several directory sizes.
+Absent values are the bloom filter false positives, present ones the hits.
+Usage: bench_addrindex [count ...]		default 1000000 and 100000000
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include "../addrindex/addrindex.h"
+#include "bench.h"
+
+#define LENGTH 20
+#define QUERIES 4000000
+
+struct address_value	{
+	uint8_t value[20];
+};
+
+/* Same function as keyhunt.cpp before addrindex */
+int searchbinary(struct address_value *buffer,char *data,int64_t array_length) {
+	int64_t half,min,max,current;
+	int r = 0,rcmp;
+	min = 0;
+	current = 0;
+	max = array_length;
+	half = array_length;
+	while(!r && half >= 1) {
+		half = (max - min)/2;
+		rcmp = memcmp(data,buffer[current+half].value,20);
+		if(rcmp == 0)	{
+			r = 1;	//Found!!
+		}
+		else	{
+			if(rcmp < 0) { //data < temp_read
+				max = (max-half);
+			}
+			else	{ // data > temp_read
+				min = (min+half);
+			}
+			current = min;
+		}
+	}
+	return r;
+}
+
+/* In order walk of the implicit tree, eytzinger[1..n] */
+uint64_t eytzinger_fill(struct address_value *sorted,struct address_value *eytzinger,uint64_t i,uint64_t k,uint64_t n)	{
+	while(k <= n)	{
+		i = eytzinger_fill(sorted,eytzinger,i,2 * k,n);
+		eytzinger[k] = sorted[i++];
+		k = 2 * k + 1;
+	}
+	return i;
+}
+
+int eytzinger_search(struct address_value *eytzinger,uint8_t *data,uint64_t n)	{
+	uint64_t k = 1;
+	int r;
+	while(k <= n)	{
+		__builtin_prefetch(&eytzinger[4 * k]);	/* The 4 grandchildren, 80 bytes */
+		__builtin_prefetch(&eytzinger[4 * k + 3]);
+		r = memcmp(data,eytzinger[k].value,20);
+		if(r == 0)	{
+			return 1;
+		}
+		k = 2 * k + (r > 0);
+	}
+	return 0;
+}
+
+/* Sorted uniform values without sorting: increasing prefixes with random gaps */
+void make_table(struct address_value *table,uint64_t count)	{
+	uint64_t prefix = 0,gap = (UINT64_MAX / count) / 10 * 9,i,v;	/* 90% of the range, no wrap around */
+	for(i = 0; i < count; i++)	{
+		prefix += 1 + next64() % (2 * gap - 1);
+		v = __builtin_bswap64(prefix);
+		memcpy(table[i].value,&v,8);
+		v = next64();
+		memcpy(table[i].value + 8,&v,8);
+		v = next64();
+		memcpy(table[i].value + 16,&v,4);
+	}
+}
+
+void make_queries(struct address_value *table,uint64_t count,uint8_t *present,uint8_t *absent)	{
+	uint64_t i,v;
+	for(i = 0; i < QUERIES; i++)	{
+		memcpy(present + i * LENGTH,table[next64() % count].value,LENGTH);
+		v = next64();
+		memcpy(absent + i * LENGTH,&v,8);
+		v = next64();
+		memcpy(absent + i * LENGTH + 8,&v,8);
+		memcpy(absent + i * LENGTH + 16,&v,4);
+	}
+}
+
+void report(const char *name,double t_absent,double t_present,uint64_t found,uint64_t fp,double mb)	{
+	printf("  %-22s absent %7.1f ns  present %7.1f ns  found %" PRIu64 "/%d  wrong %" PRIu64 "  extra %.1f MB\n",name,t_absent * 1e9 / QUERIES,t_present * 1e9 / QUERIES,found,QUERIES,fp,mb);
+}
+
+void run(uint64_t count)	{
+	struct address_value *table,*eytzinger;
+	struct addrindex index;
+	uint8_t *present = (uint8_t*) malloc(QUERIES * LENGTH);
+	uint8_t *absent = (uint8_t*) malloc(QUERIES * LENGTH);
+	uint64_t i,found,fp;
+	double t0,t_absent,t_present;
+	int bits[4],b;
+
+	printf("[+] %" PRIu64 " values, table %.1f MB\n",count,(double)count * LENGTH / 1048576);
+	seed64(1);
+	table = (struct address_value*) malloc(count * sizeof(struct address_value));
+	if(table == NULL || present == NULL || absent == NULL)	{
+		fprintf(stderr,"[E] Not enough memory for %" PRIu64 " values\n",count);
+		exit(EXIT_FAILURE);
+	}
+	make_table(table,count);
+	make_queries(table,count,present,absent);
+
+	fp = 0;
+	t0 = now();
+	for(i = 0; i < QUERIES; i++)	fp += searchbinary(table,(char*)absent + i * LENGTH,count);
+	t_absent = now() - t0;
+	found = 0;
+	t0 = now();
+	for(i = 0; i < QUERIES; i++)	found += searchbinary(table,(char*)present + i * LENGTH,count);
+	t_present = now() - t0;
+	report("searchbinary",t_absent,t_present,found,fp,0);
+
+	if(addrindex_init(&index,table,count,LENGTH,LENGTH,addrindex_bits(count,4)))	{
+		fprintf(stderr,"[E] addrindex_init\n");
+		exit(EXIT_FAILURE);
+	}
+	bits[0] = index.bits;
+	bits[1] = index.bits - 4;
+	bits[2] = index.bits - 2;
+	bits[3] = index.bits + 1;
+	addrindex_free(&index);
+	for(b = 0; b < 4; b++)	{
+		char name[64];
+		t0 = now();
+		if(addrindex_init(&index,table,count,LENGTH,LENGTH,bits[b]))	{
+			fprintf(stderr,"[E] addrindex_init\n");
+			exit(EXIT_FAILURE);
+		}
+		double t_build = now() - t0;
+		fp = 0;
+		t0 = now();
+		for(i = 0; i < QUERIES; i++)	fp += addrindex_check(&index,absent + i * LENGTH);
+		t_absent = now() - t0;
+		found = 0;
+		t0 = now();
+		for(i = 0; i < QUERIES; i++)	found += addrindex_check(&index,present + i * LENGTH);
+		t_present = now() - t0;
+		snprintf(name,64,"addrindex %d bits%s",index.bits,b == 0 ? " (auto)" : "");
+		report(name,t_absent,t_present,found,fp,(double)index.bytes / 1048576);
+		printf("  %-22s build %.3f s, %.1f values per prefix\n","",t_build,(double)count / (1ULL << index.bits));
+		addrindex_free(&index);
+	}
+
+	eytzinger = (struct address_value*) malloc((count + 1 + 4) * sizeof(struct address_value));
+	if(eytzinger == NULL)	{
+		printf("  eytzinger: not enough memory for a second copy\n");
+	}
+	else	{
+		memset(eytzinger,0xff,(count + 1 + 4) * sizeof(struct address_value));
+		eytzinger_fill(table,eytzinger,0,1,count);
+		fp = 0;
+		t0 = now();
+		for(i = 0; i < QUERIES; i++)	fp += eytzinger_search(eytzinger,absent + i * LENGTH,count);
+		t_absent = now() - t0;
+		found = 0;
+		t0 = now();
+		for(i = 0; i < QUERIES; i++)	found += eytzinger_search(eytzinger,present + i * LENGTH,count);
+		t_present = now() - t0;
+		report("eytzinger",t_absent,t_present,found,fp,(double)(count + 5) * LENGTH / 1048576);
+		free(eytzinger);
+	}
+	free(table);
+	free(present);
+	free(absent);
+}
+
+int main(int argc,char **argv)	{
+	if(argc > 1)	{
+		for(int i = 1; i < argc; i++)	{
+			run(strtoull(argv[i],NULL,10));
+		}
+	}
+	else	{
+		run(1000000);
+		run(100000000);
+	}
+	return 0;
+}
@@ -0,0 +1,77 @@
+/*
+Throughput of the BatchStep instantiations used by the scan loops.
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "../secp256k1/BatchStep.h"
+#include "bench.h"
+
+Secp256K1 *secp;
+
+/* Gn[i] = (i+1)*G, _2Gn = GRP_SIZE*G, same tables as init_generator */
+void init_table(std::vector<AffinePoint> &Gn,Point &_2Gn,int size)	{
+	Point g = secp->G;
+	Gn.resize(size / 2);
+	Gn[0].Set(&g);
+	g = secp->DoubleDirect(g);
+	Gn[1].Set(&g);
+	for(int i = 2; i < size / 2; i++) {
+		g = secp->AddDirect(g,secp->G);
+		Gn[i].Set(&g);
+	}
+	_2Gn = secp->DoubleDirect(g);
+}
+
+template <int GRP_SIZE, bool CALC_Y>
+void bench(const char *name,double seconds)	{
+	std::vector<AffinePoint> Gn;
+	Point _2Gn,startP;
+	Int key;
+	uint64_t groups = 0,sum = 0;
+	double t0,t1;
+	init_table(Gn,_2Gn,GRP_SIZE);
+	BatchStep<GRP_SIZE,CALC_Y> *bstep = new BatchStep<GRP_SIZE,CALC_Y>(&Gn[0],&_2Gn);
+	key.SetInt32(GRP_SIZE);
+	startP = secp->ComputePublicKey(&key);
+	t0 = now();
+	do {
+		for(int i = 0; i < 64; i++)	{
+			bstep->Step(&startP);
+			for(int j = 0; j < GRP_SIZE; j++)	{
+				sum += bstep->pts[j].x.v[0] + j;
+			}
+		}
+		groups += 64;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	printf("%-28s %-16s %8.2f Mkeys/s %7.1f ns/key (%lx)\n",name,PointGroup::GetBackendName(),(double)(groups * GRP_SIZE) / (t1 - t0) / 1e6,(t1 - t0) * 1e9 / (double)(groups * GRP_SIZE),(unsigned long)(sum & 0xff));
+	delete bstep;
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+	secp = new Secp256K1();
+	secp->Init();
+	for(int b = PG_IFMA; b >= PG_SCALAR; b--)	{
+		PointGroup::SetBackend(b);
+		if(PointGroup::GetBackend() != b)
+			continue;
+		bench<256,false>("BatchStep<256,x only>",seconds);
+		bench<512,false>("BatchStep<512,x only>",seconds);
+		bench<1024,false>("BatchStep<1024,x only>",seconds);
+		bench<2048,false>("BatchStep<2048,x only>",seconds);
+		bench<4096,false>("BatchStep<4096,x only>",seconds);
+		bench<256,true>("BatchStep<256,x and y>",seconds);
+		bench<512,true>("BatchStep<512,x and y>",seconds);
+		bench<1024,true>("BatchStep<1024,x and y>",seconds);
+		bench<2048,true>("BatchStep<2048,x and y>",seconds);
+		bench<4096,true>("BatchStep<4096,x and y>",seconds);
+	}
+	return 0;
+}
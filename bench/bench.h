@@ -0,0 +1,32 @@
+/*
+Shared by the bench programs: the wall clock and a splitmix64 generator,
+the same seed gives the same numbers on every run.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+static inline double now()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC,&t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint64_t bench_state;
+
+static inline void seed64(uint64_t seed)	{
+	bench_state = seed;
+}
+
+static inline uint64_t next64()	{
+	bench_state += 0x9e3779b97f4a7c15ULL;
+	uint64_t z = bench_state;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+Bloom filter probe: classic layout (bloom_init2) against the cache line
+blocked layout (bloom_init_blocked) with the same 32 bytes x values as the
+bsgs first filter. Reports the size, the measured false positive rate and
+the lookup time for absent (the usual case) and present elements, one by
+one with bloom_check and by groups of 1024 with bloom_check_batch.
+cadd is the add time of bloom_add_concurrent and badd the one of
+bloom_add_concurrent_batch, used by the bsgs threads.
+The binary fuse filter of --fuse is measured the same way, split in 256
+filters by the first byte like keyhunt does.
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include "../bloom/bloom.h"
+#include "../fuse/fuse.h"
+#include "bench.h"
+
+/* Deterministic 32 bytes items, item n of the set and of the absent ones never collide */
+void next_item(uint8_t *item)	{
+	for(int i = 0; i < 4; i++)	{
+		uint64_t z = next64();
+		memcpy(item + i * 8,&z,8);
+	}
+}
+
+#define GROUP 1024
+
+void run(const char *name,struct bloom *bf,uint64_t entries,uint64_t queries)	{
+	uint8_t item[32],results[GROUP];
+	uint8_t *absent,*copy,*batch = (uint8_t*) malloc(GROUP * 32);
+	uint64_t i,fp = 0,fp_batch = 0,found = 0;
+	double t0,t_add,t_cadd,t_badd,t_absent,t_batch,t_present;
+	int same;
+
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < entries; i++)	{
+		next_item(item);
+		bloom_add(bf,item,32);
+	}
+	t_add = (now() - t0) * 1e9 / entries;
+	copy = (uint8_t*) malloc(bf->bytes);
+	memcpy(copy,bf->bf,bf->bytes);
+	bloom_reset(bf);
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < entries; i++)	{
+		next_item(item);
+		bloom_add_concurrent(bf,item,32);
+	}
+	t_cadd = (now() - t0) * 1e9 / entries;
+	same = memcmp(copy,bf->bf,bf->bytes) == 0;
+	bloom_reset(bf);
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < entries; i += GROUP)	{
+		int n = (entries - i < GROUP) ? entries - i : GROUP;
+		for(int k = 0; k < n; k++)	{
+			next_item(batch + k * 32);
+		}
+		bloom_add_concurrent_batch(bf,batch,32,32,n);
+	}
+	t_badd = (now() - t0) * 1e9 / entries;
+	same &= memcmp(copy,bf->bf,bf->bytes) == 0;
+	free(copy);
+	free(batch);
+
+	queries -= queries % GROUP;
+	absent = (uint8_t*) malloc(queries * 32);
+	seed64((uint64_t)1 << 62);
+	for(i = 0; i < queries; i++)	{
+		next_item(absent + i * 32);
+	}
+	t0 = now();
+	for(i = 0; i < queries; i++)	{
+		fp += bloom_check(bf,absent + i * 32,32);
+	}
+	t_absent = (now() - t0) * 1e9 / queries;
+	t0 = now();
+	for(i = 0; i < queries; i += GROUP)	{
+		fp_batch += bloom_check_batch(bf,absent + i * 32,32,32,GROUP,results);
+	}
+	t_batch = (now() - t0) * 1e9 / queries;
+	free(absent);
+
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < queries && i < entries; i++)	{
+		next_item(item);
+		found += bloom_check(bf,item,32);
+	}
+	t_present = (now() - t0) * 1e9 / i;
+
+	printf("%-8s %8.1f MB %5.1f bits/item  fp rate %.2e  add %6.1f ns  cadd %6.1f ns  badd %6.1f ns  absent %6.1f ns  batch %6.1f ns  present %6.1f ns%s%s%s\n",name,(double)bf->bytes / 1048576,bf->bpe,(double)fp / queries,t_add,t_cadd,t_badd,t_absent,t_batch,t_present,found == i ? "" : "  [E] missing items",fp == fp_batch ? "" : "  [E] batch differs",same ? "" : "  [E] concurrent add differs");
+}
+
+void run_fuse(uint64_t entries,uint64_t queries)	{
+	struct fuse16 *fuse = (struct fuse16*) calloc(256,sizeof(struct fuse16));
+	uint64_t *keys[256],count[256],bytes = 0;
+	uint8_t item[32],results[GROUP];
+	uint8_t *absent;
+	uint64_t i,fp = 0,fp_batch = 0,found = 0;
+	double t0,t_add,t_absent,t_batch,t_present;
+
+	for(i = 0; i < 256; i++)	{
+		keys[i] = (uint64_t*) malloc((entries / 256 + entries / 2048 + 1024) * sizeof(uint64_t));
+		count[i] = 0;
+	}
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < entries; i++)	{
+		next_item(item);
+		keys[item[0]][count[item[0]]++] = fuse16_key(item,32);
+	}
+	for(i = 0; i < 256; i++)	{
+		if(fuse16_build(&fuse[i],keys[i],count[i]) != 0)	{
+			fprintf(stderr,"[E] fuse16_build\n");
+			exit(EXIT_FAILURE);
+		}
+		bytes += fuse[i].bytes;
+		free(keys[i]);
+	}
+	t_add = (now() - t0) * 1e9 / entries;
+
+	queries -= queries % GROUP;
+	absent = (uint8_t*) malloc(queries * 32);
+	seed64((uint64_t)1 << 62);
+	for(i = 0; i < queries; i++)	{
+		next_item(absent + i * 32);
+	}
+	t0 = now();
+	for(i = 0; i < queries; i++)	{
+		fp += fuse16_check(&fuse[absent[i * 32]],absent + i * 32,32);
+	}
+	t_absent = (now() - t0) * 1e9 / queries;
+	t0 = now();
+	for(i = 0; i < queries; i += GROUP)	{
+		fp_batch += fuse16_check_batch_split(fuse,absent + i * 32,32,32,GROUP,results);
+	}
+	t_batch = (now() - t0) * 1e9 / queries;
+	free(absent);
+
+	seed64(1);
+	t0 = now();
+	for(i = 0; i < queries && i < entries; i++)	{
+		next_item(item);
+		found += fuse16_check(&fuse[item[0]],item,32);
+	}
+	t_present = (now() - t0) * 1e9 / i;
+
+	printf("%-8s %8.1f MB %5.1f bits/item  fp rate %.2e  add %6.1f ns  absent %6.1f ns  batch %6.1f ns  present %6.1f ns%s%s\n","fuse16",(double)bytes / 1048576,(double)bytes * 8 / entries,(double)fp / queries,t_add,t_absent,t_batch,t_present,found == i ? "" : "  [E] missing items",fp == fp_batch ? "" : "  [E] batch differs");
+	for(i = 0; i < 256; i++)	{
+		fuse16_free(&fuse[i]);
+	}
+	free(fuse);
+}
+
+int main(int argc,char **argv)	{
+	uint64_t entries = (argc > 1) ? strtoull(argv[1],NULL,10) : 64000000;
+	uint64_t queries = (argc > 2) ? strtoull(argv[2],NULL,10) : 4000000;
+	struct bloom classic,blocked;
+
+	printf("%" PRIu64 " items, %" PRIu64 " queries\n",entries,queries);
+	if(bloom_init2(&classic,entries,0.000001) == 1)	{
+		fprintf(stderr,"[E] bloom_init2\n");
+		exit(EXIT_FAILURE);
+	}
+	run("classic",&classic,entries,queries);
+	bloom_free(&classic);
+
+	for(int e = 0; e < 2; e++)	{
+		long double error = e == 0 ? 0.00001 : 0.000001;
+		if(bloom_init_blocked(&blocked,entries,error) == 1)	{
+			fprintf(stderr,"[E] bloom_init_blocked\n");
+			exit(EXIT_FAILURE);
+		}
+		run(e == 0 ? "blk 1e-5" : "blk 1e-6",&blocked,entries,queries);
+		bloom_free(&blocked);
+	}
+	run_fuse(entries,queries);
+	return 0;
+}
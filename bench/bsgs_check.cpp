@@ -0,0 +1,108 @@
+/*
+BSGS second check cost per bloom hit: the old chain (ComputePublicKey of
+base_key and 32 AddDirect, one ModInv each) against the batched one
+(BSGS_S from the giant step candidate and one grouped ModInv for the 32 points).
+The third check has the same shape with BSGS_AMP3.
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "bench.h"
+
+Secp256K1 *secp;
+
+int main(int argc,char **argv)	{
+	int hits = (argc > 1) ? atoi(argv[1]) : 2000;
+	Point Q,MP,MP2,AMP2[32],point_temp,point_aux,BSGS_S,Q_AMP[32],old_x[32];
+	Point *candidates;
+	Int q,M,M2,M_double,M2_double,base_key,key;
+	uint64_t inv_old = 0,inv_new = 0,bad = 0,sum = 0;
+	unsigned char xpoint_raw[32];
+	double t0,t_old,t_new;
+	int h,i;
+
+	secp = new Secp256K1();
+	secp->Init();
+	candidates = new Point[hits];
+
+	/* Default bsgs_m and its second level like keyhunt: M2 = M/20 */
+	M.SetInt64(4194304);
+	M_double.Set(&M);
+	M_double.Add(&M);
+	M2.SetInt64(4194304 / 20);
+	M2_double.Set(&M2);
+	M2_double.Add(&M2);
+	MP = secp->ComputePublicKey(&M);
+	MP2 = secp->ComputePublicKey(&M2);
+
+	/* BSGS_AMP2[i] = -(M2 + i*M2_double)*G */
+	point_temp = secp->Negation(MP2);
+	AMP2[0] = point_temp;
+	point_temp = secp->ComputePublicKey(&M2_double);
+	point_temp = secp->Negation(point_temp);
+	for(i = 1; i < 32; i++)	{
+		AMP2[i] = secp->AddDirect(AMP2[i-1],point_temp);
+	}
+
+	q.Rand(256);
+	Q = secp->ComputePublicKey(&q);
+	base_key.Rand(128);
+
+	/* Candidate of hit h: Q - (base_key + h*M_double + M)*G as the giant step gives it */
+	for(h = 0; h < hits; h++)	{
+		key.Set(&M_double);
+		key.Mult((uint64_t)h);
+		key.Add(&M);
+		key.Add(&base_key);
+		point_aux = secp->ComputePublicKey(&key);
+		point_aux = secp->Negation(point_aux);
+		candidates[h] = secp->AddDirect(Q,point_aux);
+	}
+
+	t0 = now();
+	for(h = 0; h < hits; h++)	{
+		key.Set(&M_double);
+		key.Mult((uint64_t)h);
+		key.Add(&base_key);
+		point_aux = secp->ComputePublicKey(&key);
+		point_aux = secp->Negation(point_aux);
+		BSGS_S = secp->AddDirect(Q,point_aux);
+		inv_old += 2;
+		for(i = 0; i < 32; i++)	{
+			old_x[i] = secp->AddDirect(BSGS_S,AMP2[i]);
+			old_x[i].x.Get32Bytes(xpoint_raw);
+			sum += xpoint_raw[0];
+		}
+		inv_old += 32;
+	}
+	t_old = (now() - t0) * 1e6 / hits;
+
+	t0 = now();
+	for(h = 0; h < hits; h++)	{
+		BSGS_S = secp->AddDirect(candidates[h],MP);
+		secp->AddDirect(BSGS_S,AMP2,32,Q_AMP);
+		inv_new += 2;
+		for(i = 0; i < 32; i++)	{
+			Q_AMP[i].x.Get32Bytes(xpoint_raw);
+			sum += xpoint_raw[0];
+		}
+	}
+	t_new = (now() - t0) * 1e6 / hits;
+
+	/* Same 32 points for the last hit of both runs */
+	for(i = 0; i < 32; i++)	{
+		bad += !Q_AMP[i].x.IsEqual(&old_x[i].x) || !Q_AMP[i].y.IsEqual(&old_x[i].y);
+	}
+	if(bad)
+		printf("[E] %llu points differ\n",(unsigned long long)bad);
+	if(sum == 1)
+		printf(" ");
+
+	printf("hits %i  second check %6.2f us -> %6.2f us per hit (%.1fx)  ModInv per hit %.0f -> %.0f\n",hits,t_old,t_new,t_old / t_new,(double)inv_old / hits,(double)inv_new / hits);
+	delete[] candidates;
+	return 0;
+}
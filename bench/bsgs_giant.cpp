@@ -0,0 +1,123 @@
+/*
+BSGS giant step chain: x only groups with y recovered on bloom hits
+against groups computing y for every point, for several K factors.
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "../secp256k1/BatchStep.h"
+#include "bench.h"
+
+#define GRP_SIZE 1024
+
+Secp256K1 *secp;
+
+/* Same tables as the bsgs setup in keyhunt: GSn[i] = -(i+1)*2M*G, _2GSn = -GRP_SIZE*2M*G */
+void init_table(std::vector<AffinePoint> &GSn,Point &_2GSn,Int *M_double)	{
+	Point mp = secp->ComputePublicKey(M_double);
+	Point bsP = secp->Negation(mp);
+	Point g = bsP;
+	GSn.resize(GRP_SIZE / 2);
+	GSn[0].Set(&g);
+	g = secp->DoubleDirect(g);
+	GSn[1].Set(&g);
+	for(int i = 2; i < GRP_SIZE / 2; i++) {
+		g = secp->AddDirect(g,bsP);
+		GSn[i].Set(&g);
+	}
+	_2GSn = secp->DoubleDirect(g);
+}
+
+/* Giant points per second through the group and the 32 bytes x serialization of the first bloom check */
+template <bool CALC_Y>
+double giant_steps(std::vector<AffinePoint> &GSn,Point &_2GSn,Point startP,double seconds)	{
+	BatchStep<GRP_SIZE,CALC_Y> bstep(&GSn[0],&_2GSn);
+	unsigned char xpoint_raw[32];
+	uint64_t groups = 0,sum = 0;
+	double t0,t1;
+	t0 = now();
+	do {
+		for(int g = 0; g < 16; g++)	{
+			bstep.Step(&startP);
+			for(int i = 0; i < GRP_SIZE; i++)	{
+				bstep.pts[i].x.Get32Bytes(xpoint_raw);
+				sum += xpoint_raw[0];
+			}
+		}
+		groups += 16;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	if(sum == 1)
+		printf(" ");
+	return (double)(groups * GRP_SIZE) / (t1 - t0);
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+	int kfactors[3] = {1,256,4096};
+	std::vector<AffinePoint> GSn;
+	Point _2GSn,startP,Q,MP,candidate,S,S_old[GRP_SIZE];
+	Int M,M_double,base_key,key,q;
+	double xonly,full,t0,t_old,t_new;
+	int hits = 2000,bad;
+
+	secp = new Secp256K1();
+	secp->Init();
+	q.Rand(256);
+	Q = secp->ComputePublicKey(&q);
+	base_key.Rand(128);
+
+	for(int k = 0; k < 3; k++)	{
+		M.SetInt64(4194304);	/* default bsgs_m */
+		M.Mult((uint64_t)kfactors[k]);
+		M_double.Set(&M);
+		M_double.Add(&M);
+		MP = secp->ComputePublicKey(&M);
+		init_table(GSn,_2GSn,&M_double);
+
+		/* First center Q - (base_key + M_double*GRP_SIZE/2 + M)*G like thread_process_bsgs */
+		key.Set(&M_double);
+		key.Mult((uint64_t)(GRP_SIZE / 2));
+		key.Add(&M);
+		key.Add(&base_key);
+		key.Neg();
+		key.Add(&secp->order);
+		startP = secp->ComputePublicKey(&key);
+		startP = secp->AddDirect(Q,startP);
+
+		xonly = giant_steps<false>(GSn,_2GSn,startP,seconds);
+		full = giant_steps<true>(GSn,_2GSn,startP,seconds);
+
+		/* Cost of one hit: BSGS_S = Q - (base_key + a*2M)*G as the second check builds it */
+		BatchStep<GRP_SIZE,false> bstep(&GSn[0],&_2GSn);
+		bstep.Step(&startP);
+		t0 = now();
+		for(int h = 0; h < hits; h++)	{
+			key.Set(&M_double);
+			key.Mult((uint64_t)(h % GRP_SIZE));
+			key.Add(&base_key);
+			Point base_point = secp->ComputePublicKey(&key);
+			Point point_aux = secp->Negation(base_point);
+			S_old[h % GRP_SIZE] = secp->AddDirect(Q,point_aux);
+		}
+		t_old = (now() - t0) * 1e6 / hits;
+		bad = 0;
+		t0 = now();
+		for(int h = 0; h < hits; h++)	{
+			candidate = bstep.Recover(h % GRP_SIZE);
+			S = secp->AddDirect(candidate,MP);
+			bad += !S.equals(S_old[h % GRP_SIZE]);
+		}
+		t_new = (now() - t0) * 1e6 / hits;
+		if(bad)
+			printf("[E] %i recovered points differ\n",bad);
+
+		printf("K=%-5i giant steps x only %6.2f M/s, with y %6.2f M/s (%.2e / %.2e keys/s)  hit setup %5.2f us -> %5.2f us\n",kfactors[k],xonly / 1e6,full / 1e6,xonly * (double)M_double.GetInt64(),full * (double)M_double.GetInt64(),t_old,t_new);
+	}
+	return 0;
+}
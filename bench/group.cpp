@@ -0,0 +1,179 @@
+/*
+Working set and time of one group step (dx, grouped ModInv, the size points
+and the next center) with the group buffers in Point (before: 3 Int of
+NB64BLOCK limbs, scalar Int arithmetic) and in AffinePoint (after: BatchStep
+with each PointGroup backend). The x of every point is compared between both.
+Usage: bench_group [seconds]		default 1 per line
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "../secp256k1/IntGroup.h"
+#include "../secp256k1/BatchStep.h"
+#include "bench.h"
+
+Secp256K1 *secp;
+
+/* The group step as it was on Point buffers */
+class PointStep	{
+public:
+	PointStep(int size,Point *Gn,Point *_2Gn) : grp(size / 2 + 1)	{
+		this->size = size;
+		this->Gn = Gn;
+		this->_2Gn = _2Gn;
+		pts = new Point[size];
+		dx = new Int[size / 2 + 1];
+		grp.Set(dx);
+	}
+	~PointStep()	{
+		delete[] pts;
+		delete[] dx;
+	}
+	void Step(Point *startP)	{
+		int half = size / 2,i;
+		Int dy,dyn,_s,_p;
+		Point pp,pn;
+		for(i = 0; i < half; i++)	{
+			dx[i].ModSub(&Gn[i].x,&startP->x);
+		}
+		dx[i].ModSub(&_2Gn->x,&startP->x);
+		grp.ModInv();
+		pts[half] = *startP;
+		for(i = 0; i < half; i++)	{
+			if(i < half - 1)	{
+				pp = *startP;
+				dy.ModSub(&Gn[i].y,&pp.y);
+				_s.ModMulK1(&dy,&dx[i]);
+				_p.ModSquareK1(&_s);
+				pp.x.ModNeg();
+				pp.x.ModAdd(&_p);
+				pp.x.ModSub(&Gn[i].x);
+				pts[half + (i + 1)] = pp;
+			}
+			pn = *startP;
+			dyn.Set(&Gn[i].y);
+			dyn.ModNeg();
+			dyn.ModSub(&pn.y);
+			_s.ModMulK1(&dyn,&dx[i]);
+			_p.ModSquareK1(&_s);
+			pn.x.ModNeg();
+			pn.x.ModAdd(&_p);
+			pn.x.ModSub(&Gn[i].x);
+			pts[half - (i + 1)] = pn;
+		}
+		/* startP += _2Gn */
+		pp = *startP;
+		dy.ModSub(&_2Gn->y,&pp.y);
+		_s.ModMulK1(&dy,&dx[half]);
+		_p.ModSquareK1(&_s);
+		pp.x.ModNeg();
+		pp.x.ModAdd(&_p);
+		pp.x.ModSub(&_2Gn->x);
+		pp.y.ModSub(&_2Gn->x,&pp.x);
+		pp.y.ModMulK1(&_s);
+		pp.y.ModSub(&_2Gn->y);
+		*startP = pp;
+	}
+	Point *pts;
+private:
+	int size;
+	Point *Gn;
+	Point *_2Gn;
+	Int *dx;
+	IntGroup grp;
+};
+
+/* Gn[i] = (i+1)*G, _2Gn = size*G, same tables as init_generator */
+void init_table(std::vector<Point> &Gn,std::vector<AffinePoint> &aGn,Point &_2Gn,int size)	{
+	Point g = secp->G;
+	Gn.resize(size / 2);
+	aGn.resize(size / 2);
+	for(int i = 0; i < size / 2; i++)	{
+		Gn[i] = g;
+		aGn[i].Set(&g);
+		g = (i == 0) ? secp->DoubleDirect(g) : secp->AddDirect(g,secp->G);
+	}
+	_2Gn = secp->DoubleDirect(Gn[size / 2 - 1]);
+}
+
+template <int GRP_SIZE>
+void bench(double seconds)	{
+	std::vector<Point> Gn;
+	std::vector<AffinePoint> aGn;
+	Point _2Gn,startP,start;
+	Int key;
+	uint64_t groups;
+	double t0,t1,before;
+	size_t ws_before,ws_after;
+	int i,bad;
+	init_table(Gn,aGn,_2Gn,GRP_SIZE);
+	key.SetInt32(GRP_SIZE);
+	start = secp->ComputePublicKey(&key);
+
+	/* pts + Gn + dx */
+	ws_before = GRP_SIZE * sizeof(Point) + (GRP_SIZE / 2) * sizeof(Point) + (GRP_SIZE / 2 + 1) * sizeof(Int);
+	ws_after = GRP_SIZE * sizeof(AffinePoint) + (GRP_SIZE / 2) * sizeof(AffinePoint) + (GRP_SIZE / 2 + 1) * sizeof(Int);
+
+	PointStep *pstep = new PointStep(GRP_SIZE,&Gn[0],&_2Gn);
+	startP = start;
+	groups = 0;
+	t0 = now();
+	do {
+		for(i = 0; i < 16; i++)	{
+			pstep->Step(&startP);
+		}
+		groups += 16;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	before = (t1 - t0) * 1e6 / (double)groups;
+	printf("%4i before Point        %7zu bytes %8.1f us/group\n",GRP_SIZE,ws_before,before);
+
+	for(int b = PG_SCALAR; b <= PG_IFMA; b++)	{
+		PointGroup::SetBackend(b);
+		if(PointGroup::GetBackend() != b)
+			continue;
+		BatchStep<GRP_SIZE,false> *bstep = new BatchStep<GRP_SIZE,false>(&aGn[0],&_2Gn);
+		startP = start;
+		groups = 0;
+		t0 = now();
+		do {
+			for(i = 0; i < 16; i++)	{
+				bstep->Step(&startP);
+			}
+			groups += 16;
+			t1 = now();
+		}while(t1 - t0 < seconds);
+		/* Same group from the same center with both layouts */
+		startP = start;
+		bstep->Step(&startP);
+		startP = start;
+		pstep->Step(&startP);
+		bad = 0;
+		for(i = 0; i < GRP_SIZE; i++)	{
+			Int x;
+			bstep->pts[i].x.Get(&x);
+			bad += !x.IsEqual(&pstep->pts[i].x);
+		}
+		printf("%4i after  AffinePoint  %7zu bytes %8.1f us/group  %-16s x differ: %i\n",GRP_SIZE,ws_after,(t1 - t0) * 1e6 / (double)groups,PointGroup::GetBackendName(),bad);
+		delete bstep;
+	}
+	delete pstep;
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	secp = new Secp256K1();
+	secp->Init();
+	printf("sizeof(Point) %zu, sizeof(AffinePoint) %zu, sizeof(Int) %zu, working set = pts + Gn + dx\n",sizeof(Point),sizeof(AffinePoint),sizeof(Int));
+	bench<256>(seconds);
+	bench<512>(seconds);
+	bench<1024>(seconds);
+	bench<2048>(seconds);
+	bench<4096>(seconds);
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+sha256sse_test conformance of every SHA-256 backend, then the SHA-256 of the
+33 and 65 bytes public keys with 4 (SSE or SHA-NI), 8 (AVX2) and 16 (AVX-512)
+lanes, the fused SHA-256 + RIPEMD-160 of 8 and 16 lanes, then hash160 of 1024
+points with the 4 points GetHash160 and the batched one (from the limbs, the
+x line makes both prefixes per key).
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "../hash/sha256.h"
+#include "../hash/ripemd160.h"
+#include "bench.h"
+
+#define POINTS 1024
+
+Secp256K1 *secp;
+
+/* Pre-padded big endian words of the serialized key, as the KEYBUFF macros build them.
+   sha256_33 and sha256_65 pad in place, hence the 128 bytes rows of raw */
+void blocks(uint8_t *raw,int len,uint32_t *b)	{
+	uint8_t msg[128];
+	int nb = (len + 9 + 63) / 64,i;
+	memset(msg,0,sizeof(msg));
+	memcpy(msg,raw,len);
+	msg[len] = 0x80;
+	msg[nb * 64 - 2] = (uint8_t)((len * 8) >> 8);
+	msg[nb * 64 - 1] = (uint8_t)(len * 8);
+	for(i = 0; i < nb * 16; i++)	{
+		b[i] = (uint32_t)msg[4*i] << 24 | (uint32_t)msg[4*i+1] << 16 | (uint32_t)msg[4*i+2] << 8 | msg[4*i+3];
+	}
+}
+
+/* Backends of the table: lanes per call and SHA-NI flag for the 4 lanes entry points */
+struct backend	{
+	const char *name;
+	int lanes;
+	bool ni;
+};
+
+struct backend backends[4] = {
+	{"sse 4 lanes",4,false},
+	{"sha-ni 4 lanes",4,true},
+	{"avx2 8 lanes",8,false},
+	{"avx512 16 lanes",16,false}
+};
+
+void sha_lanes(int lanes,int nblocks,uint32_t *b,uint8_t *d)	{
+	int stride = nblocks * 16;
+	switch(lanes)	{
+		case 16:
+			if(nblocks == 1) sha256avx512_1B(b,d); else sha256avx512_2B(b,d);
+		break;
+		case 8:
+			if(nblocks == 1) sha256avx2_1B(b,d); else sha256avx2_2B(b,d);
+		break;
+		default:
+			if(nblocks == 1) sha256sse_1B(b,b + stride,b + 2*stride,b + 3*stride,d,d + 64,d + 128,d + 192);
+			else sha256sse_2B(b,b + stride,b + 2*stride,b + 3*stride,d,d + 64,d + 128,d + 192);
+		break;
+	}
+}
+
+void hash160_lanes(int lanes,int nblocks,uint32_t *b,uint8_t *h)	{
+	if(lanes == 16)	{
+		if(nblocks == 1) hash160avx512_1B(b,h); else hash160avx512_2B(b,h);
+	}
+	else	{
+		if(nblocks == 1) hash160avx2_1B(b,h); else hash160avx2_2B(b,h);
+	}
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	static uint32_t b[POINTS * 32] __attribute__((aligned(64)));
+	static uint8_t d[POINTS * 64] __attribute__((aligned(64)));
+	static uint8_t h[POINTS * 20],hr[POINTS * 20],h3[POINTS * 20],hr3[POINTS * 20];
+	static uint8_t raw[2][POINTS][128];
+	uint8_t ref[64],rh[20];
+	Point *pts = new Point[POINTS];
+	AffinePoint *apts = new AffinePoint[POINTS];
+	Int key;
+	uint64_t count;
+	double t0,t1;
+	int i,j,l,lanes,nblocks,len,errors;
+	int best = sha256_lanes();
+	int fused = hash160_lanes();
+	bool ni = sha256_ni;
+	secp = new Secp256K1();
+	secp->Init();
+	key.Rand(256);
+	for(i = 0; i < POINTS; i++)	{
+		key.AddOne();
+		pts[i] = secp->ComputePublicKey(&key);
+		apts[i].Set(&pts[i]);
+		secp->GetPublicKeyRaw(true,pts[i],(char*)raw[0][i]);
+		secp->GetPublicKeyRaw(false,pts[i],(char*)raw[1][i]);
+	}
+	errors = sha256sse_test();
+	printf("CPU SHA-256 lanes: %i, hash160 lanes: %i, SHA-NI: %s, conformance errors: %i\n",best,fused,ni ? "yes" : "no",errors);
+	for(nblocks = 1; nblocks <= 2; nblocks++)	{
+		len = nblocks == 1 ? 33 : 65;
+		for(i = 0; i < POINTS; i++)	{
+			blocks(raw[nblocks-1][i],len,b + i * nblocks * 16);
+		}
+		for(j = 0; j < 4; j++)	{
+			lanes = backends[j].lanes;
+			if(lanes > best || (backends[j].ni && !ni))	{
+				continue;
+			}
+			sha256_ni = backends[j].ni;
+			errors = 0;
+			for(i = 0; i < POINTS; i += lanes)	{
+				sha_lanes(lanes,nblocks,b + i * nblocks * 16,d + i * 64);
+			}
+			for(i = 0; i < POINTS; i++)	{
+				if(nblocks == 1) sha256_33(raw[0][i],ref); else sha256_65(raw[1][i],ref);
+				errors += memcmp(ref,d + i * 64,32) != 0;
+			}
+			count = 0;
+			t0 = now();
+			do {
+				for(i = 0; i < POINTS; i += lanes)	{
+					sha_lanes(lanes,nblocks,b + i * nblocks * 16,d + i * 64);
+				}
+				count += POINTS;
+				t1 = now();
+			}while(t1 - t0 < seconds);
+			printf("sha256 %2i bytes %-15s %7.2f ns/key errors %i\n",len,backends[j].name,(t1 - t0) * 1e9 / (double)count,errors);
+		}
+		for(lanes = 8; lanes <= fused; lanes *= 2)	{
+			errors = 0;
+			for(i = 0; i < POINTS; i += lanes)	{
+				hash160_lanes(lanes,nblocks,b + i * nblocks * 16,h + i * 20);
+			}
+			for(i = 0; i < POINTS; i++)	{
+				if(nblocks == 1) sha256_33(raw[0][i],ref); else sha256_65(raw[1][i],ref);
+				ripemd160_32(ref,rh);
+				errors += memcmp(rh,h + i * 20,20) != 0;
+			}
+			count = 0;
+			t0 = now();
+			do {
+				for(i = 0; i < POINTS; i += lanes)	{
+					hash160_lanes(lanes,nblocks,b + i * nblocks * 16,h + i * 20);
+				}
+				count += POINTS;
+				t1 = now();
+			}while(t1 - t0 < seconds);
+			printf("hash160 %2i bytes fused %2i lanes %7.2f ns/key errors %i\n",len,lanes,(t1 - t0) * 1e9 / (double)count,errors);
+		}
+		sha256_ni = ni;
+	}
+	for(l = 0; l < 3; l++)	{
+		const char *name = l == 0 ? "compressed  " : (l == 1 ? "uncompressed" : "x 02 and 03 ");
+		for(j = 0; j < 2; j++)	{
+			count = 0;
+			t0 = now();
+			do {
+				if(j == 0)	{
+					for(i = 0; i < POINTS; i += 4)	{
+						if(l == 2)	{
+							secp->GetHash160_fromX(P2PKH,0x02,&pts[i].x,&pts[i+1].x,&pts[i+2].x,&pts[i+3].x,hr + i*20,hr + (i+1)*20,hr + (i+2)*20,hr + (i+3)*20);
+							secp->GetHash160_fromX(P2PKH,0x03,&pts[i].x,&pts[i+1].x,&pts[i+2].x,&pts[i+3].x,hr3 + i*20,hr3 + (i+1)*20,hr3 + (i+2)*20,hr3 + (i+3)*20);
+						}
+						else secp->GetHash160(P2PKH,l == 0,pts[i],pts[i+1],pts[i+2],pts[i+3],hr + i*20,hr + (i+1)*20,hr + (i+2)*20,hr + (i+3)*20);
+					}
+				}
+				else	{
+					for(i = 0; i < POINTS; i += 16)	{
+						if(l == 2) secp->GetHash160_fromX(apts + i,16,h + i*20,h3 + i*20);
+						else secp->GetHash160(l == 0,apts + i,16,h + i*20);
+					}
+				}
+				count += POINTS;
+				t1 = now();
+			}while(t1 - t0 < seconds);
+			printf("hash160 %s %s %7.2f ns/key\n",name,j == 0 ? "4 points       " : "16 points batch",(t1 - t0) * 1e9 / (double)count);
+		}
+		printf("hash160 %s batch matches: %s\n",name,(memcmp(h,hr,sizeof(h)) == 0 && (l < 2 || memcmp(h3,hr3,sizeof(h3)) == 0)) ? "yes" : "NO");
+	}
+	delete[] pts;
+	delete[] apts;
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+Ethereum address of 1024 public keys: the per key KECCAK_256 of the serialized
+x | y that generate_binaddress_eth does, against keccak256_eth on the limbs
+(8 keys per call with AVX-512, 4 with AVX2). The keys are laid out like an
+array of Point (x, y and z of 5 limbs), the addresses are compared.
+Usage: bench_keccak [seconds]		default 1
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../sha3/sha3.h"
+#include "../sha3/keccak.h"
+#include "bench.h"
+
+#define KEYS 1024
+
+struct key	{
+	uint64_t x[5];
+	uint64_t y[5];
+	uint64_t z[5];
+};
+
+/* Big endian 32 bytes of the 4 limbs, what Int::Get32Bytes writes */
+void get32bytes(uint64_t *limbs,uint8_t *dst)	{
+	int i,j;
+	for(i = 0; i < 4; i++)	{
+		for(j = 0; j < 8; j++)	{
+			dst[8*i + j] = (uint8_t)(limbs[3 - i] >> (56 - 8*j));
+		}
+	}
+}
+
+void address_scalar(struct key *k,uint8_t *h)	{
+	uint8_t bin[64];
+	SHA3_256_CTX ctx;
+	get32bytes(k->x,bin);
+	get32bytes(k->y,bin + 32);
+	SHA3_256_Init(&ctx);
+	SHA3_256_Update(&ctx,bin,64);
+	KECCAK_256_Final(bin,&ctx);
+	memcpy(h,bin + 12,20);
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	static struct key keys[KEYS];
+	static uint8_t h[KEYS * 20],hr[KEYS * 20];
+	int stride = sizeof(struct key) / sizeof(uint64_t);
+	uint64_t count;
+	double t0,t1,scalar,batch;
+	int i,j,errors = 0;
+	for(i = 0; i < KEYS; i++)	{
+		for(j = 0; j < 4; j++)	{
+			keys[i].x[j] = next64();
+			keys[i].y[j] = next64();
+		}
+	}
+	count = 0;
+	t0 = now();
+	do {
+		for(i = 0; i < KEYS; i++)	{
+			address_scalar(&keys[i],hr + i * 20);
+		}
+		count += KEYS;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	scalar = (t1 - t0) * 1e9 / (double)count;
+	count = 0;
+	t0 = now();
+	do {
+		keccak256_eth(keys[0].x,keys[0].y,stride,KEYS,h);
+		count += KEYS;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	batch = (t1 - t0) * 1e9 / (double)count;
+	/* 1021 keys: the 8, 4 and single key paths */
+	memset(h,0,sizeof(h));
+	keccak256_eth(keys[0].x,keys[0].y,stride,KEYS - 3,h);
+	for(i = 0; i < KEYS - 3; i++)	{
+		errors += memcmp(h + i * 20,hr + i * 20,20) != 0;
+	}
+	printf("keccak lanes: %i\n",keccak_lanes());
+	printf("KECCAK_256 per key  %7.2f ns/key\n",scalar);
+	printf("keccak256_eth batch %7.2f ns/key errors %i\n",batch,errors);
+	return 0;
+}
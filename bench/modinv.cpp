@@ -0,0 +1,121 @@
+/*
+Int::ModInv mod P with safegcd (the default) and with DRS62 (the -DNOSAFEGCD
+path): time of one inversion, then both results are compared on random
+values and on 0, 1, P-1 and values >= P, and x * x^-1 is checked with ModMulK1.
+Usage: bench_modinv [seconds]		default 1
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Int.h"
+#include "bench.h"
+
+#define VALUES 4096
+
+Secp256K1 *secp;
+
+/* 256 bits value below P */
+void rand_below_p(Int *r,Int *p)	{
+	do {
+		r->SetInt32(0);
+		for(int i = 0; i < 4; i++)	{
+			r->bits64[i] = next64();
+		}
+	}while(r->IsGreaterOrEqual(p));
+}
+
+double time_modinv(Int *values,int n,double seconds)	{
+	Int r;
+	uint64_t count = 0;
+	double t0,t1;
+	t0 = now();
+	do {
+		for(int i = 0; i < n; i++)	{
+			r.Set(&values[i]);
+			r.ModInv();
+		}
+		count += n;
+		t1 = now();
+	}while(t1 - t0 < seconds);
+	return (t1 - t0) * 1e9 / (double)count;
+}
+
+/* Both inverses of x, 1 if they are the same and x * inverse = 1 (mod P) when x is not a multiple of P */
+int check(Int *x,Int *p)	{
+	Int a,b,xr,t;
+	a.Set(x);
+	Int::UseSafegcd(true);
+	a.ModInv();
+	b.Set(x);
+	Int::UseSafegcd(false);
+	b.ModInv();
+	Int::UseSafegcd(true);
+	if(!a.IsEqual(&b))	{
+		return 0;
+	}
+	xr.Set(x);
+	while(xr.IsGreaterOrEqual(p))	{
+		xr.Sub(p);
+	}
+	if(xr.IsZero())	{
+		return a.IsZero();
+	}
+	t.ModMulK1(&xr,&a);
+	if(t.IsGreaterOrEqual(p))	{
+		t.Sub(p);
+	}
+	return t.IsOne();
+}
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	static Int values[VALUES];
+	Int p,edge[10],one;
+	double safegcd,drs62;
+	int i,errors = 0,edge_errors = 0;
+	bool built;
+	secp = new Secp256K1();
+	secp->Init();
+	p.Set(Int::GetFieldCharacteristic());
+	one.SetInt32(1);
+	seed64(1);
+	for(i = 0; i < VALUES; i++)	{
+		rand_below_p(&values[i],&p);
+	}
+	built = Int::UseSafegcd(true);
+	safegcd = time_modinv(values,VALUES,seconds);
+	Int::UseSafegcd(false);
+	drs62 = time_modinv(values,VALUES,seconds);
+	Int::UseSafegcd(true);
+	for(i = 0; i < VALUES; i++)	{
+		errors += !check(&values[i],&p);
+	}
+	/* 0, 1, 2, P-2, P-1, P, P+1, P+2, 2^256-2 and 2^256-1 */
+	edge[0].SetInt32(0);
+	edge[1].SetInt32(1);
+	edge[2].SetInt32(2);
+	edge[3].Set(&p); edge[3].Sub(&one); edge[3].Sub(&one);
+	edge[4].Set(&p); edge[4].Sub(&one);
+	edge[5].Set(&p);
+	edge[6].Set(&p); edge[6].Add(&one);
+	edge[7].Set(&p); edge[7].Add(&one); edge[7].Add(&one);
+	edge[8].SetInt32(0);
+	for(i = 0; i < 4; i++)	{
+		edge[8].bits64[i] = 0xFFFFFFFFFFFFFFFFULL;
+	}
+	edge[8].Sub(&one);
+	edge[9].Set(&edge[8]); edge[9].Add(&one);
+	for(i = 0; i < 10; i++)	{
+		if(!check(&edge[i],&p))	{
+			edge_errors++;
+			printf("edge case %i wrong: %s\n",i,edge[i].GetBase16());
+		}
+	}
+	printf("safegcd built: %s\n",built ? "yes" : "no (NOSAFEGCD)");
+	printf("ModInv safegcd %8.1f ns\n",safegcd);
+	printf("ModInv DRS62   %8.1f ns\n",drs62);
+	printf("random values: %i errors, 0 1 P-1 and >= P: %i errors\n",errors,edge_errors);
+	return 0;
+}
@@ -0,0 +1,61 @@
+/*
+Cost of ComputePublicKey and ComputePublicKeys for each generator table size.
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../secp256k1/SECP256k1.h"
+#include "../secp256k1/Point.h"
+#include "../secp256k1/Int.h"
+#include "bench.h"
+
+#define BATCH 256
+
+Secp256K1 *secp;
+
+int main(int argc,char **argv)	{
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	Int key,keys[BATCH];
+	Point pub,pubs[BATCH];
+	uint64_t count,sum = 0;
+	double t0,t1,single,batch,build;
+	secp = new Secp256K1();
+	secp->Init();
+	key.Rand(256);
+	for(int bits = GTABLE_MIN_BITS; bits <= GTABLE_MAX_BITS; bits++)	{
+		t0 = now();
+		secp->InitGTable(bits);
+		build = now() - t0;
+
+		count = 0;
+		t0 = now();
+		do {
+			for(int i = 0; i < BATCH; i++)	{
+				key.AddOne();
+				pub = secp->ComputePublicKey(&key);
+				sum += pub.x.bits64[0];
+			}
+			count += BATCH;
+			t1 = now();
+		}while(t1 - t0 < seconds);
+		single = (t1 - t0) * 1e6 / (double)count;
+
+		count = 0;
+		t0 = now();
+		do {
+			for(int i = 0; i < BATCH; i++)	{
+				key.AddOne();
+				keys[i].Set(&key);
+			}
+			secp->ComputePublicKeys(BATCH,keys,pubs);
+			sum += pubs[0].x.bits64[0];
+			count += BATCH;
+			t1 = now();
+		}while(t1 - t0 < seconds);
+		batch = (t1 - t0) * 1e6 / (double)count;
+
+		printf("gtable %2i bits %8.1f MB build %6.3f s ComputePublicKey %6.2f us ComputePublicKeys(%i) %6.2f us/key (%lx)\n",bits,(double)(((256 + bits - 1) / bits) * ((1 << bits) - 1)) * sizeof(AffinePoint) / 1048576.0,build,single,BATCH,batch,(unsigned long)(sum & 0xff));
+	}
+	return 0;
+}
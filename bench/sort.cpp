@@ -0,0 +1,198 @@
+/*
+Build phase sort of the bP table (struct bsgs_xvalue packed to 11 bytes,
+6 bytes key of x and a 5 bytes index, as keyhunt stores it) and of the
+addressTable (20 bytes values): the introsort of keyhunt against the
+radix sort with 1 thread and with the given threads. Both sort the same
+random table, the results are compared.
+Usage: bench_sort [count] [threads]		default 16777216 and 4
+Build with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+#include "../radixsort/radixsort.h"
+#include "bench.h"
+
+#define BSGS_XVALUE_RAM 6
+#define BSGS_XVALUE_INDEX 5
+
+/* Packed to 11 bytes, the index is little endian (BSGS_XVALUE_INDEX bytes) */
+struct bsgs_xvalue	{
+	uint8_t value[6];
+	uint8_t index[5];
+};
+
+struct address_value	{
+	uint8_t value[20];
+};
+
+/* The introsort of keyhunt.cpp, the same code for both tables */
+#define INTROSORT(prefix,type,length)	\
+void prefix##_swap(type *a,type *b)	{	\
+	type t = *a; *a = *b; *b = t;	\
+}	\
+void prefix##_insertionsort(type *arr, int64_t n) {	\
+	int64_t j,i;	\
+	type key;	\
+	for(i = 1; i < n ; i++ ) {	\
+		key = arr[i];	\
+		j= i-1;	\
+		while(j >= 0 && memcmp(arr[j].value,key.value,length) > 0) {	\
+			arr[j+1] = arr[j];	\
+			j--;	\
+		}	\
+		arr[j+1] = key;	\
+	}	\
+}	\
+int64_t prefix##_partition(type *arr, int64_t n)	{	\
+	type pivot;	\
+	int64_t r,left,right;	\
+	r = n/2;	\
+	pivot = arr[r];	\
+	left = 0;	\
+	right = n-1;	\
+	do {	\
+		while(left	< right && memcmp(arr[left].value,pivot.value,length) <= 0 )	left++;	\
+		while(right >= left && memcmp(arr[right].value,pivot.value,length) > 0)	right--;	\
+		if(left < right)	{	\
+			if(left == r || right == r)	{	\
+				if(left == r)	r = right;	\
+				if(right == r)	r = left;	\
+			}	\
+			prefix##_swap(&arr[right],&arr[left]);	\
+		}	\
+	}while(left < right);	\
+	if(right != r)	prefix##_swap(&arr[right],&arr[r]);	\
+	return right;	\
+}	\
+void prefix##_heapify(type *arr, int64_t n, int64_t i) {	\
+	int64_t largest = i,l = 2 * i + 1,r = 2 * i + 2;	\
+	if (l < n && memcmp(arr[l].value,arr[largest].value,length) > 0)	largest = l;	\
+	if (r < n && memcmp(arr[r].value,arr[largest].value,length) > 0)	largest = r;	\
+	if (largest != i) {	\
+		prefix##_swap(&arr[i],&arr[largest]);	\
+		prefix##_heapify(arr, n, largest);	\
+	}	\
+}	\
+void prefix##_myheapsort(type *arr, int64_t n)	{	\
+	int64_t i;	\
+	for ( i = (n / 2) - 1; i >=	0; i--)	prefix##_heapify(arr, n, i);	\
+	for ( i = n - 1; i > 0; i--) {	\
+		prefix##_swap(&arr[0] , &arr[i]);	\
+		prefix##_heapify(arr, i, 0);	\
+	}	\
+}	\
+void prefix##_introsort(type *arr,uint32_t depthLimit, int64_t n) {	\
+	int64_t p;	\
+	if(n > 1)	{	\
+		if(n <= 16) prefix##_insertionsort(arr,n);	\
+		else if(depthLimit == 0) prefix##_myheapsort(arr,n);	\
+		else	{	\
+			p = prefix##_partition(arr,n);	\
+			if(p > 0) prefix##_introsort(arr , depthLimit-1 , p);	\
+			if(p < n) prefix##_introsort(&arr[p+1],depthLimit-1,n-(p+1));	\
+		}	\
+	}	\
+}	\
+void prefix##_sort(type *arr,int64_t n)	{	\
+	uint32_t depthLimit = ((uint32_t) ceil(log(n))) * 2;	\
+	prefix##_introsort(arr,depthLimit,n);	\
+}
+
+INTROSORT(bsgs,struct bsgs_xvalue,BSGS_XVALUE_RAM)
+INTROSORT(addr,struct address_value,20)
+
+/* Same keys in the same order, the records with equal keys may differ */
+int same_keys(uint8_t *a,uint8_t *b,uint64_t n,int size,int length)	{
+	for(uint64_t i = 0; i < n; i++)	{
+		if(memcmp(a + i * size,b + i * size,length) != 0)	{
+			return 0;
+		}
+		if(i > 0 && memcmp(b + (i - 1) * size,b + i * size,length) > 0)	{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void run(const char *name,uint8_t *table,uint64_t count,int size,int length,int threads,void (*introsort)(uint8_t*,uint64_t))	{
+	uint8_t *copy = (uint8_t*) malloc(count * size);
+	uint8_t *sorted = (uint8_t*) malloc(count * size);
+	double t0,t_intro,t_radix1,t_radix;
+	int ok;
+	if(copy == NULL || sorted == NULL)	{
+		fprintf(stderr,"[E] Not enough memory for %" PRIu64 " records\n",count);
+		exit(EXIT_FAILURE);
+	}
+	memcpy(sorted,table,count * size);
+	t0 = now();
+	introsort(sorted,count);
+	t_intro = now() - t0;
+	memcpy(copy,table,count * size);
+	t0 = now();
+	radixsort(copy,count,size,length,1);
+	t_radix1 = now() - t0;
+	ok = same_keys(sorted,copy,count,size,length);
+	memcpy(copy,table,count * size);
+	t0 = now();
+	radixsort(copy,count,size,length,threads);
+	t_radix = now() - t0;
+	ok &= same_keys(sorted,copy,count,size,length);
+	printf("[+] %s %" PRIu64 " records: introsort %.2f s, radixsort 1 thread %.2f s, %i threads %.2f s, %s\n",name,count,t_intro,t_radix1,threads,t_radix,ok ? "same order" : "DIFFERENT ORDER");
+	free(copy);
+	free(sorted);
+}
+
+void bsgs_xvalue_set_index(struct bsgs_xvalue *xvalue,uint64_t index)	{
+	for(int i = 0; i < BSGS_XVALUE_INDEX; i++)	{
+		xvalue->index[i] = (uint8_t) (index >> (8 * i));
+	}
+}
+
+void bsgs_introsort_bytes(uint8_t *table,uint64_t n)	{
+	bsgs_sort((struct bsgs_xvalue*)table,n);
+}
+
+void addr_introsort_bytes(uint8_t *table,uint64_t n)	{
+	addr_sort((struct address_value*)table,n);
+}
+
+int main(int argc,char **argv)	{
+	uint64_t count = (argc > 1) ? strtoull(argv[1],NULL,10) : 16777216;
+	int threads = (argc > 2) ? atoi(argv[2]) : 4;
+	uint64_t i,v;
+
+	seed64(1);
+	struct bsgs_xvalue *bPtable = (struct bsgs_xvalue*) malloc(count * sizeof(struct bsgs_xvalue));
+	if(bPtable == NULL)	{
+		fprintf(stderr,"[E] Not enough memory for %" PRIu64 " records\n",count);
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i < count; i++)	{
+		v = next64();
+		memcpy(bPtable[i].value,&v,BSGS_XVALUE_RAM);
+		bsgs_xvalue_set_index(&bPtable[i],i);
+	}
+	printf("[+] bP record %i bytes, key %i bytes\n",(int)sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM);
+	run("bP table",(uint8_t*)bPtable,count,sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM,threads,bsgs_introsort_bytes);
+	free(bPtable);
+
+	struct address_value *addressTable = (struct address_value*) malloc(count * sizeof(struct address_value));
+	if(addressTable == NULL)	{
+		fprintf(stderr,"[E] Not enough memory for %" PRIu64 " records\n",count);
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i < count; i++)	{
+		for(int k = 0; k < 20; k += 4)	{
+			v = next64();
+			memcpy(addressTable[i].value + k,&v,4);
+		}
+	}
+	run("addressTable",(uint8_t*)addressTable,count,sizeof(struct address_value),20,threads,addr_introsort_bytes);
+	free(addressTable);
+	return 0;
+}
@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <immintrin.h>
 
 #include "bloom.h"
 #include "../xxhash/xxhash.h"
@@ -58,12 +59,172 @@ inline static int test_bit(uint8_t *bf, uint64_t bit)
   }
 }
 
+/*
+  Cache line blocked (split block) filter, see bloom_init_blocked().
+  The high 32 bits of the hash select the block, the low 32 bits multiplied
+  by one odd salt per word select the bit of each of the 16 words.
+*/
+
+#define BLOOM_BLOCK_WORDS 16
+#define BLOOM_BLOCK_BITS 512
+
+static const uint32_t bloom_salt[BLOOM_BLOCK_WORDS] __attribute__((aligned(64))) = {
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+  0x9e3779b1U, 0x85ebca77U, 0xc2b2ae3dU, 0x27d4eb2fU,
+  0x165667b1U, 0xd3a2646dU, 0xfd7046c5U, 0xb55a4f09U
+};
+
+inline static uint32_t * bloom_block(struct bloom * bloom, uint64_t h)
+{
+  uint64_t blocks = bloom->bytes / 64;
+  return (uint32_t *)(bloom->bf + (((h >> 32) * blocks) >> 32) * 64);
+}
+
+/*
+  The AVX2 probes are built whatever -march says and selected at runtime,
+  a portable build still uses them on the CPUs that have AVX2.
+*/
+#define BLOOM_AVX2 __attribute__((target("avx2")))
+
+static int bloom_has_avx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static const int bloom_avx2 = bloom_has_avx2();
+
+BLOOM_AVX2 inline static void bloom_masks_avx2(uint32_t key, __m256i *mask0, __m256i *mask1)
+{
+  __m256i k = _mm256_set1_epi32(key);
+  __m256i one = _mm256_set1_epi32(1);
+  *mask0 = _mm256_sllv_epi32(one, _mm256_srli_epi32(_mm256_mullo_epi32(k, _mm256_load_si256((const __m256i *)bloom_salt)), 27));
+  *mask1 = _mm256_sllv_epi32(one, _mm256_srli_epi32(_mm256_mullo_epi32(k, _mm256_load_si256((const __m256i *)(bloom_salt + 8))), 27));
+}
+
+BLOOM_AVX2 static int bloom_check_add_block_avx2(uint32_t *block, uint32_t key, int add)
+{
+  __m256i mask0, mask1;
+  bloom_masks_avx2(key, &mask0, &mask1);
+  __m256i b0 = _mm256_load_si256((const __m256i *)block);
+  __m256i b1 = _mm256_load_si256((const __m256i *)(block + 8));
+  int in = _mm256_testc_si256(b0, mask0) & _mm256_testc_si256(b1, mask1);
+  if (add && !in) {
+    _mm256_store_si256((__m256i *)block, _mm256_or_si256(b0, mask0));
+    _mm256_store_si256((__m256i *)(block + 8), _mm256_or_si256(b1, mask1));
+  }
+  return in;
+}
+
+// Masks of the key in mask, 1 if the block already has all of them
+BLOOM_AVX2 static int bloom_block_masks_avx2(const uint32_t *block, uint32_t key, uint32_t *mask)
+{
+  __m256i mask0, mask1;
+  bloom_masks_avx2(key, &mask0, &mask1);
+  if (_mm256_testc_si256(_mm256_load_si256((const __m256i *)block), mask0) & _mm256_testc_si256(_mm256_load_si256((const __m256i *)(block + 8)), mask1)) {
+    return 1;
+  }
+  _mm256_store_si256((__m256i *)mask, mask0);
+  _mm256_store_si256((__m256i *)(mask + 8), mask1);
+  return 0;
+}
+
+static int bloom_check_add_blocked(struct bloom * bloom, uint64_t h, int add)
+{
+  uint32_t key = (uint32_t)h;
+  uint32_t *block = bloom_block(bloom, h);
+  if (bloom_avx2) {
+    return bloom_check_add_block_avx2(block, key, add);
+  }
+  uint32_t mask[BLOOM_BLOCK_WORDS];
+  uint32_t miss = 0;
+  int i;
+  for (i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+    mask[i] = 1U << ((key * bloom_salt[i]) >> 27);
+    miss |= mask[i] & ~block[i];
+  }
+  if (add && miss) {
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+      block[i] |= mask[i];
+    }
+  }
+  return miss == 0;
+}
+
+/*
+  Concurrent adds: every thread sets its bits with an atomic or, so the
+  threads building the same filter need no lock. Only the bits still clear
+  are written, a block or a byte already set is only read.
+*/
+static int bloom_add_blocked_atomic(struct bloom * bloom, uint64_t h)
+{
+  uint32_t key = (uint32_t)h;
+  uint64_t *block = (uint64_t *)bloom_block(bloom, h);
+  uint32_t mask[BLOOM_BLOCK_WORDS] __attribute__((aligned(32)));
+  uint64_t m;
+  int i, in = 1;
+  if (bloom_avx2) {
+    if (bloom_block_masks_avx2((const uint32_t *)block, key, mask)) {
+      return 1;
+    }
+  }
+  else {
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+      mask[i] = 1U << ((key * bloom_salt[i]) >> 27);
+    }
+  }
+  // Two words per atomic or, the words of a block are in one cache line
+  for (i = 0; i < BLOOM_BLOCK_WORDS / 2; i++) {
+    memcpy(&m, &mask[i * 2], sizeof(uint64_t));
+    if ((__atomic_load_n(&block[i], __ATOMIC_RELAXED) & m) != m) {
+      __atomic_fetch_or(&block[i], m, __ATOMIC_RELAXED);
+      in = 0;
+    }
+  }
+  return in;
+}
+
+static int bloom_add_classic_atomic(struct bloom * bloom, uint64_t a, uint64_t b)
+{
+  uint64_t x;
+  uint8_t mask, hits = 0;
+  uint8_t i;
+  for (i = 0; i < bloom->hashes; i++) {
+    x = (a + b*i) % bloom->bits;
+    mask = 1 << (x % 8);
+    if (__atomic_load_n(&bloom->bf[x >> 3], __ATOMIC_RELAXED) & mask) {
+      hits++;
+    }
+    else {
+      __atomic_fetch_or(&bloom->bf[x >> 3], mask, __ATOMIC_RELAXED);
+    }
+  }
+  return hits == bloom->hashes;
+}
+
+static int bloom_check_hashed(struct bloom * bloom, uint64_t a, uint64_t b)
+{
+  uint64_t x;
+  uint8_t i;
+  for (i = 0; i < bloom->hashes; i++) {
+    x = (a + b*i) % bloom->bits;
+    if (!test_bit(bloom->bf, x)) {
+      return 0;
+    }
+  }
+  return 1;                  // 1 == element already in (or collision)
+}
+
 static int bloom_check_add(struct bloom * bloom, const void * buffer, int len, int add)
 {
   if (bloom->ready == 0) {
     printf("bloom at %p not initialized!\n", (void *)bloom);
     return -1;
   }
+  if (bloom->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+    return bloom_check_add_blocked(bloom, XXH64(buffer, len, 0x59f2815b16f81798), add);
+  }
   uint8_t hits = 0;
   uint64_t a = XXH64(buffer, len, 0x59f2815b16f81798);
   uint64_t b = XXH64(buffer, len, a);
@@ -125,29 +286,139 @@ int bloom_init2(struct bloom * bloom, uint64_t entries, long double error)
   return 0;
 }
 
+/*
+  False positive rate of the split block filter with bpe bits per element:
+  the load of a block is Poisson with mean BLOOM_BLOCK_BITS/bpe and a
+  query matches when its bit is set in each of the 16 words.
+*/
+static double bloom_blocked_error(double bpe)
+{
+  double lambda = BLOOM_BLOCK_BITS / bpe;
+  double p = exp(-lambda);
+  double error = 0;
+  int j;
+  for (j = 0; j < (int)(lambda * 4) + 64; j++) {
+    if (j > 0) {
+      p *= lambda / j;
+    }
+    error += p * pow(1.0 - pow(1.0 - 1.0 / 32, j), BLOOM_BLOCK_WORDS);
+  }
+  return error;
+}
+
+int bloom_init_blocked(struct bloom * bloom, uint64_t entries, long double error)
+{
+  memset(bloom, 0, sizeof(struct bloom));
+  if (entries < 1000 || error <= 0 || error >= 1) {
+    return 1;
+  }
+  bloom->entries = entries;
+  bloom->error = error;
+
+  double bpe = -log(error) / 0.480453013918201; // classic bits per element
+  while (bloom_blocked_error(bpe) > error) {
+    bpe += 0.25;
+  }
+  uint64_t blocks = (uint64_t)((long double)entries * bpe / BLOOM_BLOCK_BITS) + 1;
+  if (blocks >> 32) {
+    return 1;
+  }
+  bloom->bits = blocks * BLOOM_BLOCK_BITS;
+  bloom->bytes = blocks * 64;
+  bloom->bpe = (double)bloom->bits / entries;
+  bloom->hashes = BLOOM_BLOCK_WORDS;
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  bloom->bf = (uint8_t *)_aligned_malloc(bloom->bytes, 64);
+#else
+  if (posix_memalign((void **)&bloom->bf, 64, bloom->bytes) != 0) {
+    bloom->bf = NULL;
+  }
+#endif
+  if (bloom->bf == NULL) {
+    return 1;
+  }
+  memset(bloom->bf, 0, bloom->bytes);
+
+  bloom->ready = 1;
+  bloom->major = BLOOM_BLOCKED_VERSION_MAJOR;
+  bloom->minor = BLOOM_VERSION_MINOR;
+  return 0;
+}
+
 int bloom_check(struct bloom * bloom, const void * buffer, int len)
 {
   if (bloom->ready == 0) {
     printf("bloom at %p not initialized!\n", (void *)bloom);
     return -1;
   }
-  uint8_t hits = 0;
+  if (bloom->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+    return bloom_check_add_blocked(bloom, XXH64(buffer, len, 0x59f2815b16f81798), 0);
+  }
   uint64_t a = XXH64(buffer, len, 0x59f2815b16f81798);
   uint64_t b = XXH64(buffer, len, a);
-  uint64_t x;
-  uint8_t i;
-  for (i = 0; i < bloom->hashes; i++) {
-    x = (a + b*i) % bloom->bits;
-    if (test_bit(bloom->bf, x)) {
-      hits++;
-    } else {
-      return 0;
+  return bloom_check_hashed(bloom, a, b);
+}
+
+/*
+  The lookups of a batch are done in two passes of BLOOM_BATCH keys: the
+  first one hashes every key and prefetches the lines of its first probes,
+  the second one tests the bits, by then the lines are in flight or in cache
+  instead of one DRAM miss after the other.
+*/
+
+#define BLOOM_BATCH 32
+
+static int bloom_check_batch_filters(struct bloom * bloom, int split, const uint8_t * keys, int len, int stride, int n, uint8_t * results)
+{
+  struct bloom *f[BLOOM_BATCH];
+  uint64_t a[BLOOM_BATCH];
+  uint64_t b[BLOOM_BATCH];
+  const uint8_t *key;
+  int base, m, i, hits = 0;
+
+  for (base = 0; base < n; base += BLOOM_BATCH) {
+    m = (n - base < BLOOM_BATCH) ? n - base : BLOOM_BATCH;
+    for (i = 0; i < m; i++) {
+      key = keys + (size_t)(base + i) * stride;
+      f[i] = split ? &bloom[key[0]] : bloom;
+      if (f[i]->ready == 0) {
+        printf("bloom at %p not initialized!\n", (void *)f[i]);
+        memset(results, 0, n);  // No element keeps the result of a previous batch
+        return -1;
+      }
+      a[i] = XXH64(key, len, 0x59f2815b16f81798);
+      if (f[i]->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+        _mm_prefetch((const char *)bloom_block(f[i], a[i]), _MM_HINT_T0);
+      }
+      else {
+        // Most absent keys are rejected by the first two probes
+        b[i] = XXH64(key, len, a[i]);
+        _mm_prefetch((const char *)f[i]->bf + ((a[i] % f[i]->bits) >> 3), _MM_HINT_T0);
+        _mm_prefetch((const char *)f[i]->bf + (((a[i] + b[i]) % f[i]->bits) >> 3), _MM_HINT_T0);
+      }
+    }
+    for (i = 0; i < m; i++) {
+      if (f[i]->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+        results[base + i] = bloom_check_add_blocked(f[i], a[i], 0);
+      }
+      else {
+        results[base + i] = bloom_check_hashed(f[i], a[i], b[i]);
+      }
+      hits += results[base + i];
     }
   }
-  if (hits == bloom->hashes) {
-    return 1;                // 1 == element already in (or collision)
-  }
-  return 0;
+  return hits;
+}
+
+int bloom_check_batch(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n, uint8_t * results)
+{
+  return bloom_check_batch_filters(bloom, 0, keys, len, stride, n, results);
+}
+
+int bloom_check_batch_split(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n, uint8_t * results)
+{
+  return bloom_check_batch_filters(bloom, 1, keys, len, stride, n, results);
 }
 
 
@@ -156,6 +427,74 @@ int bloom_add(struct bloom * bloom, const void * buffer, int len)
   return bloom_check_add(bloom, buffer, len, 1);
 }
 
+int bloom_add_concurrent(struct bloom * bloom, const void * buffer, int len)
+{
+  if (bloom->ready == 0) {
+    printf("bloom at %p not initialized!\n", (void *)bloom);
+    return -1;
+  }
+  uint64_t a = XXH64(buffer, len, 0x59f2815b16f81798);
+  if (bloom->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+    return bloom_add_blocked_atomic(bloom, a);
+  }
+  return bloom_add_classic_atomic(bloom, a, XXH64(buffer, len, a));
+}
+
+/*
+  The locked or of an add waits for its cache line and keeps the next adds
+  from starting their own misses, so the batch prefetches the lines of
+  BLOOM_BATCH elements before adding them.
+*/
+static int bloom_add_batch_filters(struct bloom * bloom, int split, const uint8_t * keys, int len, int stride, int n)
+{
+  struct bloom *f[BLOOM_BATCH];
+  uint64_t a[BLOOM_BATCH];
+  uint64_t b[BLOOM_BATCH];
+  const uint8_t *key;
+  int base, m, i, j, in = 0;
+
+  for (base = 0; base < n; base += BLOOM_BATCH) {
+    m = (n - base < BLOOM_BATCH) ? n - base : BLOOM_BATCH;
+    for (i = 0; i < m; i++) {
+      key = keys + (size_t)(base + i) * stride;
+      f[i] = split ? &bloom[key[0]] : bloom;
+      if (f[i]->ready == 0) {
+        printf("bloom at %p not initialized!\n", (void *)f[i]);
+        return -1;
+      }
+      a[i] = XXH64(key, len, 0x59f2815b16f81798);
+      if (f[i]->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+        _mm_prefetch((const char *)bloom_block(f[i], a[i]), _MM_HINT_T0);
+      }
+      else {
+        b[i] = XXH64(key, len, a[i]);
+        for (j = 0; j < f[i]->hashes; j++) {
+          _mm_prefetch((const char *)f[i]->bf + (((a[i] + b[i]*j) % f[i]->bits) >> 3), _MM_HINT_T0);
+        }
+      }
+    }
+    for (i = 0; i < m; i++) {
+      if (f[i]->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+        in += bloom_add_blocked_atomic(f[i], a[i]);
+      }
+      else {
+        in += bloom_add_classic_atomic(f[i], a[i], b[i]);
+      }
+    }
+  }
+  return in;
+}
+
+int bloom_add_concurrent_batch(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n)
+{
+  return bloom_add_batch_filters(bloom, 0, keys, len, stride, n);
+}
+
+int bloom_add_concurrent_batch_split(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n)
+{
+  return bloom_add_batch_filters(bloom, 1, keys, len, stride, n);
+}
+
 void bloom_print(struct bloom * bloom)
 {
   printf("bloom at %p\n", (void *)bloom);
@@ -175,7 +514,16 @@ void bloom_print(struct bloom * bloom)
 void bloom_free(struct bloom * bloom)
 {
   if (bloom->ready) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    if (bloom->major == BLOOM_BLOCKED_VERSION_MAJOR) {
+      _aligned_free(bloom->bf);
+    }
+    else {
+      free(bloom->bf);
+    }
+#else
     free(bloom->bf);
+#endif
   }
   bloom->ready = 0;
 }
@@ -296,3 +644,8 @@ const char * bloom_version()
 {
   return MAKESTRING(BLOOM_VERSION);
 }
+
+const char * bloom_probe_backend()
+{
+  return bloom_avx2 ? "AVX2" : "scalar";
+}
@@ -83,6 +83,31 @@ int bloom_savecustom(struct bloom * bloom, char * filename);
 int bloom_init2(struct bloom * bloom, uint64_t entries, long double error);
 
 
+/** ***************************************************************************
+ * Initialize a cache line blocked bloom filter.
+ *
+ * Same interface as bloom_init2() but every element lives in a single
+ * 64 byte block: one hash picks the block and 16 bits are set in it, one
+ * in each 32 bit word (split block bloom filter). A lookup is one memory
+ * access checked with SIMD instead of 'hashes' random accesses, at the
+ * price of a few more bits per element for the same error, the size is
+ * computed for the requested error.
+ *
+ * The filter is marked with major version BLOOM_BLOCKED_VERSION_MAJOR,
+ * bloom_check() and bloom_add() select the probe from it, so filters saved
+ * with either layout load back with the right one.
+ *
+ * Return:
+ * -------
+ *     0 - on success
+ *     1 - on failure
+ *
+ */
+int bloom_init_blocked(struct bloom * bloom, uint64_t entries, long double error);
+
+#define BLOOM_BLOCKED_VERSION_MAJOR 3
+
+
 /**
  * DEPRECATED.
  * Kept for compatibility with libbloom v.1. To be removed in v3.0.
@@ -111,6 +136,38 @@ int bloom_init(struct bloom * bloom, uint64_t entries, long double error);
 int bloom_check(struct bloom * bloom, const void * buffer, int len);
 
 
+/** ***************************************************************************
+ * Check n elements at once. The keys are hashed and the lines of their
+ * probes prefetched before any bit is tested, so the memory accesses of
+ * the batch overlap instead of stalling one after the other.
+ *
+ * Parameters:
+ * -----------
+ *     bloom   - Pointer to an allocated struct bloom (see above).
+ *     keys    - Element i is at keys + i*stride.
+ *     len     - Size of each element.
+ *     stride  - Distance in bytes between two elements.
+ *     n       - Number of elements.
+ *     results - results[i] is set to the bloom_check() value of element i.
+ *
+ * Return:
+ * -------
+ *     Number of elements present (or false positives)
+ *    -1 - bloom not initialized, every results[i] is 0
+ *
+ */
+int bloom_check_batch(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n, uint8_t * results);
+
+
+/** ***************************************************************************
+ * Same as bloom_check_batch() with 256 filters: bloom is an array of 256
+ * struct bloom and the first byte of each element selects its filter, like
+ * the bsgs bloom filters.
+ *
+ */
+int bloom_check_batch_split(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n, uint8_t * results);
+
+
 /** ***************************************************************************
  * Add the given element to the bloom filter.
  * The return code indicates if the element (or a collision) was already in,
@@ -132,6 +189,40 @@ int bloom_check(struct bloom * bloom, const void * buffer, int len);
 int bloom_add(struct bloom * bloom, const void * buffer, int len);
 
 
+/** ***************************************************************************
+ * Same as bloom_add() but safe to call from several threads at the same time
+ * on the same filter: the bits are set with atomic operations instead of
+ * needing a lock around each add.
+ *
+ * Return:
+ * -------
+ *     Same as bloom_add()
+ *
+ */
+int bloom_add_concurrent(struct bloom * bloom, const void * buffer, int len);
+
+
+/** ***************************************************************************
+ * bloom_add_concurrent() of n elements laid out like in bloom_check_batch().
+ * The lines of a chunk of elements are prefetched before their bits are set.
+ *
+ * Return:
+ * -------
+ *     Number of elements (or collisions) that were already in
+ *    -1 - bloom not initialized
+ *
+ */
+int bloom_add_concurrent_batch(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n);
+
+
+/** ***************************************************************************
+ * Same as bloom_add_concurrent_batch() with 256 filters, the first byte of
+ * each element selects its filter like in bloom_check_batch_split().
+ *
+ */
+int bloom_add_concurrent_batch_split(struct bloom * bloom, const uint8_t * keys, int len, int stride, int n);
+
+
 /** ***************************************************************************
  * Print (to stdout) info about this bloom filter. Debugging aid.
  *
@@ -215,6 +306,13 @@ int bloom_reset(struct bloom * bloom);
  */
 const char * bloom_version();
 
+/** ***************************************************************************
+ * Returns the name of the blocked filter probe selected for this CPU,
+ * "AVX2" or "scalar".
+ *
+ */
+const char * bloom_probe_backend();
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,10 @@ email: albertobsd@gmail.com
 #include "rmd160/rmd160.h"
 #include "oldbloom/oldbloom.h"
 #include "bloom/bloom.h"
+#include "fuse/fuse.h"
+#include "mapfile/mapfile.h"
+#include "addrindex/addrindex.h"
+#include "radixsort/radixsort.h"
 #include "sha3/sha3.h"
 #include "util.h"
 
@@ -22,9 +26,11 @@ email: albertobsd@gmail.com
 #include "secp256k1/Point.h"
 #include "secp256k1/Int.h"
 #include "secp256k1/IntGroup.h"
+#include "secp256k1/BatchStep.h"
 #include "secp256k1/Random.h"
 
 #include "hash/sha256.h"
+#include "hash/sha256_tree.h"
 #include "hash/ripemd160.h"
 
 #include <unistd.h>
@@ -52,11 +58,40 @@ struct checksumsha256	{
 	char backup[32];
 };
 
+/* Packed to 11 bytes, the index is little endian (BSGS_XVALUE_INDEX bytes) */
 struct bsgs_xvalue	{
+	uint8_t value[6];
+	uint8_t index[5];
+};
+
+/* The records of the tables saved before, keyhunt_bsgs_2_ files */
+struct bsgs_xvalue_legacy	{
 	uint8_t value[6];
 	uint64_t index;
 };
 
+/*
+	Layout of the --mmap files, same as keyhunt: the header and the 256 entries, then every bf
+	(or the bP table) at a page aligned offset so it is used in place
+*/
+#define BSGS_MAP_MAGIC "KHBSGSMP"
+
+struct bsgs_map_header	{
+	char magic[8];
+	uint64_t count;		/* 256 filters or the number of bP table elements */
+	uint64_t offset;	/* bP table offset */
+	struct checksumsha256 checksum;	/* bP table checksum */
+};
+
+struct bsgs_map_entry	{
+	uint64_t offset;
+	struct checksumsha256 checksum;
+	union	{
+		struct bloom bloom;
+		struct fuse16 fuse;
+	} filter;
+};
+
 struct tothread {
 	int nt;     //Number thread
 	char *rs;   //range start
@@ -83,10 +118,10 @@ int port;
 
 #define CPU_GRP_SIZE 1024
 
-std::vector<Point> Gn;
+std::vector<AffinePoint> Gn;
 Point _2Gn;
 
-std::vector<Point> GSn;
+std::vector<AffinePoint> GSn;
 Point _2GSn;
 
 
@@ -98,16 +133,24 @@ int sendstr(int client_fd,const char *str);
 void sleep_ms(int milliseconds);
 
 void bsgs_sort(struct bsgs_xvalue *arr,int64_t n);
-void bsgs_myheapsort(struct bsgs_xvalue *arr, int64_t n);
-void bsgs_insertionsort(struct bsgs_xvalue *arr, int64_t n);
-void bsgs_introsort(struct bsgs_xvalue *arr,uint32_t depthLimit, int64_t n);
-void bsgs_swap(struct bsgs_xvalue *a,struct bsgs_xvalue *b);
-void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i);
-int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n);
 
-int bsgs_searchbinary(struct bsgs_xvalue *arr,char *data,int64_t array_length,uint64_t *r_value);
-int bsgs_secondcheck(Int *start_range,uint32_t a,Int *privatekey);
-int bsgs_thirdcheck(Int *start_range,uint32_t a,Int *privatekey);
+void bsgs_xvalue_set_index(struct bsgs_xvalue *xvalue,uint64_t index);
+uint64_t bsgs_xvalue_get_index(struct bsgs_xvalue *xvalue);
+int bsgs_searchtable(char *data,uint64_t *r_value);
+int bsgs_table_convert(uint64_t count);
+void bsgs_table_index();
+int bsgs_secondcheck(Int *start_range,uint32_t a,Point *candidate,Int *privatekey);
+int bsgs_map_read(const char *filename,struct bloom *blooms,struct checksumsha256 *checksums);
+void bsgs_map_write(const char *filename,struct bloom *blooms,struct checksumsha256 *checksums);
+int bsgs_map_table_read(const char *filename,uint64_t count);
+void bsgs_map_table_write(const char *filename,uint64_t count);
+void bsgs_checksum_begin(const char *filename);
+void bsgs_checksum_add(uint8_t *data,uint64_t bytes,char *expected,char *backup);
+void bsgs_checksum_start();
+void bsgs_checksum_end();
+void bsgs_bloom_check_group(AffinePoint *pts,int n,unsigned char *xpoints_raw,uint8_t *bloom_hits);
+void bsgs_bP_add_group(AffinePoint *pts,int n,uint64_t i_counter,uint64_t to,unsigned char *xpoints_raw);
+int bsgs_thirdcheck(Int *start_range,uint32_t a,Point *candidate,Int *privatekey);
 
 
 void writekey(bool compressed,Int *key);
@@ -177,6 +220,10 @@ int FLAGREADEDFILE2 = 0;
 int FLAGREADEDFILE3 = 0;
 int FLAGREADEDFILE4 = 0;
 int FLAGUPDATEFILE1 = 0;
+int FLAGUPDATEFILE3 = 0;
+int FLAGBLOOMCLASSIC = 0;
+int FLAGMMAP = 0;
+int mmap_flags = 0;
 
 
 int FLAGBITRANGE = 0;
@@ -192,6 +239,7 @@ char *str_stride;
 Int stride;
 
 uint64_t BSGS_XVALUE_RAM = 6;
+#define BSGS_XVALUE_INDEX 5
 uint64_t BSGS_BUFFERXPOINTLENGTH = 32;
 uint64_t BSGS_BUFFERREGISTERLENGTH = 36;
 
@@ -204,8 +252,12 @@ bool OriginalPointsBSGScompressed;
 
 uint64_t bytes;
 char checksum[32],checksum_backup[32];
+struct sha256_tree_batch checksum_batch[2];	/* The file being read and the verification of the previous one */
+char checksum_batch_file[2][1024];
+int checksum_batch_current = 0;
 char buffer_bloom_file[1024];
 struct bsgs_xvalue *bPtable;
+struct addrindex bPtable_index;
 
 struct oldbloom oldbloom_bP;
 
@@ -217,10 +269,6 @@ struct checksumsha256 *bloom_bP_checksums;
 struct checksumsha256 *bloom_bPx2nd_checksums;
 struct checksumsha256 *bloom_bPx3rd_checksums;
 
-pthread_mutex_t *bloom_bP_mutex;
-pthread_mutex_t *bloom_bPx2nd_mutex;
-pthread_mutex_t *bloom_bPx3rd_mutex;
-
 
 
 
@@ -291,9 +339,6 @@ int main(int argc, char **argv)	{
 	char *bf_ptr = NULL;
 	char *bPload_threads_available;
 
-	// Buffers
-	char rawvalue[32];
-
 	// 64-bit integers
 	uint64_t BASE, PERTHREAD_R, itemsbloom, itemsbloom2, itemsbloom3;
 
@@ -348,6 +393,26 @@ int main(int argc, char **argv)	{
 	
 	printf("[+] Version %s, developed by AlbertoBSD\n",version);
 
+	/* Long options are not handled by getopt, take them out first */
+	s = 1;
+	for(int k = 1; k < argc; k++)	{
+		if(strcmp(argv[k],"--mmap") == 0)	{
+			FLAGMMAP = 1;
+		}
+		else if(strcmp(argv[k],"--mmap-populate") == 0)	{
+			FLAGMMAP = 1;
+			mmap_flags |= MAPFILE_POPULATE;
+		}
+		else if(strcmp(argv[k],"--mmap-huge") == 0)	{
+			FLAGMMAP = 1;
+			mmap_flags |= MAPFILE_HUGEPAGE;
+		}
+		else	{
+			argv[s++] = argv[k];
+		}
+	}
+	argc = s;
+
 	while ((c = getopt(argc, argv, "6hk:n:t:p:i:")) != -1) {
 		switch(c) {
 			case '6':
@@ -494,6 +559,10 @@ int main(int argc, char **argv)	{
 		
 		bsgs_m2 =  BSGS_M2.GetInt64();
 		bsgs_m3 =  BSGS_M3.GetInt64();
+		if(bsgs_m3 >> (8 * BSGS_XVALUE_INDEX))	{
+			fprintf(stderr,"[E] The bP table of %" PRIu64 " elements is too big, use a lower -k value\n",bsgs_m3);
+			exit(EXIT_FAILURE);
+		}
 		
 		BSGS_AUX.Set(&BSGS_N);
 		BSGS_AUX.Div(&BSGS_M);
@@ -547,67 +616,106 @@ int main(int argc, char **argv)	{
 			itemsbloom3 = 1000;
 		}
 		
+		/*
+			The 1st bloom filter is cache line blocked (keyhunt_bsgs_8_ files), the
+			files of the previous versions (keyhunt_bsgs_4_ and keyhunt_bsgs_3_) keep
+			their classic layout so they are still used
+		*/
+		if(FLAGSAVEREADFILE && !FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
+			fd_aux1 = fopen(buffer_bloom_file,"rb");
+			if(fd_aux1 == NULL)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+				fd_aux1 = fopen(buffer_bloom_file,"rb");
+			}
+			if(fd_aux1 == NULL)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_3_%" PRIu64 ".blm",bsgs_m);
+				fd_aux1 = fopen(buffer_bloom_file,"rb");
+			}
+			if(fd_aux1 != NULL)	{
+				FLAGBLOOMCLASSIC = strstr(buffer_bloom_file,"keyhunt_bsgs_8_") == NULL;
+				fclose(fd_aux1);
+			}
+		}
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m);
 		bloom_bP = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bP,__FILE__,"calloc","bloom_bP" ,__LINE__ -1 );
 		bloom_bP_checksums = (struct checksumsha256*)calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bP_checksums,__FILE__,"calloc","bloom_bP_checksums" ,__LINE__ -1 );
 		
-		bloom_bP_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bP_mutex,__FILE__,"calloc","bloom_bP_mutex" ,__LINE__ -1 );
-		
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".map",bsgs_m);
+			FLAGREADEDFILE1 = bsgs_map_read(buffer_bloom_file,bloom_bP,bloom_bP_checksums);
+		}
 
 		fflush(stdout);
 		bloom_bP_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bP_mutex[i],NULL);
-			if(bloom_init2(&bloom_bP[i],itemsbloom,0.000001)	== 1){
+			if(FLAGREADEDFILE1)	{	/* Mapped */
+				bloom_bP_totalbytes += bloom_bP[i].bytes;
+				continue;
+			}
+			/*
+				A false positive of the 1st filter only costs a second check, 1e-5 keeps the
+				blocked filter close to the size of the classic one
+			*/
+			if((FLAGBLOOMCLASSIC ? bloom_init2(&bloom_bP[i],itemsbloom,0.000001) : bloom_init_blocked(&bloom_bP[i],itemsbloom,0.00001)) == 1)	{
 				fprintf(stderr,"[E] error bloom_init _ %i\n",i);
 				exit(0);
 			}
 			bloom_bP_totalbytes += bloom_bP[i].bytes;
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP_totalbytes/(float)(uint64_t)1048576));
+		printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE1 ? ", mapped from file" : "");
 
 
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m2);
 		
-		bloom_bPx2nd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bPx2nd_mutex,__FILE__,"calloc","bloom_bPx2nd_mutex" ,__LINE__ -1 );
 		bloom_bPx2nd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx2nd,__FILE__,"calloc","bloom_bPx2nd" ,__LINE__ -1 );
 		bloom_bPx2nd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx2nd_checksums,__FILE__,"calloc","bloom_bPx2nd_checksums" ,__LINE__ -1 );
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_6_%" PRIu64 ".map",bsgs_m2);
+			FLAGREADEDFILE2 = bsgs_map_read(buffer_bloom_file,bloom_bPx2nd,bloom_bPx2nd_checksums);
+		}
 		bloom_bP2_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bPx2nd_mutex[i],NULL);
+			if(FLAGREADEDFILE2)	{	/* Mapped */
+				bloom_bP2_totalbytes += bloom_bPx2nd[i].bytes;
+				continue;
+			}
 			if(bloom_init2(&bloom_bPx2nd[i],itemsbloom2,0.000001)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ %i\n",i);
 				exit(0);
 			}
 			bloom_bP2_totalbytes += bloom_bPx2nd[i].bytes;
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576));
+		printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE2 ? ", mapped from file" : "");
 		
 
-		bloom_bPx3rd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-		checkpointer((void *)bloom_bPx3rd_mutex,__FILE__,"calloc","bloom_bPx3rd_mutex" ,__LINE__ -1 );
 		bloom_bPx3rd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx3rd,__FILE__,"calloc","bloom_bPx3rd" ,__LINE__ -1 );
 		bloom_bPx3rd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx3rd_checksums,__FILE__,"calloc","bloom_bPx3rd_checksums" ,__LINE__ -1 );
 		
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m3);
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_7_%" PRIu64 ".map",bsgs_m3);
+			FLAGREADEDFILE4 = bsgs_map_read(buffer_bloom_file,bloom_bPx3rd,bloom_bPx3rd_checksums);
+		}
 		bloom_bP3_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-			pthread_mutex_init(&bloom_bPx3rd_mutex[i],NULL);
+			if(FLAGREADEDFILE4)	{	/* Mapped */
+				bloom_bP3_totalbytes += bloom_bPx3rd[i].bytes;
+				continue;
+			}
 			if(bloom_init2(&bloom_bPx3rd[i],itemsbloom3,0.000001)	== 1){
 				fprintf(stderr,"[E] error bloom_init %i\n",i);
 				exit(0);
 			}
 			bloom_bP3_totalbytes += bloom_bPx3rd[i].bytes;
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP3_totalbytes/(float)(uint64_t)1048576));
+		printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP3_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE4 ? ", mapped from file" : "");
 
 
 
@@ -623,7 +731,7 @@ int main(int argc, char **argv)	{
 		BSGS_AMP2.reserve(32);
 		BSGS_AMP3.reserve(32);
 		
-		GSn.reserve(CPU_GRP_SIZE/2);
+		GSn.resize(CPU_GRP_SIZE/2);
 
 		i= 0;
 
@@ -633,20 +741,20 @@ int main(int argc, char **argv)	{
 		
 		Point bsP = secp->Negation(BSGS_MP_double);
 		Point g = bsP;
-		GSn[0] = g;
+		GSn[0].Set(&g);
 		
 
 		g = secp->DoubleDirect(g);
-		GSn[1] = g;
+		GSn[1].Set(&g);
 		
 		
 		for(int i = 2; i < CPU_GRP_SIZE / 2; i++) {
 			g = secp->AddDirect(g,bsP);
-			GSn[i] = g;
+			GSn[i].Set(&g);
 		}
 		
-		/* For next center point */
-		_2GSn = secp->DoubleDirect(GSn[CPU_GRP_SIZE / 2 - 1]);
+		/* For next center point, g is the last of GSn */
+		_2GSn = secp->DoubleDirect(g);
 		
 		
 		i = 0;
@@ -675,20 +783,29 @@ int main(int argc, char **argv)	{
 		}
 
 		bytes = (uint64_t)bsgs_m3 * (uint64_t) sizeof(struct bsgs_xvalue);
-		printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
-		
-		bPtable = (struct bsgs_xvalue*) malloc(bytes);
-		checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
-		memset(bPtable,0,bytes);
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".map",bsgs_m3);
+			FLAGREADEDFILE3 = bsgs_map_table_read(buffer_bloom_file,bsgs_m3);
+		}
+		if(!FLAGREADEDFILE3)	{
+			printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
+			bPtable = (struct bsgs_xvalue*) malloc(bytes);
+			checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
+			memset(bPtable,0,bytes);
+			if(FLAGMMAP)	{
+				FLAGREADEDFILE3 = FLAGUPDATEFILE3 = bsgs_table_convert(bsgs_m3);
+			}
+		}
 		
-		if(FLAGSAVEREADFILE)	{
+		if(FLAGSAVEREADFILE && !FLAGMMAP)	{
 			/*Reading file for 1st bloom filter */
 
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+			snprintf(buffer_bloom_file,1024,FLAGBLOOMCLASSIC ? "keyhunt_bsgs_4_%" PRIu64 ".blm" : "keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
 			fd_aux1 = fopen(buffer_bloom_file,"rb");
 			if(fd_aux1 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bP[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bP[i],sizeof(struct bloom),1,fd_aux1);
@@ -707,20 +824,14 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(0);
 					}
-					memset(rawvalue,0,32);
-					if(FLAGSKIPCHECKSUM == 0)	{
-						sha256((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bP_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bP_checksums[i].backup,rawvalue,32) != 0 )	{	/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(0);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,bloom_bP_checksums[i].data,bloom_bP_checksums[i].backup);
 					if(i % 64 == 0 )	{
 						printf(".");
 						fflush(stdout);
 					}
 				}
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				fclose(fd_aux1);
 				memset(buffer_bloom_file,0,1024);
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_3_%" PRIu64 ".blm",bsgs_m);
@@ -737,6 +848,7 @@ int main(int argc, char **argv)	{
 				if(fd_aux1 != NULL)	{
 					printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 					fflush(stdout);
+					bsgs_checksum_begin(buffer_bloom_file);
 					for(i = 0; i < 256;i++)	{
 						bf_ptr = (char*) bloom_bP[i].bf;	/*We need to save the current bf pointer*/
 						readed = fread(&oldbloom_bP,sizeof(struct oldbloom),1,fd_aux1);
@@ -756,20 +868,14 @@ int main(int argc, char **argv)	{
 						}
 						memcpy(bloom_bP_checksums[i].data,oldbloom_bP.checksum,32);
 						memcpy(bloom_bP_checksums[i].backup,oldbloom_bP.checksum_backup,32);
-						memset(rawvalue,0,32);
-						if(FLAGSKIPCHECKSUM == 0)	{
-							sha256((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)rawvalue);
-							if(memcmp(bloom_bP_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bP_checksums[i].backup,rawvalue,32) != 0 )	{	/* Verification */
-								fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-								exit(0);
-							}
-						}
+						bsgs_checksum_add((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,bloom_bP_checksums[i].data,bloom_bP_checksums[i].backup);
 						if(i % 32 == 0 )	{
 							printf(".");
 							fflush(stdout);
 						}
 					}
 					printf(" Done!\n");
+					bsgs_checksum_start();
 					fclose(fd_aux1);
 					FLAGUPDATEFILE1 = 1;	/* Flag to migrate the data to the new File keyhunt_bsgs_4_ */
 					FLAGREADEDFILE1 = 1;
@@ -787,6 +893,7 @@ int main(int argc, char **argv)	{
 			if(fd_aux2 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bPx2nd[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bPx2nd[i],sizeof(struct bloom),1,fd_aux2);
@@ -805,14 +912,7 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(0);
 					}
-					memset(rawvalue,0,32);
-					if(FLAGSKIPCHECKSUM == 0)	{
-						sha256((uint8_t*)bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bPx2nd_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bPx2nd_checksums[i].backup,rawvalue,32) != 0 )	{		/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(0);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,bloom_bPx2nd_checksums[i].data,bloom_bPx2nd_checksums[i].backup);
 					if(i % 64 == 0)	{
 						printf(".");
 						fflush(stdout);
@@ -820,6 +920,7 @@ int main(int argc, char **argv)	{
 				}
 				fclose(fd_aux2);
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				memset(buffer_bloom_file,0,1024);
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".blm",bsgs_m2);
 				fd_aux2 = fopen(buffer_bloom_file,"rb");
@@ -841,7 +942,7 @@ int main(int argc, char **argv)	{
 			}
 			
 			/*Reading file for bPtable */
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".tbl",bsgs_m3);
 			fd_aux3 = fopen(buffer_bloom_file,"rb");
 			if(fd_aux3 != NULL)	{
 				printf("[+] Reading bP Table from file %s .",buffer_bloom_file);
@@ -852,19 +953,15 @@ int main(int argc, char **argv)	{
 					exit(0);
 				}
 				rsize = fread(checksum,32,1,fd_aux3);
-				if(FLAGSKIPCHECKSUM == 0)	{
-					sha256((uint8_t*)bPtable,bytes,(uint8_t*)checksum_backup);
-					if(memcmp(checksum,checksum_backup,32) != 0)	{
-						fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-						exit(0);
-					}
-				}
+				bsgs_checksum_begin(buffer_bloom_file);
+				bsgs_checksum_add((uint8_t*)bPtable,bytes,checksum,NULL);
 				printf("... Done!\n");
+				bsgs_checksum_start();
 				fclose(fd_aux3);
 				FLAGREADEDFILE3 = 1;
 			}
 			else	{
-				FLAGREADEDFILE3 = 0;
+				FLAGREADEDFILE3 = FLAGUPDATEFILE3 = bsgs_table_convert(bsgs_m3);
 			}
 			
 			/*Reading file for 3rd bloom filter */
@@ -873,6 +970,7 @@ int main(int argc, char **argv)	{
 			if(fd_aux2 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bPx3rd[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bPx3rd[i],sizeof(struct bloom),1,fd_aux2);
@@ -891,14 +989,7 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(0);
 					}
-					memset(rawvalue,0,32);
-					if(FLAGSKIPCHECKSUM == 0)	{
-						sha256((uint8_t*)bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bPx3rd_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bPx3rd_checksums[i].backup,rawvalue,32) != 0 )	{		/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(0);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,bloom_bPx3rd_checksums[i].data,bloom_bPx3rd_checksums[i].backup);
 					if(i % 64 == 0)	{
 						printf(".");
 						fflush(stdout);
@@ -906,6 +997,7 @@ int main(int argc, char **argv)	{
 				}
 				fclose(fd_aux2);
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				FLAGREADEDFILE4 = 1;
 			}
 			else	{
@@ -913,6 +1005,7 @@ int main(int argc, char **argv)	{
 			}
 			
 		}
+		bsgs_checksum_end();	/* The verification of the last file read */
 		
 		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE3 || !FLAGREADEDFILE4)	{
 			if(FLAGREADEDFILE1 == 1)	{
@@ -1109,47 +1202,63 @@ int main(int argc, char **argv)	{
 			}
 		}
 		
-		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE4)	{
+		if(!FLAGREADEDFILE3)	{
+			printf("[+] Sorting %lu elements... ",bsgs_m3);
+			fflush(stdout);
+			bsgs_sort(bPtable,bsgs_m3);
+			printf("Done!\n");
+			fflush(stdout);
+		}
+		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE3 || !FLAGREADEDFILE4 || FLAGUPDATEFILE1 || FLAGUPDATEFILE3)	{
+			/* All the chunks of the new data are hashed by the NTHREADS threads */
 			printf("[+] Making checkums .. ");
 			fflush(stdout);
-		}	
-		if(!FLAGREADEDFILE1)	{
+			sha256_tree_batch_init(&checksum_batch[0],256 * 3 + 1,NTHREADS);
 			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bP[i].bf, bloom_bP[i].bytes,(uint8_t*) bloom_bP_checksums[i].data);
-				memcpy(bloom_bP_checksums[i].backup,bloom_bP_checksums[i].data,32);
+				if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
+					sha256_tree_batch_add(&checksum_batch[0],bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)bloom_bP_checksums[i].data,NULL);
+				}
+				if(!FLAGREADEDFILE2)	{
+					sha256_tree_batch_add(&checksum_batch[0],bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,(uint8_t*)bloom_bPx2nd_checksums[i].data,NULL);
+				}
+				if(!FLAGREADEDFILE4)	{
+					sha256_tree_batch_add(&checksum_batch[0],bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,(uint8_t*)bloom_bPx3rd_checksums[i].data,NULL);
+				}
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE2)	{
-			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bPx2nd[i].bf, bloom_bPx2nd[i].bytes,(uint8_t*) bloom_bPx2nd_checksums[i].data);
-				memcpy(bloom_bPx2nd_checksums[i].backup,bloom_bPx2nd_checksums[i].data,32);
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
+				sha256_tree_batch_add(&checksum_batch[0],(uint8_t*)bPtable,bytes,(uint8_t*)checksum,NULL);
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE4)	{
+			sha256_tree_batch_wait(&checksum_batch[0]);
 			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bPx3rd[i].bf, bloom_bPx3rd[i].bytes,(uint8_t*) bloom_bPx3rd_checksums[i].data);
+				memcpy(bloom_bP_checksums[i].backup,bloom_bP_checksums[i].data,32);
+				memcpy(bloom_bPx2nd_checksums[i].backup,bloom_bPx2nd_checksums[i].data,32);
 				memcpy(bloom_bPx3rd_checksums[i].backup,bloom_bPx3rd_checksums[i].data,32);
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE4)	{
-			printf(" done\n");
-			fflush(stdout);
-		}	
-		if(!FLAGREADEDFILE3)	{
-			printf("[+] Sorting %lu elements... ",bsgs_m3);
-			fflush(stdout);
-			bsgs_sort(bPtable,bsgs_m3);
-			sha256((uint8_t*)bPtable, bytes,(uint8_t*) checksum);
 			memcpy(checksum_backup,checksum,32);
-			printf("Done!\n");
+			printf("done\n");
 			fflush(stdout);
 		}
-		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
+		if(FLAGMMAP)	{
+			if(!FLAGREADEDFILE1)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".map",bsgs_m);
+				bsgs_map_write(buffer_bloom_file,bloom_bP,bloom_bP_checksums);
+			}
+			if(!FLAGREADEDFILE2)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_6_%" PRIu64 ".map",bsgs_m2);
+				bsgs_map_write(buffer_bloom_file,bloom_bPx2nd,bloom_bPx2nd_checksums);
+			}
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".map",bsgs_m3);
+				bsgs_map_table_write(buffer_bloom_file,bsgs_m3);
+			}
+			if(!FLAGREADEDFILE4)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_7_%" PRIu64 ".map",bsgs_m3);
+				bsgs_map_write(buffer_bloom_file,bloom_bPx3rd,bloom_bPx3rd_checksums);
+			}
+		}
+		else if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
 			if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+				snprintf(buffer_bloom_file,1024,FLAGBLOOMCLASSIC ? "keyhunt_bsgs_4_%" PRIu64 ".blm" : "keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
 				
 				if(FLAGUPDATEFILE1)	{
 					printf("[W] Updating old file into a new one\n");
@@ -1229,9 +1338,9 @@ int main(int argc, char **argv)	{
 				}
 			}
 			
-			if(!FLAGREADEDFILE3)	{
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
 				/* Writing file for bPtable */
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".tbl",bsgs_m3);
 				fd_aux3 = fopen(buffer_bloom_file,"wb");
 				if(fd_aux3 != NULL)	{
 					printf("[+] Writing bP Table to file %s .. ",buffer_bloom_file);
@@ -1293,6 +1402,7 @@ int main(int argc, char **argv)	{
 			}
 		}
 	}
+	bsgs_table_index();
 	/* 
 		Here we already finish the BSGS setup
 		- Baby table and bloom filters are alrady setup
@@ -1438,163 +1548,120 @@ char *publickeytohashrmd160(char *pkey,int length)	{
 }
 
 
-/*	OK	*/
-void bsgs_swap(struct bsgs_xvalue *a,struct bsgs_xvalue *b)	{
-	struct bsgs_xvalue t;
-	t	= *a;
-	*a =  *b;
-	*b =   t;
-}
-
-/*	OK	*/
+/* Only the BSGS_XVALUE_RAM bytes of the key are sorted, the index follows them */
 void bsgs_sort(struct bsgs_xvalue *arr,int64_t n)	{
-	uint32_t depthLimit = ((uint32_t) ceil(log(n))) * 2;
-	bsgs_introsort(arr,depthLimit,n);
+	radixsort(arr,n,sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM,NTHREADS);
 }
 
-/*	OK	*/
-void bsgs_introsort(struct bsgs_xvalue *arr,uint32_t depthLimit, int64_t n) {
-	int64_t p;
-	if(n > 1)	{
-		if(n <= 16) {
-			bsgs_insertionsort(arr,n);
-		}
-		else	{
-			if(depthLimit == 0) {
-				bsgs_myheapsort(arr,n);
-			}
-			else	{
-				p = bsgs_partition(arr,n);
-				if(p > 0) bsgs_introsort(arr , depthLimit-1 , p);
-				if(p < n) bsgs_introsort(&arr[p+1],depthLimit-1,n-(p+1));
-			}
-		}
-	}
-}
-
-/*	OK	*/
-void bsgs_insertionsort(struct bsgs_xvalue *arr, int64_t n) {
-	int64_t j;
-	int64_t i;
-	struct bsgs_xvalue key;
-	for(i = 1; i < n ; i++ ) {
-		key = arr[i];
-		j= i-1;
-		while(j >= 0 && memcmp(arr[j].value,key.value,BSGS_XVALUE_RAM) > 0) {
-			arr[j+1] = arr[j];
-			j--;
-		}
-		arr[j+1] = key;
+void bsgs_xvalue_set_index(struct bsgs_xvalue *xvalue,uint64_t index)	{
+	for(int i = 0; i < BSGS_XVALUE_INDEX; i++)	{
+		xvalue->index[i] = (uint8_t) (index >> (8 * i));
 	}
 }
 
-int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n)	{
-	struct bsgs_xvalue pivot;
-	int64_t r,left,right;
-	r = n/2;
-	pivot = arr[r];
-	left = 0;
-	right = n-1;
-	do {
-		while(left	< right && memcmp(arr[left].value,pivot.value,BSGS_XVALUE_RAM) <= 0 )	{
-			left++;
-		}
-		while(right >= left && memcmp(arr[right].value,pivot.value,BSGS_XVALUE_RAM) > 0)	{
-			right--;
-		}
-		if(left < right)	{
-			if(left == r || right == r)	{
-				if(left == r)	{
-					r = right;
-				}
-				if(right == r)	{
-					r = left;
-				}
-			}
-			bsgs_swap(&arr[right],&arr[left]);
-		}
-	}while(left < right);
-	if(right != r)	{
-		bsgs_swap(&arr[right],&arr[r]);
+uint64_t bsgs_xvalue_get_index(struct bsgs_xvalue *xvalue)	{
+	uint64_t index = 0;
+	for(int i = BSGS_XVALUE_INDEX - 1; i >= 0; i--)	{
+		index = (index << 8) | xvalue->index[i];
 	}
-	return right;
+	return index;
 }
 
-void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i) {
-	int64_t largest = i;
-	int64_t l = 2 * i + 1;
-	int64_t r = 2 * i + 2;
-	if (l < n && memcmp(arr[l].value,arr[largest].value,BSGS_XVALUE_RAM) > 0)
-		largest = l;
-	if (r < n && memcmp(arr[r].value,arr[largest].value,BSGS_XVALUE_RAM) > 0)
-		largest = r;
-	if (largest != i) {
-		bsgs_swap(&arr[i],&arr[largest]);
-		bsgs_heapify(arr, n, largest);
+/* The bytes 16 to 21 of the X value are searched with the bPtable_index directory */
+int bsgs_searchtable(char *data,uint64_t *r_value)	{
+	struct bsgs_xvalue *xvalue = (struct bsgs_xvalue*) addrindex_find(&bPtable_index,data+16);
+	if(xvalue == NULL)	{
+		return 0;
 	}
+	*r_value = bsgs_xvalue_get_index(xvalue);
+	return 1;
 }
 
-void bsgs_myheapsort(struct bsgs_xvalue	*arr, int64_t n)	{
-	int64_t i;
-	for ( i = (n / 2) - 1; i >=	0; i--)	{
-		bsgs_heapify(arr, n, i);
+/*
+	The directory has at least 2^16 prefixes of the sorted bP table and at
+	most 16 elements per prefix, the range of a lookup is 2 or 3 cache lines.
+*/
+void bsgs_table_index()	{
+	int bits = addrindex_bits(bsgs_m3,16);
+	if(bits < 16)	{
+		bits = 16;
 	}
-	for ( i = n - 1; i > 0; i--) {
-		bsgs_swap(&arr[0] , &arr[i]);
-		bsgs_heapify(arr, i, 0);
+	if(addrindex_init(&bPtable_index,bPtable,bsgs_m3,sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM,bits))	{
+		fprintf(stderr,"[E] error addrindex_init for %" PRIu64 " elements\n",bsgs_m3);
+		exit(EXIT_FAILURE);
 	}
+	printf("[+] bP Table index of %i bits: %.2f MB\n",bPtable_index.bits,(double)bPtable_index.bytes/(double)1048576);
 }
 
-int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length,uint64_t *r_value) {
-	int64_t min,max,half,current;
-	int r = 0,rcmp;
-	min = 0;
-	current = 0;
-	max = array_length;
-	half = array_length;
-	while(!r && half >= 1) {
-		half = (max - min)/2;
-		rcmp = memcmp(data+16,buffer[current+half].value,BSGS_XVALUE_RAM);
-		if(rcmp == 0)	{
-			*r_value = buffer[current+half].index;
-			r = 1;
+/*
+	Tables saved before the packed bsgs_xvalue, keyhunt_bsgs_2_ .tbl or .map
+	files, are mapped, verified and packed into bPtable, the caller saves the
+	new file. The .map files from --mmap are checked the same way.
+*/
+int bsgs_table_convert(uint64_t count)	{
+	struct bsgs_xvalue_legacy *legacy;
+	struct bsgs_map_header *header;
+	struct mapfile mf;
+	char filename[1024];
+	char *expected;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue_legacy),i;
+	for(int format = 0; format < 2; format++)	{
+		snprintf(filename,1024,format ? "keyhunt_bsgs_2_%" PRIu64 ".map" : "keyhunt_bsgs_2_%" PRIu64 ".tbl",count);
+		if(mapfile_open(&mf,filename,0) != 0)	{
+			continue;
 		}
-		else	{
-			if(rcmp < 0) {
-				max = (max-half);
+		if(format == 0)	{
+			if(mf.length != bytes + 32)	{
+				fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+				exit(EXIT_FAILURE);
 			}
-			else	{
-				min = (min+half);
+			legacy = (struct bsgs_xvalue_legacy*) mf.base;
+			expected = (char*) mf.base + bytes;
+		}
+		else	{
+			header = (struct bsgs_map_header*) mf.base;
+			if(mf.length < sizeof(struct bsgs_map_header) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != count || header->offset + bytes > mf.length)	{
+				fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+				exit(EXIT_FAILURE);
 			}
-			current = min;
+			legacy = (struct bsgs_xvalue_legacy*) (mf.base + header->offset);
+			expected = header->checksum.data;
 		}
+		bsgs_checksum_end();	/* The warnings of the previous file first */
+		printf("[+] Converting bP Table from file %s .",filename);
+		fflush(stdout);
+		bsgs_checksum_begin(filename);
+		bsgs_checksum_add((uint8_t*)legacy,bytes,expected,NULL);
+		bsgs_checksum_start();
+		bsgs_checksum_end();
+		for(i = 0; i < count; i++)	{
+			memcpy(bPtable[i].value,legacy[i].value,BSGS_XVALUE_RAM);
+			bsgs_xvalue_set_index(&bPtable[i],legacy[i].index);
+		}
+		mapfile_close(&mf);
+		printf(".. Done!\n");
+		printf("[W] The file %s can be deleted once the new one is saved\n",filename);
+		return 1;
 	}
-	return r;
+	return 0;
 }
 
 void *thread_process_bsgs(void *vargp)	{
 
 	FILE *filekey;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	char *aux_c,*hextemp;
+	unsigned char xpoints_raw[CPU_GRP_SIZE * 32];
+	uint8_t bloom_hits[CPU_GRP_SIZE];
 	Int base_key,keyfound;
 	Point base_point,point_aux,point_found;
 	uint32_t r, cycles;
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	
-	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Point point_candidate;
+	BatchStep<CPU_GRP_SIZE,false> *bstep = new BatchStep<CPU_GRP_SIZE,false>(&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
 
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
 	Int km,intaux;
-	Point pp;
-	Point pn;
-	grp->Set(dx);
 	
 
 	
@@ -1676,101 +1743,14 @@ void *thread_process_bsgs(void *vargp)	{
 			
 			uint32_t j = 0;
 			while( j < cycles && bsgs_found == 0 )	{
-			
-				int i;
-				
-				for(i = 0; i < hLength; i++) {
-					dx[i].ModSub(&GSn[i].x,&startP.x);
-				}
-				dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-				dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-
-				// Grouped ModInv
-				grp->ModInv();
-				
-				/*
-				We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-				We compute key in the positive and negative way from the center of the group
-				*/
-
-				// center point
-				pts[CPU_GRP_SIZE / 2] = startP;
-				
-				for(i = 0; i<hLength; i++) {
-
-					pp = startP;
-					pn = startP;
-
-					// P = startP + i*G
-					dy.ModSub(&GSn[i].y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-					
-#if 0 /* For this BSGS we don't neet to calculate the Y value of intermediate points */
-pp.y.ModSub(&GSn[i].x,&pp.x);
-pp.y.ModMulK1(&_s);
-pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-					// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0	/* For this BSGS we don't neet to calculate the Y value of intermediate points */
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-					pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-					pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
-				}
-
-				// First point (startP - (GRP_SZIE/2)*G)
-				pn = startP;
-				dyn.Set(&GSn[i].y);
-				dyn.ModNeg();
-				dyn.ModSub(&pn.y);
-
-				_s.ModMulK1(&dyn,&dx[i]);
-				_p.ModSquareK1(&_s);
-
-				pn.x.ModNeg();
-				pn.x.ModAdd(&_p);
-				pn.x.ModSub(&GSn[i].x);
-
-
-#if 0 /* For this BSGS we don't neet to calculate the Y value of intermediate points */
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-				pts[0] = pn;
+				bstep->Step(&startP);
+				bsgs_bloom_check_group(pts,CPU_GRP_SIZE,xpoints_raw,bloom_hits);
 				
 				for(int i = 0; i<CPU_GRP_SIZE && bsgs_found == 0; i++) {
 					
-					pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-					
-					r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-					
-					if(r) {
-						r = bsgs_secondcheck(&base_key,((j*1024) + i),&keyfound);
+					if(bloom_hits[i]) {
+						point_candidate = bstep->Recover(i);
+						r = bsgs_secondcheck(&base_key,((j*1024) + i),&point_candidate,&keyfound);
 						if(r)	{
 							hextemp = keyfound.GetBase16();
 							printf("[+] Thread Key found privkey %s   \n",hextemp);
@@ -1796,139 +1776,150 @@ pn.y.ModAdd(&GSn[i].y);
 					
 				}// For for pts variable
 				
-				// Next start point (startP += (bsSize*GRP_SIZE).G)
-				
-				pp = startP;
-				dy.ModSub(&_2GSn.y,&pp.y);
-
-				_s.ModMulK1(&dy,&dx[i + 1]);
-				_p.ModSquareK1(&_s);
-
-				pp.x.ModNeg();
-				pp.x.ModAdd(&_p);
-				pp.x.ModSub(&_2GSn.x);
-				
-				
-				/* For this BSGS we only need to calculate the Y value of  the next start point  */
-
-				pp.y.ModSub(&_2GSn.x,&pp.x);
-				pp.y.ModMulK1(&_s);
-				pp.y.ModSub(&_2GSn.y);
-				startP = pp;
 				
 				j++;
 			} //while all the aMP points
 		} // end else
 	}while(base_key.IsLower(&n_range_end) && bsgs_found == 0);
-	delete grp;
+	delete bstep;
 	pthread_exit(NULL);
 }
 
 /*
 	The bsgs_secondcheck function is made to perform a second BSGS search in a Range of less size.
 	This funtion is made with the especific purpouse to USE a smaller bPtable in RAM.
+	candidate is the full giant step point that hit the first bloom filter,
+	Q - (start_range + a*BSGS_M_double + BSGS_M)*G, see BatchStep::Recover
 */
-int bsgs_secondcheck(Int *start_range,uint32_t a,Int *privatekey)	{
+/*
+	First bsgs check for the whole group: x of each point as 32 bytes and one
+	batched lookup in bloom_bP, the probes of the group are prefetched together
+*/
+void bsgs_bloom_check_group(AffinePoint *pts,int n,unsigned char *xpoints_raw,uint8_t *bloom_hits)	{
+	for(int i = 0; i < n; i++)	{
+		pts[i].x.Get32Bytes(xpoints_raw + (i * 32));
+	}
+	bloom_check_batch_split(bloom_bP,xpoints_raw,32,32,n,bloom_hits);
+}
+
+int bsgs_secondcheck(Int *start_range,uint32_t a,Point *candidate,Int *privatekey)	{
 	int i = 0,found = 0,r = 0;
 	Int base_key;
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_S,BSGS_Q_AMP[32];
 	char xpoint_raw[32];
-	
+
+
 	base_key.Set(&BSGS_M_double);
 	base_key.Mult((uint64_t) a);
 	base_key.Add(start_range);
 
-	base_point = secp->ComputePublicKey(&base_key);
-	point_aux = secp->Negation(base_point);
 	/*
 		BSGS_S = Q - base_key
 				 Q is the target Key
 		base_key is the Start range + a*BSGS_M
+		so BSGS_S = candidate + BSGS_MP, AddDirect can't double so that case goes by base_key
 	*/
-	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
-	BSGS_Q.Set(BSGS_S);
+	if(candidate->x.IsEqual(&BSGS_MP.x))	{
+		base_point = secp->ComputePublicKey(&base_key);
+		point_aux = secp->Negation(base_point);
+		BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
+	}
+	else	{
+		BSGS_S = secp->AddDirect(*candidate,BSGS_MP);
+	}
+	/* The 32 points BSGS_S + BSGS_AMP2[i] with a single inversion */
+	secp->AddDirect(BSGS_S,&BSGS_AMP2[0],32,BSGS_Q_AMP);
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP2[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *) xpoint_raw);
-		
-		r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
-
-		if(r)	{
-			found = bsgs_thirdcheck(&base_key,i,privatekey);
+		if(!BSGS_Q_AMP[i].z.IsZero())	{
+			BSGS_Q_AMP[i].x.Get32Bytes((unsigned char *) xpoint_raw);
+			r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
+			if(r)	{
+				found = bsgs_thirdcheck(&base_key,i,&BSGS_Q_AMP[i],privatekey);
+			}
 		}
 		i++;
 	}while(i < 32 && !found);
 	return found;
 }
 
-int bsgs_thirdcheck(Int *start_range,uint32_t a,Int *privatekey)	{
+/*
+	candidate is the second check point that hit its bloom filter,
+	Q - (start_range + a*BSGS_M2_double + BSGS_M2)*G
+*/
+int bsgs_thirdcheck(Int *start_range,uint32_t a,Point *candidate,Int *privatekey)	{
 	uint64_t j = 0;
 	int i = 0,found = 0,r = 0;
 	Int base_key,calculatedkey;
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_S,BSGS_Q_AMP[32];
 	char xpoint_raw[32];
 
 	base_key.SetInt32(a);
 	base_key.Mult(&BSGS_M2_double);
 	base_key.Add(start_range);
 
-	base_point = secp->ComputePublicKey(&base_key);
-	point_aux = secp->Negation(base_point);
-	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
-	BSGS_Q.Set(BSGS_S);
+	if(candidate->x.IsEqual(&BSGS_MP2.x))	{
+		base_point = secp->ComputePublicKey(&base_key);
+		point_aux = secp->Negation(base_point);
+		BSGS_S = secp->AddDirect(OriginalPointsBSGS,point_aux);
+	}
+	else	{
+		BSGS_S = secp->AddDirect(*candidate,BSGS_MP2);
+	}
+	secp->AddDirect(BSGS_S,&BSGS_AMP3[0],32,BSGS_Q_AMP);
 	
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP3[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *)xpoint_raw);
-		r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
-		if(r)	{
-			r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
+		if(!BSGS_Q_AMP[i].z.IsZero())	{
+			BSGS_Q_AMP[i].x.Get32Bytes((unsigned char *)xpoint_raw);
+			r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
 			if(r)	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add((uint64_t)(j+1));
-				privatekey->Add(&base_key);
-				
-				point_aux = secp->ComputePublicKey(privatekey);
-				
-				if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
-					found = 1;
-				}
-				else	{
+				r = bsgs_searchtable(xpoint_raw,&j);
+				if(r)	{
 					calcualteindex(i,&calculatedkey);
 					privatekey->Set(&calculatedkey);
-					privatekey->Sub((uint64_t)(j+1));
+					privatekey->Add((uint64_t)(j+1));
 					privatekey->Add(&base_key);
-					
 					point_aux = secp->ComputePublicKey(privatekey);
 					if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
 						found = 1;
 					}
+					else	{
+						calcualteindex(i,&calculatedkey);
+						privatekey->Set(&calculatedkey);
+						privatekey->Sub((uint64_t)(j+1));
+						privatekey->Add(&base_key);
+						point_aux = secp->ComputePublicKey(privatekey);
+						if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
+							found = 1;
+						}
+					}
 				}
 			}
 		}
 		else	{
 			/*
-				For some reason the AddDirect don't return 000000... value when the publickeys are the negated values from each other
-				Why JLP?
-				This is is an special case
+				BSGS_S and BSGS_AMP3[i] have the same x so BSGS_S is +/- the
+				index point, AddDirect can't handle it, check both keys here
 			*/
-			if(BSGS_Q.x.IsEqual(&BSGS_AMP3[i].x))	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add(&base_key);
+			calcualteindex(i,&calculatedkey);
+			privatekey->Set(&base_key);
+			privatekey->Add(&calculatedkey);
+			point_aux = secp->ComputePublicKey(privatekey);
+			if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
 				found = 1;
 			}
+			else	{
+				privatekey->Set(&base_key);
+				privatekey->Sub(&calculatedkey);
+				point_aux = secp->ComputePublicKey(privatekey);
+				if(point_aux.x.IsEqual(&OriginalPointsBSGS.x))	{
+					found = 1;
+				}
+			}
 		}
 		i++;
 	}while(i < 32 && !found);
-
 	return found;
 }
 
@@ -1960,20 +1951,51 @@ void sleep_ms(int milliseconds)	{ // cross-platform sleep function
 }
 
 
+/*
+	Insert the group of bP points i_counter .. i_counter+n-1: bPtable and the 3rd
+	bloom filter take the first bsgs_m3 points, the 2nd one the first bsgs_m2
+	and the 1st one every point below to. The filters are shared by all the
+	threads, the adds set their bits with atomic operations instead of locks.
+*/
+void bsgs_bP_add_group(AffinePoint *pts,int n,uint64_t i_counter,uint64_t to,unsigned char *xpoints_raw)	{
+	uint64_t n1,n2,n3,j;
+	for(j = 0; j < (uint64_t)n; j++)	{
+		pts[j].x.Get32Bytes(xpoints_raw + (j * 32));
+	}
+	n3 = (i_counter < bsgs_m3) ? bsgs_m3 - i_counter : 0;
+	n2 = (i_counter < bsgs_m2) ? bsgs_m2 - i_counter : 0;
+	n1 = (i_counter < to) ? to - i_counter : 0;
+	n3 = (n3 < (uint64_t)n) ? n3 : n;
+	n2 = (n2 < (uint64_t)n) ? n2 : n;
+	n1 = (n1 < (uint64_t)n) ? n1 : n;
+	if(!FLAGREADEDFILE3)	{
+		for(j = 0; j < n3; j++)	{
+			memcpy(bPtable[i_counter + j].value,xpoints_raw + (j * 32) + 16,BSGS_XVALUE_RAM);
+			bsgs_xvalue_set_index(&bPtable[i_counter + j],i_counter + j);
+		}
+	}
+	if(!FLAGREADEDFILE4)	{
+		bloom_add_concurrent_batch_split(bloom_bPx3rd,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n3);
+	}
+	if(!FLAGREADEDFILE2)	{
+		bloom_add_concurrent_batch_split(bloom_bPx2nd,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n2);
+	}
+	if(!FLAGREADEDFILE1)	{
+		bloom_add_concurrent_batch_split(bloom_bP,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n1);
+	}
+}
+
 void *thread_bPload(void *vargp)	{
 
-	char rawvalue[32];
+	unsigned char xpoints_raw[CPU_GRP_SIZE * 32];
 	struct bPload *tt;
-	uint64_t i_counter,j,nbStep,to;
+	uint64_t i_counter,nbStep,to;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
+	BatchStep<CPU_GRP_SIZE,false> *bstep = new BatchStep<CPU_GRP_SIZE,false>(&Gn[0],&_2Gn);
+	AffinePoint *pts = bstep->pts;
 	
-	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
+	int threadid;
 	tt = (struct bPload *)vargp;
 	Int km((uint64_t)(tt->from + 1));
 	threadid = tt->threadid;
@@ -1990,128 +2012,12 @@ void *thread_bPload(void *vargp)	{
 	
 	km.Add((uint64_t)(CPU_GRP_SIZE / 2));
 	startP = secp->ComputePublicKey(&km);
-	grp->Set(dx);
 	for(uint64_t s=0;s<nbStep;s++) {
-		for(i = 0; i < hLength; i++) {
-			dx[i].ModSub(&Gn[i].x,&startP.x);
-		}
-		dx[i].ModSub(&Gn[i].x,&startP.x); // For the first point
-		dx[i + 1].ModSub(&_2Gn.x,&startP.x);// For the next center point
-		// Grouped ModInv
-		grp->ModInv();
-
-		// We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-		// We compute key in the positive and negative way from the center of the group
-		// center point
-		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
-
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
-
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-		}
-
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
-
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
-#endif
-
-		pts[0] = pn;
-		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
-			bloom_bP_index = (uint8_t)rawvalue[0];
-
-			if(i_counter < bsgs_m3)	{
-				if(!FLAGREADEDFILE3)	{
-					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
-				}
-				if(!FLAGREADEDFILE4)	{
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-				}
-			}
-			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-			}
-			if(i_counter < to && !FLAGREADEDFILE1 )	{
-				pthread_mutex_lock(&bloom_bP_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bP_mutex[bloom_bP_index]);
-			}
-			i_counter++;
-		}
-		// Next start point (startP + GRP_SIZE*G)
-		pp = startP;
-		dy.ModSub(&_2Gn.y,&pp.y);
-
-		_s.ModMulK1(&dy,&dx[i + 1]);
-		_p.ModSquareK1(&_s);
-
-		pp.x.ModNeg();
-		pp.x.ModAdd(&_p);
-		pp.x.ModSub(&_2Gn.x);
-
-		pp.y.ModSub(&_2Gn.x,&pp.x);
-		pp.y.ModMulK1(&_s);
-		pp.y.ModSub(&_2Gn.y);
-		startP = pp;
+		bstep->Step(&startP);
+		bsgs_bP_add_group(pts,CPU_GRP_SIZE,i_counter,to,xpoints_raw);
+		i_counter += CPU_GRP_SIZE;
 	}
-	delete grp;
+	delete bstep;
 	pthread_mutex_lock(&bPload_mutex[threadid]);
 	tt->finished = 1;
 	pthread_mutex_unlock(&bPload_mutex[threadid]);
@@ -2120,16 +2026,13 @@ void *thread_bPload(void *vargp)	{
 }
 
 void *thread_bPload_2blooms(void *vargp)	{
-	char rawvalue[32];
+	unsigned char xpoints_raw[CPU_GRP_SIZE * 32];
 	struct bPload *tt;
-	uint64_t i_counter,j,nbStep;
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	uint64_t i_counter,nbStep;
 	Point startP;
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
-	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
+	BatchStep<CPU_GRP_SIZE,false> *bstep = new BatchStep<CPU_GRP_SIZE,false>(&Gn[0],&_2Gn);
+	AffinePoint *pts = bstep->pts;
+	int threadid;
 	tt = (struct bPload *)vargp;
 	Int km((uint64_t)(tt->from +1 ));
 	threadid = tt->threadid;
@@ -2144,129 +2047,212 @@ void *thread_bPload_2blooms(void *vargp)	{
 	
 	km.Add((uint64_t)(CPU_GRP_SIZE / 2));
 	startP = secp->ComputePublicKey(&km);
-	grp->Set(dx);
 	for(uint64_t s=0;s<nbStep;s++) {
-		for(i = 0; i < hLength; i++) {
-			dx[i].ModSub(&Gn[i].x,&startP.x);
-		}
-		dx[i].ModSub(&Gn[i].x,&startP.x); // For the first point
-		dx[i + 1].ModSub(&_2Gn.x,&startP.x);// For the next center point
-		// Grouped ModInv
-		grp->ModInv();
-
-		// We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-		// We compute key in the positive and negative way from the center of the group
-		// center point
-		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
-
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
+		bstep->Step(&startP);
+		bsgs_bP_add_group(pts,CPU_GRP_SIZE,i_counter,0,xpoints_raw);
+		i_counter += CPU_GRP_SIZE;
+	}
+	delete bstep;
+	pthread_mutex_lock(&bPload_mutex[threadid]);
+	tt->finished = 1;
+	pthread_mutex_unlock(&bPload_mutex[threadid]);
+	pthread_exit(NULL);
+	return NULL;
+}
 
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
 
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
+/*
+	The checksums of a file are verified by the NTHREADS threads while the next
+	file is read: bsgs_checksum_start() waits for the previous file and starts
+	the current one, bsgs_checksum_end() waits for the last one
+*/
+void bsgs_checksum_begin(const char *filename)	{
+	snprintf(checksum_batch_file[checksum_batch_current],1024,"%s",filename);
+	sha256_tree_batch_init(&checksum_batch[checksum_batch_current],256,NTHREADS);
+}
 
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
+void bsgs_checksum_add(uint8_t *data,uint64_t bytes,char *expected,char *backup)	{
+	if(FLAGSKIPCHECKSUM)	{
+		return;
+	}
+	if(backup != NULL && memcmp(expected,backup,32) != 0)	{
+		fprintf(stderr,"[E] Error checksum file mismatch! %s\n",checksum_batch_file[checksum_batch_current]);
+		exit(EXIT_FAILURE);
+	}
+	sha256_tree_batch_add(&checksum_batch[checksum_batch_current],data,bytes,NULL,(uint8_t*)expected);
+}
 
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
+void bsgs_checksum_start()	{
+	bsgs_checksum_end();
+	sha256_tree_batch_start(&checksum_batch[checksum_batch_current]);
+	checksum_batch_current ^= 1;
+}
 
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-#endif
+void bsgs_checksum_end()	{
+	int previous = checksum_batch_current ^ 1;
+	if(checksum_batch[previous].jobs == NULL)	{
+		return;
+	}
+	if(sha256_tree_batch_wait(&checksum_batch[previous]) != 0)	{
+		fprintf(stderr,"[E] Error checksum file mismatch! %s\n",checksum_batch_file[previous]);
+		exit(EXIT_FAILURE);
+	}
+	if(checksum_batch[previous].legacy)	{
+		printf("[W] The file %s has the checksums of a previous version, delete it to save it again\n",checksum_batch_file[previous]);
+	}
+}
 
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
+/*
+	The mapping is kept until the process ends, bf points into it
+	Return 0 if the file doesn't exist, the caller prints the sizes
+*/
+int bsgs_map_read(const char *filename,struct bloom *blooms,struct checksumsha256 *checksums)	{
+	struct mapfile mf;
+	struct bsgs_map_header *header;
+	struct bsgs_map_entry *entries;
+	uint64_t bytes;
+	uint8_t *data;
+	int r;
+	r = mapfile_open(&mf,filename,mmap_flags);
+	if(r == -1)	{
+		return 0;
+	}
+	if(r != 0)	{
+		fprintf(stderr,"[E] Error can't map the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	header = (struct bsgs_map_header*) mf.base;
+	entries = (struct bsgs_map_entry*) (mf.base + sizeof(struct bsgs_map_header));
+	if(mf.length < sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != 256)	{
+		fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	bsgs_checksum_begin(filename);
+	for(int i = 0; i < 256; i++)	{
+		memcpy(&blooms[i],&entries[i].filter.bloom,sizeof(struct bloom));
+		bytes = blooms[i].bytes;
+		if(entries[i].offset % MAPFILE_ALIGN != 0 || entries[i].offset + bytes > mf.length)	{
+			fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
 		}
+		data = mf.base + entries[i].offset;
+		blooms[i].bf = data;
+		memcpy(&checksums[i],&entries[i].checksum,sizeof(struct checksumsha256));
+		bsgs_checksum_add(data,bytes,checksums[i].data,checksums[i].backup);
+	}
+	bsgs_checksum_start();	/* The first accesses to the mapping run in parallel */
+	return 1;
+}
 
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
-
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
-#endif
-
-		pts[0] = pn;
-		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
-			bloom_bP_index = (uint8_t)rawvalue[0];
-			if(i_counter < bsgs_m3)	{
-				if(!FLAGREADEDFILE3)	{
-					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
-				}
-				if(!FLAGREADEDFILE4)	{
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-				}
-			}
-			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-			}
-			i_counter++;
+void bsgs_map_write(const char *filename,struct bloom *blooms,struct checksumsha256 *checksums)	{
+	struct bsgs_map_header header;
+	struct bsgs_map_entry *entries;
+	uint64_t offset,bytes;
+	FILE *fd;
+	uint8_t *data;
+	int i;
+	entries = (struct bsgs_map_entry*) calloc(256,sizeof(struct bsgs_map_entry));
+	checkpointer((void *)entries,__FILE__,"calloc","entries" ,__LINE__ -1 );
+	memset(&header,0,sizeof(struct bsgs_map_header));
+	memcpy(header.magic,BSGS_MAP_MAGIC,8);
+	header.count = 256;
+	offset = mapfile_align(sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry));
+	for(i = 0; i < 256; i++)	{
+		memcpy(&entries[i].filter.bloom,&blooms[i],sizeof(struct bloom));
+		bytes = blooms[i].bytes;
+		memcpy(&entries[i].checksum,&checksums[i],sizeof(struct checksumsha256));
+		entries[i].offset = offset;
+		offset = mapfile_align(offset + bytes);
+	}
+	fd = fopen(filename,"wb");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Writing bloom filter to file %s ",filename);
+	fflush(stdout);
+	if(fwrite(&header,sizeof(struct bsgs_map_header),1,fd) != 1 || fwrite(entries,sizeof(struct bsgs_map_entry),256,fd) != 256)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	offset = sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry);
+	for(i = 0; i < 256; i++)	{
+		data = blooms[i].bf;
+		bytes = blooms[i].bytes;
+		offset = mapfile_pad(fd,offset);
+		if(offset != entries[i].offset || fwrite(data,bytes,1,fd) != 1)	{
+			fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
 		}
-		// Next start point (startP + GRP_SIZE*G)
-		pp = startP;
-		dy.ModSub(&_2Gn.y,&pp.y);
-
-		_s.ModMulK1(&dy,&dx[i + 1]);
-		_p.ModSquareK1(&_s);
-
-		pp.x.ModNeg();
-		pp.x.ModAdd(&_p);
-		pp.x.ModSub(&_2Gn.x);
+		offset += bytes;
+		if(i % 64 == 0)	{
+			printf(".");
+			fflush(stdout);
+		}
+	}
+	if(mapfile_pad(fd,offset) == 0)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf(" Done!\n");
+	fclose(fd);
+	free(entries);
+}
 
-		pp.y.ModSub(&_2Gn.x,&pp.x);
-		pp.y.ModMulK1(&_s);
-		pp.y.ModSub(&_2Gn.y);
-		startP = pp;
+/* Same as bsgs_map_read for the bP table, bPtable points into the mapping */
+int bsgs_map_table_read(const char *filename,uint64_t count)	{
+	struct mapfile mf;
+	struct bsgs_map_header *header;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue);
+	int r;
+	r = mapfile_open(&mf,filename,mmap_flags);
+	if(r == -1)	{
+		return 0;
 	}
-	delete grp;
-	pthread_mutex_lock(&bPload_mutex[threadid]);
-	tt->finished = 1;
-	pthread_mutex_unlock(&bPload_mutex[threadid]);
-	pthread_exit(NULL);
-	return NULL;
+	if(r != 0)	{
+		fprintf(stderr,"[E] Error can't map the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	header = (struct bsgs_map_header*) mf.base;
+	if(mf.length < sizeof(struct bsgs_map_header) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != count || header->offset % MAPFILE_ALIGN != 0 || header->offset + bytes > mf.length)	{
+		fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Mapping bP Table from file %s .",filename);
+	fflush(stdout);
+	bPtable = (struct bsgs_xvalue*) (mf.base + header->offset);
+	memcpy(checksum,header->checksum.data,32);
+	bsgs_checksum_begin(filename);
+	bsgs_checksum_add((uint8_t*)bPtable,bytes,checksum,NULL);
+	printf("... Done!\n");
+	bsgs_checksum_start();
+	return 1;
 }
 
+void bsgs_map_table_write(const char *filename,uint64_t count)	{
+	struct bsgs_map_header header;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue);
+	FILE *fd;
+	memset(&header,0,sizeof(struct bsgs_map_header));
+	memcpy(header.magic,BSGS_MAP_MAGIC,8);
+	header.count = count;
+	header.offset = mapfile_align(sizeof(struct bsgs_map_header));
+	memcpy(header.checksum.data,checksum,32);
+	memcpy(header.checksum.backup,checksum,32);
+	fd = fopen(filename,"wb");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Writing bP Table to file %s .. ",filename);
+	fflush(stdout);
+	if(fwrite(&header,sizeof(struct bsgs_map_header),1,fd) != 1 || mapfile_pad(fd,sizeof(struct bsgs_map_header)) != header.offset || fwrite(bPtable,bytes,1,fd) != 1 || mapfile_pad(fd,header.offset + bytes) == 0)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("Done!\n");
+	fclose(fd);
+}
 
 /* This function takes in two parameters:
 
@@ -2286,6 +2272,9 @@ void menu() {
 	printf("-t tn       Threads number, must be a positive integer\n");
 	printf("-p port     TCP port Number for listening conections");
 	printf("-i ip		IP Address for listening conections");
+	printf("--mmap      Save the BSGS data in page aligned .map files and map them read-only, the processes share them\n");
+	printf("--mmap-populate  Same as --mmap, read the whole files when they are mapped\n");
+	printf("--mmap-huge      Same as --mmap, ask for transparent huge pages on the mapped files\n");
 	printf("\nExample:\n\n");
 	printf("./bsgs -k 512 \n\n");
 	exit(EXIT_FAILURE);
@@ -2330,15 +2319,16 @@ void init_generator()	{
 	Point G = secp->ComputePublicKey(&stride);
 	Point g;
 	g.Set(G);
-	Gn.reserve(CPU_GRP_SIZE / 2);
-	Gn[0] = g;
+	Gn.resize(CPU_GRP_SIZE / 2);
+	Gn[0].Set(&g);
 	g = secp->DoubleDirect(g);
-	Gn[1] = g;
+	Gn[1].Set(&g);
 	for(int i = 2; i < CPU_GRP_SIZE / 2; i++) {
 		g = secp->AddDirect(g,G);
-		Gn[i] = g;
+		Gn[i].Set(&g);
 	}
-	_2Gn = secp->DoubleDirect(Gn[CPU_GRP_SIZE / 2 - 1]);
+	/* g is the last of Gn */
+	_2Gn = secp->DoubleDirect(g);
 }
 
 void* client_handler(void* arg) {
@@ -2465,4 +2455,4 @@ int sendstr(int client_fd,const char *str)	{
 		printf("Failed to send message to client\n");
 	}
 	return bytes;
-}
\ No newline at end of file
+}
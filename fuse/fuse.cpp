@@ -0,0 +1,254 @@
+/*
+ * Refer to fuse.h for documentation on the public interfaces.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "fuse.h"
+#include "../xxhash/xxhash.h"
+
+#define FUSE_ARITY 3
+#define FUSE_MAX_SEGMENT_LENGTH 262144
+#define FUSE_MAX_ATTEMPTS 100
+#define FUSE_BATCH 32
+
+static inline uint64_t fuse_mix(uint64_t key, uint64_t seed)
+{
+  uint64_t h = key + seed;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static inline uint64_t fuse_mulhi(uint64_t a, uint64_t b)
+{
+  return (uint64_t)(((unsigned __int128)a * b) >> 64);
+}
+
+static inline uint16_t fuse_fingerprint(uint64_t hash)
+{
+  return (uint16_t)(hash ^ (hash >> 32));
+}
+
+// The 3 positions of a hash: one in each of 3 consecutive segments
+static inline void fuse_positions(struct fuse16 * fuse, uint64_t hash, uint32_t * h)
+{
+  h[0] = (uint32_t)fuse_mulhi(hash, fuse->segment_count_length);
+  h[1] = h[0] + fuse->segment_length;
+  h[2] = h[1] + fuse->segment_length;
+  h[1] ^= (uint32_t)(hash >> 18) & fuse->segment_length_mask;
+  h[2] ^= (uint32_t)hash & fuse->segment_length_mask;
+}
+
+// Sizes from the paper for 3-wise binary fuse filters
+static int fuse_size(struct fuse16 * fuse, uint64_t n)
+{
+  uint64_t capacity, segment_count, array_length;
+  double size_factor;
+
+  if (n < 2) {
+    n = 2;
+  }
+  fuse->segment_length = 1U << (int)floor(log((double)n) / log(3.33) + 2.25);
+  if (fuse->segment_length > FUSE_MAX_SEGMENT_LENGTH) {
+    fuse->segment_length = FUSE_MAX_SEGMENT_LENGTH;
+  }
+  fuse->segment_length_mask = fuse->segment_length - 1;
+  size_factor = 0.875 + 0.25 * log(1000000.0) / log((double)n);
+  if (size_factor < 1.125) {
+    size_factor = 1.125;
+  }
+  capacity = (uint64_t)round((double)n * size_factor);
+  segment_count = (capacity + fuse->segment_length - 1) / fuse->segment_length;
+  segment_count = (segment_count <= FUSE_ARITY - 1) ? 1 : segment_count - (FUSE_ARITY - 1);
+  array_length = (segment_count + FUSE_ARITY - 1) * fuse->segment_length;
+  if (array_length >> 32) {
+    return 1;
+  }
+  fuse->array_length = (uint32_t)array_length;
+  fuse->segment_count_length = (uint32_t)(segment_count * fuse->segment_length);
+  fuse->bytes = array_length * sizeof(uint16_t);
+  return 0;
+}
+
+static int fuse_cmp(const void * a, const void * b)
+{
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+uint64_t fuse16_key(const void * buffer, int len)
+{
+  return XXH64(buffer, len, 0x59f2815b16f81798);
+}
+
+int fuse16_build(struct fuse16 * fuse, uint64_t * keys, uint64_t n)
+{
+  uint8_t *t2count = NULL;
+  uint64_t *t2hash = NULL;
+  uint32_t *alone = NULL;
+  uint64_t *reverse_order = NULL;
+  uint8_t *reverse_h = NULL;
+  uint32_t h[FUSE_ARITY * 2 - 1];
+  uint64_t i, hash, stacksize = 0;
+  uint32_t queue, index, other;
+  uint8_t found;
+  int attempt, k, rv = 1;
+
+  memset(fuse, 0, sizeof(struct fuse16));
+  if (fuse_size(fuse, n)) {
+    return 1;
+  }
+  fuse->entries = n;
+  fuse->fingerprints = (uint16_t *)calloc(fuse->array_length, sizeof(uint16_t));
+  t2count = (uint8_t *)malloc(fuse->array_length);
+  t2hash = (uint64_t *)malloc((uint64_t)fuse->array_length * sizeof(uint64_t));
+  alone = (uint32_t *)malloc((uint64_t)fuse->array_length * sizeof(uint32_t));
+  reverse_order = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+  reverse_h = (uint8_t *)malloc(n + 1);
+  if (fuse->fingerprints == NULL || t2count == NULL || t2hash == NULL || alone == NULL || reverse_order == NULL || reverse_h == NULL) {
+    goto build_end;
+  }
+
+  for (attempt = 0; attempt < FUSE_MAX_ATTEMPTS; attempt++) {
+    fuse->seed = fuse_mix(attempt, 0x9e3779b97f4a7c15ULL);
+    memset(t2count, 0, fuse->array_length);
+    memset(t2hash, 0, (uint64_t)fuse->array_length * sizeof(uint64_t));
+
+    // Each slot keeps the count of its keys (<< 2), the xor of their position index and of their hashes
+    for (i = 0; i < n; i++) {
+      hash = fuse_mix(keys[i], fuse->seed);
+      fuse_positions(fuse, hash, h);
+      for (k = 0; k < FUSE_ARITY; k++) {
+        t2count[h[k]] += 4;
+        t2count[h[k]] ^= k;
+        t2hash[h[k]] ^= hash;
+      }
+    }
+
+    // Peel the slots with a single key, last peeled keys are assigned first
+    queue = 0;
+    for (index = 0; index < fuse->array_length; index++) {
+      alone[queue] = index;
+      queue += ((t2count[index] >> 2) == 1);
+    }
+    stacksize = 0;
+    while (queue > 0) {
+      index = alone[--queue];
+      if ((t2count[index] >> 2) == 1) {
+        hash = t2hash[index];
+        found = t2count[index] & 3;
+        reverse_h[stacksize] = found;
+        reverse_order[stacksize] = hash;
+        stacksize++;
+        fuse_positions(fuse, hash, h);
+        h[3] = h[0];
+        h[4] = h[1];
+        for (k = 1; k < FUSE_ARITY; k++) {
+          other = h[found + k];
+          alone[queue] = other;
+          queue += ((t2count[other] >> 2) == 2);
+          t2count[other] -= 4;
+          t2count[other] ^= (found + k) % FUSE_ARITY;
+          t2hash[other] ^= hash;
+        }
+      }
+    }
+    if (stacksize == n) {
+      break;
+    }
+    // Duplicated keys can't be peeled, remove them before the next seed
+    qsort(keys, n, sizeof(uint64_t), fuse_cmp);
+    for (i = 1, stacksize = (n > 0); i < n; i++) {
+      if (keys[i] != keys[stacksize - 1]) {
+        keys[stacksize++] = keys[i];
+      }
+    }
+    n = stacksize;
+    fuse->entries = n;
+  }
+  if (attempt == FUSE_MAX_ATTEMPTS) {
+    goto build_end;
+  }
+
+  for (i = n; i > 0; i--) {
+    hash = reverse_order[i - 1];
+    found = reverse_h[i - 1];
+    fuse_positions(fuse, hash, h);
+    h[3] = h[0];
+    h[4] = h[1];
+    fuse->fingerprints[h[found]] = fuse_fingerprint(hash) ^ fuse->fingerprints[h[found + 1]] ^ fuse->fingerprints[h[found + 2]];
+  }
+  rv = 0;
+
+ build_end:
+  free(t2count);
+  free(t2hash);
+  free(alone);
+  free(reverse_order);
+  free(reverse_h);
+  if (rv) {
+    fuse16_free(fuse);
+  }
+  return rv;
+}
+
+static inline int fuse_check_hash(struct fuse16 * fuse, uint64_t hash)
+{
+  uint32_t h[FUSE_ARITY];
+  fuse_positions(fuse, hash, h);
+  return fuse_fingerprint(hash) == (fuse->fingerprints[h[0]] ^ fuse->fingerprints[h[1]] ^ fuse->fingerprints[h[2]]);
+}
+
+int fuse16_check(struct fuse16 * fuse, const void * buffer, int len)
+{
+  if (fuse->fingerprints == NULL) {
+    return 0;
+  }
+  return fuse_check_hash(fuse, fuse_mix(fuse16_key(buffer, len), fuse->seed));
+}
+
+int fuse16_check_batch_split(struct fuse16 * fuse, const uint8_t * keys, int len, int stride, int n, uint8_t * results)
+{
+  struct fuse16 *f[FUSE_BATCH];
+  uint64_t hash[FUSE_BATCH];
+  uint32_t h[FUSE_ARITY];
+  const uint8_t *key;
+  int base, m, i, k, hits = 0;
+
+  for (base = 0; base < n; base += FUSE_BATCH) {
+    m = (n - base < FUSE_BATCH) ? n - base : FUSE_BATCH;
+    for (i = 0; i < m; i++) {
+      key = keys + (size_t)(base + i) * stride;
+      f[i] = &fuse[key[0]];
+      if (f[i]->fingerprints == NULL) {
+        continue;
+      }
+      hash[i] = fuse_mix(fuse16_key(key, len), f[i]->seed);
+      fuse_positions(f[i], hash[i], h);
+      for (k = 0; k < FUSE_ARITY; k++) {
+        _mm_prefetch((const char *)&f[i]->fingerprints[h[k]], _MM_HINT_T0);
+      }
+    }
+    for (i = 0; i < m; i++) {
+      results[base + i] = (f[i]->fingerprints != NULL) && fuse_check_hash(f[i], hash[i]);
+      hits += results[base + i];
+    }
+  }
+  return hits;
+}
+
+void fuse16_free(struct fuse16 * fuse)
+{
+  free(fuse->fingerprints);
+  fuse->fingerprints = NULL;
+}
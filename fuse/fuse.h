@@ -0,0 +1,90 @@
+/*
+ * Binary fuse filter with 16 bits fingerprints, see
+ * "Binary Fuse Filters: Fast and Smaller Than Xor Filters"
+ * Thomas Mueller Graf, Daniel Lemire, 2022.
+ *
+ * Static approximate set: it is built once from the complete set of keys,
+ * then each lookup reads 3 fingerprints. About 18 to 20 bits per element for a
+ * false positive rate of 2^-16, against 30 bits for the blocked bloom
+ * filter at 1e-5.
+ */
+
+#ifndef _FUSE_H
+#define _FUSE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fuse16
+{
+  uint64_t seed;
+  uint64_t entries;
+  uint64_t bytes;
+  uint32_t segment_length;
+  uint32_t segment_length_mask;
+  uint32_t segment_count_length;
+  uint32_t array_length;
+  uint16_t *fingerprints;
+};
+
+
+/** ***************************************************************************
+ * 64 bits key of an element, the keys given to fuse16_build() must come
+ * from this function so the lookups find them.
+ *
+ */
+uint64_t fuse16_key(const void * buffer, int len);
+
+
+/** ***************************************************************************
+ * Build the filter from n keys. The keys array may be reordered and
+ * duplicated keys removed from it.
+ *
+ * Return:
+ * -------
+ *     0 - on success
+ *     1 - on failure (allocation or too many elements)
+ *
+ */
+int fuse16_build(struct fuse16 * fuse, uint64_t * keys, uint64_t n);
+
+
+/** ***************************************************************************
+ * Check if the given element is in the filter.
+ *
+ * Return:
+ * -------
+ *     0 - element is not present
+ *     1 - element is present (or false positive)
+ *
+ */
+int fuse16_check(struct fuse16 * fuse, const void * buffer, int len);
+
+
+/** ***************************************************************************
+ * Same as bloom_check_batch_split(): fuse is an array of 256 filters and the
+ * first byte of each element selects its filter. The 3 fingerprints of
+ * every element of a chunk are prefetched before they are read.
+ *
+ * Return:
+ * -------
+ *     Number of elements present (or false positives)
+ *
+ */
+int fuse16_check_batch_split(struct fuse16 * fuse, const uint8_t * keys, int len, int stride, int n, uint8_t * results);
+
+
+/** ***************************************************************************
+ * Deallocate the fingerprints.
+ *
+ */
+void fuse16_free(struct fuse16 * fuse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
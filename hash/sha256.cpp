@@ -354,6 +354,17 @@ inline uint32_t _rotr(uint32_t x, uint8_t r) {
 
   }
 
+  // Consecutive 64-byte chunks, on the SHA extensions when the CPU has them
+  inline void TransformBlocks(uint32_t* s, const unsigned char* chunk, size_t blocks)
+  {
+    if (sha256_ni) {
+      sha256ni_transform(s, chunk, blocks);
+      return;
+    }
+    for (; blocks > 0; blocks--, chunk += 64)
+      Transform(s, chunk);
+  }
+
 } // namespace sha256
 
 
@@ -396,14 +407,15 @@ void CSHA256::Write(const unsigned char* data, size_t len)
     memcpy(buf + bufsize, data, 64 - bufsize);
     bytes += 64 - bufsize;
     data += 64 - bufsize;
-    _sha256::Transform(s, buf);
+    _sha256::TransformBlocks(s, buf, 1);
     bufsize = 0;
   }
-  while (end >= data + 64) {
+  if (end >= data + 64) {
     // Process full chunks directly from the source.
-    _sha256::Transform(s, data);
-    bytes += 64;
-    data += 64;
+    size_t blocks = (end - data) / 64;
+    _sha256::TransformBlocks(s, data, blocks);
+    bytes += 64 * blocks;
+    data += 64 * blocks;
   }
   if (end > data) {
     // Fill the buffer with what remains.
@@ -447,7 +459,7 @@ void sha256_33(unsigned char *input, unsigned char *digest) {
   _sha256::Initialize(s);
   memcpy(input + 33, _sha256::pad, 23);
   memcpy(input + 56, sizedesc_33, 8);
-  _sha256::Transform(s, input);
+  _sha256::TransformBlocks(s, input, 1);
 
   WRITEBE32(digest, s[0]);
   WRITEBE32(digest + 4, s[1]);
@@ -469,8 +481,7 @@ void sha256_65(unsigned char *input, unsigned char *digest) {
   memcpy(input + 120, sizedesc_65, 8);
 
   _sha256::Initialize(s);
-  _sha256::Transform(s, input);
-  _sha256::Transform(s, input+64);
+  _sha256::TransformBlocks(s, input, 2);
 
   WRITEBE32(digest, s[0]);
   WRITEBE32(digest + 4, s[1]);
@@ -525,3 +536,27 @@ bool sha256_file(const char* file_name, uint8_t* checksum) {
 	fclose(file);
 	return true;
 }
+
+int sha256_lanes() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return 16;
+    // 4 messages interleaved on SHA-NI are ahead of the 8 AVX2 lanes
+    if (!sha256_ni && __builtin_cpu_supports("avx2"))
+        return 8;
+#endif
+    return 4;
+}
+
+int hash160_lanes() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return 16;
+    // SHA-NI wins on the SHA-256 alone, not against the 8 lanes RIPEMD-160
+    if (__builtin_cpu_supports("avx2"))
+        return 8;
+#endif
+    return 4;
+}
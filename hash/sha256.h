@@ -34,7 +34,41 @@ void sha256sse_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
 void sha256sse_checksum(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+// 8 (AVX2) and 16 (AVX-512) messages of 1 or 2 pre-padded blocks of 16 words,
+// stored one after the other at i, the digest of message n goes to d + 64*n
+void sha256avx2_1B(uint32_t *i, uint8_t *d);
+void sha256avx2_2B(uint32_t *i, uint8_t *d);
+void sha256avx512_1B(uint32_t *i, uint8_t *d);
+void sha256avx512_2B(uint32_t *i, uint8_t *d);
+// SHA-256 then RIPEMD-160 of the same blocks, the hash160 of lane n goes to h+20n
+void hash160avx2_1B(uint32_t *i, uint8_t *h);
+void hash160avx2_2B(uint32_t *i, uint8_t *h);
+void hash160avx512_1B(uint32_t *i, uint8_t *h);
+void hash160avx512_2B(uint32_t *i, uint8_t *h);
+// Same from the 32 bits limbs of the coordinates (Int::bits) of n keys stride
+// words apart, without building the messages: both prefixes of x, compressed
+// (prefix from the parity of y) and uncompressed keys
+void hash160avx2_fromX(uint32_t *x, int stride, uint8_t *h02, uint8_t *h03);
+void hash160avx2_comp(uint32_t *x, uint32_t *y, int stride, uint8_t *h);
+void hash160avx2_uncomp(uint32_t *x, uint32_t *y, int stride, uint8_t *h);
+void hash160avx512_fromX(uint32_t *x, int stride, uint8_t *h02, uint8_t *h03);
+void hash160avx512_comp(uint32_t *x, uint32_t *y, int stride, uint8_t *h);
+void hash160avx512_uncomp(uint32_t *x, uint32_t *y, int stride, uint8_t *h);
+// SHA extensions backend, set at startup when the CPU has them: the scalar
+// functions and sha256sse_1B / sha256sse_2B then run on sha256ni_*
+extern bool sha256_ni;
+bool sha256ni_supported();
+void sha256ni_transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
+void sha256ni_1B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+void sha256ni_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+// Widest parallel SHA-256 this CPU runs: 16, 8 or 4 (SSE or SHA-NI)
+int sha256_lanes();
+// Widest hash160: 16 or 8 with the fused RIPEMD-160 above, else 4
+int hash160_lanes();
 std::string sha256_hex(unsigned char *digest);
-void sha256sse_test();
+// Every backend the CPU has against the scalar code, returns the number of mismatches
+int sha256sse_test();
 
 #endif
\ No newline at end of file
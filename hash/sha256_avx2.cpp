@@ -0,0 +1,650 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  8 SHA-256 in parallel with AVX2, same rounds as sha256_sse.cpp on 256 bits
+  registers. The functions are built for AVX2 whatever -march says, callers
+  check sha256_lanes() first.
+
+  The 8 lanes RIPEMD-160 of the 32 bytes digests is here too: hash160avx2_*
+  run it on the SHA-256 state registers, the digests never go to memory.
+*/
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+namespace _sha256avx2
+{
+
+#define Maj(b,c,d) _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)) )
+#define Ch(b,c,d)  _mm256_xor_si256(_mm256_and_si256(b, c) , _mm256_andnot_si256(b , d) )
+#define ROR(x,n)   _mm256_or_si256( _mm256_srli_epi32(x, n) , _mm256_slli_epi32(x, 32 - n) )
+#define SHR(x,n)   _mm256_srli_epi32(x, n)
+
+  /* SHA256 Functions */
+#define	S0(x) (_mm256_xor_si256(ROR((x), 2) , _mm256_xor_si256(ROR((x), 13), ROR((x), 22))))
+#define	S1(x) (_mm256_xor_si256(ROR((x), 6) , _mm256_xor_si256(ROR((x), 11), ROR((x), 25))))
+#define	s0(x) (_mm256_xor_si256(ROR((x), 7) , _mm256_xor_si256(ROR((x), 18), SHR((x), 3))))
+#define	s1(x) (_mm256_xor_si256(ROR((x), 17), _mm256_xor_si256(ROR((x), 19), SHR((x), 10))))
+
+#define add4(x0, x1, x2, x3) _mm256_add_epi32(_mm256_add_epi32(x0, x1), _mm256_add_epi32(x2, x3))
+#define add3(x0, x1, x2 ) _mm256_add_epi32(_mm256_add_epi32(x0, x1), x2)
+#define add5(x0, x1, x2, x3, x4) _mm256_add_epi32(add3(x0, x1, x2), _mm256_add_epi32(x3, x4))
+
+
+#define	Round(a, b, c, d, e, f, g, h, i, w)                    \
+    T1 = add5(h, S1(e), Ch(e, f, g), _mm256_set1_epi32(i), w); \
+    d = _mm256_add_epi32(d, T1);                               \
+    T2 = _mm256_add_epi32(S0(a), Maj(a, b, c));                \
+    h = _mm256_add_epi32(T1, T2);
+
+#define WMIX() \
+  w0 = add4(s1(w14), w9, s0(w1), w0); \
+  w1 = add4(s1(w15), w10, s0(w2), w1); \
+  w2 = add4(s1(w0), w11, s0(w3), w2); \
+  w3 = add4(s1(w1), w12, s0(w4), w3); \
+  w4 = add4(s1(w2), w13, s0(w5), w4); \
+  w5 = add4(s1(w3), w14, s0(w6), w5); \
+  w6 = add4(s1(w4), w15, s0(w7), w6); \
+  w7 = add4(s1(w5), w0, s0(w8), w7); \
+  w8 = add4(s1(w6), w1, s0(w9), w8); \
+  w9 = add4(s1(w7), w2, s0(w10), w9); \
+  w10 = add4(s1(w8), w3, s0(w11), w10); \
+  w11 = add4(s1(w9), w4, s0(w12), w11); \
+  w12 = add4(s1(w10), w5, s0(w13), w12); \
+  w13 = add4(s1(w11), w6, s0(w14), w13); \
+  w14 = add4(s1(w12), w7, s0(w15), w14); \
+  w15 = add4(s1(w13), w8, s0(w0), w15);
+
+  // Initialise state
+  AVX2_TARGET inline void Initialize(__m256i *s) {
+    s[0] = _mm256_set1_epi32(0x6a09e667);
+    s[1] = _mm256_set1_epi32(0xbb67ae85);
+    s[2] = _mm256_set1_epi32(0x3c6ef372);
+    s[3] = _mm256_set1_epi32(0xa54ff53a);
+    s[4] = _mm256_set1_epi32(0x510e527f);
+    s[5] = _mm256_set1_epi32(0x9b05688c);
+    s[6] = _mm256_set1_epi32(0x1f83d9ab);
+    s[7] = _mm256_set1_epi32(0x5be0cd19);
+  }
+
+  // Message words of the 8 lanes, the blocks of the lanes are stride words apart
+  AVX2_TARGET inline void Load(__m256i *w, uint32_t *blk, int stride) {
+
+    __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    int i;
+
+    for (i = 0; i < 16; i++)
+      w[i] = _mm256_i32gather_epi32((const int *)(blk + i), idx, 4);
+
+  }
+
+  // Perform 8 SHA in parallel using AVX2 on the message words w
+  AVX2_TARGET inline void Transform(__m256i *s, __m256i *w)
+  {
+    __m256i a,b,c,d,e,f,g,h;
+    __m256i w0, w1, w2, w3, w4, w5, w6, w7;
+    __m256i w8, w9, w10, w11, w12, w13, w14, w15;
+    __m256i T1, T2;
+
+    a = s[0];
+    b = s[1];
+    c = s[2];
+    d = s[3];
+    e = s[4];
+    f = s[5];
+    g = s[6];
+    h = s[7];
+
+    w0 = w[0];
+    w1 = w[1];
+    w2 = w[2];
+    w3 = w[3];
+    w4 = w[4];
+    w5 = w[5];
+    w6 = w[6];
+    w7 = w[7];
+    w8 = w[8];
+    w9 = w[9];
+    w10 = w[10];
+    w11 = w[11];
+    w12 = w[12];
+    w13 = w[13];
+    w14 = w[14];
+    w15 = w[15];
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w0);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w1);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w2);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w4);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w5);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w6);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w7);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w8);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w9);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w10);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w11);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w12);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w13);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w0);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w1);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w2);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w3);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w6);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w7);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w9);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w10);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w11);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w13);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w14);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w0);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w1);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w2);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w3);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w4);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w5);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w6);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w7);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w9);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w10);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w11);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w13);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w14);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w0);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w1);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w2);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w6);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w7);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w8);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w9);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w10);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w11);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w12);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w13);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w15);
+
+    s[0] = _mm256_add_epi32(a, s[0]);
+    s[1] = _mm256_add_epi32(b, s[1]);
+    s[2] = _mm256_add_epi32(c, s[2]);
+    s[3] = _mm256_add_epi32(d, s[3]);
+    s[4] = _mm256_add_epi32(e, s[4]);
+    s[5] = _mm256_add_epi32(f, s[5]);
+    s[6] = _mm256_add_epi32(g, s[6]);
+    s[7] = _mm256_add_epi32(h, s[7]);
+
+  }
+
+  // Byte swap the state and write the digest of lane i at d + 64*i
+  AVX2_TARGET void Unpack(__m256i *s, uint8_t *d) {
+
+    __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i t[8], u[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+      s[i] = _mm256_shuffle_epi8(s[i], mask);
+
+    // 8x8 transpose, u[i] holds the words i&3 of the lanes (i>>2) and (i>>2)+4
+    for (i = 0; i < 8; i += 4) {
+      t[i + 0] = _mm256_unpacklo_epi32(s[i + 0], s[i + 1]);
+      t[i + 1] = _mm256_unpackhi_epi32(s[i + 0], s[i + 1]);
+      t[i + 2] = _mm256_unpacklo_epi32(s[i + 2], s[i + 3]);
+      t[i + 3] = _mm256_unpackhi_epi32(s[i + 2], s[i + 3]);
+      u[i + 0] = _mm256_unpacklo_epi64(t[i + 0], t[i + 2]);
+      u[i + 1] = _mm256_unpackhi_epi64(t[i + 0], t[i + 2]);
+      u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+      u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (i = 0; i < 4; i++) {
+      _mm256_storeu_si256((__m256i *)(d + 64 * i), _mm256_permute2x128_si256(u[i], u[i + 4], 0x20));
+      _mm256_storeu_si256((__m256i *)(d + 64 * (i + 4)), _mm256_permute2x128_si256(u[i], u[i + 4], 0x31));
+    }
+
+  }
+
+  // The 8 limbs of 32 bits of 8 Int, least significant first, stride words apart
+  AVX2_TARGET inline void Limbs(__m256i *l, uint32_t *p, int stride) {
+
+    __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    int i;
+
+    for (i = 0; i < 8; i++)
+      l[i] = _mm256_i32gather_epi32((const int *)(p + i), idx, 4);
+
+  }
+
+  /*
+    Big endian message words of the public keys built from the limbs, the 33
+    bytes key is prefix | x and the 65 bytes one 04 | x | y. prefix is in the
+    top byte, the padding and length words are constants.
+  */
+  AVX2_TARGET inline void KeyX(__m256i *w, __m256i *x, __m256i prefix) {
+
+    int i;
+
+    w[0] = _mm256_or_si256(prefix, _mm256_srli_epi32(x[7], 8));
+    for (i = 1; i < 8; i++)
+      w[i] = _mm256_or_si256(_mm256_srli_epi32(x[7 - i], 8), _mm256_slli_epi32(x[8 - i], 24));
+    w[8] = _mm256_or_si256(_mm256_set1_epi32(0x00800000), _mm256_slli_epi32(x[0], 24));
+    for (i = 9; i < 15; i++)
+      w[i] = _mm256_setzero_si256();
+    w[15] = _mm256_set1_epi32(33 << 3);
+
+  }
+
+  AVX2_TARGET inline void KeyXY(__m256i *w, __m256i *x, __m256i *y) {
+
+    int i;
+
+    w[0] = _mm256_or_si256(_mm256_set1_epi32(0x04000000), _mm256_srli_epi32(x[7], 8));
+    for (i = 1; i < 8; i++)
+      w[i] = _mm256_or_si256(_mm256_srli_epi32(x[7 - i], 8), _mm256_slli_epi32(x[8 - i], 24));
+    w[8] = _mm256_or_si256(_mm256_srli_epi32(y[7], 8), _mm256_slli_epi32(x[0], 24));
+    for (i = 1; i < 8; i++)
+      w[8 + i] = _mm256_or_si256(_mm256_srli_epi32(y[7 - i], 8), _mm256_slli_epi32(y[8 - i], 24));
+    w[16] = _mm256_or_si256(_mm256_set1_epi32(0x00800000), _mm256_slli_epi32(y[0], 24));
+    for (i = 17; i < 31; i++)
+      w[i] = _mm256_setzero_si256();
+    w[31] = _mm256_set1_epi32(65 << 3);
+
+  }
+
+} // end namespace
+
+namespace _ripemd160avx2
+{
+
+#define ROL(x,n) _mm256_or_si256( _mm256_slli_epi32(x, n) , _mm256_srli_epi32(x, 32 - n) )
+#define f1(x,y,z) _mm256_xor_si256(x, _mm256_xor_si256(y, z))
+#define f2(x,y,z) _mm256_or_si256(_mm256_and_si256(x,y),_mm256_andnot_si256(x,z))
+#define f3(x,y,z) _mm256_xor_si256(_mm256_or_si256(x,_mm256_xor_si256(y,_mm256_set1_epi32(-1))),z)
+#define f4(x,y,z) _mm256_or_si256(_mm256_and_si256(x,z),_mm256_andnot_si256(z,y))
+#define f5(x,y,z) _mm256_xor_si256(x,_mm256_or_si256(y,_mm256_xor_si256(z,_mm256_set1_epi32(-1))))
+
+#define radd3(x0, x1, x2 ) _mm256_add_epi32(_mm256_add_epi32(x0, x1), x2)
+#define radd4(x0, x1, x2, x3) _mm256_add_epi32(_mm256_add_epi32(x0, x1), _mm256_add_epi32(x2, x3))
+
+#define RRound(a,b,c,d,e,f,x,k,r) \
+  u = radd4(a,f,x,_mm256_set1_epi32(k)); \
+  a = _mm256_add_epi32(ROL(u, r),e); \
+  c = ROL(c, 10);
+
+#define R11(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R21(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r)
+#define R31(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r)
+#define R41(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r)
+#define R51(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r)
+#define R12(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r)
+#define R22(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r)
+#define R32(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r)
+#define R42(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r)
+#define R52(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+
+  /*
+    RIPEMD-160 of the 8 SHA-256 digests still in the state registers s[0..7].
+    The 32 bytes input is a single block: the digest words byte swapped to
+    little endian, then the 0x80 pad and the 256 bits length as constants.
+    Writes the 5 state words of every lane in r.
+  */
+  AVX2_TARGET inline void Transform32(__m256i *s, __m256i *r) {
+
+    __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i a1 = _mm256_set1_epi32(0x67452301ul);
+    __m256i b1 = _mm256_set1_epi32(0xEFCDAB89ul);
+    __m256i c1 = _mm256_set1_epi32(0x98BADCFEul);
+    __m256i d1 = _mm256_set1_epi32(0x10325476ul);
+    __m256i e1 = _mm256_set1_epi32(0xC3D2E1F0ul);
+    __m256i a2 = a1;
+    __m256i b2 = b1;
+    __m256i c2 = c1;
+    __m256i d2 = d1;
+    __m256i e2 = e1;
+    __m256i u;
+    __m256i w[16];
+    int i;
+
+    for (i = 0; i < 8; i++)
+      w[i] = _mm256_shuffle_epi8(s[i], mask);
+    w[8] = _mm256_set1_epi32(0x80);
+    for (i = 9; i < 16; i++)
+      w[i] = _mm256_setzero_si256();
+    w[14] = _mm256_set1_epi32(32 << 3);
+
+    R11(a1, b1, c1, d1, e1, w[0], 11);
+    R12(a2, b2, c2, d2, e2, w[5], 8);
+    R11(e1, a1, b1, c1, d1, w[1], 14);
+    R12(e2, a2, b2, c2, d2, w[14], 9);
+    R11(d1, e1, a1, b1, c1, w[2], 15);
+    R12(d2, e2, a2, b2, c2, w[7], 9);
+    R11(c1, d1, e1, a1, b1, w[3], 12);
+    R12(c2, d2, e2, a2, b2, w[0], 11);
+    R11(b1, c1, d1, e1, a1, w[4], 5);
+    R12(b2, c2, d2, e2, a2, w[9], 13);
+    R11(a1, b1, c1, d1, e1, w[5], 8);
+    R12(a2, b2, c2, d2, e2, w[2], 15);
+    R11(e1, a1, b1, c1, d1, w[6], 7);
+    R12(e2, a2, b2, c2, d2, w[11], 15);
+    R11(d1, e1, a1, b1, c1, w[7], 9);
+    R12(d2, e2, a2, b2, c2, w[4], 5);
+    R11(c1, d1, e1, a1, b1, w[8], 11);
+    R12(c2, d2, e2, a2, b2, w[13], 7);
+    R11(b1, c1, d1, e1, a1, w[9], 13);
+    R12(b2, c2, d2, e2, a2, w[6], 7);
+    R11(a1, b1, c1, d1, e1, w[10], 14);
+    R12(a2, b2, c2, d2, e2, w[15], 8);
+    R11(e1, a1, b1, c1, d1, w[11], 15);
+    R12(e2, a2, b2, c2, d2, w[8], 11);
+    R11(d1, e1, a1, b1, c1, w[12], 6);
+    R12(d2, e2, a2, b2, c2, w[1], 14);
+    R11(c1, d1, e1, a1, b1, w[13], 7);
+    R12(c2, d2, e2, a2, b2, w[10], 14);
+    R11(b1, c1, d1, e1, a1, w[14], 9);
+    R12(b2, c2, d2, e2, a2, w[3], 12);
+    R11(a1, b1, c1, d1, e1, w[15], 8);
+    R12(a2, b2, c2, d2, e2, w[12], 6);
+
+    R21(e1, a1, b1, c1, d1, w[7], 7);
+    R22(e2, a2, b2, c2, d2, w[6], 9);
+    R21(d1, e1, a1, b1, c1, w[4], 6);
+    R22(d2, e2, a2, b2, c2, w[11], 13);
+    R21(c1, d1, e1, a1, b1, w[13], 8);
+    R22(c2, d2, e2, a2, b2, w[3], 15);
+    R21(b1, c1, d1, e1, a1, w[1], 13);
+    R22(b2, c2, d2, e2, a2, w[7], 7);
+    R21(a1, b1, c1, d1, e1, w[10], 11);
+    R22(a2, b2, c2, d2, e2, w[0], 12);
+    R21(e1, a1, b1, c1, d1, w[6], 9);
+    R22(e2, a2, b2, c2, d2, w[13], 8);
+    R21(d1, e1, a1, b1, c1, w[15], 7);
+    R22(d2, e2, a2, b2, c2, w[5], 9);
+    R21(c1, d1, e1, a1, b1, w[3], 15);
+    R22(c2, d2, e2, a2, b2, w[10], 11);
+    R21(b1, c1, d1, e1, a1, w[12], 7);
+    R22(b2, c2, d2, e2, a2, w[14], 7);
+    R21(a1, b1, c1, d1, e1, w[0], 12);
+    R22(a2, b2, c2, d2, e2, w[15], 7);
+    R21(e1, a1, b1, c1, d1, w[9], 15);
+    R22(e2, a2, b2, c2, d2, w[8], 12);
+    R21(d1, e1, a1, b1, c1, w[5], 9);
+    R22(d2, e2, a2, b2, c2, w[12], 7);
+    R21(c1, d1, e1, a1, b1, w[2], 11);
+    R22(c2, d2, e2, a2, b2, w[4], 6);
+    R21(b1, c1, d1, e1, a1, w[14], 7);
+    R22(b2, c2, d2, e2, a2, w[9], 15);
+    R21(a1, b1, c1, d1, e1, w[11], 13);
+    R22(a2, b2, c2, d2, e2, w[1], 13);
+    R21(e1, a1, b1, c1, d1, w[8], 12);
+    R22(e2, a2, b2, c2, d2, w[2], 11);
+
+    R31(d1, e1, a1, b1, c1, w[3], 11);
+    R32(d2, e2, a2, b2, c2, w[15], 9);
+    R31(c1, d1, e1, a1, b1, w[10], 13);
+    R32(c2, d2, e2, a2, b2, w[5], 7);
+    R31(b1, c1, d1, e1, a1, w[14], 6);
+    R32(b2, c2, d2, e2, a2, w[1], 15);
+    R31(a1, b1, c1, d1, e1, w[4], 7);
+    R32(a2, b2, c2, d2, e2, w[3], 11);
+    R31(e1, a1, b1, c1, d1, w[9], 14);
+    R32(e2, a2, b2, c2, d2, w[7], 8);
+    R31(d1, e1, a1, b1, c1, w[15], 9);
+    R32(d2, e2, a2, b2, c2, w[14], 6);
+    R31(c1, d1, e1, a1, b1, w[8], 13);
+    R32(c2, d2, e2, a2, b2, w[6], 6);
+    R31(b1, c1, d1, e1, a1, w[1], 15);
+    R32(b2, c2, d2, e2, a2, w[9], 14);
+    R31(a1, b1, c1, d1, e1, w[2], 14);
+    R32(a2, b2, c2, d2, e2, w[11], 12);
+    R31(e1, a1, b1, c1, d1, w[7], 8);
+    R32(e2, a2, b2, c2, d2, w[8], 13);
+    R31(d1, e1, a1, b1, c1, w[0], 13);
+    R32(d2, e2, a2, b2, c2, w[12], 5);
+    R31(c1, d1, e1, a1, b1, w[6], 6);
+    R32(c2, d2, e2, a2, b2, w[2], 14);
+    R31(b1, c1, d1, e1, a1, w[13], 5);
+    R32(b2, c2, d2, e2, a2, w[10], 13);
+    R31(a1, b1, c1, d1, e1, w[11], 12);
+    R32(a2, b2, c2, d2, e2, w[0], 13);
+    R31(e1, a1, b1, c1, d1, w[5], 7);
+    R32(e2, a2, b2, c2, d2, w[4], 7);
+    R31(d1, e1, a1, b1, c1, w[12], 5);
+    R32(d2, e2, a2, b2, c2, w[13], 5);
+
+    R41(c1, d1, e1, a1, b1, w[1], 11);
+    R42(c2, d2, e2, a2, b2, w[8], 15);
+    R41(b1, c1, d1, e1, a1, w[9], 12);
+    R42(b2, c2, d2, e2, a2, w[6], 5);
+    R41(a1, b1, c1, d1, e1, w[11], 14);
+    R42(a2, b2, c2, d2, e2, w[4], 8);
+    R41(e1, a1, b1, c1, d1, w[10], 15);
+    R42(e2, a2, b2, c2, d2, w[1], 11);
+    R41(d1, e1, a1, b1, c1, w[0], 14);
+    R42(d2, e2, a2, b2, c2, w[3], 14);
+    R41(c1, d1, e1, a1, b1, w[8], 15);
+    R42(c2, d2, e2, a2, b2, w[11], 14);
+    R41(b1, c1, d1, e1, a1, w[12], 9);
+    R42(b2, c2, d2, e2, a2, w[15], 6);
+    R41(a1, b1, c1, d1, e1, w[4], 8);
+    R42(a2, b2, c2, d2, e2, w[0], 14);
+    R41(e1, a1, b1, c1, d1, w[13], 9);
+    R42(e2, a2, b2, c2, d2, w[5], 6);
+    R41(d1, e1, a1, b1, c1, w[3], 14);
+    R42(d2, e2, a2, b2, c2, w[12], 9);
+    R41(c1, d1, e1, a1, b1, w[7], 5);
+    R42(c2, d2, e2, a2, b2, w[2], 12);
+    R41(b1, c1, d1, e1, a1, w[15], 6);
+    R42(b2, c2, d2, e2, a2, w[13], 9);
+    R41(a1, b1, c1, d1, e1, w[14], 8);
+    R42(a2, b2, c2, d2, e2, w[9], 12);
+    R41(e1, a1, b1, c1, d1, w[5], 6);
+    R42(e2, a2, b2, c2, d2, w[7], 5);
+    R41(d1, e1, a1, b1, c1, w[6], 5);
+    R42(d2, e2, a2, b2, c2, w[10], 15);
+    R41(c1, d1, e1, a1, b1, w[2], 12);
+    R42(c2, d2, e2, a2, b2, w[14], 8);
+
+    R51(b1, c1, d1, e1, a1, w[4], 9);
+    R52(b2, c2, d2, e2, a2, w[12], 8);
+    R51(a1, b1, c1, d1, e1, w[0], 15);
+    R52(a2, b2, c2, d2, e2, w[15], 5);
+    R51(e1, a1, b1, c1, d1, w[5], 5);
+    R52(e2, a2, b2, c2, d2, w[10], 12);
+    R51(d1, e1, a1, b1, c1, w[9], 11);
+    R52(d2, e2, a2, b2, c2, w[4], 9);
+    R51(c1, d1, e1, a1, b1, w[7], 6);
+    R52(c2, d2, e2, a2, b2, w[1], 12);
+    R51(b1, c1, d1, e1, a1, w[12], 8);
+    R52(b2, c2, d2, e2, a2, w[5], 5);
+    R51(a1, b1, c1, d1, e1, w[2], 13);
+    R52(a2, b2, c2, d2, e2, w[8], 14);
+    R51(e1, a1, b1, c1, d1, w[10], 12);
+    R52(e2, a2, b2, c2, d2, w[7], 6);
+    R51(d1, e1, a1, b1, c1, w[14], 5);
+    R52(d2, e2, a2, b2, c2, w[6], 8);
+    R51(c1, d1, e1, a1, b1, w[1], 12);
+    R52(c2, d2, e2, a2, b2, w[2], 13);
+    R51(b1, c1, d1, e1, a1, w[3], 13);
+    R52(b2, c2, d2, e2, a2, w[13], 6);
+    R51(a1, b1, c1, d1, e1, w[8], 14);
+    R52(a2, b2, c2, d2, e2, w[14], 5);
+    R51(e1, a1, b1, c1, d1, w[11], 11);
+    R52(e2, a2, b2, c2, d2, w[0], 15);
+    R51(d1, e1, a1, b1, c1, w[6], 8);
+    R52(d2, e2, a2, b2, c2, w[3], 13);
+    R51(c1, d1, e1, a1, b1, w[15], 5);
+    R52(c2, d2, e2, a2, b2, w[9], 11);
+    R51(b1, c1, d1, e1, a1, w[13], 6);
+    R52(b2, c2, d2, e2, a2, w[11], 11);
+
+    r[0] = radd3(_mm256_set1_epi32(0xEFCDAB89ul),c1,d2);
+    r[1] = radd3(_mm256_set1_epi32(0x98BADCFEul),d1,e2);
+    r[2] = radd3(_mm256_set1_epi32(0x10325476ul),e1,a2);
+    r[3] = radd3(_mm256_set1_epi32(0xC3D2E1F0ul),a1,b2);
+    r[4] = radd3(_mm256_set1_epi32(0x67452301ul),b1,c2);
+  }
+
+  // Write the 20 bytes hash of lane i at h + 20*i
+  AVX2_TARGET inline void Unpack(__m256i *r, uint8_t *h) {
+
+#ifdef WIN64
+    __declspec(align(32)) uint32_t t[5][8];
+#else
+    uint32_t t[5][8] __attribute__((aligned(32)));
+#endif
+    int i, j;
+
+    for (j = 0; j < 5; j++)
+      _mm256_store_si256((__m256i *)t[j], r[j]);
+    for (i = 0; i < 8; i++)
+      for (j = 0; j < 5; j++)
+        ((uint32_t *)(h + 20 * i))[j] = t[j][i];
+
+  }
+
+} // end namespace
+
+AVX2_TARGET void sha256avx2_1B(uint32_t *i, uint8_t *d) {
+
+  __m256i s[8], w[16];
+
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Load(w, i, 16);
+  _sha256avx2::Transform(s, w);
+  _sha256avx2::Unpack(s, d);
+
+}
+
+AVX2_TARGET void sha256avx2_2B(uint32_t *i, uint8_t *d) {
+
+  __m256i s[8], w[16];
+
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Load(w, i, 32);
+  _sha256avx2::Transform(s, w);
+  _sha256avx2::Load(w, i + 16, 32);
+  _sha256avx2::Transform(s, w);
+  _sha256avx2::Unpack(s, d);
+
+}
+
+// hash160 of 8 public keys, the RIPEMD-160 of lane i is written at h + 20*i
+AVX2_TARGET void hash160avx2_1B(uint32_t *i, uint8_t *h) {
+
+  __m256i s[8], w[16], r[5];
+
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Load(w, i, 16);
+  _sha256avx2::Transform(s, w);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h);
+
+}
+
+AVX2_TARGET void hash160avx2_2B(uint32_t *i, uint8_t *h) {
+
+  __m256i s[8], w[16], r[5];
+
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Load(w, i, 32);
+  _sha256avx2::Transform(s, w);
+  _sha256avx2::Load(w, i + 16, 32);
+  _sha256avx2::Transform(s, w);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h);
+
+}
+
+// hash160 of the 02 and 03 keys of 8 x coordinates, x points to the limbs of
+// the first one and the next ones are stride words apart. Only w[0] differs.
+AVX2_TARGET void hash160avx2_fromX(uint32_t *x, int stride, uint8_t *h02, uint8_t *h03) {
+
+  __m256i l[8], w[16], s[8], r[5];
+
+  _sha256avx2::Limbs(l, x, stride);
+  _sha256avx2::KeyX(w, l, _mm256_set1_epi32(0x02000000));
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Transform(s, w);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h02);
+
+  w[0] = _mm256_add_epi32(w[0], _mm256_set1_epi32(0x01000000));
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Transform(s, w);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h03);
+
+}
+
+// Compressed keys, the prefix comes from the parity of the y limbs
+AVX2_TARGET void hash160avx2_comp(uint32_t *x, uint32_t *y, int stride, uint8_t *h) {
+
+  __m256i l[8], w[16], s[8], r[5], prefix;
+  __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+
+  prefix = _mm256_and_si256(_mm256_i32gather_epi32((const int *)(y), idx, 4), _mm256_set1_epi32(1));
+  prefix = _mm256_slli_epi32(_mm256_add_epi32(prefix, _mm256_set1_epi32(2)), 24);
+  _sha256avx2::Limbs(l, x, stride);
+  _sha256avx2::KeyX(w, l, prefix);
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Transform(s, w);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h);
+
+}
+
+AVX2_TARGET void hash160avx2_uncomp(uint32_t *x, uint32_t *y, int stride, uint8_t *h) {
+
+  __m256i lx[8], ly[8], w[32], s[8], r[5];
+
+  _sha256avx2::Limbs(lx, x, stride);
+  _sha256avx2::Limbs(ly, y, stride);
+  _sha256avx2::KeyXY(w, lx, ly);
+  _sha256avx2::Initialize(s);
+  _sha256avx2::Transform(s, w);
+  _sha256avx2::Transform(s, w + 16);
+  _ripemd160avx2::Transform32(s, r);
+  _ripemd160avx2::Unpack(r, h);
+
+}
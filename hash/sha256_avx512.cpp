@@ -0,0 +1,637 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  16 SHA-256 in parallel with AVX-512, the rounds of sha256_sse.cpp with the
+  native rotate and the three inputs logic of AVX-512F. The functions are
+  built for AVX-512 whatever -march says, callers check sha256_lanes() first.
+
+  hash160avx512_* chain the 16 lanes RIPEMD-160 (vprold rotates, f1..f5 on
+  vpternlogd) to the SHA-256 state registers.
+*/
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+
+// The unmasked shifts, rotates and gathers of GCC 12 start from
+// _mm512_undefined_epi32() and trip -Wuninitialized, the zero masked forms
+// with all the lanes set give the same instructions (a vpxor for the gathers).
+#define ALL16 ((__mmask16)0xFFFF)
+#define SLLI(x,n) _mm512_maskz_slli_epi32(ALL16, x, n)
+#define SRLI(x,n) _mm512_maskz_srli_epi32(ALL16, x, n)
+#define GATHER(idx,p) _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ALL16, idx, p, 4)
+
+namespace _sha256avx512
+{
+
+// Maj(b,c,d) = (b & c) | (d & (b | c)), Ch(b,c,d) = (b & c) ^ (~b & d)
+#define Maj(b,c,d) _mm512_ternarylogic_epi32(b, c, d, 0xE8)
+#define Ch(b,c,d)  _mm512_ternarylogic_epi32(b, c, d, 0xCA)
+#define XOR3(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define ROR(x,n)   _mm512_maskz_ror_epi32(ALL16, x, n)
+#define SHR(x,n)   SRLI(x, n)
+
+  /* SHA256 Functions */
+#define	S0(x) XOR3(ROR((x), 2), ROR((x), 13), ROR((x), 22))
+#define	S1(x) XOR3(ROR((x), 6), ROR((x), 11), ROR((x), 25))
+#define	s0(x) XOR3(ROR((x), 7), ROR((x), 18), SHR((x), 3))
+#define	s1(x) XOR3(ROR((x), 17), ROR((x), 19), SHR((x), 10))
+
+#define add4(x0, x1, x2, x3) _mm512_add_epi32(_mm512_add_epi32(x0, x1), _mm512_add_epi32(x2, x3))
+#define add3(x0, x1, x2 ) _mm512_add_epi32(_mm512_add_epi32(x0, x1), x2)
+#define add5(x0, x1, x2, x3, x4) _mm512_add_epi32(add3(x0, x1, x2), _mm512_add_epi32(x3, x4))
+
+
+#define	Round(a, b, c, d, e, f, g, h, i, w)                    \
+    T1 = add5(h, S1(e), Ch(e, f, g), _mm512_set1_epi32(i), w); \
+    d = _mm512_add_epi32(d, T1);                               \
+    T2 = _mm512_add_epi32(S0(a), Maj(a, b, c));                \
+    h = _mm512_add_epi32(T1, T2);
+
+#define WMIX() \
+  w0 = add4(s1(w14), w9, s0(w1), w0); \
+  w1 = add4(s1(w15), w10, s0(w2), w1); \
+  w2 = add4(s1(w0), w11, s0(w3), w2); \
+  w3 = add4(s1(w1), w12, s0(w4), w3); \
+  w4 = add4(s1(w2), w13, s0(w5), w4); \
+  w5 = add4(s1(w3), w14, s0(w6), w5); \
+  w6 = add4(s1(w4), w15, s0(w7), w6); \
+  w7 = add4(s1(w5), w0, s0(w8), w7); \
+  w8 = add4(s1(w6), w1, s0(w9), w8); \
+  w9 = add4(s1(w7), w2, s0(w10), w9); \
+  w10 = add4(s1(w8), w3, s0(w11), w10); \
+  w11 = add4(s1(w9), w4, s0(w12), w11); \
+  w12 = add4(s1(w10), w5, s0(w13), w12); \
+  w13 = add4(s1(w11), w6, s0(w14), w13); \
+  w14 = add4(s1(w12), w7, s0(w15), w14); \
+  w15 = add4(s1(w13), w8, s0(w0), w15);
+
+  // Initialise state
+  AVX512_TARGET inline void Initialize(__m512i *s) {
+    s[0] = _mm512_set1_epi32(0x6a09e667);
+    s[1] = _mm512_set1_epi32(0xbb67ae85);
+    s[2] = _mm512_set1_epi32(0x3c6ef372);
+    s[3] = _mm512_set1_epi32(0xa54ff53a);
+    s[4] = _mm512_set1_epi32(0x510e527f);
+    s[5] = _mm512_set1_epi32(0x9b05688c);
+    s[6] = _mm512_set1_epi32(0x1f83d9ab);
+    s[7] = _mm512_set1_epi32(0x5be0cd19);
+  }
+
+  // Message words of the 16 lanes, the blocks of the lanes are stride words apart
+  AVX512_TARGET inline void Load(__m512i *w, uint32_t *blk, int stride) {
+
+    __m512i idx = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride));
+    int i;
+
+    for (i = 0; i < 16; i++)
+      w[i] = GATHER(idx, (const void *)(blk + i));
+
+  }
+
+  // Perform 16 SHA in parallel using AVX-512 on the message words w
+  AVX512_TARGET inline void Transform(__m512i *s, __m512i *w)
+  {
+    __m512i a,b,c,d,e,f,g,h;
+    __m512i w0, w1, w2, w3, w4, w5, w6, w7;
+    __m512i w8, w9, w10, w11, w12, w13, w14, w15;
+    __m512i T1, T2;
+
+    a = s[0];
+    b = s[1];
+    c = s[2];
+    d = s[3];
+    e = s[4];
+    f = s[5];
+    g = s[6];
+    h = s[7];
+
+    w0 = w[0];
+    w1 = w[1];
+    w2 = w[2];
+    w3 = w[3];
+    w4 = w[4];
+    w5 = w[5];
+    w6 = w[6];
+    w7 = w[7];
+    w8 = w[8];
+    w9 = w[9];
+    w10 = w[10];
+    w11 = w[11];
+    w12 = w[12];
+    w13 = w[13];
+    w14 = w[14];
+    w15 = w[15];
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w0);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w1);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w2);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w4);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w5);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w6);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w7);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w8);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w9);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w10);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w11);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w12);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w13);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w0);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w1);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w2);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w3);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w6);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w7);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w9);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w10);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w11);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w13);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w14);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w0);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w1);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w2);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w3);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w4);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w5);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w6);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w7);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w8);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w9);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w10);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w11);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w12);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w13);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w14);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w15);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w0);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w1);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w2);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w3);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w4);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w5);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w6);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w7);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w8);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w9);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w10);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w11);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w12);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w13);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w14);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w15);
+
+    s[0] = _mm512_add_epi32(a, s[0]);
+    s[1] = _mm512_add_epi32(b, s[1]);
+    s[2] = _mm512_add_epi32(c, s[2]);
+    s[3] = _mm512_add_epi32(d, s[3]);
+    s[4] = _mm512_add_epi32(e, s[4]);
+    s[5] = _mm512_add_epi32(f, s[5]);
+    s[6] = _mm512_add_epi32(g, s[6]);
+    s[7] = _mm512_add_epi32(h, s[7]);
+
+  }
+
+  // Byte swap the state and write the digest of lane i at d + 64*i
+  AVX512_TARGET void Unpack(__m512i *s, uint8_t *d) {
+
+    __m512i mask = _mm512_set4_epi32(0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203);
+    __m512i idx = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(16));
+    int i;
+
+    for (i = 0; i < 8; i++)
+      _mm512_i32scatter_epi32((void *)(d + 4 * i), idx, _mm512_shuffle_epi8(s[i], mask), 4);
+
+  }
+
+  // The 8 limbs of 32 bits of 16 Int, least significant first, stride words apart
+  AVX512_TARGET inline void Limbs(__m512i *l, uint32_t *p, int stride) {
+
+    __m512i idx = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride));
+    int i;
+
+    for (i = 0; i < 8; i++)
+      l[i] = GATHER(idx, (const void *)(p + i));
+
+  }
+
+  /*
+    Big endian message words of the public keys built from the limbs, the 33
+    bytes key is prefix | x and the 65 bytes one 04 | x | y. prefix is in the
+    top byte, the padding and length words are constants.
+  */
+  AVX512_TARGET inline void KeyX(__m512i *w, __m512i *x, __m512i prefix) {
+
+    int i;
+
+    w[0] = _mm512_or_si512(prefix, SRLI(x[7], 8));
+    for (i = 1; i < 8; i++)
+      w[i] = _mm512_or_si512(SRLI(x[7 - i], 8), SLLI(x[8 - i], 24));
+    w[8] = _mm512_or_si512(_mm512_set1_epi32(0x00800000), SLLI(x[0], 24));
+    for (i = 9; i < 15; i++)
+      w[i] = _mm512_setzero_si512();
+    w[15] = _mm512_set1_epi32(33 << 3);
+
+  }
+
+  AVX512_TARGET inline void KeyXY(__m512i *w, __m512i *x, __m512i *y) {
+
+    int i;
+
+    w[0] = _mm512_or_si512(_mm512_set1_epi32(0x04000000), SRLI(x[7], 8));
+    for (i = 1; i < 8; i++)
+      w[i] = _mm512_or_si512(SRLI(x[7 - i], 8), SLLI(x[8 - i], 24));
+    w[8] = _mm512_or_si512(SRLI(y[7], 8), SLLI(x[0], 24));
+    for (i = 1; i < 8; i++)
+      w[8 + i] = _mm512_or_si512(SRLI(y[7 - i], 8), SLLI(y[8 - i], 24));
+    w[16] = _mm512_or_si512(_mm512_set1_epi32(0x00800000), SLLI(y[0], 24));
+    for (i = 17; i < 31; i++)
+      w[i] = _mm512_setzero_si512();
+    w[31] = _mm512_set1_epi32(65 << 3);
+
+  }
+
+} // end namespace
+
+namespace _ripemd160avx512
+{
+
+#define ROL(x,n) _mm512_maskz_rol_epi32(ALL16, x, n)
+// vpternlogd truth tables of f1..f5 with x = 0xF0, y = 0xCC, z = 0xAA
+#define f1(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+#define f2(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0xCA)
+#define f3(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0x59)
+#define f4(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0xE4)
+#define f5(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0x2D)
+
+#define radd3(x0, x1, x2 ) _mm512_add_epi32(_mm512_add_epi32(x0, x1), x2)
+#define radd4(x0, x1, x2, x3) _mm512_add_epi32(_mm512_add_epi32(x0, x1), _mm512_add_epi32(x2, x3))
+
+#define RRound(a,b,c,d,e,f,x,k,r) \
+  u = radd4(a,f,x,_mm512_set1_epi32(k)); \
+  a = _mm512_add_epi32(ROL(u, r),e); \
+  c = ROL(c, 10);
+
+#define R11(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R21(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r)
+#define R31(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r)
+#define R41(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r)
+#define R51(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r)
+#define R12(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r)
+#define R22(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r)
+#define R32(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r)
+#define R42(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r)
+#define R52(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+
+  /*
+    RIPEMD-160 of the 16 SHA-256 digests still in the state registers s[0..7].
+    The 32 bytes input is a single block: the digest words byte swapped to
+    little endian, then the 0x80 pad and the 256 bits length as constants.
+    Writes the 5 state words of every lane in r.
+  */
+  AVX512_TARGET inline void Transform32(__m512i *s, __m512i *r) {
+
+    __m512i mask = _mm512_set4_epi32(0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203);
+    __m512i a1 = _mm512_set1_epi32(0x67452301ul);
+    __m512i b1 = _mm512_set1_epi32(0xEFCDAB89ul);
+    __m512i c1 = _mm512_set1_epi32(0x98BADCFEul);
+    __m512i d1 = _mm512_set1_epi32(0x10325476ul);
+    __m512i e1 = _mm512_set1_epi32(0xC3D2E1F0ul);
+    __m512i a2 = a1;
+    __m512i b2 = b1;
+    __m512i c2 = c1;
+    __m512i d2 = d1;
+    __m512i e2 = e1;
+    __m512i u;
+    __m512i w[16];
+    int i;
+
+    for (i = 0; i < 8; i++)
+      w[i] = _mm512_shuffle_epi8(s[i], mask);
+    w[8] = _mm512_set1_epi32(0x80);
+    for (i = 9; i < 16; i++)
+      w[i] = _mm512_setzero_si512();
+    w[14] = _mm512_set1_epi32(32 << 3);
+
+    R11(a1, b1, c1, d1, e1, w[0], 11);
+    R12(a2, b2, c2, d2, e2, w[5], 8);
+    R11(e1, a1, b1, c1, d1, w[1], 14);
+    R12(e2, a2, b2, c2, d2, w[14], 9);
+    R11(d1, e1, a1, b1, c1, w[2], 15);
+    R12(d2, e2, a2, b2, c2, w[7], 9);
+    R11(c1, d1, e1, a1, b1, w[3], 12);
+    R12(c2, d2, e2, a2, b2, w[0], 11);
+    R11(b1, c1, d1, e1, a1, w[4], 5);
+    R12(b2, c2, d2, e2, a2, w[9], 13);
+    R11(a1, b1, c1, d1, e1, w[5], 8);
+    R12(a2, b2, c2, d2, e2, w[2], 15);
+    R11(e1, a1, b1, c1, d1, w[6], 7);
+    R12(e2, a2, b2, c2, d2, w[11], 15);
+    R11(d1, e1, a1, b1, c1, w[7], 9);
+    R12(d2, e2, a2, b2, c2, w[4], 5);
+    R11(c1, d1, e1, a1, b1, w[8], 11);
+    R12(c2, d2, e2, a2, b2, w[13], 7);
+    R11(b1, c1, d1, e1, a1, w[9], 13);
+    R12(b2, c2, d2, e2, a2, w[6], 7);
+    R11(a1, b1, c1, d1, e1, w[10], 14);
+    R12(a2, b2, c2, d2, e2, w[15], 8);
+    R11(e1, a1, b1, c1, d1, w[11], 15);
+    R12(e2, a2, b2, c2, d2, w[8], 11);
+    R11(d1, e1, a1, b1, c1, w[12], 6);
+    R12(d2, e2, a2, b2, c2, w[1], 14);
+    R11(c1, d1, e1, a1, b1, w[13], 7);
+    R12(c2, d2, e2, a2, b2, w[10], 14);
+    R11(b1, c1, d1, e1, a1, w[14], 9);
+    R12(b2, c2, d2, e2, a2, w[3], 12);
+    R11(a1, b1, c1, d1, e1, w[15], 8);
+    R12(a2, b2, c2, d2, e2, w[12], 6);
+
+    R21(e1, a1, b1, c1, d1, w[7], 7);
+    R22(e2, a2, b2, c2, d2, w[6], 9);
+    R21(d1, e1, a1, b1, c1, w[4], 6);
+    R22(d2, e2, a2, b2, c2, w[11], 13);
+    R21(c1, d1, e1, a1, b1, w[13], 8);
+    R22(c2, d2, e2, a2, b2, w[3], 15);
+    R21(b1, c1, d1, e1, a1, w[1], 13);
+    R22(b2, c2, d2, e2, a2, w[7], 7);
+    R21(a1, b1, c1, d1, e1, w[10], 11);
+    R22(a2, b2, c2, d2, e2, w[0], 12);
+    R21(e1, a1, b1, c1, d1, w[6], 9);
+    R22(e2, a2, b2, c2, d2, w[13], 8);
+    R21(d1, e1, a1, b1, c1, w[15], 7);
+    R22(d2, e2, a2, b2, c2, w[5], 9);
+    R21(c1, d1, e1, a1, b1, w[3], 15);
+    R22(c2, d2, e2, a2, b2, w[10], 11);
+    R21(b1, c1, d1, e1, a1, w[12], 7);
+    R22(b2, c2, d2, e2, a2, w[14], 7);
+    R21(a1, b1, c1, d1, e1, w[0], 12);
+    R22(a2, b2, c2, d2, e2, w[15], 7);
+    R21(e1, a1, b1, c1, d1, w[9], 15);
+    R22(e2, a2, b2, c2, d2, w[8], 12);
+    R21(d1, e1, a1, b1, c1, w[5], 9);
+    R22(d2, e2, a2, b2, c2, w[12], 7);
+    R21(c1, d1, e1, a1, b1, w[2], 11);
+    R22(c2, d2, e2, a2, b2, w[4], 6);
+    R21(b1, c1, d1, e1, a1, w[14], 7);
+    R22(b2, c2, d2, e2, a2, w[9], 15);
+    R21(a1, b1, c1, d1, e1, w[11], 13);
+    R22(a2, b2, c2, d2, e2, w[1], 13);
+    R21(e1, a1, b1, c1, d1, w[8], 12);
+    R22(e2, a2, b2, c2, d2, w[2], 11);
+
+    R31(d1, e1, a1, b1, c1, w[3], 11);
+    R32(d2, e2, a2, b2, c2, w[15], 9);
+    R31(c1, d1, e1, a1, b1, w[10], 13);
+    R32(c2, d2, e2, a2, b2, w[5], 7);
+    R31(b1, c1, d1, e1, a1, w[14], 6);
+    R32(b2, c2, d2, e2, a2, w[1], 15);
+    R31(a1, b1, c1, d1, e1, w[4], 7);
+    R32(a2, b2, c2, d2, e2, w[3], 11);
+    R31(e1, a1, b1, c1, d1, w[9], 14);
+    R32(e2, a2, b2, c2, d2, w[7], 8);
+    R31(d1, e1, a1, b1, c1, w[15], 9);
+    R32(d2, e2, a2, b2, c2, w[14], 6);
+    R31(c1, d1, e1, a1, b1, w[8], 13);
+    R32(c2, d2, e2, a2, b2, w[6], 6);
+    R31(b1, c1, d1, e1, a1, w[1], 15);
+    R32(b2, c2, d2, e2, a2, w[9], 14);
+    R31(a1, b1, c1, d1, e1, w[2], 14);
+    R32(a2, b2, c2, d2, e2, w[11], 12);
+    R31(e1, a1, b1, c1, d1, w[7], 8);
+    R32(e2, a2, b2, c2, d2, w[8], 13);
+    R31(d1, e1, a1, b1, c1, w[0], 13);
+    R32(d2, e2, a2, b2, c2, w[12], 5);
+    R31(c1, d1, e1, a1, b1, w[6], 6);
+    R32(c2, d2, e2, a2, b2, w[2], 14);
+    R31(b1, c1, d1, e1, a1, w[13], 5);
+    R32(b2, c2, d2, e2, a2, w[10], 13);
+    R31(a1, b1, c1, d1, e1, w[11], 12);
+    R32(a2, b2, c2, d2, e2, w[0], 13);
+    R31(e1, a1, b1, c1, d1, w[5], 7);
+    R32(e2, a2, b2, c2, d2, w[4], 7);
+    R31(d1, e1, a1, b1, c1, w[12], 5);
+    R32(d2, e2, a2, b2, c2, w[13], 5);
+
+    R41(c1, d1, e1, a1, b1, w[1], 11);
+    R42(c2, d2, e2, a2, b2, w[8], 15);
+    R41(b1, c1, d1, e1, a1, w[9], 12);
+    R42(b2, c2, d2, e2, a2, w[6], 5);
+    R41(a1, b1, c1, d1, e1, w[11], 14);
+    R42(a2, b2, c2, d2, e2, w[4], 8);
+    R41(e1, a1, b1, c1, d1, w[10], 15);
+    R42(e2, a2, b2, c2, d2, w[1], 11);
+    R41(d1, e1, a1, b1, c1, w[0], 14);
+    R42(d2, e2, a2, b2, c2, w[3], 14);
+    R41(c1, d1, e1, a1, b1, w[8], 15);
+    R42(c2, d2, e2, a2, b2, w[11], 14);
+    R41(b1, c1, d1, e1, a1, w[12], 9);
+    R42(b2, c2, d2, e2, a2, w[15], 6);
+    R41(a1, b1, c1, d1, e1, w[4], 8);
+    R42(a2, b2, c2, d2, e2, w[0], 14);
+    R41(e1, a1, b1, c1, d1, w[13], 9);
+    R42(e2, a2, b2, c2, d2, w[5], 6);
+    R41(d1, e1, a1, b1, c1, w[3], 14);
+    R42(d2, e2, a2, b2, c2, w[12], 9);
+    R41(c1, d1, e1, a1, b1, w[7], 5);
+    R42(c2, d2, e2, a2, b2, w[2], 12);
+    R41(b1, c1, d1, e1, a1, w[15], 6);
+    R42(b2, c2, d2, e2, a2, w[13], 9);
+    R41(a1, b1, c1, d1, e1, w[14], 8);
+    R42(a2, b2, c2, d2, e2, w[9], 12);
+    R41(e1, a1, b1, c1, d1, w[5], 6);
+    R42(e2, a2, b2, c2, d2, w[7], 5);
+    R41(d1, e1, a1, b1, c1, w[6], 5);
+    R42(d2, e2, a2, b2, c2, w[10], 15);
+    R41(c1, d1, e1, a1, b1, w[2], 12);
+    R42(c2, d2, e2, a2, b2, w[14], 8);
+
+    R51(b1, c1, d1, e1, a1, w[4], 9);
+    R52(b2, c2, d2, e2, a2, w[12], 8);
+    R51(a1, b1, c1, d1, e1, w[0], 15);
+    R52(a2, b2, c2, d2, e2, w[15], 5);
+    R51(e1, a1, b1, c1, d1, w[5], 5);
+    R52(e2, a2, b2, c2, d2, w[10], 12);
+    R51(d1, e1, a1, b1, c1, w[9], 11);
+    R52(d2, e2, a2, b2, c2, w[4], 9);
+    R51(c1, d1, e1, a1, b1, w[7], 6);
+    R52(c2, d2, e2, a2, b2, w[1], 12);
+    R51(b1, c1, d1, e1, a1, w[12], 8);
+    R52(b2, c2, d2, e2, a2, w[5], 5);
+    R51(a1, b1, c1, d1, e1, w[2], 13);
+    R52(a2, b2, c2, d2, e2, w[8], 14);
+    R51(e1, a1, b1, c1, d1, w[10], 12);
+    R52(e2, a2, b2, c2, d2, w[7], 6);
+    R51(d1, e1, a1, b1, c1, w[14], 5);
+    R52(d2, e2, a2, b2, c2, w[6], 8);
+    R51(c1, d1, e1, a1, b1, w[1], 12);
+    R52(c2, d2, e2, a2, b2, w[2], 13);
+    R51(b1, c1, d1, e1, a1, w[3], 13);
+    R52(b2, c2, d2, e2, a2, w[13], 6);
+    R51(a1, b1, c1, d1, e1, w[8], 14);
+    R52(a2, b2, c2, d2, e2, w[14], 5);
+    R51(e1, a1, b1, c1, d1, w[11], 11);
+    R52(e2, a2, b2, c2, d2, w[0], 15);
+    R51(d1, e1, a1, b1, c1, w[6], 8);
+    R52(d2, e2, a2, b2, c2, w[3], 13);
+    R51(c1, d1, e1, a1, b1, w[15], 5);
+    R52(c2, d2, e2, a2, b2, w[9], 11);
+    R51(b1, c1, d1, e1, a1, w[13], 6);
+    R52(b2, c2, d2, e2, a2, w[11], 11);
+
+    r[0] = radd3(_mm512_set1_epi32(0xEFCDAB89ul),c1,d2);
+    r[1] = radd3(_mm512_set1_epi32(0x98BADCFEul),d1,e2);
+    r[2] = radd3(_mm512_set1_epi32(0x10325476ul),e1,a2);
+    r[3] = radd3(_mm512_set1_epi32(0xC3D2E1F0ul),a1,b2);
+    r[4] = radd3(_mm512_set1_epi32(0x67452301ul),b1,c2);
+  }
+
+  // Write the 20 bytes hash of lane i at h + 20*i
+  AVX512_TARGET inline void Unpack(__m512i *r, uint8_t *h) {
+
+    __m512i idx = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(5));
+    int j;
+
+    for (j = 0; j < 5; j++)
+      _mm512_i32scatter_epi32((void *)(h + 4 * j), idx, r[j], 4);
+
+  }
+
+} // end namespace
+
+AVX512_TARGET void sha256avx512_1B(uint32_t *i, uint8_t *d) {
+
+  __m512i s[8], w[16];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Load(w, i, 16);
+  _sha256avx512::Transform(s, w);
+  _sha256avx512::Unpack(s, d);
+
+}
+
+AVX512_TARGET void sha256avx512_2B(uint32_t *i, uint8_t *d) {
+
+  __m512i s[8], w[16];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Load(w, i, 32);
+  _sha256avx512::Transform(s, w);
+  _sha256avx512::Load(w, i + 16, 32);
+  _sha256avx512::Transform(s, w);
+  _sha256avx512::Unpack(s, d);
+
+}
+
+// hash160 of 16 public keys, the RIPEMD-160 of lane i is written at h + 20*i
+AVX512_TARGET void hash160avx512_1B(uint32_t *i, uint8_t *h) {
+
+  __m512i s[8], w[16], r[5];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Load(w, i, 16);
+  _sha256avx512::Transform(s, w);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h);
+
+}
+
+AVX512_TARGET void hash160avx512_2B(uint32_t *i, uint8_t *h) {
+
+  __m512i s[8], w[16], r[5];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Load(w, i, 32);
+  _sha256avx512::Transform(s, w);
+  _sha256avx512::Load(w, i + 16, 32);
+  _sha256avx512::Transform(s, w);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h);
+
+}
+
+// hash160 of the 02 and 03 keys of 16 x coordinates, x points to the limbs of
+// the first one and the next ones are stride words apart. Only w[0] differs.
+AVX512_TARGET void hash160avx512_fromX(uint32_t *x, int stride, uint8_t *h02, uint8_t *h03) {
+
+  __m512i l[8], w[16], s[8], r[5];
+
+  _sha256avx512::Limbs(l, x, stride);
+  _sha256avx512::KeyX(w, l, _mm512_set1_epi32(0x02000000));
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, w);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h02);
+
+  w[0] = _mm512_add_epi32(w[0], _mm512_set1_epi32(0x01000000));
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, w);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h03);
+
+}
+
+// Compressed keys, the prefix comes from the parity of the y limbs
+AVX512_TARGET void hash160avx512_comp(uint32_t *x, uint32_t *y, int stride, uint8_t *h) {
+
+  __m512i l[8], w[16], s[8], r[5], prefix;
+  __m512i idx = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride));
+
+  prefix = _mm512_and_si512(GATHER(idx, (const void *)(y)), _mm512_set1_epi32(1));
+  prefix = SLLI(_mm512_add_epi32(prefix, _mm512_set1_epi32(2)), 24);
+  _sha256avx512::Limbs(l, x, stride);
+  _sha256avx512::KeyX(w, l, prefix);
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, w);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h);
+
+}
+
+AVX512_TARGET void hash160avx512_uncomp(uint32_t *x, uint32_t *y, int stride, uint8_t *h) {
+
+  __m512i lx[8], ly[8], w[32], s[8], r[5];
+
+  _sha256avx512::Limbs(lx, x, stride);
+  _sha256avx512::Limbs(ly, y, stride);
+  _sha256avx512::KeyXY(w, lx, ly);
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, w);
+  _sha256avx512::Transform(s, w + 16);
+  _ripemd160avx512::Transform32(s, r);
+  _ripemd160avx512::Unpack(r, h);
+
+}
@@ -0,0 +1,167 @@
+/*
+ * SHA-256 with the x86 SHA extensions (Intel Goldmont / Ice Lake, AMD Zen and
+ * newer). One sha256rnds2 does 2 rounds of a single message, its latency is
+ * hidden by running the rounds of up to 4 messages interleaved.
+ *
+ * The functions are built for SHA-NI whatever -march says, they are only
+ * called when sha256_ni is set. The file is built with -mno-avx: sha256rnds2
+ * and friends only have the legacy SSE encoding, mixed with the VEX encoded
+ * shuffles and adds of -march=native every call pays the AVX/SSE transition.
+ */
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+#define NI_TARGET __attribute__((target("sha,sse4.1")))
+
+bool sha256_ni = sha256ni_supported();
+
+namespace _sha256ni
+{
+
+#ifdef WIN64
+  static const __declspec(align(16)) uint32_t K[] = {
+#else
+  static const uint32_t K[] __attribute__ ((aligned (16))) = {
+#endif
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+  static const uint32_t _init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  // a..h to the ABEF / CDGH layout of sha256rnds2
+  NI_TARGET inline void Load(const uint32_t *s, __m128i &abef, __m128i &cdgh) {
+    __m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)s), 0xB1);
+    cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(s + 4)), 0x1B);
+    abef = _mm_alignr_epi8(t, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, t, 0xF0);
+  }
+
+  NI_TARGET inline void Store(__m128i abef, __m128i cdgh, uint32_t *s) {
+    __m128i t = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i *)s, _mm_blend_epi16(t, cdgh, 0xF0));
+    _mm_storeu_si128((__m128i *)(s + 4), _mm_alignr_epi8(cdgh, t, 8));
+  }
+
+  // Digest bytes of N states
+  template<int N> NI_TARGET inline void Digest(__m128i *abef, __m128i *cdgh, uint8_t **d) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    uint32_t s[8];
+    for (int k = 0; k < N; k++) {
+      Store(abef[k], cdgh[k], s);
+      _mm_storeu_si128((__m128i *)d[k], _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)s), bswap));
+      _mm_storeu_si128((__m128i *)(d[k] + 16), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(s + 4)), bswap));
+    }
+  }
+
+  /*
+    One block of N messages, the rounds of the N messages are interleaved.
+    b[k] points to 16 words, as bytes of the message (bytes = true) or as
+    big endian words already loaded (the sha256sse_* input).
+  */
+  template<int N, bool bytes> NI_TARGET inline void Transform(__m128i *abef, __m128i *cdgh, const uint8_t **b) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i m[N][4], abef0[N], cdgh0[N], w;
+    int k, t;
+
+    for (k = 0; k < N; k++) {
+      abef0[k] = abef[k];
+      cdgh0[k] = cdgh[k];
+      for (t = 0; t < 4; t++) {
+        m[k][t] = _mm_loadu_si128((const __m128i *)(b[k] + 16 * t));
+        if (bytes)
+          m[k][t] = _mm_shuffle_epi8(m[k][t], bswap);
+      }
+    }
+
+    // 4 rounds per step, from the 5th step the schedule is
+    // W[t] = msg2(msg1(W[t-4], W[t-3]) + W[t-2..t-1] >> 32 bits, W[t-1])
+#pragma GCC unroll 16
+    for (t = 0; t < 16; t++) {
+      for (k = 0; k < N; k++) {
+        if (t >= 4)
+          m[k][t & 3] = _mm_sha256msg2_epu32(
+            _mm_add_epi32(_mm_sha256msg1_epu32(m[k][t & 3], m[k][(t + 1) & 3]),
+                          _mm_alignr_epi8(m[k][(t + 3) & 3], m[k][(t + 2) & 3], 4)),
+            m[k][(t + 3) & 3]);
+        w = _mm_add_epi32(m[k][t & 3], _mm_load_si128((const __m128i *)(K + 4 * t)));
+        cdgh[k] = _mm_sha256rnds2_epu32(cdgh[k], abef[k], w);
+        abef[k] = _mm_sha256rnds2_epu32(abef[k], cdgh[k], _mm_shuffle_epi32(w, 0x0E));
+      }
+    }
+
+    for (k = 0; k < N; k++) {
+      abef[k] = _mm_add_epi32(abef[k], abef0[k]);
+      cdgh[k] = _mm_add_epi32(cdgh[k], cdgh0[k]);
+    }
+  }
+
+  // 1 or 2 blocks of 4 messages given as words, the sha256sse_1B / 2B layout
+  template<int blocks> NI_TARGET inline void Words4(uint32_t **i, uint8_t **d) {
+    __m128i abef[4], cdgh[4];
+    const uint8_t *b[4];
+    int k;
+    for (k = 0; k < 4; k++) {
+      Load(_init, abef[k], cdgh[k]);
+      b[k] = (const uint8_t *)i[k];
+    }
+    Transform<4, false>(abef, cdgh, b);
+    if (blocks == 2) {
+      for (k = 0; k < 4; k++)
+        b[k] += 64;
+      Transform<4, false>(abef, cdgh, b);
+    }
+    Digest<4>(abef, cdgh, d);
+  }
+
+} // end namespace
+
+bool sha256ni_supported() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#else
+  return false;
+#endif
+}
+
+NI_TARGET void sha256ni_transform(uint32_t *s, const uint8_t *chunk, size_t blocks) {
+
+  __m128i abef, cdgh;
+
+  _sha256ni::Load(s, abef, cdgh);
+  for (; blocks > 0; blocks--, chunk += 64)
+    _sha256ni::Transform<1, true>(&abef, &cdgh, &chunk);
+  _sha256ni::Store(abef, cdgh, s);
+
+}
+
+NI_TARGET void sha256ni_1B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3) {
+
+  uint32_t *i[4] = { i0, i1, i2, i3 };
+  uint8_t *d[4] = { d0, d1, d2, d3 };
+  _sha256ni::Words4<1>(i, d);
+
+}
+
+NI_TARGET void sha256ni_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
+  uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3) {
+
+  uint32_t *i[4] = { i0, i1, i2, i3 };
+  uint8_t *d[4] = { d0, d1, d2, d3 };
+  _sha256ni::Words4<2>(i, d);
+
+}
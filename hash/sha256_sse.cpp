@@ -435,6 +435,11 @@ void sha256sse_1B(
 
   __m128i s[8];
 
+  if (sha256_ni) {
+    sha256ni_1B(i0, i1, i2, i3, d0, d1, d2, d3);
+    return;
+  }
+
   _sha256sse::Initialize(s);
   _sha256sse::Transform(s,i0,i1,i2,i3);
 
@@ -500,6 +505,11 @@ void sha256sse_2B(
 
   __m128i s[8];
 
+  if (sha256_ni) {
+    sha256ni_2B(i0, i1, i2, i3, d0, d1, d2, d3);
+    return;
+  }
+
   _sha256sse::Initialize(s);
   _sha256sse::Transform(s, i0, i1, i2, i3);
   _sha256sse::Transform(s, i0 + 16, i1 + 16, i2 + 16, i3 + 16);
@@ -576,52 +586,114 @@ void sha256sse_checksum(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
 
 }
 
-#if 0
-void sha256sse_test() {
-
-  unsigned char h0[32];
-  unsigned char h1[32];
-  unsigned char h2[32];
-  unsigned char h3[32];
-  unsigned char ch0[32];
-  unsigned char ch1[32];
-  unsigned char ch2[32];
-  unsigned char ch3[32];
-  unsigned char m0[64];
-  unsigned char m1[64];
-  unsigned char m2[64];
-  unsigned char m3[64];
-
-  strcpy((char *)m0, "This is a test message to test 01");
-  strcpy((char *)m1, "This is a test message to test 02");
-  strcpy((char *)m2, "This is a test message to test 03");
-  strcpy((char *)m3, "This is a test message to test 04");
-
-  sha256_33(m0, ch0);
-  sha256_33(m1, ch1);
-  sha256_33(m2, ch2);
-  sha256_33(m3, ch3);
-
-  sha256sse_33(m0,m1,m2,m3,h0,h1,h2,h3);
-
-  if((sha256_hex(h0) != sha256_hex(ch0)) ||
-     (sha256_hex(h1) != sha256_hex(ch1)) ||
-     (sha256_hex(h2) != sha256_hex(ch2)) ||
-     (sha256_hex(h3) != sha256_hex(ch3))) {
-
-    printf("SHA() Results Wrong !\n");
-    printf("SHA: %s\n", sha256_hex(ch0).c_str());
-    printf("SHA: %s\n", sha256_hex(ch1).c_str());
-    printf("SHA: %s\n", sha256_hex(ch2).c_str());
-    printf("SHA: %s\n\n", sha256_hex(ch3).c_str());
-    printf("SSE: %s\n", sha256_hex(h0).c_str());
-    printf("SSE: %s\n", sha256_hex(h1).c_str());
-    printf("SSE: %s\n", sha256_hex(h2).c_str());
-    printf("SSE: %s\n\n", sha256_hex(h3).c_str());
+// Pre-padded big endian words of a message of len bytes (1 or 2 blocks)
+static void sha256_words(uint8_t *msg, int len, uint32_t *w) {
+
+  uint8_t b[128];
+  int n = (len + 9 + 63) / 64;
+
+  memset(b, 0, sizeof(b));
+  memcpy(b, msg, len);
+  b[len] = 0x80;
+  b[n * 64 - 2] = (uint8_t)((len * 8) >> 8);
+  b[n * 64 - 1] = (uint8_t)(len * 8);
+  for (int i = 0; i < n * 16; i++)
+    w[i] = (uint32_t)b[4 * i] << 24 | (uint32_t)b[4 * i + 1] << 16 | (uint32_t)b[4 * i + 2] << 8 | b[4 * i + 3];
+
+}
+
+int sha256sse_test() {
+
+  uint8_t msg[16][128];
+  uint8_t ref[16][32];
+  uint8_t h[16 * 64];
+  uint8_t data[300], href[32];
+  uint32_t w[16 * 32];
+  bool ni = sha256_ni;
+  int lanes = sha256_lanes();
+  int errors = 0, e, i, k, len, nb;
+
+  for (i = 0; i < (int)sizeof(data); i++)
+    data[i] = (uint8_t)(i * 7 + 3);
+
+  for (len = 33; len <= 65; len += 32) {
+
+    nb = (len == 33) ? 1 : 2;
+    sha256_ni = false;
+    for (k = 0; k < 16; k++) {
+      for (i = 0; i < len; i++)
+        msg[k][i] = (uint8_t)(k * 31 + i * 13 + len);
+      if (len == 33) sha256_33(msg[k], ref[k]); else sha256_65(msg[k], ref[k]);
+      sha256_words(msg[k], len, w + k * nb * 16);
+    }
+
+    // SSE, then SHA-NI through the same entry points
+    for (int b = 0; b < 2; b++) {
+      if (b == 1 && !ni)
+        continue;
+      sha256_ni = (b == 1);
+      e = 0;
+      for (k = 0; k < 16; k += 4) {
+        uint32_t *x = w + k * nb * 16;
+        if (nb == 1) sha256sse_1B(x, x + 16, x + 32, x + 48, h, h + 64, h + 128, h + 192);
+        else sha256sse_2B(x, x + 32, x + 64, x + 96, h, h + 64, h + 128, h + 192);
+        for (i = 0; i < 4; i++)
+          e += memcmp(h + 64 * i, ref[k + i], 32) != 0;
+      }
+      printf("SHA %s %i bytes: %s\n", b ? "sha-ni 4 lanes" : "sse 4 lanes   ", len, e ? "Wrong !" : "OK");
+      errors += e;
+    }
+    sha256_ni = false;
+
+    for (int n = 8; n <= lanes; n *= 2) {
+      e = 0;
+      if (n == 8 && nb == 1) {
+        sha256avx2_1B(w, h);
+        sha256avx2_1B(w + 8 * 16, h + 8 * 64);
+      } else if (n == 8) {
+        sha256avx2_2B(w, h);
+        sha256avx2_2B(w + 8 * 32, h + 8 * 64);
+      } else if (nb == 1) {
+        sha256avx512_1B(w, h);
+      } else {
+        sha256avx512_2B(w, h);
+      }
+      for (k = 0; k < 16; k++)
+        e += memcmp(h + 64 * k, ref[k], 32) != 0;
+      printf("SHA %s %i bytes: %s\n", n == 8 ? "avx2 8 lanes  " : "avx512 16 lanes", len, e ? "Wrong !" : "OK");
+      errors += e;
+    }
+
+    if (ni) {
+      e = 0;
+      sha256_ni = true;
+      for (k = 0; k < 16; k++) {
+        for (i = 0; i < len; i++)
+          msg[k][i] = (uint8_t)(k * 31 + i * 13 + len);
+        if (len == 33) sha256_33(msg[k], h); else sha256_65(msg[k], h);
+        e += memcmp(h, ref[k], 32) != 0;
+      }
+      printf("SHA sha-ni %i bytes: %s\n", len, e ? "Wrong !" : "OK");
+      errors += e;
+    }
 
   }
 
-  printf("SHA() Results OK !\n");
+  // Any length through the streaming code, several blocks at once on SHA-NI
+  if (ni) {
+    e = 0;
+    for (len = 0; len <= (int)sizeof(data); len++) {
+      sha256_ni = false;
+      sha256(data, len, href);
+      sha256_ni = true;
+      sha256(data, len, h);
+      e += memcmp(h, href, 32) != 0;
+    }
+    printf("SHA sha-ni 0 to %i bytes: %s\n", (int)sizeof(data), e ? "Wrong !" : "OK");
+    errors += e;
+  }
+
+  sha256_ni = ni;
+  return errors;
 
 }
-#endif
@@ -0,0 +1,164 @@
+/*
+ * Refer to sha256_tree.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha256.h"
+#include "sha256_tree.h"
+
+static uint64_t sha256_tree_chunks(uint64_t length)
+{
+  return (length == 0) ? 1 : (length + SHA256_TREE_CHUNK - 1) / SHA256_TREE_CHUNK;
+}
+
+static void sha256_tree_chunk(uint8_t * input, uint64_t length, uint64_t chunk, uint8_t * digest)
+{
+  uint64_t offset = chunk * SHA256_TREE_CHUNK;
+  uint64_t n = (length - offset < SHA256_TREE_CHUNK) ? length - offset : SHA256_TREE_CHUNK;
+  sha256(input + offset, n, digest);
+}
+
+void sha256_tree(uint8_t * input, uint64_t length, uint8_t * digest)
+{
+  uint64_t chunks = sha256_tree_chunks(length);
+  uint8_t *digests = (uint8_t *)malloc(chunks * 32);
+  if (digests == NULL) {
+    fprintf(stderr, "[E] error malloc sha256_tree\n");
+    exit(EXIT_FAILURE);
+  }
+  for (uint64_t c = 0; c < chunks; c++) {
+    sha256_tree_chunk(input, length, c, digests + c * 32);
+  }
+  sha256(digests, chunks * 32, digest);
+  free(digests);
+}
+
+void sha256_tree_batch_init(struct sha256_tree_batch * batch, int capacity, int nthreads)
+{
+  memset(batch, 0, sizeof(struct sha256_tree_batch));
+  batch->capacity = capacity;
+  batch->nthreads = (nthreads < 1) ? 1 : nthreads;
+  batch->jobs = (struct sha256_tree_job *)calloc(capacity, sizeof(struct sha256_tree_job));
+  batch->first_chunk = (uint64_t *)calloc(capacity + 1, sizeof(uint64_t));
+  if (batch->jobs == NULL || batch->first_chunk == NULL) {
+    fprintf(stderr, "[E] error calloc sha256_tree_batch\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void sha256_tree_batch_add(struct sha256_tree_batch * batch, uint8_t * input, uint64_t length, uint8_t * digest, const uint8_t * expected)
+{
+  struct sha256_tree_job *job;
+  if (batch->count == batch->capacity) {
+    fprintf(stderr, "[E] sha256_tree_batch is full\n");
+    exit(EXIT_FAILURE);
+  }
+  job = &batch->jobs[batch->count];
+  job->input = input;
+  job->length = length;
+  job->digest = digest;
+  job->expected = expected;
+  batch->first_chunk[batch->count] = batch->chunks;
+  batch->chunks += sha256_tree_chunks(length);
+  batch->count++;
+  batch->first_chunk[batch->count] = batch->chunks;
+}
+
+// Threads take the chunks of all the jobs in order, one at a time
+#if defined(_WIN64) && !defined(__CYGWIN__)
+static DWORD WINAPI sha256_tree_thread(LPVOID vargp)
+#else
+static void *sha256_tree_thread(void *vargp)
+#endif
+{
+  struct sha256_tree_batch *batch = (struct sha256_tree_batch *)vargp;
+  uint64_t c;
+  int j = 0;
+  while ((c = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED)) < batch->chunks) {
+    while (batch->first_chunk[j + 1] <= c) {
+      j++;
+    }
+    sha256_tree_chunk(batch->jobs[j].input, batch->jobs[j].length, c - batch->first_chunk[j], batch->chunk_digests + c * 32);
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+void sha256_tree_batch_start(struct sha256_tree_batch * batch)
+{
+  int i;
+  batch->chunk_digests = (uint8_t *)malloc((batch->chunks + 1) * 32);
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  batch->tid = (HANDLE *)calloc(batch->nthreads, sizeof(HANDLE));
+#else
+  batch->tid = (pthread_t *)calloc(batch->nthreads, sizeof(pthread_t));
+#endif
+  if (batch->chunk_digests == NULL || batch->tid == NULL) {
+    fprintf(stderr, "[E] error malloc sha256_tree_batch\n");
+    exit(EXIT_FAILURE);
+  }
+  batch->next = 0;
+  for (i = 0; i < batch->nthreads; i++) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    batch->tid[i] = CreateThread(NULL, 0, sha256_tree_thread, (void *)batch, 0, NULL);
+    if (batch->tid[i] == NULL) {
+#else
+    if (pthread_create(&batch->tid[i], NULL, sha256_tree_thread, (void *)batch) != 0) {
+#endif
+      fprintf(stderr, "[E] error creating the sha256 threads\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  batch->running = 1;
+}
+
+int sha256_tree_batch_wait(struct sha256_tree_batch * batch)
+{
+  struct sha256_tree_job *job;
+  uint8_t digest[32];
+  int i;
+  if (!batch->running) {
+    sha256_tree_batch_start(batch);
+  }
+  for (i = 0; i < batch->nthreads; i++) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    WaitForSingleObject(batch->tid[i], INFINITE);
+    CloseHandle(batch->tid[i]);
+#else
+    pthread_join(batch->tid[i], NULL);
+#endif
+  }
+  batch->running = 0;
+  for (i = 0; i < batch->count; i++) {
+    job = &batch->jobs[i];
+    sha256(batch->chunk_digests + batch->first_chunk[i] * 32, (batch->first_chunk[i + 1] - batch->first_chunk[i]) * 32, digest);
+    if (job->digest != NULL) {
+      memcpy(job->digest, digest, 32);
+    }
+    if (job->expected != NULL && memcmp(job->expected, digest, 32) != 0) {
+      sha256(job->input, job->length, digest);  // Checksum of an older file
+      if (memcmp(job->expected, digest, 32) == 0) {
+        batch->legacy++;
+      }
+      else {
+        batch->mismatch++;
+      }
+    }
+  }
+  free(batch->jobs);
+  free(batch->first_chunk);
+  free(batch->chunk_digests);
+  free(batch->tid);
+  batch->jobs = NULL;
+  batch->first_chunk = NULL;
+  batch->chunk_digests = NULL;
+  batch->tid = NULL;
+  batch->count = 0;
+  return batch->mismatch;
+}
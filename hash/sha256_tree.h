@@ -0,0 +1,102 @@
+/*
+ * Chunked sha256 for the checksums of the saved files: the digest of a
+ * buffer is the sha256 of the sha256 of each 1 MB chunk, so the chunks of
+ * all the buffers of a batch are hashed by several threads.
+ */
+
+#ifndef SHA256_TREE_H
+#define SHA256_TREE_H
+
+#include <stdint.h>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define SHA256_TREE_CHUNK 1048576
+
+struct sha256_tree_job
+{
+  uint8_t *input;
+  uint64_t length;
+  uint8_t *digest;          // Where the digest is saved, may be NULL
+  const uint8_t *expected;  // Digest to verify, may be NULL
+};
+
+struct sha256_tree_batch
+{
+  struct sha256_tree_job *jobs;
+  int count;
+  int capacity;
+  int nthreads;
+  int running;
+  uint64_t chunks;
+  uint64_t *first_chunk;
+  uint8_t *chunk_digests;
+  uint64_t next;
+  int mismatch;  // Jobs with a wrong expected digest
+  int legacy;    // Jobs whose expected digest is the plain sha256 of the input
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  HANDLE *tid;
+#else
+  pthread_t *tid;
+#endif
+};
+
+
+/** ***************************************************************************
+ * Digest of one buffer, same value as a batch job but in the calling thread.
+ *
+ */
+void sha256_tree(uint8_t * input, uint64_t length, uint8_t * digest);
+
+
+/** ***************************************************************************
+ * Prepare an empty batch for up to capacity buffers.
+ *
+ * Parameters:
+ * -----------
+ *     batch    - Pointer to the batch.
+ *     capacity - Maximum number of buffers.
+ *     nthreads - Number of threads hashing the chunks.
+ *
+ */
+void sha256_tree_batch_init(struct sha256_tree_batch * batch, int capacity, int nthreads);
+
+
+/** ***************************************************************************
+ * Add a buffer to the batch. The buffer must stay valid until
+ * sha256_tree_batch_wait() returns.
+ *
+ * Parameters:
+ * -----------
+ *     digest   - 32 bytes for the digest of input, or NULL.
+ *     expected - 32 bytes to verify, or NULL. A digest made by sha256() of
+ *                the whole buffer (files saved before the chunked checksums)
+ *                is accepted and counted in batch->legacy.
+ *
+ */
+void sha256_tree_batch_add(struct sha256_tree_batch * batch, uint8_t * input, uint64_t length, uint8_t * digest, const uint8_t * expected);
+
+
+/** ***************************************************************************
+ * Start hashing in the background, the caller may keep reading other data.
+ *
+ */
+void sha256_tree_batch_start(struct sha256_tree_batch * batch);
+
+
+/** ***************************************************************************
+ * Wait for the threads, save the digests and verify the expected ones. The
+ * batch can be initialized again after it.
+ *
+ * Return:
+ * -------
+ *     Number of buffers that don't match their expected digest
+ *
+ */
+int sha256_tree_batch_wait(struct sha256_tree_batch * batch);
+
+#endif
@@ -15,16 +15,23 @@ email: albertobsd@gmail.com
 #include "rmd160/rmd160.h"
 #include "oldbloom/oldbloom.h"
 #include "bloom/bloom.h"
+#include "fuse/fuse.h"
+#include "mapfile/mapfile.h"
+#include "addrindex/addrindex.h"
+#include "radixsort/radixsort.h"
 #include "sha3/sha3.h"
+#include "sha3/keccak.h"
 #include "util.h"
 
 #include "secp256k1/SECP256k1.h"
 #include "secp256k1/Point.h"
 #include "secp256k1/Int.h"
 #include "secp256k1/IntGroup.h"
+#include "secp256k1/BatchStep.h"
 #include "secp256k1/Random.h"
 
 #include "hash/sha256.h"
+#include "hash/sha256_tree.h"
 #include "hash/ripemd160.h"
 
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -67,11 +74,40 @@ struct checksumsha256	{
 	char backup[32];
 };
 
+/* Packed to 11 bytes, the index is little endian (BSGS_XVALUE_INDEX bytes) */
 struct bsgs_xvalue	{
+	uint8_t value[6];
+	uint8_t index[5];
+};
+
+/* The records of the tables saved before, keyhunt_bsgs_2_ files */
+struct bsgs_xvalue_legacy	{
 	uint8_t value[6];
 	uint64_t index;
 };
 
+/*
+	Layout of the --mmap files: the header and the 256 entries, then every bf
+	(or the bP table) at a page aligned offset so it is used in place
+*/
+#define BSGS_MAP_MAGIC "KHBSGSMP"
+
+struct bsgs_map_header	{
+	char magic[8];
+	uint64_t count;		/* 256 filters or the number of bP table elements */
+	uint64_t offset;	/* bP table offset */
+	struct checksumsha256 checksum;	/* bP table checksum */
+};
+
+struct bsgs_map_entry	{
+	uint64_t offset;
+	struct checksumsha256 checksum;
+	union	{
+		struct bloom bloom;
+		struct fuse16 fuse;
+	} filter;
+};
+
 struct address_value	{
 	uint8_t value[20];
 };
@@ -92,6 +128,12 @@ struct bPload	{
 	uint32_t finished;
 };
 
+struct fuse_keys	{
+	uint64_t *keys;
+	uint64_t count;
+	uint64_t size;
+};
+
 #if defined(_WIN64) && !defined(__CYGWIN__)
 #define PACK( __Declaration__ ) __pragma( pack(push, 1) ) __Declaration__ __pragma( pack(pop))
 PACK(struct publickey
@@ -124,39 +166,53 @@ int minikey_n_limit;
 	
 const char *version = "0.2.230519 Satoshi Quest";
 
-#define CPU_GRP_SIZE 1024
+#define CPU_GRP_SIZE 1024	/* Default group size, see --tune */
+#define HASH_GROUP 16	/* Points per GetHash160 call in thread_process, hashed 16, 8 or 4 at once */
+#define TUNE_FILE "keyhunt_tune.txt"
+#define RANDOM_BATCH 64	/* Random starts drawn and computed together, see random_starts */
 
-std::vector<Point> Gn;
+int cpu_grp_size = CPU_GRP_SIZE;
+
+std::vector<AffinePoint> Gn;
 Point _2Gn;
 
-std::vector<Point> GSn;
+std::vector<AffinePoint> GSn;
 Point _2GSn;
 
 void menu();
+void cpu_info();
 void init_generator();
+void random_starts(Int *keys,Point *centers);
+const char *tune_key();
+void tune_group_size();
+void load_group_size();
 
-int searchbinary(struct address_value *buffer,char *data,int64_t array_length);
 void sleep_ms(int milliseconds);
 
 void _sort(struct address_value *arr,int64_t N);
-void _insertionsort(struct address_value *arr, int64_t n);
-void _introsort(struct address_value *arr,uint32_t depthLimit, int64_t n);
-void _swap(struct address_value *a,struct address_value *b);
-int64_t _partition(struct address_value *arr, int64_t n);
-void _myheapsort(struct address_value	*arr, int64_t n);
-void _heapify(struct address_value *arr, int64_t n, int64_t i);
-
 void bsgs_sort(struct bsgs_xvalue *arr,int64_t n);
-void bsgs_myheapsort(struct bsgs_xvalue *arr, int64_t n);
-void bsgs_insertionsort(struct bsgs_xvalue *arr, int64_t n);
-void bsgs_introsort(struct bsgs_xvalue *arr,uint32_t depthLimit, int64_t n);
-void bsgs_swap(struct bsgs_xvalue *a,struct bsgs_xvalue *b);
-void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i);
-int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n);
 
-int bsgs_searchbinary(struct bsgs_xvalue *arr,char *data,int64_t array_length,uint64_t *r_value);
-int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey);
-int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey);
+void bsgs_xvalue_set_index(struct bsgs_xvalue *xvalue,uint64_t index);
+uint64_t bsgs_xvalue_get_index(struct bsgs_xvalue *xvalue);
+int bsgs_searchtable(char *data,uint64_t *r_value);
+int bsgs_table_convert(uint64_t count);
+void bsgs_table_index();
+int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Point *candidate,Int *privatekey);
+void bsgs_bloom_check_group(AffinePoint *pts,int n,unsigned char *xpoints_raw,uint8_t *bloom_hits);
+int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Point *candidate,Int *privatekey);
+void bsgs_bP_add_group(AffinePoint *pts,int n,uint64_t i_counter,uint64_t to,unsigned char *xpoints_raw);
+void bsgs_fuse_add(int index,char *rawvalue);
+void bsgs_fuse_build();
+int bsgs_fuse_read(const char *filename,FILE *fd);
+void bsgs_fuse_write(const char *filename);
+int bsgs_map_read(const char *filename,struct bloom *blooms,struct fuse16 *fuses,struct checksumsha256 *checksums);
+void bsgs_map_write(const char *filename,struct bloom *blooms,struct fuse16 *fuses,struct checksumsha256 *checksums);
+int bsgs_map_table_read(const char *filename,uint64_t count);
+void bsgs_map_table_write(const char *filename,uint64_t count);
+void bsgs_checksum_begin(const char *filename);
+void bsgs_checksum_add(uint8_t *data,uint64_t bytes,char *expected,char *backup);
+void bsgs_checksum_start();
+void bsgs_checksum_end();
 
 void sha256sse_22(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3);
 void sha256sse_23(uint8_t *src0, uint8_t *src1, uint8_t *src2, uint8_t *src3, uint8_t *dst0, uint8_t *dst1, uint8_t *dst2, uint8_t *dst3);
@@ -184,6 +240,8 @@ bool processOneVanity();
 bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom);
 
 void writeFileIfNeeded(const char *fileName);
+bool checksum_input_file(const char *fileName,uint8_t *checksum);
+bool data_file_name(const char *fileName,char *fileBloomName,bool rename_old);
 
 void calcualteindex(int i,Int *key);
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -197,6 +255,7 @@ DWORD WINAPI thread_process_bsgs_random(LPVOID vargp);
 DWORD WINAPI thread_process_bsgs_dance(LPVOID vargp);
 DWORD WINAPI thread_bPload(LPVOID vargp);
 DWORD WINAPI thread_bPload_2blooms(LPVOID vargp);
+DWORD WINAPI thread_fuse_build(LPVOID vargp);
 #else
 void *thread_process_vanity(void *vargp);
 void *thread_process_minikeys(void *vargp);	
@@ -208,6 +267,7 @@ void *thread_process_bsgs_random(void *vargp);
 void *thread_process_bsgs_dance(void *vargp);
 void *thread_bPload(void *vargp);
 void *thread_bPload_2blooms(void *vargp);
+void *thread_fuse_build(void *vargp);
 #endif
 
 char *pubkeytopubaddress(char *pkey,int length);
@@ -219,6 +279,7 @@ void increment_minikey_N(char *rawbuffer);
 	
 void KECCAK_256(uint8_t *source, size_t size,uint8_t *dst);
 void generate_binaddress_eth(Point &publickey,unsigned char *dst_address);
+void generate_binaddress_eth_group(AffinePoint *publickeys,int n,unsigned char *dst_address);
 
 int THREADOUTPUT = 0;
 char *bit_range_str_min;
@@ -294,9 +355,16 @@ int FLAGREADEDFILE2 = 0;
 int FLAGREADEDFILE3 = 0;
 int FLAGREADEDFILE4 = 0;
 int FLAGUPDATEFILE1 = 0;
+int FLAGUPDATEFILE3 = 0;
+int FLAGBLOOMCLASSIC = 0;
+int FLAGFUSE = 0;
+int FLAGMMAP = 0;
+int mmap_flags = 0;
 
 
 int FLAGSTRIDE = 0;
+int FLAGTUNE = 0;
+int gtable_bits = 0;
 int FLAGSEARCH = 2;
 int FLAGBITRANGE = 0;
 int FLAGRANGE = 0;
@@ -316,6 +384,7 @@ char *str_stride;
 Int stride;
 
 uint64_t BSGS_XVALUE_RAM = 6;
+#define BSGS_XVALUE_INDEX 5
 uint64_t BSGS_BUFFERXPOINTLENGTH = 32;
 uint64_t BSGS_BUFFERREGISTERLENGTH = 36;
 
@@ -328,13 +397,20 @@ bool *OriginalPointsBSGScompressed;
 
 uint64_t bytes;
 char checksum[32],checksum_backup[32];
+struct sha256_tree_batch checksum_batch[2];	/* The file being read and the verification of the previous one */
+char checksum_batch_file[2][1024];
+int checksum_batch_current = 0;
 char buffer_bloom_file[1024];
 struct bsgs_xvalue *bPtable;
+struct addrindex bPtable_index;
 struct address_value *addressTable;
+struct addrindex addressIndex;
 
 struct oldbloom oldbloom_bP;
 
 struct bloom *bloom_bP;
+struct fuse16 *fuse_bP;	//Static replacement of bloom_bP, see --fuse
+struct fuse_keys *fuse_bP_keys;
 struct bloom *bloom_bPx2nd; //2nd Bloom filter check
 struct bloom *bloom_bPx3rd; //3rd Bloom filter check
 
@@ -342,15 +418,6 @@ struct checksumsha256 *bloom_bP_checksums;
 struct checksumsha256 *bloom_bPx2nd_checksums;
 struct checksumsha256 *bloom_bPx3rd_checksums;
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-std::vector<HANDLE> bloom_bP_mutex;
-std::vector<HANDLE> bloom_bPx2nd_mutex;
-std::vector<HANDLE> bloom_bPx3rd_mutex;
-#else
-pthread_mutex_t *bloom_bP_mutex;
-pthread_mutex_t *bloom_bPx2nd_mutex;
-pthread_mutex_t *bloom_bPx3rd_mutex;
-#endif
 
 
 
@@ -414,7 +481,6 @@ Secp256K1 *secp;
 
 int main(int argc, char **argv)	{
 	char buffer[2048];
-	char rawvalue[32];
 	struct tothread *tt;	//tothread
 	Tokenizer t,tokenizerbsgs;	//tokenizer
 	char *fileName = NULL;
@@ -456,7 +522,6 @@ int main(int argc, char **argv)	{
 	OUTPUTSECONDS.SetInt32(30);
 	ZERO.SetInt32(0);
 	ONE.SetInt32(1);
-	BSGS_GROUP_SIZE.SetInt32(CPU_GRP_SIZE);
 	
 #if defined(_WIN64) && !defined(__CYGWIN__)
 	//Any windows secure random source goes here
@@ -486,6 +551,42 @@ int main(int argc, char **argv)	{
 	
 	printf("[+] Version %s, developed by AlbertoBSD\n",version);
 
+	/* Long options are not handled by getopt on every platform, take them out first */
+	j = 1;
+	for(int k = 1; k < argc; k++)	{
+		if(strcmp(argv[k],"--tune") == 0)	{
+			FLAGTUNE = 1;
+		}
+		else if(strcmp(argv[k],"--cpu-info") == 0)	{
+			cpu_info();
+		}
+		else if(strcmp(argv[k],"--fuse") == 0)	{
+			FLAGFUSE = 1;
+		}
+		else if(strcmp(argv[k],"--mmap") == 0)	{
+			FLAGMMAP = 1;
+		}
+		else if(strcmp(argv[k],"--mmap-populate") == 0)	{
+			FLAGMMAP = 1;
+			mmap_flags |= MAPFILE_POPULATE;
+		}
+		else if(strcmp(argv[k],"--mmap-huge") == 0)	{
+			FLAGMMAP = 1;
+			mmap_flags |= MAPFILE_HUGEPAGE;
+		}
+		else if(strcmp(argv[k],"--gtable") == 0 && k + 1 < argc)	{
+			gtable_bits = strtol(argv[++k],NULL,10);
+			if(gtable_bits < GTABLE_MIN_BITS || gtable_bits > GTABLE_MAX_BITS)	{
+				fprintf(stderr,"[E] Invalid --gtable value, it must be between %i and %i\n",GTABLE_MIN_BITS,GTABLE_MAX_BITS);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else	{
+			argv[j++] = argv[k];
+		}
+	}
+	argc = j;
+
 	while ((c = getopt(argc, argv, "deh6MqRSB:b:c:C:E:f:I:k:l:m:N:n:p:r:s:t:v:G:8:z:")) != -1) {
 		switch(c) {
 			case 'h':
@@ -800,7 +901,6 @@ int main(int argc, char **argv)	{
 		FLAGSTRIDE = 1;
 		stride.Set(&ONE);
 	}
-	init_generator();
 	if(FLAGMODE == MODE_BSGS )	{
 		printf("[+] Mode BSGS %s\n",bsgs_modes[FLAGBSGSMODE]);
 	}
@@ -813,6 +913,22 @@ int main(int argc, char **argv)	{
 		FLAGCRYPTO = CRYPTO_BTC;
 		printf("[+] Setting search for btc adddress\n");
 	}
+	if((FLAGMODE == MODE_ADDRESS || FLAGMODE == MODE_RMD160) && FLAGCRYPTO == CRYPTO_BTC)	{
+		printf("[+] Hash160 of %i public keys at once%s\n",secp->GetHashLanes(),(secp->GetHashLanes() == 4 && sha256_ni) ? " with SHA-NI" : "");
+	}
+	if(gtable_bits != 0 && gtable_bits != secp->GetGTableBits())	{
+		secp->InitGTable(gtable_bits);
+		printf("[+] Generator table with %i bits windows\n",gtable_bits);
+	}
+	if(FLAGMODE != MODE_MINIKEYS)	{
+		if(FLAGTUNE)	{
+			tune_group_size();
+		}
+		else	{
+			load_group_size();
+		}
+	}
+	init_generator();
 	if(FLAGRANGE) {
 		n_range_start.SetBase16(range_start);
 		if(n_range_start.IsZero())	{
@@ -841,7 +957,7 @@ int main(int argc, char **argv)	{
 		}
 	}
 	if(FLAGMODE != MODE_BSGS && FLAGMODE != MODE_MINIKEYS)	{
-		BSGS_N.SetInt32(DEBUGCOUNT);
+		BSGS_N.SetInt32(cpu_grp_size);
 		if(FLAGRANGE == 0 && FLAGBITRANGE == 0)	{
 			n_range_start.SetInt32(1);
 			n_range_end.Set(&secp->order);
@@ -883,6 +999,12 @@ int main(int argc, char **argv)	{
 				FLAG_N = 0;
 				N_SEQUENTIAL_MAX = 0x100000000;
 			}
+			if(N_SEQUENTIAL_MAX % cpu_grp_size != 0)	{
+				fprintf(stderr,"[W] n value is not a multiple of the group size %i, using %i\n",cpu_grp_size,CPU_GRP_SIZE);
+				cpu_grp_size = CPU_GRP_SIZE;
+				BSGS_N.SetInt32(cpu_grp_size);
+				init_generator();
+			}
 		}
 		printf("[+] N = %p\n",(void*)N_SEQUENTIAL_MAX);
 		if(FLAGMODE == MODE_MINIKEYS)	{
@@ -957,6 +1079,13 @@ int main(int argc, char **argv)	{
 			printf(" done! %" PRIu64 " values were loaded and sorted\n",N);
 			writeFileIfNeeded(fileName);
 		}
+		if(FLAGMODE != MODE_VANITY)	{
+			if(addrindex_init(&addressIndex,addressTable,N,sizeof(struct address_value),sizeof(struct address_value),addrindex_bits(N,4)))	{
+				fprintf(stderr,"[E] error addrindex_init for %" PRIu64 " elements\n",N);
+				exit(EXIT_FAILURE);
+			}
+			printf("[+] Lookup index of %i bits: %.2f MB\n",addressIndex.bits,(double)addressIndex.bytes/(double)1048576);
+		}
 	}
 	
 	if(FLAGMODE == MODE_BSGS )	{
@@ -1075,8 +1204,17 @@ int main(int argc, char **argv)	{
 			exit(EXIT_FAILURE);
 		}
 
+		BSGS_GROUP_SIZE.SetInt32(cpu_grp_size);
 		BSGS_AUX.Set(&BSGS_M);
 		BSGS_AUX.Mod(&BSGS_GROUP_SIZE);	
+		if(!BSGS_AUX.IsZero() && cpu_grp_size != CPU_GRP_SIZE)	{
+			fprintf(stderr,"[W] M value is not divisible by the group size %i, using %i\n",cpu_grp_size,CPU_GRP_SIZE);
+			cpu_grp_size = CPU_GRP_SIZE;
+			init_generator();
+			BSGS_GROUP_SIZE.SetInt32(cpu_grp_size);
+			BSGS_AUX.Set(&BSGS_M);
+			BSGS_AUX.Mod(&BSGS_GROUP_SIZE);	
+		}
 		
 		if(!BSGS_AUX.IsZero()){ //If M is not divisible by  BSGS_GROUP_SIZE (1024) 
 			hextemp = BSGS_GROUP_SIZE.GetBase10();
@@ -1159,6 +1297,10 @@ int main(int argc, char **argv)	{
 		
 		bsgs_m2 =  BSGS_M2.GetInt64();
 		bsgs_m3 =  BSGS_M3.GetInt64();
+		if(bsgs_m3 >> (8 * BSGS_XVALUE_INDEX))	{
+			fprintf(stderr,"[E] The bP table of %" PRIu64 " elements is too big, use a lower -k value\n",bsgs_m3);
+			exit(EXIT_FAILURE);
+		}
 		
 		BSGS_AUX.Set(&BSGS_N);
 		BSGS_AUX.Div(&BSGS_M);
@@ -1212,58 +1354,97 @@ int main(int argc, char **argv)	{
 			itemsbloom3 = 1000;
 		}
 		
-		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m);
-		bloom_bP = (struct bloom*)calloc(256,sizeof(struct bloom));
-		checkpointer((void *)bloom_bP,__FILE__,"calloc","bloom_bP" ,__LINE__ -1 );
+		/*
+			The 1st bloom filter is cache line blocked (keyhunt_bsgs_8_ files), the
+			files of the previous versions (keyhunt_bsgs_4_ and keyhunt_bsgs_3_) keep
+			their classic layout so they are still used
+		*/
+		if(FLAGSAVEREADFILE && !FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
+			fd_aux1 = fopen(buffer_bloom_file,"rb");
+			if(fd_aux1 == NULL)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+				fd_aux1 = fopen(buffer_bloom_file,"rb");
+			}
+			if(fd_aux1 == NULL)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_3_%" PRIu64 ".blm",bsgs_m);
+				fd_aux1 = fopen(buffer_bloom_file,"rb");
+			}
+			if(fd_aux1 != NULL)	{
+				FLAGBLOOMCLASSIC = strstr(buffer_bloom_file,"keyhunt_bsgs_8_") == NULL;
+				fclose(fd_aux1);
+			}
+		}
+		if(FLAGFUSE)	{
+			printf("[+] Binary fuse filter for %" PRIu64 " elements ",bsgs_m);
+			fuse_bP = (struct fuse16*)calloc(256,sizeof(struct fuse16));
+			checkpointer((void *)fuse_bP,__FILE__,"calloc","fuse_bP" ,__LINE__ -1 );
+			fuse_bP_keys = (struct fuse_keys*)calloc(256,sizeof(struct fuse_keys));
+			checkpointer((void *)fuse_bP_keys,__FILE__,"calloc","fuse_bP_keys" ,__LINE__ -1 );
+			for(i = 0; i < 256; i++)	{
+				fuse_bP_keys[i].size = (bsgs_m / 256) + (bsgs_m / 2048) + 1024;
+				fuse_bP_keys[i].keys = (uint64_t*) malloc(fuse_bP_keys[i].size * sizeof(uint64_t));
+				checkpointer((void *)fuse_bP_keys[i].keys,__FILE__,"malloc","fuse_bP_keys" ,__LINE__ -1 );
+			}
+		}
+		else	{
+			printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m);
+			bloom_bP = (struct bloom*)calloc(256,sizeof(struct bloom));
+			checkpointer((void *)bloom_bP,__FILE__,"calloc","bloom_bP" ,__LINE__ -1 );
+		}
 		bloom_bP_checksums = (struct checksumsha256*)calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bP_checksums,__FILE__,"calloc","bloom_bP_checksums" ,__LINE__ -1 );
 		
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bP_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-		
-#else
-		bloom_bP_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bP_mutex,__FILE__,"calloc","bloom_bP_mutex" ,__LINE__ -1 );
-		
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,FLAGFUSE ? "keyhunt_bsgs_9_%" PRIu64 ".map" : "keyhunt_bsgs_8_%" PRIu64 ".map",bsgs_m);
+			FLAGREADEDFILE1 = bsgs_map_read(buffer_bloom_file,FLAGFUSE ? NULL : bloom_bP,FLAGFUSE ? fuse_bP : NULL,bloom_bP_checksums);
+		}
 
 		fflush(stdout);
 		bloom_bP_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bP_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bP_mutex[i],NULL);
-#endif
-			if(bloom_init2(&bloom_bP[i],itemsbloom,0.000001)	== 1){
+			if(FLAGREADEDFILE1)	{	/* Mapped */
+				bloom_bP_totalbytes += FLAGFUSE ? fuse_bP[i].bytes : bloom_bP[i].bytes;
+				continue;
+			}
+			if(FLAGFUSE)	{
+				continue;	/* Built once all the x values are known, see bsgs_fuse_build */
+			}
+			/*
+				A false positive of the 1st filter only costs a second check, 1e-5 keeps the
+				blocked filter close to the size of the classic one
+			*/
+			if((FLAGBLOOMCLASSIC ? bloom_init2(&bloom_bP[i],itemsbloom,0.000001) : bloom_init_blocked(&bloom_bP[i],itemsbloom,0.00001)) == 1)	{
 				fprintf(stderr,"[E] error bloom_init _ [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
 			}
 			bloom_bP_totalbytes += bloom_bP[i].bytes;
 			//if(FLAGDEBUG) bloom_print(&bloom_bP[i]);
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP_totalbytes/(float)(uint64_t)1048576));
+		if(FLAGFUSE && !FLAGREADEDFILE1)	{
+			printf(": ~%.2f MB\n",(float)((double)bsgs_m * 19 / 8 / 1048576));
+		}
+		else	{
+			printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE1 ? ", mapped from file" : "");
+		}
 
 
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m2);
 		
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bPx2nd_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-#else
-		bloom_bPx2nd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bPx2nd_mutex,__FILE__,"calloc","bloom_bPx2nd_mutex" ,__LINE__ -1 );
 		bloom_bPx2nd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx2nd,__FILE__,"calloc","bloom_bPx2nd" ,__LINE__ -1 );
 		bloom_bPx2nd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx2nd_checksums,__FILE__,"calloc","bloom_bPx2nd_checksums" ,__LINE__ -1 );
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_6_%" PRIu64 ".map",bsgs_m2);
+			FLAGREADEDFILE2 = bsgs_map_read(buffer_bloom_file,bloom_bPx2nd,NULL,bloom_bPx2nd_checksums);
+		}
 		bloom_bP2_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bPx2nd_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bPx2nd_mutex[i],NULL);
-#endif
+			if(FLAGREADEDFILE2)	{	/* Mapped */
+				bloom_bP2_totalbytes += bloom_bPx2nd[i].bytes;
+				continue;
+			}
 			if(bloom_init2(&bloom_bPx2nd[i],itemsbloom2,0.000001)	== 1){
 				fprintf(stderr,"[E] error bloom_init _ [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
@@ -1271,28 +1452,25 @@ int main(int argc, char **argv)	{
 			bloom_bP2_totalbytes += bloom_bPx2nd[i].bytes;
 			//if(FLAGDEBUG) bloom_print(&bloom_bPx2nd[i]);
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576));
+		printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP2_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE2 ? ", mapped from file" : "");
 		
 
-#if defined(_WIN64) && !defined(__CYGWIN__)
-		bloom_bPx3rd_mutex = (HANDLE*) calloc(256,sizeof(HANDLE));
-#else
-		bloom_bPx3rd_mutex = (pthread_mutex_t*) calloc(256,sizeof(pthread_mutex_t));
-#endif
-		checkpointer((void *)bloom_bPx3rd_mutex,__FILE__,"calloc","bloom_bPx3rd_mutex" ,__LINE__ -1 );
 		bloom_bPx3rd = (struct bloom*)calloc(256,sizeof(struct bloom));
 		checkpointer((void *)bloom_bPx3rd,__FILE__,"calloc","bloom_bPx3rd" ,__LINE__ -1 );
 		bloom_bPx3rd_checksums = (struct checksumsha256*) calloc(256,sizeof(struct checksumsha256));
 		checkpointer((void *)bloom_bPx3rd_checksums,__FILE__,"calloc","bloom_bPx3rd_checksums" ,__LINE__ -1 );
 		
 		printf("[+] Bloom filter for %" PRIu64 " elements ",bsgs_m3);
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_7_%" PRIu64 ".map",bsgs_m3);
+			FLAGREADEDFILE4 = bsgs_map_read(buffer_bloom_file,bloom_bPx3rd,NULL,bloom_bPx3rd_checksums);
+		}
 		bloom_bP3_totalbytes = 0;
 		for(i=0; i< 256; i++)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-			bloom_bPx3rd_mutex[i] = CreateMutex(NULL, FALSE, NULL);
-#else
-			pthread_mutex_init(&bloom_bPx3rd_mutex[i],NULL);
-#endif
+			if(FLAGREADEDFILE4)	{	/* Mapped */
+				bloom_bP3_totalbytes += bloom_bPx3rd[i].bytes;
+				continue;
+			}
 			if(bloom_init2(&bloom_bPx3rd[i],itemsbloom3,0.000001)	== 1){
 				fprintf(stderr,"[E] error bloom_init [%" PRIu64 "]\n",i);
 				exit(EXIT_FAILURE);
@@ -1300,7 +1478,7 @@ int main(int argc, char **argv)	{
 			bloom_bP3_totalbytes += bloom_bPx3rd[i].bytes;
 			//if(FLAGDEBUG) bloom_print(&bloom_bPx3rd[i]);
 		}
-		printf(": %.2f MB\n",(float)((float)(uint64_t)bloom_bP3_totalbytes/(float)(uint64_t)1048576));
+		printf(": %.2f MB%s\n",(float)((float)(uint64_t)bloom_bP3_totalbytes/(float)(uint64_t)1048576),FLAGREADEDFILE4 ? ", mapped from file" : "");
 		//if(FLAGDEBUG) printf("[D] bloom_bP3_totalbytes : %" PRIu64 "\n",bloom_bP3_totalbytes);
 
 
@@ -1315,7 +1493,7 @@ int main(int argc, char **argv)	{
 		
 		BSGS_AMP2.reserve(32);
 		BSGS_AMP3.reserve(32);
-		GSn.reserve(CPU_GRP_SIZE/2);
+		GSn.resize(cpu_grp_size/2);
 
 		i= 0;
 
@@ -1324,18 +1502,18 @@ int main(int argc, char **argv)	{
 		/* Auxiliar Points to speed up calculations for the main bloom filter check */
 		Point bsP = secp->Negation(BSGS_MP_double);
 		Point g = bsP;
-		GSn[0] = g;
+		GSn[0].Set(&g);
 
 		g = secp->DoubleDirect(g);
-		GSn[1] = g;
+		GSn[1].Set(&g);
 		
-		for(int i = 2; i < CPU_GRP_SIZE / 2; i++) {
+		for(int i = 2; i < cpu_grp_size / 2; i++) {
 			g = secp->AddDirect(g,bsP);
-			GSn[i] = g;
+			GSn[i].Set(&g);
 		}
 		
-		/* For next center point */
-		_2GSn = secp->DoubleDirect(GSn[CPU_GRP_SIZE / 2 - 1]);
+		/* For next center point, g is the last of GSn */
+		_2GSn = secp->DoubleDirect(g);
 				
 		i = 0;
 		point_temp.Set(BSGS_MP2);
@@ -1364,20 +1542,38 @@ int main(int argc, char **argv)	{
 		}
 
 		bytes = (uint64_t)bsgs_m3 * (uint64_t) sizeof(struct bsgs_xvalue);
-		printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
-		
-		bPtable = (struct bsgs_xvalue*) malloc(bytes);
-		checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
-		memset(bPtable,0,bytes);
+		if(FLAGMMAP)	{
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".map",bsgs_m3);
+			FLAGREADEDFILE3 = bsgs_map_table_read(buffer_bloom_file,bsgs_m3);
+		}
+		if(!FLAGREADEDFILE3)	{
+			printf("[+] Allocating %.2f MB for %" PRIu64  " bP Points\n",(double)(bytes/1048576),bsgs_m3);
+			bPtable = (struct bsgs_xvalue*) malloc(bytes);
+			checkpointer((void *)bPtable,__FILE__,"malloc","bPtable" ,__LINE__ -1 );
+			memset(bPtable,0,bytes);
+			if(FLAGMMAP)	{
+				FLAGREADEDFILE3 = FLAGUPDATEFILE3 = bsgs_table_convert(bsgs_m3);
+			}
+		}
 		
-		if(FLAGSAVEREADFILE)	{
+		if(FLAGSAVEREADFILE && !FLAGMMAP)	{
 			/*Reading file for 1st bloom filter */
 
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+			if(FLAGFUSE)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_9_%" PRIu64 ".fus",bsgs_m);
+			}
+			else	{
+				snprintf(buffer_bloom_file,1024,FLAGBLOOMCLASSIC ? "keyhunt_bsgs_4_%" PRIu64 ".blm" : "keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
+			}
 			fd_aux1 = fopen(buffer_bloom_file,"rb");
-			if(fd_aux1 != NULL)	{
+			if(fd_aux1 != NULL && FLAGFUSE)	{
+				FLAGREADEDFILE1 = bsgs_fuse_read(buffer_bloom_file,fd_aux1);
+				fclose(fd_aux1);
+			}
+			else if(fd_aux1 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bP[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bP[i],sizeof(struct bloom),1,fd_aux1);
@@ -1396,19 +1592,14 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(EXIT_FAILURE);
 					}
-					if(FLAGSKIPCHECKSUM == 0)	{
-						sha256((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bP_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bP_checksums[i].backup,rawvalue,32) != 0 )	{	/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(EXIT_FAILURE);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,bloom_bP_checksums[i].data,bloom_bP_checksums[i].backup);
 					if(i % 64 == 0 )	{
 						printf(".");
 						fflush(stdout);
 					}
 				}
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				fclose(fd_aux1);
 				memset(buffer_bloom_file,0,1024);
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_3_%" PRIu64 ".blm",bsgs_m);
@@ -1419,12 +1610,13 @@ int main(int argc, char **argv)	{
 				}
 				FLAGREADEDFILE1 = 1;
 			}
-			else	{	/*Checking for old file    keyhunt_bsgs_3_   */
+			else if(!FLAGFUSE)	{	/*Checking for old file    keyhunt_bsgs_3_   */
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_3_%" PRIu64 ".blm",bsgs_m);
 				fd_aux1 = fopen(buffer_bloom_file,"rb");
 				if(fd_aux1 != NULL)	{
 					printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 					fflush(stdout);
+					bsgs_checksum_begin(buffer_bloom_file);
 					for(i = 0; i < 256;i++)	{
 						bf_ptr = (char*) bloom_bP[i].bf;	/*We need to save the current bf pointer*/
 						readed = fread(&oldbloom_bP,sizeof(struct oldbloom),1,fd_aux1);
@@ -1450,20 +1642,14 @@ int main(int argc, char **argv)	{
 						}
 						memcpy(bloom_bP_checksums[i].data,oldbloom_bP.checksum,32);
 						memcpy(bloom_bP_checksums[i].backup,oldbloom_bP.checksum_backup,32);
-						memset(rawvalue,0,32);
-						if(FLAGSKIPCHECKSUM == 0)	{
-							sha256((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)rawvalue);
-							if(memcmp(bloom_bP_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bP_checksums[i].backup,rawvalue,32) != 0 )	{	/* Verification */
-								fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-								exit(EXIT_FAILURE);
-							}
-						}
+						bsgs_checksum_add((uint8_t*)bloom_bP[i].bf,bloom_bP[i].bytes,bloom_bP_checksums[i].data,bloom_bP_checksums[i].backup);
 						if(i % 32 == 0 )	{
 							printf(".");
 							fflush(stdout);
 						}
 					}
 					printf(" Done!\n");
+					bsgs_checksum_start();
 					fclose(fd_aux1);
 					FLAGUPDATEFILE1 = 1;	/* Flag to migrate the data to the new File keyhunt_bsgs_4_ */
 					FLAGREADEDFILE1 = 1;
@@ -1481,6 +1667,7 @@ int main(int argc, char **argv)	{
 			if(fd_aux2 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bPx2nd[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bPx2nd[i],sizeof(struct bloom),1,fd_aux2);
@@ -1499,14 +1686,7 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(EXIT_FAILURE);
 					}
-					memset(rawvalue,0,32);
-					if(FLAGSKIPCHECKSUM == 0)	{								
-						sha256((uint8_t*)bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bPx2nd_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bPx2nd_checksums[i].backup,rawvalue,32) != 0 )	{		/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(EXIT_FAILURE);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,bloom_bPx2nd_checksums[i].data,bloom_bPx2nd_checksums[i].backup);
 					if(i % 64 == 0)	{
 						printf(".");
 						fflush(stdout);
@@ -1514,6 +1694,7 @@ int main(int argc, char **argv)	{
 				}
 				fclose(fd_aux2);
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				memset(buffer_bloom_file,0,1024);
 				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".blm",bsgs_m2);
 				fd_aux2 = fopen(buffer_bloom_file,"rb");
@@ -1535,7 +1716,7 @@ int main(int argc, char **argv)	{
 			}
 			
 			/*Reading file for bPtable */
-			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+			snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".tbl",bsgs_m3);
 			fd_aux3 = fopen(buffer_bloom_file,"rb");
 			if(fd_aux3 != NULL)	{
 				printf("[+] Reading bP Table from file %s .",buffer_bloom_file);
@@ -1550,19 +1731,15 @@ int main(int argc, char **argv)	{
 					fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 					exit(EXIT_FAILURE);
 				}
-				if(FLAGSKIPCHECKSUM == 0)	{
-					sha256((uint8_t*)bPtable,bytes,(uint8_t*)checksum_backup);
-					if(memcmp(checksum,checksum_backup,32) != 0)	{
-						fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-						exit(EXIT_FAILURE);
-					}
-				}
+				bsgs_checksum_begin(buffer_bloom_file);
+				bsgs_checksum_add((uint8_t*)bPtable,bytes,checksum,NULL);
 				printf("... Done!\n");
+				bsgs_checksum_start();
 				fclose(fd_aux3);
 				FLAGREADEDFILE3 = 1;
 			}
 			else	{
-				FLAGREADEDFILE3 = 0;
+				FLAGREADEDFILE3 = FLAGUPDATEFILE3 = bsgs_table_convert(bsgs_m3);
 			}
 			
 			/*Reading file for 3rd bloom filter */
@@ -1571,6 +1748,7 @@ int main(int argc, char **argv)	{
 			if(fd_aux2 != NULL)	{
 				printf("[+] Reading bloom filter from file %s ",buffer_bloom_file);
 				fflush(stdout);
+				bsgs_checksum_begin(buffer_bloom_file);
 				for(i = 0; i < 256;i++)	{
 					bf_ptr = (char*) bloom_bPx3rd[i].bf;	/*We need to save the current bf pointer*/
 					readed = fread(&bloom_bPx3rd[i],sizeof(struct bloom),1,fd_aux2);
@@ -1589,14 +1767,7 @@ int main(int argc, char **argv)	{
 						fprintf(stderr,"[E] Error reading the file %s\n",buffer_bloom_file);
 						exit(EXIT_FAILURE);
 					}
-					memset(rawvalue,0,32);
-					if(FLAGSKIPCHECKSUM == 0)	{							
-						sha256((uint8_t*)bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,(uint8_t*)rawvalue);
-						if(memcmp(bloom_bPx3rd_checksums[i].data,rawvalue,32) != 0 || memcmp(bloom_bPx3rd_checksums[i].backup,rawvalue,32) != 0 )	{		/* Verification */
-							fprintf(stderr,"[E] Error checksum file mismatch! %s\n",buffer_bloom_file);
-							exit(EXIT_FAILURE);
-						}
-					}
+					bsgs_checksum_add((uint8_t*)bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,bloom_bPx3rd_checksums[i].data,bloom_bPx3rd_checksums[i].backup);
 					if(i % 64 == 0)	{
 						printf(".");
 						fflush(stdout);
@@ -1604,6 +1775,7 @@ int main(int argc, char **argv)	{
 				}
 				fclose(fd_aux2);
 				printf(" Done!\n");
+				bsgs_checksum_start();
 				FLAGREADEDFILE4 = 1;
 			}
 			else	{
@@ -1611,6 +1783,7 @@ int main(int argc, char **argv)	{
 			}
 			
 		}
+		bsgs_checksum_end();	/* The verification of the last file read */
 		
 		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE3 || !FLAGREADEDFILE4)	{
 			if(FLAGREADEDFILE1 == 1)	{
@@ -1840,47 +2013,75 @@ int main(int argc, char **argv)	{
 			}
 		}
 		
-		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE4)	{
+		if(FLAGFUSE && !FLAGREADEDFILE1)	{
+			bsgs_fuse_build();
+		}
+		if(!FLAGREADEDFILE3)	{
+			printf("[+] Sorting %lu elements... ",bsgs_m3);
+			fflush(stdout);
+			bsgs_sort(bPtable,bsgs_m3);
+			printf("Done!\n");
+			fflush(stdout);
+		}
+		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE3 || !FLAGREADEDFILE4 || FLAGUPDATEFILE1 || FLAGUPDATEFILE3)	{
+			/* All the chunks of the new data are hashed by the NTHREADS threads */
 			printf("[+] Making checkums .. ");
 			fflush(stdout);
-		}	
-		if(!FLAGREADEDFILE1)	{
+			sha256_tree_batch_init(&checksum_batch[0],256 * 3 + 1,NTHREADS);
 			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bP[i].bf, bloom_bP[i].bytes,(uint8_t*) bloom_bP_checksums[i].data);
-				memcpy(bloom_bP_checksums[i].backup,bloom_bP_checksums[i].data,32);
+				if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
+					if(FLAGFUSE)	{
+						sha256_tree_batch_add(&checksum_batch[0],(uint8_t*)fuse_bP[i].fingerprints,fuse_bP[i].bytes,(uint8_t*)bloom_bP_checksums[i].data,NULL);
+					}
+					else	{
+						sha256_tree_batch_add(&checksum_batch[0],bloom_bP[i].bf,bloom_bP[i].bytes,(uint8_t*)bloom_bP_checksums[i].data,NULL);
+					}
+				}
+				if(!FLAGREADEDFILE2)	{
+					sha256_tree_batch_add(&checksum_batch[0],bloom_bPx2nd[i].bf,bloom_bPx2nd[i].bytes,(uint8_t*)bloom_bPx2nd_checksums[i].data,NULL);
+				}
+				if(!FLAGREADEDFILE4)	{
+					sha256_tree_batch_add(&checksum_batch[0],bloom_bPx3rd[i].bf,bloom_bPx3rd[i].bytes,(uint8_t*)bloom_bPx3rd_checksums[i].data,NULL);
+				}
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE2)	{
-			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bPx2nd[i].bf, bloom_bPx2nd[i].bytes,(uint8_t*) bloom_bPx2nd_checksums[i].data);
-				memcpy(bloom_bPx2nd_checksums[i].backup,bloom_bPx2nd_checksums[i].data,32);
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
+				sha256_tree_batch_add(&checksum_batch[0],(uint8_t*)bPtable,bytes,(uint8_t*)checksum,NULL);
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE4)	{
+			sha256_tree_batch_wait(&checksum_batch[0]);
 			for(i = 0; i < 256 ; i++)	{
-				sha256((uint8_t*)bloom_bPx3rd[i].bf, bloom_bPx3rd[i].bytes,(uint8_t*) bloom_bPx3rd_checksums[i].data);
+				memcpy(bloom_bP_checksums[i].backup,bloom_bP_checksums[i].data,32);
+				memcpy(bloom_bPx2nd_checksums[i].backup,bloom_bPx2nd_checksums[i].data,32);
 				memcpy(bloom_bPx3rd_checksums[i].backup,bloom_bPx3rd_checksums[i].data,32);
 			}
-			printf(".");
-		}
-		if(!FLAGREADEDFILE1 || !FLAGREADEDFILE2 || !FLAGREADEDFILE4)	{
-			printf(" done\n");
-			fflush(stdout);
-		}	
-		if(!FLAGREADEDFILE3)	{
-			printf("[+] Sorting %lu elements... ",bsgs_m3);
-			fflush(stdout);
-			bsgs_sort(bPtable,bsgs_m3);
-			sha256((uint8_t*)bPtable, bytes,(uint8_t*) checksum);
 			memcpy(checksum_backup,checksum,32);
-			printf("Done!\n");
+			printf("done\n");
 			fflush(stdout);
 		}
-		if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
-			if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_4_%" PRIu64 ".blm",bsgs_m);
+		if(FLAGMMAP)	{
+			if(!FLAGREADEDFILE1)	{
+				snprintf(buffer_bloom_file,1024,FLAGFUSE ? "keyhunt_bsgs_9_%" PRIu64 ".map" : "keyhunt_bsgs_8_%" PRIu64 ".map",bsgs_m);
+				bsgs_map_write(buffer_bloom_file,FLAGFUSE ? NULL : bloom_bP,FLAGFUSE ? fuse_bP : NULL,bloom_bP_checksums);
+			}
+			if(!FLAGREADEDFILE2)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_6_%" PRIu64 ".map",bsgs_m2);
+				bsgs_map_write(buffer_bloom_file,bloom_bPx2nd,NULL,bloom_bPx2nd_checksums);
+			}
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".map",bsgs_m3);
+				bsgs_map_table_write(buffer_bloom_file,bsgs_m3);
+			}
+			if(!FLAGREADEDFILE4)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_7_%" PRIu64 ".map",bsgs_m3);
+				bsgs_map_write(buffer_bloom_file,bloom_bPx3rd,NULL,bloom_bPx3rd_checksums);
+			}
+		}
+		else if(FLAGSAVEREADFILE || FLAGUPDATEFILE1 )	{
+			if(FLAGFUSE && !FLAGREADEDFILE1)	{
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_9_%" PRIu64 ".fus",bsgs_m);
+				bsgs_fuse_write(buffer_bloom_file);
+			}
+			else if(!FLAGREADEDFILE1 || FLAGUPDATEFILE1)	{
+				snprintf(buffer_bloom_file,1024,FLAGBLOOMCLASSIC ? "keyhunt_bsgs_4_%" PRIu64 ".blm" : "keyhunt_bsgs_8_%" PRIu64 ".blm",bsgs_m);
 				
 				if(FLAGUPDATEFILE1)	{
 					printf("[W] Updating old file into a new one\n");
@@ -1960,9 +2161,9 @@ int main(int argc, char **argv)	{
 				}
 			}
 			
-			if(!FLAGREADEDFILE3)	{
+			if(!FLAGREADEDFILE3 || FLAGUPDATEFILE3)	{
 				/* Writing file for bPtable */
-				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_2_%" PRIu64 ".tbl",bsgs_m3);
+				snprintf(buffer_bloom_file,1024,"keyhunt_bsgs_5_%" PRIu64 ".tbl",bsgs_m3);
 				fd_aux3 = fopen(buffer_bloom_file,"wb");
 				if(fd_aux3 != NULL)	{
 					printf("[+] Writing bP Table to file %s .. ",buffer_bloom_file);
@@ -2023,7 +2224,7 @@ int main(int argc, char **argv)	{
 				}
 			}
 		}
-
+		bsgs_table_index();
 
 		i = 0;
 
@@ -2308,32 +2509,6 @@ char *pubkeytopubaddress(char *pkey,int length)	{
 	return pubaddress;	// pubaddress need to be free by te caller funtion
 }
 
-int searchbinary(struct address_value *buffer,char *data,int64_t array_length) {
-	int64_t half,min,max,current;
-	int r = 0,rcmp;
-	min = 0;
-	current = 0;
-	max = array_length;
-	half = array_length;
-	while(!r && half >= 1) {
-		half = (max - min)/2;
-		rcmp = memcmp(data,buffer[current+half].value,20);
-		if(rcmp == 0)	{
-			r = 1;	//Found!!
-		}
-		else	{
-			if(rcmp < 0) { //data < temp_read
-				max = (max-half);
-			}
-			else	{ // data > temp_read
-				min = (min+half);
-			}
-			current = min;
-		}
-	}
-	return r;
-}
-
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process_minikeys(LPVOID vargp) {
 #else
@@ -2458,15 +2633,15 @@ void *thread_process_minikeys(void *vargp)	{
 					
 					for(k = 0; k < 4; k++)	{
 						key_mpz[k].Set32Bytes((uint8_t*)rawvalue[k]);
-						publickey[k] = secp->ComputePublicKey(&key_mpz[k]);
 					}
+					secp->ComputePublicKeys(4,key_mpz,publickey);
 					
 					secp->GetHash160(P2PKH,false,publickey[0],publickey[1],publickey[2],publickey[3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
 					
 					for(k = 0; k < 4; k++)	{
 						r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],20);
 						if(r) {
-							r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
+							r = addrindex_check(&addressIndex,publickeyhashrmd160_uncompress[k]);
 							if(r) {
 								/* hit */
 								hextemp = key_mpz[k].GetBase16();
@@ -2511,42 +2686,77 @@ DWORD WINAPI thread_process(LPVOID vargp) {
 void *thread_process(void *vargp)	{
 #endif
 	struct tothread *tt;
-	Point pts[CPU_GRP_SIZE];
-	Point endomorphism_beta[CPU_GRP_SIZE];
-	Point endomorphism_beta2[CPU_GRP_SIZE];
-	Point endomorphism_negeted_point[4];
+	AffinePoint *pts;
+	AffinePoint *endomorphism_beta = NULL;
+	AffinePoint *endomorphism_beta2 = NULL;
+	AffinePoint endomorphism_negeted_point[HASH_GROUP];
+	FieldElem fbeta,fbeta2;
 	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	BatchStepBase *bstep;
 	Point startP;
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
-	Point pp;
-	Point pn;
-	int i,l,pp_offset,pn_offset,hLength = (CPU_GRP_SIZE / 2 - 1);
+	int i,l;
 	uint64_t j,count;
 	Point R,temporal,publickey;
 	int r,thread_number,continue_flag = 1,k;
 	char *hextemp = NULL;
 	
 	char publickeyhashrmd160[20];
-	char publickeyhashrmd160_uncompress[4][20];
-	char rawvalue[32];
+	char publickeyhashrmd160_uncompress[HASH_GROUP][20];
 	
-	char publickeyhashrmd160_endomorphism[12][4][20];
+	char publickeyhashrmd160_endomorphism[12][HASH_GROUP][20];
+	char xpoints_raw[3][HASH_GROUP][32];
+	uint8_t bloom_hits_endomorphism[12][HASH_GROUP];
+	uint8_t bloom_hits_uncompress[HASH_GROUP];
+	int bloom_rows_first = 0,bloom_rows_last = 0;
+	bool bloom_check_uncompress;
 	
 	bool calculate_y = FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH || FLAGCRYPTO  == CRYPTO_ETH;
+	Int *random_keys = NULL;
+	Point *random_centers = NULL;
+	int random_index = RANDOM_BATCH;
 	Int key_mpz,keyfound,temp_stride;
+	/*
+		Hashes checked for each HASH_GROUP points, rows of publickeyhashrmd160_endomorphism from
+		bloom_rows_first to bloom_rows_last and publickeyhashrmd160_uncompress
+	*/
+	if(FLAGCRYPTO == CRYPTO_BTC)	{
+		if(FLAGENDOMORPHISM)	{
+			bloom_rows_first = (FLAGSEARCH == SEARCH_UNCOMPRESS) ? 6 : 0;
+			bloom_rows_last = (FLAGSEARCH == SEARCH_COMPRESS) ? 6 : 12;
+		}
+		else	{
+			bloom_rows_last = (FLAGSEARCH == SEARCH_UNCOMPRESS) ? 0 : 2;
+		}
+	}
+	else	{
+		bloom_rows_last = FLAGENDOMORPHISM ? 6 : 0;
+	}
+	bloom_check_uncompress = !FLAGENDOMORPHISM && (FLAGCRYPTO == CRYPTO_ETH || FLAGSEARCH != SEARCH_COMPRESS);
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
-	grp->Set(dx);
+	bstep = NewBatchStep(cpu_grp_size,calculate_y,&Gn[0],&_2Gn);
+	pts = bstep->pts;
+	if(FLAGENDOMORPHISM)	{
+		endomorphism_beta = new AffinePoint[cpu_grp_size];
+		endomorphism_beta2 = new AffinePoint[cpu_grp_size];
+		fbeta.Set(&beta);
+		fbeta2.Set(&beta2);
+	}
+	if(FLAGRANDOM)	{
+		random_keys = new Int[RANDOM_BATCH];
+		random_centers = new Point[RANDOM_BATCH];
+	}
 			
 	do {
 		if(FLAGRANDOM){
-			key_mpz.Rand(&n_range_start,&n_range_end);
+			if(random_index == RANDOM_BATCH)	{
+				random_starts(random_keys,random_centers);
+				random_index = 0;
+			}
+			key_mpz.Set(&random_keys[random_index]);
+			startP = random_centers[random_index];
+			random_index++;
 		}
 		else	{
 			if(n_range_start.IsLower(&n_range_end))	{
@@ -2561,6 +2771,11 @@ void *thread_process(void *vargp)	{
 				n_range_start.Add(N_SEQUENTIAL_MAX);
 				pthread_mutex_unlock(&write_random);
 #endif
+				temp_stride.SetInt32(cpu_grp_size / 2);
+				temp_stride.Mult(&stride);
+				key_mpz.Add(&temp_stride);
+				startP = secp->ComputePublicKey(&key_mpz);
+				key_mpz.Sub(&temp_stride);
 			}
 			else	{
 				continue_flag = 0;
@@ -2584,133 +2799,28 @@ void *thread_process(void *vargp)	{
 				}
 			}
 			do {
-				temp_stride.SetInt32(CPU_GRP_SIZE / 2);
-				temp_stride.Mult(&stride);
-				key_mpz.Add(&temp_stride);
-	 			startP = secp->ComputePublicKey(&key_mpz);
-				key_mpz.Sub(&temp_stride);
-
-				for(i = 0; i < hLength; i++) {
-					dx[i].ModSub(&Gn[i].x,&startP.x);
-				}
-			
-				dx[i].ModSub(&Gn[i].x,&startP.x);  // For the first point
-				dx[i + 1].ModSub(&_2Gn.x,&startP.x); // For the next center point
-				grp->ModInv();
-
-				pts[CPU_GRP_SIZE / 2] = startP;
-
-				for(i = 0; i<hLength; i++) {
-					pp = startP;
-					pn = startP;
-
-					// P = startP + i*G
-					dy.ModSub(&Gn[i].y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
+				/* startP is the center of the next group, the previous Step moved it */
+				bstep->Step(&startP);
 
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-					if(calculate_y)	{
-						pp.y.ModSub(&Gn[i].x,&pp.x);
-						pp.y.ModMulK1(&_s);
-						pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-					}
-
-					// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-					dyn.Set(&Gn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-					if(calculate_y)	{
-						pn.y.ModSub(&Gn[i].x,&pn.x);
-						pn.y.ModMulK1(&_s);
-						pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-					}
-
-					pp_offset = CPU_GRP_SIZE / 2 + (i + 1);
-					pn_offset = CPU_GRP_SIZE / 2 - (i + 1);
-
-					pts[pp_offset] = pp;
-					pts[pn_offset] = pn;
-					
-					if(FLAGENDOMORPHISM)	{
-						/*
-							Q = (x,y)
-							For any point Q
-							Q*lambda = (x*beta mod p ,y)
-							Q*lambda is a Scalar Multiplication
-							x*beta is just a Multiplication (Very fast)
-						*/
-						
+				if(FLAGENDOMORPHISM)	{
+					/*
+						Q = (x,y)
+						For any point Q
+						Q*lambda = (x*beta mod p ,y)
+						Q*lambda is a Scalar Multiplication
+						x*beta is just a Multiplication (Very fast)
+					*/
+					for(i = 0; i < cpu_grp_size; i++)	{
 						if( calculate_y  )	{
-							endomorphism_beta[pp_offset].y.Set(&pp.y);
-							endomorphism_beta[pn_offset].y.Set(&pn.y);
-							endomorphism_beta2[pp_offset].y.Set(&pp.y);
-							endomorphism_beta2[pn_offset].y.Set(&pn.y);
+							endomorphism_beta[i].y = pts[i].y;
+							endomorphism_beta2[i].y = pts[i].y;
 						}
-						endomorphism_beta[pp_offset].x.ModMulK1(&pp.x, &beta);
-						endomorphism_beta[pn_offset].x.ModMulK1(&pn.x, &beta);
-						endomorphism_beta2[pp_offset].x.ModMulK1(&pp.x, &beta2);
-						endomorphism_beta2[pn_offset].x.ModMulK1(&pn.x, &beta2);
-					}
-				}
-				/*
-					Half point for endomorphism because pts[CPU_GRP_SIZE / 2] was not calcualte in the previous cycle
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-
-						endomorphism_beta[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-						endomorphism_beta2[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-					}
-					endomorphism_beta[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta);
-					endomorphism_beta2[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta2);
-				}
-
-				// First point (startP - (GRP_SZIE/2)*G)
-				pn = startP;
-				dyn.Set(&Gn[i].y);
-				dyn.ModNeg();
-				dyn.ModSub(&pn.y);
-
-				_s.ModMulK1(&dyn,&dx[i]);
-				_p.ModSquareK1(&_s);
-
-				pn.x.ModNeg();
-				pn.x.ModAdd(&_p);
-				pn.x.ModSub(&Gn[i].x);
-				
-				if(calculate_y)	{
-					pn.y.ModSub(&Gn[i].x,&pn.x);
-					pn.y.ModMulK1(&_s);
-					pn.y.ModAdd(&Gn[i].y);
-				}
-
-				pts[0] = pn;
-				
-				/*
-					First point for endomorphism because pts[0] was not calcualte previously
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-						endomorphism_beta[0].y.Set(&pn.y);
-						endomorphism_beta2[0].y.Set(&pn.y);
+						endomorphism_beta[i].x.ModMulK1(&pts[i].x, &fbeta);
+						endomorphism_beta2[i].x.ModMulK1(&pts[i].x, &fbeta2);
 					}
-					endomorphism_beta[0].x.ModMulK1(&pn.x, &beta);
-					endomorphism_beta2[0].x.ModMulK1(&pn.x, &beta2);
 				}
 								
-				for(j = 0; j < CPU_GRP_SIZE/4;j++){
+				for(j = 0; j < (uint64_t)cpu_grp_size/HASH_GROUP;j++){
 					switch(FLAGMODE)	{
 						case MODE_RMD160:
 						case MODE_ADDRESS:
@@ -2718,84 +2828,102 @@ void *thread_process(void *vargp)	{
 								
 								if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH ){
 									if(FLAGENDOMORPHISM)	{
-										secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+										secp->GetHash160_fromX(&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[0],(uint8_t*)publickeyhashrmd160_endomorphism[1]);
 
-										secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
+										secp->GetHash160_fromX(&endomorphism_beta[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[2],(uint8_t*)publickeyhashrmd160_endomorphism[3]);
 
-										secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
+										secp->GetHash160_fromX(&endomorphism_beta2[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[4],(uint8_t*)publickeyhashrmd160_endomorphism[5]);
 									}
 									else	{
-										secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-										secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+										secp->GetHash160_fromX(&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[0],(uint8_t*)publickeyhashrmd160_endomorphism[1]);
 									}
 									
 								}
 								if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH){
 									if(FLAGENDOMORPHISM)	{
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(pts[(j*4)+l]);
+										for(l = 0; l < HASH_GROUP; l++)	{
+											endomorphism_negeted_point[l].SetNegation(&pts[(j*HASH_GROUP)+l]);
 										}
-										secp->GetHash160(P2PKH,false, pts[(j*4)], pts[(j*4)+1], pts[(j*4)+2], pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3]);
-										secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0] ,endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta[(j*4)+l]);
+										secp->GetHash160(false,&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[6]);
+										secp->GetHash160(false,endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[7]);
+										for(l = 0; l < HASH_GROUP; l++)	{
+											endomorphism_negeted_point[l].SetNegation(&endomorphism_beta[(j*HASH_GROUP)+l]);
 										}
-										secp->GetHash160(P2PKH,false,endomorphism_beta[(j*4)],  endomorphism_beta[(j*4)+1], endomorphism_beta[(j*4)+2], endomorphism_beta[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3]);
-										secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
+										secp->GetHash160(false,&endomorphism_beta[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[8]);
+										secp->GetHash160(false,endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[9]);
 
-										for(l = 0; l < 4; l++)	{
-											endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta2[(j*4)+l]);
+										for(l = 0; l < HASH_GROUP; l++)	{
+											endomorphism_negeted_point[l].SetNegation(&endomorphism_beta2[(j*HASH_GROUP)+l]);
 										}
-										secp->GetHash160(P2PKH,false, endomorphism_beta2[(j*4)],  endomorphism_beta2[(j*4)+1] ,  endomorphism_beta2[(j*4)+2] ,  endomorphism_beta2[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3]);
-										secp->GetHash160(P2PKH,false, endomorphism_negeted_point[0], endomorphism_negeted_point[1],   endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
+										secp->GetHash160(false,&endomorphism_beta2[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[10]);
+										secp->GetHash160(false,endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[11]);
 
 									}
 									else	{
-										secp->GetHash160(P2PKH,false,pts[(j*4)],pts[(j*4)+1],pts[(j*4)+2],pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
+										secp->GetHash160(false,&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_uncompress);
 										
 									}
 								}
 							}								
 							else if(FLAGCRYPTO == CRYPTO_ETH){
+								/* Keccak of whole groups, rows 1, 3 and 5 are the negated points */
 								if(FLAGENDOMORPHISM)	{
-									for(k = 0; k < 4;k++)	{
-										endomorphism_negeted_point[k] = secp->Negation(pts[(j*4)+k]);
-										generate_binaddress_eth(pts[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[0][k]);
-										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[1][k]);
-										endomorphism_negeted_point[k] = secp->Negation(endomorphism_beta[(j*4)+k]);
-										generate_binaddress_eth(endomorphism_beta[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[2][k]);
-										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[3][k]);
-										endomorphism_negeted_point[k] = secp->Negation(endomorphism_beta2[(j*4)+k]);
-										generate_binaddress_eth(endomorphism_beta[(4*j)+k],(uint8_t*)publickeyhashrmd160_endomorphism[4][k]);
-										generate_binaddress_eth(endomorphism_negeted_point[k],(uint8_t*)publickeyhashrmd160_endomorphism[5][k]);
+									generate_binaddress_eth_group(&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[0]);
+									for(k = 0; k < HASH_GROUP;k++)	{
+										endomorphism_negeted_point[k].SetNegation(&pts[(j*HASH_GROUP)+k]);
+									}
+									generate_binaddress_eth_group(endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[1]);
+									generate_binaddress_eth_group(&endomorphism_beta[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[2]);
+									for(k = 0; k < HASH_GROUP;k++)	{
+										endomorphism_negeted_point[k].SetNegation(&endomorphism_beta[(j*HASH_GROUP)+k]);
 									}
+									generate_binaddress_eth_group(endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[3]);
+									generate_binaddress_eth_group(&endomorphism_beta2[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[4]);
+									for(k = 0; k < HASH_GROUP;k++)	{
+										endomorphism_negeted_point[k].SetNegation(&endomorphism_beta2[(j*HASH_GROUP)+k]);
+									}
+									generate_binaddress_eth_group(endomorphism_negeted_point,HASH_GROUP,(uint8_t*)publickeyhashrmd160_endomorphism[5]);
 								}
 								else	{
-									for(k = 0; k < 4;k++)	{
-										generate_binaddress_eth(pts[(4*j)+k],(uint8_t*)publickeyhashrmd160_uncompress[k]);
-									}
+									generate_binaddress_eth_group(&pts[j*HASH_GROUP],HASH_GROUP,(uint8_t*)publickeyhashrmd160_uncompress);
 								}
 								
 							}
 						break;
 					}
 
+					/* All the values of these HASH_GROUP points go to the bloom filter in one batch, their probes are prefetched together */
+					if(FLAGMODE == MODE_XPOINT)	{
+						for(k = 0; k < HASH_GROUP;k++)	{
+							pts[(HASH_GROUP*j)+k].x.Get32Bytes((unsigned char *)xpoints_raw[0][k]);
+							if(FLAGENDOMORPHISM)	{
+								endomorphism_beta[(j*HASH_GROUP)+k].x.Get32Bytes((unsigned char *)xpoints_raw[1][k]);
+								endomorphism_beta2[(j*HASH_GROUP)+k].x.Get32Bytes((unsigned char *)xpoints_raw[2][k]);
+							}
+						}
+						bloom_check_batch(&bloom,(uint8_t*)xpoints_raw[0][0],MAXLENGTHADDRESS,32,FLAGENDOMORPHISM ? 3 * HASH_GROUP : HASH_GROUP,bloom_hits_endomorphism[0]);
+					}
+					else	{
+						if(bloom_rows_last > bloom_rows_first)	{
+							bloom_check_batch(&bloom,(uint8_t*)publickeyhashrmd160_endomorphism[bloom_rows_first][0],MAXLENGTHADDRESS,20,(bloom_rows_last - bloom_rows_first) * HASH_GROUP,bloom_hits_endomorphism[bloom_rows_first]);
+						}
+						if(bloom_check_uncompress)	{
+							bloom_check_batch(&bloom,(uint8_t*)publickeyhashrmd160_uncompress[0],MAXLENGTHADDRESS,20,HASH_GROUP,bloom_hits_uncompress);
+						}
+					}
 
 					switch(FLAGMODE)	{
 						case MODE_RMD160:
 						case MODE_ADDRESS:
 							if( FLAGCRYPTO  == CRYPTO_BTC) {
 								
-								for(k = 0; k < 4;k++)	{
+								for(k = 0; k < HASH_GROUP;k++)	{
 									if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH){
 										if(FLAGENDOMORPHISM)	{
 											for(l = 0;l < 6; l++)	{
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+												r = bloom_hits_endomorphism[l][k];
 												if(r) {
-													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
+													r = addrindex_check(&addressIndex,publickeyhashrmd160_endomorphism[l][k]);
 													if(r) {
 														keyfound.SetInt32(k);
 														keyfound.Mult(&stride);
@@ -2856,9 +2984,9 @@ void *thread_process(void *vargp)	{
 										}
 										else	{
 											for(l = 0;l < 2; l++)	{
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+												r = bloom_hits_endomorphism[l][k];
 												if(r) {
-													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
+													r = addrindex_check(&addressIndex,publickeyhashrmd160_endomorphism[l][k]);
 													if(r) {
 														keyfound.SetInt32(k);
 														keyfound.Mult(&stride);
@@ -2880,9 +3008,9 @@ void *thread_process(void *vargp)	{
 									if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
 										if(FLAGENDOMORPHISM)	{
 											for(l = 6;l < 12; l++)	{	//We check the array from 6 to 12(excluded) because we save the uncompressed information there
-												r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);	//Check in Bloom filter
+												r = bloom_hits_endomorphism[l][k];	//Check in Bloom filter
 												if(r) {
-													r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);		//Check in Array using Binary search
+													r = addrindex_check(&addressIndex,publickeyhashrmd160_endomorphism[l][k]);		//Check in Array using the lookup index
 													if(r) {
 														keyfound.SetInt32(k);
 														keyfound.Mult(&stride);
@@ -2924,9 +3052,9 @@ void *thread_process(void *vargp)	{
 											}
 										}
 										else	{
-											r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
+											r = bloom_hits_uncompress[k];
 											if(r) {
-												r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
+												r = addrindex_check(&addressIndex,publickeyhashrmd160_uncompress[k]);
 												if(r) {
 													keyfound.SetInt32(k);
 													keyfound.Mult(&stride);
@@ -2940,11 +3068,11 @@ void *thread_process(void *vargp)	{
 							}
 							else if( FLAGCRYPTO == CRYPTO_ETH) {
 								if(FLAGENDOMORPHISM)	{
-									for(k = 0; k < 4;k++)	{
+									for(k = 0; k < HASH_GROUP;k++)	{
 										for(l = 0;l < 6; l++)	{
-											r = bloom_check(&bloom,publickeyhashrmd160_endomorphism[l][k],MAXLENGTHADDRESS);
+											r = bloom_hits_endomorphism[l][k];
 											if(r) {
-												r = searchbinary(addressTable,publickeyhashrmd160_endomorphism[l][k],N);
+												r = addrindex_check(&addressIndex,publickeyhashrmd160_endomorphism[l][k]);
 												if(r) {												
 													keyfound.SetInt32(k);
 													keyfound.Mult(&stride);
@@ -2987,10 +3115,10 @@ void *thread_process(void *vargp)	{
 									}
 								}
 								else	{
-									for(k = 0; k < 4;k++)	{
-										r = bloom_check(&bloom,publickeyhashrmd160_uncompress[k],MAXLENGTHADDRESS);
+									for(k = 0; k < HASH_GROUP;k++)	{
+										r = bloom_hits_uncompress[k];
 										if(r) {
-											r = searchbinary(addressTable,publickeyhashrmd160_uncompress[k],N);
+											r = addrindex_check(&addressIndex,publickeyhashrmd160_uncompress[k]);
 											if(r) {
 												keyfound.SetInt32(k);
 												keyfound.Mult(&stride);
@@ -3003,12 +3131,11 @@ void *thread_process(void *vargp)	{
 							}
 						break;
 						case MODE_XPOINT:
-							for(k = 0; k < 4;k++)	{
+							for(k = 0; k < HASH_GROUP;k++)	{
 								if(FLAGENDOMORPHISM)	{
-									pts[(4*j)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									r = bloom_hits_endomorphism[0][k];
 									if(r) {
-										r = searchbinary(addressTable,rawvalue,N);
+										r = addrindex_check(&addressIndex,xpoints_raw[0][k]);
 										if(r) {
 											keyfound.SetInt32(k);
 											keyfound.Mult(&stride);
@@ -3017,10 +3144,9 @@ void *thread_process(void *vargp)	{
 											writekey(false,&keyfound);
 										}
 									}
-									endomorphism_beta[(j*4)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									r = bloom_hits_endomorphism[1][k];
 									if(r) {
-										r = searchbinary(addressTable,rawvalue,N);
+										r = addrindex_check(&addressIndex,xpoints_raw[1][k]);
 										if(r) {
 											keyfound.SetInt32(k);
 											keyfound.Mult(&stride);
@@ -3031,10 +3157,9 @@ void *thread_process(void *vargp)	{
 										}
 									}
 									
-									endomorphism_beta2[(j*4)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									r = bloom_hits_endomorphism[2][k];
 									if(r) {
-										r = searchbinary(addressTable,rawvalue,N);
+										r = addrindex_check(&addressIndex,xpoints_raw[2][k]);
 										if(r) {
 											keyfound.SetInt32(k);
 											keyfound.Mult(&stride);
@@ -3045,10 +3170,9 @@ void *thread_process(void *vargp)	{
 									}
 								}
 								else	{
-									pts[(4*j)+k].x.Get32Bytes((unsigned char *)rawvalue);
-									r = bloom_check(&bloom,rawvalue,MAXLENGTHADDRESS);
+									r = bloom_hits_endomorphism[0][k];
 									if(r) {
-										r = searchbinary(addressTable,rawvalue,N);
+										r = addrindex_check(&addressIndex,xpoints_raw[0][k]);
 										if(r) {
 											keyfound.SetInt32(k);
 											keyfound.Mult(&stride);
@@ -3061,8 +3185,8 @@ void *thread_process(void *vargp)	{
 							}
 						break;
 					}
-					count+=4;
-					temp_stride.SetInt32(4);
+					count+=HASH_GROUP;
+					temp_stride.SetInt32(HASH_GROUP);
 					temp_stride.Mult(&stride);
 					key_mpz.Add(&temp_stride);
 				}
@@ -3074,26 +3198,14 @@ void *thread_process(void *vargp)	{
 				*/
 
 				steps[thread_number]++;
-
-				// Next start point (startP + GRP_SIZE*G)
-				pp = startP;
-				dy.ModSub(&_2Gn.y,&pp.y);
-
-				_s.ModMulK1(&dy,&dx[i + 1]);
-				_p.ModSquareK1(&_s);
-
-				pp.x.ModNeg();
-				pp.x.ModAdd(&_p);
-				pp.x.ModSub(&_2Gn.x);
-
-				//The Y value for the next start point always need to be calculated
-				pp.y.ModSub(&_2Gn.x,&pp.x);
-				pp.y.ModMulK1(&_s);
-				pp.y.ModSub(&_2Gn.y);
-				startP = pp;
 			}while(count < N_SEQUENTIAL_MAX && continue_flag);
 		}
 	} while(continue_flag);
+	delete[] endomorphism_beta;
+	delete[] endomorphism_beta2;
+	delete[] random_keys;
+	delete[] random_centers;
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -3105,22 +3217,15 @@ DWORD WINAPI thread_process_vanity(LPVOID vargp) {
 void *thread_process_vanity(void *vargp)	{
 #endif
 	struct tothread *tt;
-	Point pts[CPU_GRP_SIZE];
-	Point endomorphism_beta[CPU_GRP_SIZE];
-	Point endomorphism_beta2[CPU_GRP_SIZE];
-	Point endomorphism_negeted_point[4];
+	AffinePoint *pts;
+	AffinePoint *endomorphism_beta = NULL;
+	AffinePoint *endomorphism_beta2 = NULL;
+	AffinePoint endomorphism_negeted_point[4];
+	FieldElem fbeta,fbeta2;
 		
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	BatchStepBase *bstep;
 	Point startP;
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
-	Point pp;	//point positive
-	Point pn;	//point negative
-	int l,pp_offset,pn_offset,i,hLength = (CPU_GRP_SIZE / 2 - 1);
+	int l,i;
 	uint64_t j,count;
 	Point R,temporal,publickey;
 	int thread_number,continue_flag = 1,k;
@@ -3130,16 +3235,30 @@ void *thread_process_vanity(void *vargp)	{
 	
 	char publickeyhashrmd160_endomorphism[12][4][20];
 	
+	Int *random_keys = NULL;
+	Point *random_centers = NULL;
+	int random_index = RANDOM_BATCH;
 	Int key_mpz,temp_stride,keyfound;
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
-	grp->Set(dx);
 	
 	
 	//if FLAGENDOMORPHISM  == 1 and only compress search is enabled then there is no need to calculate the Y value value					
 	
 	bool calculate_y = FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH;
+	bstep = NewBatchStep(cpu_grp_size,calculate_y,&Gn[0],&_2Gn);
+	pts = bstep->pts;
+	if(FLAGENDOMORPHISM)	{
+		endomorphism_beta = new AffinePoint[cpu_grp_size];
+		endomorphism_beta2 = new AffinePoint[cpu_grp_size];
+		fbeta.Set(&beta);
+		fbeta2.Set(&beta2);
+	}
+	if(FLAGRANDOM)	{
+		random_keys = new Int[RANDOM_BATCH];
+		random_centers = new Point[RANDOM_BATCH];
+	}
 	
 	/*
 	if(FLAGDEBUG && thread_number == 0)	{
@@ -3156,7 +3275,13 @@ void *thread_process_vanity(void *vargp)	{
 
 	do {
 		if(FLAGRANDOM){
-			key_mpz.Rand(&n_range_start,&n_range_end);
+			if(random_index == RANDOM_BATCH)	{
+				random_starts(random_keys,random_centers);
+				random_index = 0;
+			}
+			key_mpz.Set(&random_keys[random_index]);
+			startP = random_centers[random_index];
+			random_index++;
 		}
 		else	{
 			if(n_range_start.IsLower(&n_range_end))	{
@@ -3171,6 +3296,11 @@ void *thread_process_vanity(void *vargp)	{
 				n_range_start.Add(N_SEQUENTIAL_MAX);
 				pthread_mutex_unlock(&write_random);
 #endif
+				temp_stride.SetInt32(cpu_grp_size / 2);
+				temp_stride.Mult(&stride);
+				key_mpz.Add(&temp_stride);
+				startP = secp->ComputePublicKey(&key_mpz);
+				key_mpz.Sub(&temp_stride);
 			}
 			else	{
 				continue_flag = 0;
@@ -3194,169 +3324,62 @@ void *thread_process_vanity(void *vargp)	{
 				}
 			}
 			do {
-				temp_stride.SetInt32(CPU_GRP_SIZE / 2);
-				temp_stride.Mult(&stride);
-				key_mpz.Add(&temp_stride);
-	 			startP = secp->ComputePublicKey(&key_mpz);
-				key_mpz.Sub(&temp_stride);
-
-				for(i = 0; i < hLength; i++) {
-					dx[i].ModSub(&Gn[i].x,&startP.x);
-				}
-			
-				dx[i].ModSub(&Gn[i].x,&startP.x);  // For the first point
-				dx[i + 1].ModSub(&_2Gn.x,&startP.x); // For the next center point
-				grp->ModInv();
+				/* startP is the center of the next group, the previous Step moved it */
+				bstep->Step(&startP);
 
-				pts[CPU_GRP_SIZE / 2] = startP;
-
-				for(i = 0; i<hLength; i++) {
-					pp = startP;
-					pn = startP;
-
-					// P = startP + i*G
-					dy.ModSub(&Gn[i].y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-					
-					if(calculate_y)	{
-						pp.y.ModSub(&Gn[i].x,&pp.x);
-						pp.y.ModMulK1(&_s);
-						pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-					}
-
-					// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-					dyn.Set(&Gn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-					_p.ModSquareK1(&_s);            // _p = pow2(s)
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-					if( calculate_y  )	{
-						pn.y.ModSub(&Gn[i].x,&pn.x);
-						pn.y.ModMulK1(&_s);
-						pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-					}
-					pp_offset = CPU_GRP_SIZE / 2 + (i + 1);
-					pn_offset = CPU_GRP_SIZE / 2 - (i + 1);
-
-					pts[pp_offset] = pp;
-					pts[pn_offset] = pn;
-					
-					if(FLAGENDOMORPHISM)	{
-						/*
-							Q = (x,y)
-							For any point Q
-							Q*lambda = (x*beta mod p ,y)
-							Q*lambda is a Scalar Multiplication
-							x*beta is just a Multiplication (Very fast)
-						*/
-						
+				if(FLAGENDOMORPHISM)	{
+					/*
+						Q = (x,y)
+						For any point Q
+						Q*lambda = (x*beta mod p ,y)
+						Q*lambda is a Scalar Multiplication
+						x*beta is just a Multiplication (Very fast)
+					*/
+					for(i = 0; i < cpu_grp_size; i++)	{
 						if( calculate_y  )	{
-							endomorphism_beta[pp_offset].y.Set(&pp.y);
-							endomorphism_beta[pn_offset].y.Set(&pn.y);
-							endomorphism_beta2[pp_offset].y.Set(&pp.y);
-							endomorphism_beta2[pn_offset].y.Set(&pn.y);
+							endomorphism_beta[i].y = pts[i].y;
+							endomorphism_beta2[i].y = pts[i].y;
 						}
-						endomorphism_beta[pp_offset].x.ModMulK1(&pp.x, &beta);
-						endomorphism_beta[pn_offset].x.ModMulK1(&pn.x, &beta);
-						endomorphism_beta2[pp_offset].x.ModMulK1(&pp.x, &beta2);
-						endomorphism_beta2[pn_offset].x.ModMulK1(&pn.x, &beta2);
+						endomorphism_beta[i].x.ModMulK1(&pts[i].x, &fbeta);
+						endomorphism_beta2[i].x.ModMulK1(&pts[i].x, &fbeta2);
 					}
 				}
-				/*
-					Half point for endomorphism because pts[CPU_GRP_SIZE / 2] was not calcualte in the previous cycle
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-
-						endomorphism_beta[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-						endomorphism_beta2[CPU_GRP_SIZE / 2].y.Set(&pts[CPU_GRP_SIZE / 2].y);
-					}
-					endomorphism_beta[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta);
-					endomorphism_beta2[CPU_GRP_SIZE / 2].x.ModMulK1(&pts[CPU_GRP_SIZE / 2].x, &beta2);
-				}
-				
-				// First point (startP - (GRP_SZIE/2)*G)
-				pn = startP;
-				dyn.Set(&Gn[i].y);
-				dyn.ModNeg();
-				dyn.ModSub(&pn.y);
-
-				_s.ModMulK1(&dyn,&dx[i]);
-				_p.ModSquareK1(&_s);
-
-				pn.x.ModNeg();
-				pn.x.ModAdd(&_p);
-				pn.x.ModSub(&Gn[i].x);
-				
-				if(calculate_y )	{
-					pn.y.ModSub(&Gn[i].x,&pn.x);
-					pn.y.ModMulK1(&_s);
-					pn.y.ModAdd(&Gn[i].y);
-				}
-				pts[0] = pn;
-				
-				/*
-					First point for endomorphism because pts[0] was not calcualte previously
-				*/
-				if(FLAGENDOMORPHISM)	{
-					if( calculate_y  )	{
-						endomorphism_beta[0].y.Set(&pn.y);
-						endomorphism_beta2[0].y.Set(&pn.y);
-					}
-					endomorphism_beta[0].x.ModMulK1(&pn.x, &beta);
-					endomorphism_beta2[0].x.ModMulK1(&pn.x, &beta2);
-				}
 				
-				for(j = 0; j < CPU_GRP_SIZE/4;j++)	{
+				for(j = 0; j < (uint64_t)cpu_grp_size/4;j++)	{
 					if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH ){
 						if(FLAGENDOMORPHISM)	{
-							secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+							secp->GetHash160_fromX(&pts[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[0],(uint8_t*)publickeyhashrmd160_endomorphism[1]);
 
-							secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[2][0],(uint8_t*)publickeyhashrmd160_endomorphism[2][1],(uint8_t*)publickeyhashrmd160_endomorphism[2][2],(uint8_t*)publickeyhashrmd160_endomorphism[2][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta[(j*4)].x,&endomorphism_beta[(j*4)+1].x,&endomorphism_beta[(j*4)+2].x,&endomorphism_beta[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[3][0],(uint8_t*)publickeyhashrmd160_endomorphism[3][1],(uint8_t*)publickeyhashrmd160_endomorphism[3][2],(uint8_t*)publickeyhashrmd160_endomorphism[3][3]);
+							secp->GetHash160_fromX(&endomorphism_beta[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[2],(uint8_t*)publickeyhashrmd160_endomorphism[3]);
 
-							secp->GetHash160_fromX(P2PKH,0x02,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[4][0],(uint8_t*)publickeyhashrmd160_endomorphism[4][1],(uint8_t*)publickeyhashrmd160_endomorphism[4][2],(uint8_t*)publickeyhashrmd160_endomorphism[4][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&endomorphism_beta2[(j*4)].x,&endomorphism_beta2[(j*4)+1].x,&endomorphism_beta2[(j*4)+2].x,&endomorphism_beta2[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[5][0],(uint8_t*)publickeyhashrmd160_endomorphism[5][1],(uint8_t*)publickeyhashrmd160_endomorphism[5][2],(uint8_t*)publickeyhashrmd160_endomorphism[5][3]);
+							secp->GetHash160_fromX(&endomorphism_beta2[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[4],(uint8_t*)publickeyhashrmd160_endomorphism[5]);
 
 						}
 						else	{
-							secp->GetHash160_fromX(P2PKH,0x02,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[0][0],(uint8_t*)publickeyhashrmd160_endomorphism[0][1],(uint8_t*)publickeyhashrmd160_endomorphism[0][2],(uint8_t*)publickeyhashrmd160_endomorphism[0][3]);
-							secp->GetHash160_fromX(P2PKH,0x03,&pts[(j*4)].x,&pts[(j*4)+1].x,&pts[(j*4)+2].x,&pts[(j*4)+3].x,(uint8_t*)publickeyhashrmd160_endomorphism[1][0],(uint8_t*)publickeyhashrmd160_endomorphism[1][1],(uint8_t*)publickeyhashrmd160_endomorphism[1][2],(uint8_t*)publickeyhashrmd160_endomorphism[1][3]);
+							secp->GetHash160_fromX(&pts[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[0],(uint8_t*)publickeyhashrmd160_endomorphism[1]);
 						}
 					}
 					if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
 						if(FLAGENDOMORPHISM)	{
 							for(l = 0; l < 4; l++)	{
-								endomorphism_negeted_point[l] = secp->Negation(pts[(j*4)+l]);
+								endomorphism_negeted_point[l].SetNegation(&pts[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false, pts[(j*4)], pts[(j*4)+1], pts[(j*4)+2], pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_endomorphism[6][0],(uint8_t*)publickeyhashrmd160_endomorphism[6][1],(uint8_t*)publickeyhashrmd160_endomorphism[6][2],(uint8_t*)publickeyhashrmd160_endomorphism[6][3]);
-							secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0] ,endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[7][0],(uint8_t*)publickeyhashrmd160_endomorphism[7][1],(uint8_t*)publickeyhashrmd160_endomorphism[7][2],(uint8_t*)publickeyhashrmd160_endomorphism[7][3]);
+							secp->GetHash160(false,&pts[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[6]);
+							secp->GetHash160(false,endomorphism_negeted_point,4,(uint8_t*)publickeyhashrmd160_endomorphism[7]);
 							for(l = 0; l < 4; l++)	{
-								endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta[(j*4)+l]);
+								endomorphism_negeted_point[l].SetNegation(&endomorphism_beta[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false,endomorphism_beta[(j*4)],  endomorphism_beta[(j*4)+1], endomorphism_beta[(j*4)+2], endomorphism_beta[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[8][0],(uint8_t*)publickeyhashrmd160_endomorphism[8][1],(uint8_t*)publickeyhashrmd160_endomorphism[8][2],(uint8_t*)publickeyhashrmd160_endomorphism[8][3]);
-							secp->GetHash160(P2PKH,false,endomorphism_negeted_point[0],endomorphism_negeted_point[1],endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[9][0],(uint8_t*)publickeyhashrmd160_endomorphism[9][1],(uint8_t*)publickeyhashrmd160_endomorphism[9][2],(uint8_t*)publickeyhashrmd160_endomorphism[9][3]);
+							secp->GetHash160(false,&endomorphism_beta[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[8]);
+							secp->GetHash160(false,endomorphism_negeted_point,4,(uint8_t*)publickeyhashrmd160_endomorphism[9]);
 
 							for(l = 0; l < 4; l++)	{
-								endomorphism_negeted_point[l] = secp->Negation(endomorphism_beta2[(j*4)+l]);
+								endomorphism_negeted_point[l].SetNegation(&endomorphism_beta2[(j*4)+l]);
 							}
-							secp->GetHash160(P2PKH,false, endomorphism_beta2[(j*4)],  endomorphism_beta2[(j*4)+1] ,  endomorphism_beta2[(j*4)+2] ,  endomorphism_beta2[(j*4)+3] ,(uint8_t*)publickeyhashrmd160_endomorphism[10][0],(uint8_t*)publickeyhashrmd160_endomorphism[10][1],(uint8_t*)publickeyhashrmd160_endomorphism[10][2],(uint8_t*)publickeyhashrmd160_endomorphism[10][3]);
-							secp->GetHash160(P2PKH,false, endomorphism_negeted_point[0], endomorphism_negeted_point[1],   endomorphism_negeted_point[2],endomorphism_negeted_point[3],(uint8_t*)publickeyhashrmd160_endomorphism[11][0],(uint8_t*)publickeyhashrmd160_endomorphism[11][1],(uint8_t*)publickeyhashrmd160_endomorphism[11][2],(uint8_t*)publickeyhashrmd160_endomorphism[11][3]);
+							secp->GetHash160(false,&endomorphism_beta2[j*4],4,(uint8_t*)publickeyhashrmd160_endomorphism[10]);
+							secp->GetHash160(false,endomorphism_negeted_point,4,(uint8_t*)publickeyhashrmd160_endomorphism[11]);
 						}
 						else	{
-							secp->GetHash160(P2PKH,false,pts[(j*4)],pts[(j*4)+1],pts[(j*4)+2],pts[(j*4)+3],(uint8_t*)publickeyhashrmd160_uncompress[0],(uint8_t*)publickeyhashrmd160_uncompress[1],(uint8_t*)publickeyhashrmd160_uncompress[2],(uint8_t*)publickeyhashrmd160_uncompress[3]);
+							secp->GetHash160(false,&pts[j*4],4,(uint8_t*)publickeyhashrmd160_uncompress);
 							
 						}
 					}
@@ -3511,265 +3534,119 @@ void *thread_process_vanity(void *vargp)	{
 					key_mpz.Add(&temp_stride);
 				}
 				steps[thread_number]++;
-
-				// Next start point (startP + GRP_SIZE*G)
-				pp = startP;
-				dy.ModSub(&_2Gn.y,&pp.y);
-
-				_s.ModMulK1(&dy,&dx[i + 1]);
-				_p.ModSquareK1(&_s);
-
-				pp.x.ModNeg();
-				pp.x.ModAdd(&_p);
-				pp.x.ModSub(&_2Gn.x);
-				
-				//The Y value for the next start point always need to be calculated
-				pp.y.ModSub(&_2Gn.x,&pp.x);
-				pp.y.ModMulK1(&_s);
-				pp.y.ModSub(&_2Gn.y);
-				startP = pp;
 			}while(count < N_SEQUENTIAL_MAX && continue_flag);
 		}
 	} while(continue_flag);
+	delete[] endomorphism_beta;
+	delete[] endomorphism_beta2;
+	delete[] random_keys;
+	delete[] random_centers;
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
 
-void _swap(struct address_value *a,struct address_value *b)	{
-	struct address_value t;
-	t  = *a;
-	*a = *b;
-	*b =  t;
-}
-
+/* Radix sort of the whole 20 bytes value with the NTHREADS threads */
 void _sort(struct address_value *arr,int64_t n)	{
-	uint32_t depthLimit = ((uint32_t) ceil(log(n))) * 2;
-	_introsort(arr,depthLimit,n);
+	radixsort(arr,n,sizeof(struct address_value),sizeof(struct address_value),NTHREADS);
 }
 
-void _introsort(struct address_value *arr,uint32_t depthLimit, int64_t n) {
-	int64_t p;
-	if(n > 1)	{
-		if(n <= 16) {
-			_insertionsort(arr,n);
-		}
-		else	{
-			if(depthLimit == 0) {
-				_myheapsort(arr,n);
-			}
-			else	{
-				p = _partition(arr,n);
-				if(p > 0) _introsort(arr , depthLimit-1 , p);
-				if(p < n) _introsort(&arr[p+1],depthLimit-1,n-(p+1));
-			}
-		}
-	}
-}
-
-void _insertionsort(struct address_value *arr, int64_t n) {
-	int64_t j;
-	int64_t i;
-	struct address_value key;
-	for(i = 1; i < n ; i++ ) {
-		key = arr[i];
-		j= i-1;
-		while(j >= 0 && memcmp(arr[j].value,key.value,20) > 0) {
-			arr[j+1] = arr[j];
-			j--;
-		}
-		arr[j+1] = key;
-	}
-}
-
-int64_t _partition(struct address_value *arr, int64_t n)	{
-	struct address_value pivot;
-	int64_t r,left,right;
-	r = n/2;
-	pivot = arr[r];
-	left = 0;
-	right = n-1;
-	do {
-		while(left	< right && memcmp(arr[left].value,pivot.value,20) <= 0 )	{
-			left++;
-		}
-		while(right >= left && memcmp(arr[right].value,pivot.value,20) > 0)	{
-			right--;
-		}
-		if(left < right)	{
-			if(left == r || right == r)	{
-				if(left == r)	{
-					r = right;
-				}
-				if(right == r)	{
-					r = left;
-				}
-			}
-			_swap(&arr[right],&arr[left]);
-		}
-	}while(left < right);
-	if(right != r)	{
-		_swap(&arr[right],&arr[r]);
-	}
-	return right;
-}
-
-void _heapify(struct address_value *arr, int64_t n, int64_t i) {
-	int64_t largest = i;
-	int64_t l = 2 * i + 1;
-	int64_t r = 2 * i + 2;
-	if (l < n && memcmp(arr[l].value,arr[largest].value,20) > 0)
-		largest = l;
-	if (r < n && memcmp(arr[r].value,arr[largest].value,20) > 0)
-		largest = r;
-	if (largest != i) {
-		_swap(&arr[i],&arr[largest]);
-		_heapify(arr, n, largest);
-	}
-}
-
-void _myheapsort(struct address_value	*arr, int64_t n)	{
-	int64_t i;
-	for ( i = (n / 2) - 1; i >=	0; i--)	{
-		_heapify(arr, n, i);
-	}
-	for ( i = n - 1; i > 0; i--) {
-		_swap(&arr[0] , &arr[i]);
-		_heapify(arr, i, 0);
-	}
-}
-
-/*	OK	*/
-void bsgs_swap(struct bsgs_xvalue *a,struct bsgs_xvalue *b)	{
-	struct bsgs_xvalue t;
-	t	= *a;
-	*a = *b;
-	*b =	t;
-}
-
-/*	OK	*/
+/* Only the BSGS_XVALUE_RAM bytes of the key are sorted, the index follows them */
 void bsgs_sort(struct bsgs_xvalue *arr,int64_t n)	{
-	uint32_t depthLimit = ((uint32_t) ceil(log(n))) * 2;
-	bsgs_introsort(arr,depthLimit,n);
+	radixsort(arr,n,sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM,NTHREADS);
 }
 
-/*	OK	*/
-void bsgs_introsort(struct bsgs_xvalue *arr,uint32_t depthLimit, int64_t n) {
-	int64_t p;
-	if(n > 1)	{
-		if(n <= 16) {
-			bsgs_insertionsort(arr,n);
-		}
-		else	{
-			if(depthLimit == 0) {
-				bsgs_myheapsort(arr,n);
-			}
-			else	{
-				p = bsgs_partition(arr,n);
-				if(p > 0) bsgs_introsort(arr , depthLimit-1 , p);
-				if(p < n) bsgs_introsort(&arr[p+1],depthLimit-1,n-(p+1));
-			}
-		}
+void bsgs_xvalue_set_index(struct bsgs_xvalue *xvalue,uint64_t index)	{
+	for(int i = 0; i < BSGS_XVALUE_INDEX; i++)	{
+		xvalue->index[i] = (uint8_t) (index >> (8 * i));
 	}
 }
 
-/*	OK	*/
-void bsgs_insertionsort(struct bsgs_xvalue *arr, int64_t n) {
-	int64_t j;
-	int64_t i;
-	struct bsgs_xvalue key;
-	for(i = 1; i < n ; i++ ) {
-		key = arr[i];
-		j= i-1;
-		while(j >= 0 && memcmp(arr[j].value,key.value,BSGS_XVALUE_RAM) > 0) {
-			arr[j+1] = arr[j];
-			j--;
-		}
-		arr[j+1] = key;
+uint64_t bsgs_xvalue_get_index(struct bsgs_xvalue *xvalue)	{
+	uint64_t index = 0;
+	for(int i = BSGS_XVALUE_INDEX - 1; i >= 0; i--)	{
+		index = (index << 8) | xvalue->index[i];
 	}
+	return index;
 }
 
-int64_t bsgs_partition(struct bsgs_xvalue *arr, int64_t n)	{
-	struct bsgs_xvalue pivot;
-	int64_t r,left,right;
-	r = n/2;
-	pivot = arr[r];
-	left = 0;
-	right = n-1;
-	do {
-		while(left	< right && memcmp(arr[left].value,pivot.value,BSGS_XVALUE_RAM) <= 0 )	{
-			left++;
-		}
-		while(right >= left && memcmp(arr[right].value,pivot.value,BSGS_XVALUE_RAM) > 0)	{
-			right--;
-		}
-		if(left < right)	{
-			if(left == r || right == r)	{
-				if(left == r)	{
-					r = right;
-				}
-				if(right == r)	{
-					r = left;
-				}
-			}
-			bsgs_swap(&arr[right],&arr[left]);
-		}
-	}while(left < right);
-	if(right != r)	{
-		bsgs_swap(&arr[right],&arr[r]);
-	}
-	return right;
-}
-
-void bsgs_heapify(struct bsgs_xvalue *arr, int64_t n, int64_t i) {
-	int64_t largest = i;
-	int64_t l = 2 * i + 1;
-	int64_t r = 2 * i + 2;
-	if (l < n && memcmp(arr[l].value,arr[largest].value,BSGS_XVALUE_RAM) > 0)
-		largest = l;
-	if (r < n && memcmp(arr[r].value,arr[largest].value,BSGS_XVALUE_RAM) > 0)
-		largest = r;
-	if (largest != i) {
-		bsgs_swap(&arr[i],&arr[largest]);
-		bsgs_heapify(arr, n, largest);
+/* The bytes 16 to 21 of the X value are searched with the bPtable_index directory */
+int bsgs_searchtable(char *data,uint64_t *r_value)	{
+	struct bsgs_xvalue *xvalue = (struct bsgs_xvalue*) addrindex_find(&bPtable_index,data+16);
+	if(xvalue == NULL)	{
+		return 0;
 	}
+	*r_value = bsgs_xvalue_get_index(xvalue);
+	return 1;
 }
 
-void bsgs_myheapsort(struct bsgs_xvalue	*arr, int64_t n)	{
-	int64_t i;
-	for ( i = (n / 2) - 1; i >=	0; i--)	{
-		bsgs_heapify(arr, n, i);
+/*
+	The directory has at least 2^16 prefixes of the sorted bP table and at
+	most 16 elements per prefix, the range of a lookup is 2 or 3 cache lines.
+*/
+void bsgs_table_index()	{
+	int bits = addrindex_bits(bsgs_m3,16);
+	if(bits < 16)	{
+		bits = 16;
 	}
-	for ( i = n - 1; i > 0; i--) {
-		bsgs_swap(&arr[0] , &arr[i]);
-		bsgs_heapify(arr, i, 0);
+	if(addrindex_init(&bPtable_index,bPtable,bsgs_m3,sizeof(struct bsgs_xvalue),BSGS_XVALUE_RAM,bits))	{
+		fprintf(stderr,"[E] error addrindex_init for %" PRIu64 " elements\n",bsgs_m3);
+		exit(EXIT_FAILURE);
 	}
+	printf("[+] bP Table index of %i bits: %.2f MB\n",bPtable_index.bits,(double)bPtable_index.bytes/(double)1048576);
 }
 
-int bsgs_searchbinary(struct bsgs_xvalue *buffer,char *data,int64_t array_length,uint64_t *r_value) {
-	int64_t min,max,half,current;
-	int r = 0,rcmp;
-	min = 0;
-	current = 0;
-	max = array_length;
-	half = array_length;
-	while(!r && half >= 1) {
-		half = (max - min)/2;
-		rcmp = memcmp(data+16,buffer[current+half].value,BSGS_XVALUE_RAM);
-		if(rcmp == 0)	{
-			*r_value = buffer[current+half].index;
-			r = 1;
+/*
+	Tables saved before the packed bsgs_xvalue, keyhunt_bsgs_2_ .tbl or .map
+	files, are mapped, verified and packed into bPtable, the caller saves the
+	new file. The .map files from --mmap are checked the same way.
+*/
+int bsgs_table_convert(uint64_t count)	{
+	struct bsgs_xvalue_legacy *legacy;
+	struct bsgs_map_header *header;
+	struct mapfile mf;
+	char filename[1024];
+	char *expected;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue_legacy),i;
+	for(int format = 0; format < 2; format++)	{
+		snprintf(filename,1024,format ? "keyhunt_bsgs_2_%" PRIu64 ".map" : "keyhunt_bsgs_2_%" PRIu64 ".tbl",count);
+		if(mapfile_open(&mf,filename,0) != 0)	{
+			continue;
+		}
+		if(format == 0)	{
+			if(mf.length != bytes + 32)	{
+				fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+				exit(EXIT_FAILURE);
+			}
+			legacy = (struct bsgs_xvalue_legacy*) mf.base;
+			expected = (char*) mf.base + bytes;
 		}
 		else	{
-			if(rcmp < 0) {
-				max = (max-half);
-			}
-			else	{
-				min = (min+half);
+			header = (struct bsgs_map_header*) mf.base;
+			if(mf.length < sizeof(struct bsgs_map_header) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != count || header->offset + bytes > mf.length)	{
+				fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+				exit(EXIT_FAILURE);
 			}
-			current = min;
+			legacy = (struct bsgs_xvalue_legacy*) (mf.base + header->offset);
+			expected = header->checksum.data;
 		}
+		bsgs_checksum_end();	/* The warnings of the previous file first */
+		printf("[+] Converting bP Table from file %s .",filename);
+		fflush(stdout);
+		bsgs_checksum_begin(filename);
+		bsgs_checksum_add((uint8_t*)legacy,bytes,expected,NULL);
+		bsgs_checksum_start();
+		bsgs_checksum_end();
+		for(i = 0; i < count; i++)	{
+			memcpy(bPtable[i].value,legacy[i].value,BSGS_XVALUE_RAM);
+			bsgs_xvalue_set_index(&bPtable[i],legacy[i].index);
+		}
+		mapfile_close(&mf);
+		printf(".. Done!\n");
+		printf("[W] The file %s can be deleted once the new one is saved\n",filename);
+		return 1;
 	}
-	return r;
+	return 0;
 }
 
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -3782,38 +3659,37 @@ void *thread_process_bsgs(void *vargp)	{
 	struct tothread* tt;
 
 	// Character variables
-	char xpoint_raw[32], *aux_c, *hextemp;
+	char *aux_c, *hextemp;
 
 	// Integer variables
 	Int base_key, keyfound;
-	IntGroup* grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Int dy, dyn, _s, _p, km, intaux;
+	Int km, intaux;
 
 	// Point variables
 	Point base_point, point_aux, point_found;
 	Point startP;
-	Point pp, pn;
-	Point pts[CPU_GRP_SIZE];
+	Point point_candidate;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	uint8_t *bloom_hits = (uint8_t*) malloc(cpu_grp_size);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -2 );
+	checkpointer((void *)bloom_hits,__FILE__,"malloc","bloom_hits" ,__LINE__ -2 );
 
 	// Unsigned integer variables
 	uint32_t k, l, r, salir, thread_number, cycles;
 
-	// Other variables
-	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	grp->Set(dx);
-
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
 	
-	cycles = bsgs_aux / 1024;
-	if(bsgs_aux % 1024 != 0)	{
+	cycles = bsgs_aux / cpu_grp_size;
+	if(bsgs_aux % cpu_grp_size != 0)	{
 		cycles++;
 	}
 
 	intaux.Set(&BSGS_M_double);
-	intaux.Mult(CPU_GRP_SIZE/2);
+	intaux.Mult(cpu_grp_size/2);
 	intaux.Add(&BSGS_M);
 	
 	do	{	
@@ -3869,83 +3745,12 @@ void *thread_process_bsgs(void *vargp)	{
 				startP  = secp->AddDirect(OriginalPointsBSGS[k],point_aux);
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
-					int i;
-					for(i = 0; i < hLength; i++) {
-						dx[i].ModSub(&GSn[i].x,&startP.x);
-					}
-					dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-					dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-					// Grouped ModInv
-					grp->ModInv();
-					/*
-					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-					We compute key in the positive and negative way from the center of the group
-					*/
-					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
-					for(i = 0; i<hLength; i++) {
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-					}
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-					pts[0] = pn;
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
+					bstep->Step(&startP);
+					bsgs_bloom_check_group(pts,cpu_grp_size,xpoints_raw,bloom_hits);
+					for(int i = 0; i<cpu_grp_size && bsgs_found[k]== 0; i++) {
+						if(bloom_hits[i]) {
+							point_candidate = bstep->Recover(i);
+							r = bsgs_secondcheck(&base_key,((j*cpu_grp_size) + i),k,&point_candidate,&keyfound);
 							if(r)	{
 								hextemp = keyfound.GetBase16();
 								printf("[+] Thread Key found privkey %s   \n",hextemp);
@@ -3982,21 +3787,6 @@ pn.y.ModAdd(&GSn[i].y);
 							} //End if second check
 						}//End if first check
 					}// For for pts variable
-					// Next start point (startP += (bsSize*GRP_SIZE).G)
-					pp = startP;
-					dy.ModSub(&_2GSn.y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i + 1]);
-					_p.ModSquareK1(&_s);
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&_2GSn.x);
-
-					pp.y.ModSub(&_2GSn.x,&pp.x);
-					pp.y.ModMulK1(&_s);
-					pp.y.ModSub(&_2GSn.y);
-					startP = pp;
 					
 					j++;
 				} // end while
@@ -4004,6 +3794,9 @@ pn.y.ModAdd(&GSn[i].y);
 		}
 		steps[thread_number]+=2;
 	}while(1);
+	free(xpoints_raw);
+	free(bloom_hits);
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -4016,40 +3809,38 @@ void *thread_process_bsgs_random(void *vargp)	{
 
 	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	char *aux_c,*hextemp;
 	Int base_key,keyfound,n_range_random;
 	Point base_point,point_aux,point_found;
 	uint32_t l,k,r,salir,thread_number,cycles;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	
-	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Point point_candidate;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	uint8_t *bloom_hits = (uint8_t*) malloc(cpu_grp_size);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -2 );
+	checkpointer((void *)bloom_hits,__FILE__,"malloc","bloom_hits" ,__LINE__ -2 );
 
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
 	Int km,intaux;
-	Point pp;
-	Point pn;
-	grp->Set(dx);
+	Int random_keys[RANDOM_BATCH],random_scalars[2 * RANDOM_BATCH];
+	Point random_points[2 * RANDOM_BATCH];
+	int random_index = RANDOM_BATCH;
 
 
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
 	
-	cycles = bsgs_aux / 1024;
-	if(bsgs_aux % 1024 != 0)	{
+	cycles = bsgs_aux / cpu_grp_size;
+	if(bsgs_aux % cpu_grp_size != 0)	{
 		cycles++;
 	}
 	
 	intaux.Set(&BSGS_M_double);
-	intaux.Mult(CPU_GRP_SIZE/2);
+	intaux.Mult(cpu_grp_size/2);
 	intaux.Add(&BSGS_M);
 
 	do	{
@@ -4060,18 +3851,36 @@ void *thread_process_bsgs_random(void *vargp)	{
 		-b	bit | Min bit value | Max bit value |
 		-r	A:B | A             | B             |
 	*/
+		if(random_index == RANDOM_BATCH)	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
-		WaitForSingleObject(bsgs_thread, INFINITE);
+			WaitForSingleObject(bsgs_thread, INFINITE);
 #else
-		pthread_mutex_lock(&bsgs_thread);
+			pthread_mutex_lock(&bsgs_thread);
 #endif
-
-		base_key.Rand(&n_range_start,&n_range_end);
+			for(l = 0; l < RANDOM_BATCH; l++)	{
+				random_keys[l].Rand(&n_range_start,&n_range_end);
+			}
 #if defined(_WIN64) && !defined(__CYGWIN__)
-		ReleaseMutex(bsgs_thread);
+			ReleaseMutex(bsgs_thread);
 #else
-		pthread_mutex_unlock(&bsgs_thread);
+			pthread_mutex_unlock(&bsgs_thread);
 #endif
+			/* base_key.G and (-base_key - intaux).G of the whole batch with one inversion */
+			for(l = 0; l < RANDOM_BATCH; l++)	{
+				random_scalars[2 * l].Set(&random_keys[l]);
+				km.Set(&random_keys[l]);
+				km.Neg();
+				km.Add(&secp->order);
+				km.Sub(&intaux);
+				random_scalars[2 * l + 1].Set(&km);
+			}
+			secp->ComputePublicKeys(2 * RANDOM_BATCH,random_scalars,random_points);
+			random_index = 0;
+		}
+		base_key.Set(&random_keys[random_index]);
+		base_point = random_points[2 * random_index];
+		point_aux = random_points[2 * random_index + 1];
+		random_index++;
 
 		if(FLAGMATRIX)	{
 				aux_c = base_key.GetBase16();
@@ -4088,15 +3897,6 @@ void *thread_process_bsgs_random(void *vargp)	{
 				THREADOUTPUT = 1;
 			}
 		}
-		base_point = secp->ComputePublicKey(&base_key);
-
-		km.Set(&base_key);
-		km.Neg();
-		
-		
-		km.Add(&secp->order);
-		km.Sub(&intaux);
-		point_aux = secp->ComputePublicKey(&km);
 
 
 		/* We need to test individually every point in BSGS_Q */
@@ -4106,95 +3906,13 @@ void *thread_process_bsgs_random(void *vargp)	{
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
 				
-					int i;
-					for(i = 0; i < hLength; i++) {
-						dx[i].ModSub(&GSn[i].x,&startP.x);
-					}
-					dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-					dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-
-					// Grouped ModInv
-					grp->ModInv();
-					
-					/*
-					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-					We compute key in the positive and negative way from the center of the group
-					*/
-
-					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
-					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
-					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
+					bstep->Step(&startP);
+					bsgs_bloom_check_group(pts,cpu_grp_size,xpoints_raw,bloom_hits);
 					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
+					for(int i = 0; i<cpu_grp_size && bsgs_found[k]== 0; i++) {
+						if(bloom_hits[i]) {
+							point_candidate = bstep->Recover(i);
+							r = bsgs_secondcheck(&base_key,((j*cpu_grp_size) + i),k,&point_candidate,&keyfound);
 							if(r)	{
 								hextemp = keyfound.GetBase16();
 								printf("[+] Thread Key found privkey %s    \n",hextemp);
@@ -4234,22 +3952,6 @@ pn.y.ModAdd(&GSn[i].y);
 						
 					}// For for pts variable
 					
-					// Next start point (startP += (bsSize*GRP_SIZE).G)
-					
-					pp = startP;
-					dy.ModSub(&_2GSn.y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i + 1]);
-					_p.ModSquareK1(&_s);
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&_2GSn.x);
-
-					pp.y.ModSub(&_2GSn.x,&pp.x);
-					pp.y.ModMulK1(&_s);
-					pp.y.ModSub(&_2GSn.y);
-					startP = pp;
 					
 					j++;
 					
@@ -4259,6 +3961,9 @@ pn.y.ModAdd(&GSn[i].y);
 
 		steps[thread_number]+=2;
 	}while(1);
+	free(xpoints_raw);
+	free(bloom_hits);
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -4267,12 +3972,30 @@ pn.y.ModAdd(&GSn[i].y);
 /*
 	The bsgs_secondcheck function is made to perform a second BSGS search in a Range of less size.
 	This funtion is made with the especific purpouse to USE a smaller bPtable in RAM.
+	candidate is the full giant step point that hit the first bloom filter,
+	Q - (start_range + a*BSGS_M_double + BSGS_M)*G, see BatchStep::Recover
 */
-int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey)	{
+/*
+	First bsgs check for the whole group: x of each point as 32 bytes and one
+	batched lookup in bloom_bP, the probes of the group are prefetched together
+*/
+void bsgs_bloom_check_group(AffinePoint *pts,int n,unsigned char *xpoints_raw,uint8_t *bloom_hits)	{
+	for(int i = 0; i < n; i++)	{
+		pts[i].x.Get32Bytes(xpoints_raw + (i * 32));
+	}
+	if(FLAGFUSE)	{
+		fuse16_check_batch_split(fuse_bP,xpoints_raw,32,32,n,bloom_hits);
+	}
+	else	{
+		bloom_check_batch_split(bloom_bP,xpoints_raw,32,32,n,bloom_hits);
+	}
+}
+
+int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Point *candidate,Int *privatekey)	{
 	int i = 0,found = 0,r = 0;
 	Int base_key;
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_S,BSGS_Q_AMP[32];
 	char xpoint_raw[32];
 
 
@@ -4280,87 +4003,109 @@ int bsgs_secondcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privateke
 	base_key.Mult((uint64_t) a);
 	base_key.Add(start_range);
 
-	base_point = secp->ComputePublicKey(&base_key);
-	point_aux = secp->Negation(base_point);
-
 	/*
 		BSGS_S = Q - base_key
 				 Q is the target Key
 		base_key is the Start range + a*BSGS_M
+		so BSGS_S = candidate + BSGS_MP, AddDirect can't double so that case goes by base_key
 	*/
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
-	BSGS_Q.Set(BSGS_S);
+	if(candidate->x.IsEqual(&BSGS_MP.x))	{
+		base_point = secp->ComputePublicKey(&base_key);
+		point_aux = secp->Negation(base_point);
+		BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
+	}
+	else	{
+		BSGS_S = secp->AddDirect(*candidate,BSGS_MP);
+	}
+	/* The 32 points BSGS_S + BSGS_AMP2[i] with a single inversion */
+	secp->AddDirect(BSGS_S,&BSGS_AMP2[0],32,BSGS_Q_AMP);
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP2[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *) xpoint_raw);
-		r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
-		if(r)	{
-			found = bsgs_thirdcheck(&base_key,i,k_index,privatekey);
+		if(!BSGS_Q_AMP[i].z.IsZero())	{
+			BSGS_Q_AMP[i].x.Get32Bytes((unsigned char *) xpoint_raw);
+			r = bloom_check(&bloom_bPx2nd[(uint8_t) xpoint_raw[0]],xpoint_raw,32);
+			if(r)	{
+				found = bsgs_thirdcheck(&base_key,i,k_index,&BSGS_Q_AMP[i],privatekey);
+			}
 		}
 		i++;
 	}while(i < 32 && !found);
 	return found;
 }
 
-int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Int *privatekey)	{
+/*
+	candidate is the second check point that hit its bloom filter,
+	Q - (start_range + a*BSGS_M2_double + BSGS_M2)*G
+*/
+int bsgs_thirdcheck(Int *start_range,uint32_t a,uint32_t k_index,Point *candidate,Int *privatekey)	{
 	uint64_t j = 0;
 	int i = 0,found = 0,r = 0;
 	Int base_key,calculatedkey;
 	Point base_point,point_aux;
-	Point BSGS_Q, BSGS_S,BSGS_Q_AMP;
+	Point BSGS_S,BSGS_Q_AMP[32];
 	char xpoint_raw[32];
 
 	base_key.SetInt32(a);
 	base_key.Mult(&BSGS_M2_double);
 	base_key.Add(start_range);
 
-	base_point = secp->ComputePublicKey(&base_key);
-	point_aux = secp->Negation(base_point);
-	
-	BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
-	BSGS_Q.Set(BSGS_S);
+	if(candidate->x.IsEqual(&BSGS_MP2.x))	{
+		base_point = secp->ComputePublicKey(&base_key);
+		point_aux = secp->Negation(base_point);
+		BSGS_S = secp->AddDirect(OriginalPointsBSGS[k_index],point_aux);
+	}
+	else	{
+		BSGS_S = secp->AddDirect(*candidate,BSGS_MP2);
+	}
+	secp->AddDirect(BSGS_S,&BSGS_AMP3[0],32,BSGS_Q_AMP);
 	
 	do {
-		BSGS_Q_AMP = secp->AddDirect(BSGS_Q,BSGS_AMP3[i]);
-		BSGS_S.Set(BSGS_Q_AMP);
-		BSGS_S.x.Get32Bytes((unsigned char *)xpoint_raw);
-		r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
-		if(r)	{
-			r = bsgs_searchbinary(bPtable,xpoint_raw,bsgs_m3,&j);
+		if(!BSGS_Q_AMP[i].z.IsZero())	{
+			BSGS_Q_AMP[i].x.Get32Bytes((unsigned char *)xpoint_raw);
+			r = bloom_check(&bloom_bPx3rd[(uint8_t)xpoint_raw[0]],xpoint_raw,32);
 			if(r)	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add((uint64_t)(j+1));
-				privatekey->Add(&base_key);
-				point_aux = secp->ComputePublicKey(privatekey);
-				if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
-					found = 1;
-				}
-				else	{
+				r = bsgs_searchtable(xpoint_raw,&j);
+				if(r)	{
 					calcualteindex(i,&calculatedkey);
 					privatekey->Set(&calculatedkey);
-					privatekey->Sub((uint64_t)(j+1));
+					privatekey->Add((uint64_t)(j+1));
 					privatekey->Add(&base_key);
 					point_aux = secp->ComputePublicKey(privatekey);
 					if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
 						found = 1;
 					}
+					else	{
+						calcualteindex(i,&calculatedkey);
+						privatekey->Set(&calculatedkey);
+						privatekey->Sub((uint64_t)(j+1));
+						privatekey->Add(&base_key);
+						point_aux = secp->ComputePublicKey(privatekey);
+						if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
+							found = 1;
+						}
+					}
 				}
 			}
 		}
 		else	{
 			/*
-				For some reason the AddDirect don't return 000000... value when the publickeys are the negated values from each other
-				Why JLP?
-				This is is an special case
+				BSGS_S and BSGS_AMP3[i] have the same x so BSGS_S is +/- the
+				index point, AddDirect can't handle it, check both keys here
 			*/
-			if(BSGS_Q.x.IsEqual(&BSGS_AMP3[i].x))	{
-				calcualteindex(i,&calculatedkey);
-				privatekey->Set(&calculatedkey);
-				privatekey->Add(&base_key);
+			calcualteindex(i,&calculatedkey);
+			privatekey->Set(&base_key);
+			privatekey->Add(&calculatedkey);
+			point_aux = secp->ComputePublicKey(privatekey);
+			if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
 				found = 1;
 			}
+			else	{
+				privatekey->Set(&base_key);
+				privatekey->Sub(&calculatedkey);
+				point_aux = secp->ComputePublicKey(privatekey);
+				if(point_aux.x.IsEqual(&OriginalPointsBSGS[k_index].x))	{
+					found = 1;
+				}
+			}
 		}
 		i++;
 	}while(i < 32 && !found);
@@ -4387,15 +4132,168 @@ void init_generator()	{
 	Point G = secp->ComputePublicKey(&stride);
 	Point g;
 	g.Set(G);
-	Gn.reserve(CPU_GRP_SIZE / 2);
-	Gn[0] = g;
+	Gn.resize(cpu_grp_size / 2);
+	Gn[0].Set(&g);
 	g = secp->DoubleDirect(g);
-	Gn[1] = g;
-	for(int i = 2; i < CPU_GRP_SIZE / 2; i++) {
+	Gn[1].Set(&g);
+	for(int i = 2; i < cpu_grp_size / 2; i++) {
 		g = secp->AddDirect(g,G);
-		Gn[i] = g;
+		Gn[i].Set(&g);
+	}
+	/* g is the last of Gn */
+	_2Gn = secp->DoubleDirect(g);
+}
+
+/*
+	Draw RANDOM_BATCH random base keys and compute the center of their first
+	group, (key + cpu_grp_size/2 * stride).G, sharing a single inversion
+*/
+void random_starts(Int *keys,Point *centers)	{
+	Int half,center[RANDOM_BATCH];
+	half.SetInt32(cpu_grp_size / 2);
+	half.Mult(&stride);
+	for(int i = 0; i < RANDOM_BATCH; i++)	{
+		keys[i].Rand(&n_range_start,&n_range_end);
+		center[i].Set(&keys[i]);
+		center[i].Add(&half);
+	}
+	secp->ComputePublicKeys(RANDOM_BATCH,center,centers);
+}
+
+/* Name of the current search in TUNE_FILE */
+const char *tune_key()	{
+	static char key[64];
+	switch(FLAGMODE)	{
+		case MODE_BSGS:
+		case MODE_XPOINT:
+			snprintf(key,64,"%s",modes[FLAGMODE]);
+		break;
+		default:
+			if(FLAGCRYPTO == CRYPTO_ETH)	{
+				snprintf(key,64,"%s_eth",modes[FLAGMODE]);
+			}
+			else	{
+				snprintf(key,64,"%s_%s",modes[FLAGMODE],publicsearch[FLAGSEARCH]);
+			}
+		break;
+	}
+	return key;
+}
+
+/*
+	Time the batch stepping for each group size with the per point work of the
+	selected mode (hashing or x serialization), save the fastest in TUNE_FILE
+*/
+void tune_group_size()	{
+	BatchStepBase *bstep;
+	Point startP;
+	AffinePoint *pts;
+	Int key;
+	FILE *fd;
+	char rawvalue[32],line[128],name[64],lines[64][128];
+	uint8_t hashes[2][HASH_GROUP][20];
+	uint64_t keys;
+	clock_t t0,t1;
+	double speed,best_speed = 0;
+	int size,j,k,n = 0,best = CPU_GRP_SIZE;
+	bool calculate_y = FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH || FLAGCRYPTO == CRYPTO_ETH;
+	if(FLAGMODE == MODE_BSGS || FLAGMODE == MODE_XPOINT)	{
+		calculate_y = false;
+	}
+	printf("[+] Tuning group size for %s\n",tune_key());
+	for(size = BATCHSTEP_MIN_SIZE; size <= BATCHSTEP_MAX_SIZE; size *= 2)	{
+		cpu_grp_size = size;
+		init_generator();
+		bstep = NewBatchStep(size,calculate_y,&Gn[0],&_2Gn);
+		pts = bstep->pts;
+		key.SetInt32(size / 2);
+		key.Add(&n_range_start);
+		startP = secp->ComputePublicKey(&key);
+		keys = 0;
+		t0 = clock();
+		do	{
+			bstep->Step(&startP);
+			switch(FLAGMODE)	{
+				case MODE_BSGS:
+				case MODE_XPOINT:
+					for(j = 0; j < size; j++)	{
+						pts[j].x.Get32Bytes((unsigned char*)rawvalue);
+					}
+				break;
+				default:
+					if(FLAGCRYPTO == CRYPTO_ETH)	{
+						for(j = 0; j < size; j += HASH_GROUP)	{
+							generate_binaddress_eth_group(&pts[j],HASH_GROUP,hashes[0][0]);
+						}
+						break;
+					}
+					for(j = 0; j < size; j += HASH_GROUP)	{
+						if(FLAGSEARCH == SEARCH_COMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
+							secp->GetHash160_fromX(&pts[j],HASH_GROUP,hashes[0][0],hashes[1][0]);
+						}
+						if(FLAGSEARCH == SEARCH_UNCOMPRESS || FLAGSEARCH == SEARCH_BOTH)	{
+							secp->GetHash160(false,&pts[j],HASH_GROUP,hashes[0][0]);
+						}
+					}
+				break;
+			}
+			keys += size;
+			t1 = clock();
+		}while(t1 - t0 < CLOCKS_PER_SEC);
+		delete bstep;
+		speed = (double)keys * CLOCKS_PER_SEC / (double)(t1 - t0);
+		printf("[+] Group size %4i : %.0f keys/s\n",size,speed);
+		if(speed > best_speed)	{
+			best_speed = speed;
+			best = size;
+		}
+	}
+	cpu_grp_size = best;
+	printf("[+] Group size %i selected, saved in %s\n",best,TUNE_FILE);
+
+	/* Keep the entries of the other modes */
+	fd = fopen(TUNE_FILE,"r");
+	if(fd != NULL)	{
+		while(n < 64 && fgets(line,128,fd) != NULL)	{
+			if(sscanf(line,"%63s %i",name,&k) == 2 && strcmp(name,tune_key()) != 0)	{
+				snprintf(lines[n++],128,"%s %i\n",name,k);
+			}
+		}
+		fclose(fd);
+	}
+	fd = fopen(TUNE_FILE,"w");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Can't write %s\n",TUNE_FILE);
+		return;
+	}
+	for(j = 0; j < n; j++)	{
+		fputs(lines[j],fd);
+	}
+	fprintf(fd,"%s %i\n",tune_key(),best);
+	fclose(fd);
+}
+
+/* Group size saved by a previous --tune for this mode, if any */
+void load_group_size()	{
+	FILE *fd;
+	char line[128],name[64];
+	int size;
+	fd = fopen(TUNE_FILE,"r");
+	if(fd == NULL)	{
+		return;
+	}
+	while(fgets(line,128,fd) != NULL)	{
+		if(sscanf(line,"%63s %i",name,&size) == 2 && strcmp(name,tune_key()) == 0)	{
+			if(size >= BATCHSTEP_MIN_SIZE && size <= BATCHSTEP_MAX_SIZE && (size & (size - 1)) == 0)	{
+				cpu_grp_size = size;
+				printf("[+] Group size %i (%s)\n",size,TUNE_FILE);
+			}
+			else	{
+				fprintf(stderr,"[W] Ignoring group size %i in %s\n",size,TUNE_FILE);
+			}
+		}
 	}
-	_2Gn = secp->DoubleDirect(Gn[CPU_GRP_SIZE / 2 - 1]);
+	fclose(fd);
 }
 
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -4404,18 +4302,16 @@ DWORD WINAPI thread_bPload(LPVOID vargp) {
 void *thread_bPload(void *vargp)	{
 #endif
 
-	char rawvalue[32];
 	struct bPload *tt;
-	uint64_t i_counter,j,nbStep,to;
+	uint64_t i_counter,nbStep,to;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&Gn[0],&_2Gn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -1 );
 	
-	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
+	int threadid;
 	tt = (struct bPload *)vargp;
 	Int km((uint64_t)(tt->from + 1));
 	threadid = tt->threadid;
@@ -4423,172 +4319,434 @@ void *thread_bPload(void *vargp)	{
 	
 	i_counter = tt->from;
 
-	nbStep = (tt->to - tt->from) / CPU_GRP_SIZE;
+	nbStep = (tt->to - tt->from) / cpu_grp_size;
 	
-	if( ((tt->to - tt->from) % CPU_GRP_SIZE )  != 0)	{
+	if( ((tt->to - tt->from) % cpu_grp_size )  != 0)	{
 		nbStep++;
 	}
 	//if(FLAGDEBUG) printf("[D] thread %i nbStep %" PRIu64 "\n",threadid,nbStep);
 	to = tt->to;
 	
-	km.Add((uint64_t)(CPU_GRP_SIZE / 2));
+	km.Add((uint64_t)(cpu_grp_size / 2));
 	startP = secp->ComputePublicKey(&km);
-	grp->Set(dx);
 	for(uint64_t s=0;s<nbStep;s++) {
-		for(i = 0; i < hLength; i++) {
-			dx[i].ModSub(&Gn[i].x,&startP.x);
-		}
-		dx[i].ModSub(&Gn[i].x,&startP.x); // For the first point
-		dx[i + 1].ModSub(&_2Gn.x,&startP.x);// For the next center point
-		// Grouped ModInv
-		grp->ModInv();
-
-		// We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-		// We compute key in the positive and negative way from the center of the group
-		// center point
-		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
-
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
-
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
+		bstep->Step(&startP);
+		bsgs_bP_add_group(pts,cpu_grp_size,i_counter,to,xpoints_raw);
+		i_counter += cpu_grp_size;
+	}
+	free(xpoints_raw);
+	delete bstep;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+	WaitForSingleObject(bPload_mutex[threadid], INFINITE);
+	tt->finished = 1;
+	ReleaseMutex(bPload_mutex[threadid]);
+#else	
+	pthread_mutex_lock(&bPload_mutex[threadid]);
+	tt->finished = 1;
+	pthread_mutex_unlock(&bPload_mutex[threadid]);
+	pthread_exit(NULL);
 #endif
+	return NULL;
+}
 
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
+/*
+	Insert the group of bP points i_counter .. i_counter+n-1: bPtable and the 3rd
+	bloom filter take the first bsgs_m3 points, the 2nd one the first bsgs_m2
+	and the 1st one every point below to. The filters are shared by all the
+	threads, the adds set their bits with atomic operations instead of locks.
+*/
+void bsgs_bP_add_group(AffinePoint *pts,int n,uint64_t i_counter,uint64_t to,unsigned char *xpoints_raw)	{
+	uint64_t n1,n2,n3,j;
+	for(j = 0; j < (uint64_t)n; j++)	{
+		pts[j].x.Get32Bytes(xpoints_raw + (j * 32));
+	}
+	n3 = (i_counter < bsgs_m3) ? bsgs_m3 - i_counter : 0;
+	n2 = (i_counter < bsgs_m2) ? bsgs_m2 - i_counter : 0;
+	n1 = (i_counter < to) ? to - i_counter : 0;
+	n3 = (n3 < (uint64_t)n) ? n3 : n;
+	n2 = (n2 < (uint64_t)n) ? n2 : n;
+	n1 = (n1 < (uint64_t)n) ? n1 : n;
+	if(!FLAGREADEDFILE3)	{
+		for(j = 0; j < n3; j++)	{
+			memcpy(bPtable[i_counter + j].value,xpoints_raw + (j * 32) + 16,BSGS_XVALUE_RAM);
+			bsgs_xvalue_set_index(&bPtable[i_counter + j],i_counter + j);
 		}
+	}
+	if(!FLAGREADEDFILE4)	{
+		bloom_add_concurrent_batch_split(bloom_bPx3rd,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n3);
+	}
+	if(!FLAGREADEDFILE2)	{
+		bloom_add_concurrent_batch_split(bloom_bPx2nd,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n2);
+	}
+	if(!FLAGREADEDFILE1 && FLAGFUSE)	{
+		for(j = 0; j < n1; j++)	{
+			bsgs_fuse_add(xpoints_raw[j * 32],(char*)xpoints_raw + (j * 32));
+		}
+	}
+	else if(!FLAGREADEDFILE1)	{
+		bloom_add_concurrent_batch_split(bloom_bP,xpoints_raw,BSGS_BUFFERXPOINTLENGTH,32,n1);
+	}
+}
 
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
+/*
+	The fuse filters are static: thread_bPload only collects the 64 bits keys of
+	the x values, bsgs_fuse_build makes the 256 filters once all the keys are known.
+	The keys need 8 bytes per element until the build is done. Each buffer has
+	room for 12.5% more than its expected share, the threads take their slot with
+	an atomic add.
+*/
+void bsgs_fuse_add(int index,char *rawvalue)	{
+	struct fuse_keys *fk = &fuse_bP_keys[index];
+	uint64_t slot = __atomic_fetch_add(&fk->count,1,__ATOMIC_RELAXED);
+	if(slot >= fk->size)	{
+		fprintf(stderr,"[E] fuse_bP_keys [%i] is full\n",index);
+		exit(EXIT_FAILURE);
+	}
+	fk->keys[slot] = fuse16_key(rawvalue,BSGS_BUFFERXPOINTLENGTH);
+}
 
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
+#if defined(_WIN64) && !defined(__CYGWIN__)
+DWORD WINAPI thread_fuse_build(LPVOID vargp) {
+#else
+void *thread_fuse_build(void *vargp)	{
 #endif
+	int threadid = *(int*)vargp;
+	for(int i = threadid; i < 256; i += NTHREADS)	{
+		if(fuse16_build(&fuse_bP[i],fuse_bP_keys[i].keys,fuse_bP_keys[i].count) != 0)	{
+			fprintf(stderr,"[E] error fuse16_build _ [%i]\n",i);
+			exit(EXIT_FAILURE);
+		}
+		free(fuse_bP_keys[i].keys);
+		fuse_bP_keys[i].keys = NULL;
+	}
+	return NULL;
+}
 
-		pts[0] = pn;
-		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
-			bloom_bP_index = (uint8_t)rawvalue[0];
-			/*
-			if(FLAGDEBUG){
-				tohex_dst(rawvalue,32,hexraw);
-				printf("%i : %s : %i\n",i_counter,hexraw,bloom_bP_index);
-			}
-			*/
-			if(i_counter < bsgs_m3)	{
-				if(!FLAGREADEDFILE3)	{
-					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
-				}
-				if(!FLAGREADEDFILE4)	{
+void bsgs_fuse_build()	{
+	uint64_t total = 0;
+	int i,*ids;
 #if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx3rd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx3rd_mutex[bloom_bP_index]);
+	HANDLE *tid;
+	DWORD s;
+	tid = (HANDLE*)calloc(NTHREADS, sizeof(HANDLE));
 #else
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
+	pthread_t *tid;
+	tid = (pthread_t *) calloc(NTHREADS,sizeof(pthread_t));
 #endif
-				}
-			}
-			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
+	checkpointer((void *)tid,__FILE__,"calloc","tid" ,__LINE__ -1 );
+	ids = (int*) calloc(NTHREADS,sizeof(int));
+	checkpointer((void *)ids,__FILE__,"calloc","ids" ,__LINE__ -1 );
+	printf("[+] Building binary fuse filters ");
+	fflush(stdout);
+	for(i = 0; i < NTHREADS; i++)	{
+		ids[i] = i;
 #if defined(_WIN64) && !defined(__CYGWIN__)
-				WaitForSingleObject(bloom_bPx2nd_mutex[bloom_bP_index], INFINITE);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				ReleaseMutex(bloom_bPx2nd_mutex[bloom_bP_index]);
+		tid[i] = CreateThread(NULL, 0, thread_fuse_build, (void*) &ids[i], 0, &s);
 #else
-				pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-#endif	
-			}
-			if(i_counter < to && !FLAGREADEDFILE1 )	{
+		pthread_create(&tid[i],NULL,thread_fuse_build,(void*) &ids[i]);
+#endif
+	}
+	for(i = 0; i < NTHREADS; i++)	{
 #if defined(_WIN64) && !defined(__CYGWIN__)
-				WaitForSingleObject(bloom_bP_mutex[bloom_bP_index], INFINITE);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				ReleaseMutex(bloom_bP_mutex[bloom_bP_index);
+		WaitForSingleObject(tid[i], INFINITE);
+		CloseHandle(tid[i]);
 #else
-				pthread_mutex_lock(&bloom_bP_mutex[bloom_bP_index]);
-				bloom_add(&bloom_bP[bloom_bP_index], rawvalue ,BSGS_BUFFERXPOINTLENGTH);
-				pthread_mutex_unlock(&bloom_bP_mutex[bloom_bP_index]);
+		pthread_join(tid[i],NULL);
 #endif
+	}
+	for(i = 0; i < 256; i++)	{
+		total += fuse_bP[i].bytes;
+	}
+	printf(": %.2f MB, %.2f bits per element\n",(double)total/1048576,(double)total*8/bsgs_m);
+	free(fuse_bP_keys);
+	fuse_bP_keys = NULL;
+	free(ids);
+	free(tid);
+}
+
+int bsgs_fuse_read(const char *filename,FILE *fd)	{
+	uint64_t readed;
+	printf("[+] Reading binary fuse filter from file %s ",filename);
+	fflush(stdout);
+	bsgs_checksum_begin(filename);
+	for(int i = 0; i < 256; i++)	{
+		free(fuse_bP_keys[i].keys);	/* Nothing to build */
+		fuse_bP_keys[i].keys = NULL;
+		readed = fread(&fuse_bP[i],sizeof(struct fuse16),1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error reading the file %s\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		fuse_bP[i].fingerprints = (uint16_t*) malloc(fuse_bP[i].bytes);
+		checkpointer((void *)fuse_bP[i].fingerprints,__FILE__,"malloc","fingerprints" ,__LINE__ -1 );
+		readed = fread(fuse_bP[i].fingerprints,fuse_bP[i].bytes,1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error reading the file %s\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		readed = fread(&bloom_bP_checksums[i],sizeof(struct checksumsha256),1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error reading the file %s\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		bsgs_checksum_add((uint8_t*)fuse_bP[i].fingerprints,fuse_bP[i].bytes,bloom_bP_checksums[i].data,bloom_bP_checksums[i].backup);
+		if(i % 64 == 0 )	{
+			printf(".");
+			fflush(stdout);
+		}
+	}
+	printf(" Done!\n");
+	bsgs_checksum_start();
+	return 1;
+}
+
+void bsgs_fuse_write(const char *filename)	{
+	FILE *fd;
+	uint64_t readed;
+	fd = fopen(filename,"wb");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Writing binary fuse filter to file %s ",filename);
+	fflush(stdout);
+	for(int i = 0; i < 256; i++)	{
+		readed = fwrite(&fuse_bP[i],sizeof(struct fuse16),1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		readed = fwrite(fuse_bP[i].fingerprints,fuse_bP[i].bytes,1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		readed = fwrite(&bloom_bP_checksums[i],sizeof(struct checksumsha256),1,fd);
+		if(readed != 1)	{
+			fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		if(i % 64 == 0)	{
+			printf(".");
+			fflush(stdout);
+		}
+	}
+	printf(" Done!\n");
+	fclose(fd);
+}
+
+/*
+	The checksums of a file are verified by the NTHREADS threads while the next
+	file is read: bsgs_checksum_start() waits for the previous file and starts
+	the current one, bsgs_checksum_end() waits for the last one
+*/
+void bsgs_checksum_begin(const char *filename)	{
+	snprintf(checksum_batch_file[checksum_batch_current],1024,"%s",filename);
+	sha256_tree_batch_init(&checksum_batch[checksum_batch_current],256,NTHREADS);
+}
+
+void bsgs_checksum_add(uint8_t *data,uint64_t bytes,char *expected,char *backup)	{
+	if(FLAGSKIPCHECKSUM)	{
+		return;
+	}
+	if(backup != NULL && memcmp(expected,backup,32) != 0)	{
+		fprintf(stderr,"[E] Error checksum file mismatch! %s\n",checksum_batch_file[checksum_batch_current]);
+		exit(EXIT_FAILURE);
+	}
+	sha256_tree_batch_add(&checksum_batch[checksum_batch_current],data,bytes,NULL,(uint8_t*)expected);
+}
+
+void bsgs_checksum_start()	{
+	bsgs_checksum_end();
+	sha256_tree_batch_start(&checksum_batch[checksum_batch_current]);
+	checksum_batch_current ^= 1;
+}
+
+void bsgs_checksum_end()	{
+	int previous = checksum_batch_current ^ 1;
+	if(checksum_batch[previous].jobs == NULL)	{
+		return;
+	}
+	if(sha256_tree_batch_wait(&checksum_batch[previous]) != 0)	{
+		fprintf(stderr,"[E] Error checksum file mismatch! %s\n",checksum_batch_file[previous]);
+		exit(EXIT_FAILURE);
+	}
+	if(checksum_batch[previous].legacy)	{
+		printf("[W] The file %s has the checksums of a previous version, delete it to save it again\n",checksum_batch_file[previous]);
+	}
+}
+
+/*
+	The mapping is kept until the process ends, bf and fingerprints point into it
+	Return 0 if the file doesn't exist, the caller prints the sizes
+*/
+int bsgs_map_read(const char *filename,struct bloom *blooms,struct fuse16 *fuses,struct checksumsha256 *checksums)	{
+	struct mapfile mf;
+	struct bsgs_map_header *header;
+	struct bsgs_map_entry *entries;
+	uint64_t bytes;
+	uint8_t *data;
+	int r;
+	r = mapfile_open(&mf,filename,mmap_flags);
+	if(r == -1)	{
+		return 0;
+	}
+	if(r != 0)	{
+		fprintf(stderr,"[E] Error can't map the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	header = (struct bsgs_map_header*) mf.base;
+	entries = (struct bsgs_map_entry*) (mf.base + sizeof(struct bsgs_map_header));
+	if(mf.length < sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != 256)	{
+		fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	bsgs_checksum_begin(filename);
+	for(int i = 0; i < 256; i++)	{
+		if(fuses)	{
+			if(fuse_bP_keys != NULL)	{
+				free(fuse_bP_keys[i].keys);	/* Nothing to build */
+				fuse_bP_keys[i].keys = NULL;
 			}
-			i_counter++;
+			memcpy(&fuses[i],&entries[i].filter.fuse,sizeof(struct fuse16));
+			bytes = fuses[i].bytes;
 		}
-		// Next start point (startP + GRP_SIZE*G)
-		pp = startP;
-		dy.ModSub(&_2Gn.y,&pp.y);
+		else	{
+			memcpy(&blooms[i],&entries[i].filter.bloom,sizeof(struct bloom));
+			bytes = blooms[i].bytes;
+		}
+		if(entries[i].offset % MAPFILE_ALIGN != 0 || entries[i].offset + bytes > mf.length)	{
+			fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		data = mf.base + entries[i].offset;
+		if(fuses)	{
+			fuses[i].fingerprints = (uint16_t*) data;
+		}
+		else	{
+			blooms[i].bf = data;
+		}
+		memcpy(&checksums[i],&entries[i].checksum,sizeof(struct checksumsha256));
+		bsgs_checksum_add(data,bytes,checksums[i].data,checksums[i].backup);
+	}
+	bsgs_checksum_start();	/* The first accesses to the mapping run in parallel */
+	return 1;
+}
 
-		_s.ModMulK1(&dy,&dx[i + 1]);
-		_p.ModSquareK1(&_s);
+void bsgs_map_write(const char *filename,struct bloom *blooms,struct fuse16 *fuses,struct checksumsha256 *checksums)	{
+	struct bsgs_map_header header;
+	struct bsgs_map_entry *entries;
+	uint64_t offset,bytes;
+	FILE *fd;
+	uint8_t *data;
+	int i;
+	entries = (struct bsgs_map_entry*) calloc(256,sizeof(struct bsgs_map_entry));
+	checkpointer((void *)entries,__FILE__,"calloc","entries" ,__LINE__ -1 );
+	memset(&header,0,sizeof(struct bsgs_map_header));
+	memcpy(header.magic,BSGS_MAP_MAGIC,8);
+	header.count = 256;
+	offset = mapfile_align(sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry));
+	for(i = 0; i < 256; i++)	{
+		if(fuses)	{
+			memcpy(&entries[i].filter.fuse,&fuses[i],sizeof(struct fuse16));
+			bytes = fuses[i].bytes;
+		}
+		else	{
+			memcpy(&entries[i].filter.bloom,&blooms[i],sizeof(struct bloom));
+			bytes = blooms[i].bytes;
+		}
+		memcpy(&entries[i].checksum,&checksums[i],sizeof(struct checksumsha256));
+		entries[i].offset = offset;
+		offset = mapfile_align(offset + bytes);
+	}
+	fd = fopen(filename,"wb");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Writing %s to file %s ",fuses ? "binary fuse filter" : "bloom filter",filename);
+	fflush(stdout);
+	if(fwrite(&header,sizeof(struct bsgs_map_header),1,fd) != 1 || fwrite(entries,sizeof(struct bsgs_map_entry),256,fd) != 256)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	offset = sizeof(struct bsgs_map_header) + 256 * sizeof(struct bsgs_map_entry);
+	for(i = 0; i < 256; i++)	{
+		data = fuses ? (uint8_t*) fuses[i].fingerprints : blooms[i].bf;
+		bytes = fuses ? fuses[i].bytes : blooms[i].bytes;
+		offset = mapfile_pad(fd,offset);
+		if(offset != entries[i].offset || fwrite(data,bytes,1,fd) != 1)	{
+			fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+			exit(EXIT_FAILURE);
+		}
+		offset += bytes;
+		if(i % 64 == 0)	{
+			printf(".");
+			fflush(stdout);
+		}
+	}
+	if(mapfile_pad(fd,offset) == 0)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf(" Done!\n");
+	fclose(fd);
+	free(entries);
+}
 
-		pp.x.ModNeg();
-		pp.x.ModAdd(&_p);
-		pp.x.ModSub(&_2Gn.x);
+/* Same as bsgs_map_read for the bP table, bPtable points into the mapping */
+int bsgs_map_table_read(const char *filename,uint64_t count)	{
+	struct mapfile mf;
+	struct bsgs_map_header *header;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue);
+	int r;
+	r = mapfile_open(&mf,filename,mmap_flags);
+	if(r == -1)	{
+		return 0;
+	}
+	if(r != 0)	{
+		fprintf(stderr,"[E] Error can't map the file %s\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	header = (struct bsgs_map_header*) mf.base;
+	if(mf.length < sizeof(struct bsgs_map_header) || memcmp(header->magic,BSGS_MAP_MAGIC,8) != 0 || header->count != count || header->offset % MAPFILE_ALIGN != 0 || header->offset + bytes > mf.length)	{
+		fprintf(stderr,"[E] Invalid file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("[+] Mapping bP Table from file %s .",filename);
+	fflush(stdout);
+	bPtable = (struct bsgs_xvalue*) (mf.base + header->offset);
+	memcpy(checksum,header->checksum.data,32);
+	bsgs_checksum_begin(filename);
+	bsgs_checksum_add((uint8_t*)bPtable,bytes,checksum,NULL);
+	printf("... Done!\n");
+	bsgs_checksum_start();
+	return 1;
+}
 
-		pp.y.ModSub(&_2Gn.x,&pp.x);
-		pp.y.ModMulK1(&_s);
-		pp.y.ModSub(&_2Gn.y);
-		startP = pp;
+void bsgs_map_table_write(const char *filename,uint64_t count)	{
+	struct bsgs_map_header header;
+	uint64_t bytes = count * sizeof(struct bsgs_xvalue);
+	FILE *fd;
+	memset(&header,0,sizeof(struct bsgs_map_header));
+	memcpy(header.magic,BSGS_MAP_MAGIC,8);
+	header.count = count;
+	header.offset = mapfile_align(sizeof(struct bsgs_map_header));
+	memcpy(header.checksum.data,checksum,32);
+	memcpy(header.checksum.backup,checksum,32);
+	fd = fopen(filename,"wb");
+	if(fd == NULL)	{
+		fprintf(stderr,"[E] Error can't create the file %s\n",filename);
+		exit(EXIT_FAILURE);
 	}
-	delete grp;
-#if defined(_WIN64) && !defined(__CYGWIN__)
-	WaitForSingleObject(bPload_mutex[threadid], INFINITE);
-	tt->finished = 1;
-	ReleaseMutex(bPload_mutex[threadid]);
-#else	
-	pthread_mutex_lock(&bPload_mutex[threadid]);
-	tt->finished = 1;
-	pthread_mutex_unlock(&bPload_mutex[threadid]);
-	pthread_exit(NULL);
-#endif
-	return NULL;
+	printf("[+] Writing bP Table to file %s .. ",filename);
+	fflush(stdout);
+	if(fwrite(&header,sizeof(struct bsgs_map_header),1,fd) != 1 || mapfile_pad(fd,sizeof(struct bsgs_map_header)) != header.offset || fwrite(bPtable,bytes,1,fd) != 1 || mapfile_pad(fd,header.offset + bytes) == 0)	{
+		fprintf(stderr,"[E] Error writing the file %s please delete it\n",filename);
+		exit(EXIT_FAILURE);
+	}
+	printf("Done!\n");
+	fclose(fd);
 }
 
 #if defined(_WIN64) && !defined(__CYGWIN__)
@@ -4596,160 +4754,37 @@ DWORD WINAPI thread_bPload_2blooms(LPVOID vargp) {
 #else
 void *thread_bPload_2blooms(void *vargp)	{
 #endif
-	char rawvalue[32];
 	struct bPload *tt;
-	uint64_t i_counter,j,nbStep; //,to;
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	uint64_t i_counter,nbStep; //,to;
 	Point startP;
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
-	Int dy,dyn,_s,_p;
-	Point pp,pn;
-	int i,bloom_bP_index,hLength = (CPU_GRP_SIZE / 2 - 1) ,threadid;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&Gn[0],&_2Gn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -1 );
+	int threadid;
 	tt = (struct bPload *)vargp;
 	Int km((uint64_t)(tt->from +1 ));
 	threadid = tt->threadid;
 	
 	i_counter = tt->from;
 
-	nbStep = (tt->to - (tt->from)) / CPU_GRP_SIZE;
+	nbStep = (tt->to - (tt->from)) / cpu_grp_size;
 	
-	if( ((tt->to - (tt->from)) % CPU_GRP_SIZE )  != 0)	{
+	if( ((tt->to - (tt->from)) % cpu_grp_size )  != 0)	{
 		nbStep++;
 	}
 	//if(FLAGDEBUG) printf("[D] thread %i nbStep %" PRIu64 "\n",threadid,nbStep);
 	//to = tt->to;
 	
-	km.Add((uint64_t)(CPU_GRP_SIZE / 2));
+	km.Add((uint64_t)(cpu_grp_size / 2));
 	startP = secp->ComputePublicKey(&km);
-	grp->Set(dx);
 	for(uint64_t s=0;s<nbStep;s++) {
-		for(i = 0; i < hLength; i++) {
-			dx[i].ModSub(&Gn[i].x,&startP.x);
-		}
-		dx[i].ModSub(&Gn[i].x,&startP.x); // For the first point
-		dx[i + 1].ModSub(&_2Gn.x,&startP.x);// For the next center point
-		// Grouped ModInv
-		grp->ModInv();
-
-		// We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-		// We compute key in the positive and negative way from the center of the group
-		// center point
-		
-		pts[CPU_GRP_SIZE / 2] = startP;	//Center point
-
-		for(i = 0; i<hLength; i++) {
-			pp = startP;
-			pn = startP;
-
-			// P = startP + i*G
-			dy.ModSub(&Gn[i].y,&pp.y);
-
-			_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pp.x.ModNeg();
-			pp.x.ModAdd(&_p);
-			pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pp.y.ModSub(&Gn[i].x,&pp.x);
-			pp.y.ModMulK1(&_s);
-			pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-			dyn.Set(&Gn[i].y);
-			dyn.ModNeg();
-			dyn.ModSub(&pn.y);
-
-			_s.ModMulK1(&dyn,&dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-			_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-			pn.x.ModNeg();
-			pn.x.ModAdd(&_p);
-			pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-			pn.y.ModSub(&Gn[i].x,&pn.x);
-			pn.y.ModMulK1(&_s);
-			pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
-#endif
-
-			pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-			pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-		}
-
-		// First point (startP - (GRP_SZIE/2)*G)
-		pn = startP;
-		dyn.Set(&Gn[i].y);
-		dyn.ModNeg();
-		dyn.ModSub(&pn.y);
-
-		_s.ModMulK1(&dyn,&dx[i]);
-		_p.ModSquareK1(&_s);
-
-		pn.x.ModNeg();
-		pn.x.ModAdd(&_p);
-		pn.x.ModSub(&Gn[i].x);
-
-#if 0
-		pn.y.ModSub(&Gn[i].x,&pn.x);
-		pn.y.ModMulK1(&_s);
-		pn.y.ModAdd(&Gn[i].y);
-#endif
-
-		pts[0] = pn;
-		for(j=0;j<CPU_GRP_SIZE;j++)	{
-			pts[j].x.Get32Bytes((unsigned char*)rawvalue);
-			bloom_bP_index = (uint8_t)rawvalue[0];
-			if(i_counter < bsgs_m3)	{
-				if(!FLAGREADEDFILE3)	{
-					memcpy(bPtable[i_counter].value,rawvalue+16,BSGS_XVALUE_RAM);
-					bPtable[i_counter].index = i_counter;
-				}
-				if(!FLAGREADEDFILE4)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx3rd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx3rd_mutex[bloom_bP_index]);
-#else
-					pthread_mutex_lock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx3rd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx3rd_mutex[bloom_bP_index]);
-#endif
-				}
-			}
-			if(i_counter < bsgs_m2 && !FLAGREADEDFILE2)	{
-#if defined(_WIN64) && !defined(__CYGWIN__)
-					WaitForSingleObject(bloom_bPx2nd_mutex[bloom_bP_index], INFINITE);
-					bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					ReleaseMutex(bloom_bPx2nd_mutex[bloom_bP_index]);
-#else
-					pthread_mutex_lock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-					bloom_add(&bloom_bPx2nd[bloom_bP_index], rawvalue, BSGS_BUFFERXPOINTLENGTH);
-					pthread_mutex_unlock(&bloom_bPx2nd_mutex[bloom_bP_index]);
-#endif			
-			}
-			i_counter++;
-		}
-		// Next start point (startP + GRP_SIZE*G)
-		pp = startP;
-		dy.ModSub(&_2Gn.y,&pp.y);
-
-		_s.ModMulK1(&dy,&dx[i + 1]);
-		_p.ModSquareK1(&_s);
-
-		pp.x.ModNeg();
-		pp.x.ModAdd(&_p);
-		pp.x.ModSub(&_2Gn.x);
-
-		pp.y.ModSub(&_2Gn.x,&pp.x);
-		pp.y.ModMulK1(&_s);
-		pp.y.ModSub(&_2Gn.y);
-		startP = pp;
+		bstep->Step(&startP);
+		bsgs_bP_add_group(pts,cpu_grp_size,i_counter,0,xpoints_raw);
+		i_counter += cpu_grp_size;
 	}
-	delete grp;
+	free(xpoints_raw);
+	delete bstep;
 #if defined(_WIN64) && !defined(__CYGWIN__)
 	WaitForSingleObject(bPload_mutex[threadid], INFINITE);
 	tt->finished = 1;
@@ -4788,36 +4823,44 @@ void generate_binaddress_eth(Point &publickey,unsigned char *dst_address)	{
 	memcpy(dst_address,bin_publickey+12,20);
 }
 
+/* The addresses of n consecutive points, 20 bytes apart in dst_address. keccak256_eth reads the
+   limbs of the coordinates and hashes 8 points at once with AVX-512, 4 with AVX2 */
+void generate_binaddress_eth_group(AffinePoint *publickeys,int n,unsigned char *dst_address)	{
+	keccak256_eth(publickeys[0].x.v,publickeys[0].y.v,sizeof(AffinePoint) / sizeof(uint64_t),n,dst_address);
+}
+
 #if defined(_WIN64) && !defined(__CYGWIN__)
 DWORD WINAPI thread_process_bsgs_dance(LPVOID vargp) {
 #else
 void *thread_process_bsgs_dance(void *vargp)	{
 #endif
 
-	Point pts[CPU_GRP_SIZE];
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pp,pn,startP,base_point,point_aux,point_found;
+	Point point_candidate;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	uint8_t *bloom_hits = (uint8_t*) malloc(cpu_grp_size);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -2 );
+	checkpointer((void *)bloom_hits,__FILE__,"malloc","bloom_hits" ,__LINE__ -2 );
+	Point startP,base_point,point_aux,point_found;
 	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
-	Int base_key,keyfound,dy,dyn,_s,_p,km,intaux;
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+	char *aux_c,*hextemp;
+	Int base_key,keyfound,km,intaux;
 	uint32_t k,l,r,salir,thread_number,entrar,cycles;
-	int hLength = (CPU_GRP_SIZE / 2 - 1);	
 
-	grp->Set(dx);
 	
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
 	
-	cycles = bsgs_aux / 1024;
-	if(bsgs_aux % 1024 != 0)	{
+	cycles = bsgs_aux / cpu_grp_size;
+	if(bsgs_aux % cpu_grp_size != 0)	{
 		cycles++;
 	}
 	
 	intaux.Set(&BSGS_M_double);
-	intaux.Mult(CPU_GRP_SIZE/2);
+	intaux.Mult(cpu_grp_size/2);
 	intaux.Add(&BSGS_M);
 	
 	entrar = 1;
@@ -4909,97 +4952,12 @@ void *thread_process_bsgs_dance(void *vargp)	{
 				startP  = secp->AddDirect(OriginalPointsBSGS[k],point_aux);
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
-				
-					int i;
-					
-					for(i = 0; i < hLength; i++) {
-						dx[i].ModSub(&GSn[i].x,&startP.x);
-					}
-					dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-					dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-
-					// Grouped ModInv
-					grp->ModInv();
-					
-					/*
-					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-					We compute key in the positive and negative way from the center of the group
-					*/
-
-					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
-					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
-					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
-					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
+					bstep->Step(&startP);
+					bsgs_bloom_check_group(pts,cpu_grp_size,xpoints_raw,bloom_hits);
+					for(int i = 0; i<cpu_grp_size && bsgs_found[k]== 0; i++) {
+						if(bloom_hits[i]) {
+							point_candidate = bstep->Recover(i);
+							r = bsgs_secondcheck(&base_key,((j*cpu_grp_size) + i),k,&point_candidate,&keyfound);
 							if(r)	{
 								hextemp = keyfound.GetBase16();
 								printf("[+] Thread Key found privkey %s   \n",hextemp);
@@ -5039,22 +4997,6 @@ pn.y.ModAdd(&GSn[i].y);
 						
 					}// For for pts variable
 					
-					// Next start point (startP += (bsSize*GRP_SIZE).G)
-					
-					pp = startP;
-					dy.ModSub(&_2GSn.y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i + 1]);
-					_p.ModSquareK1(&_s);
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&_2GSn.x);
-
-					pp.y.ModSub(&_2GSn.x,&pp.x);
-					pp.y.ModMulK1(&_s);
-					pp.y.ModSub(&_2GSn.y);
-					startP = pp;
 					
 					j++;
 				}//while all the aMP points
@@ -5062,6 +5004,9 @@ pn.y.ModAdd(&GSn[i].y);
 		}
 		steps[thread_number]+=2;
 	}while(1);
+	free(xpoints_raw);
+	free(bloom_hits);
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -5073,39 +5018,34 @@ void *thread_process_bsgs_backward(void *vargp)	{
 #endif
 	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	char *aux_c,*hextemp;
 	Int base_key,keyfound;
 	Point base_point,point_aux,point_found;
 	uint32_t k,l,r,salir,thread_number,entrar,cycles;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	
-	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Point point_candidate;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	uint8_t *bloom_hits = (uint8_t*) malloc(cpu_grp_size);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -2 );
+	checkpointer((void *)bloom_hits,__FILE__,"malloc","bloom_hits" ,__LINE__ -2 );
 
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
 	Int km,intaux;
-	Point pp;
-	Point pn;
-	grp->Set(dx);
 
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
 
-	cycles = bsgs_aux / 1024;
-	if(bsgs_aux % 1024 != 0)	{
+	cycles = bsgs_aux / cpu_grp_size;
+	if(bsgs_aux % cpu_grp_size != 0)	{
 		cycles++;
 	}
 	
 	intaux.Set(&BSGS_M_double);
-	intaux.Mult(CPU_GRP_SIZE/2);
+	intaux.Mult(cpu_grp_size/2);
 	intaux.Add(&BSGS_M);
 	
 	entrar = 1;
@@ -5169,95 +5109,13 @@ void *thread_process_bsgs_backward(void *vargp)	{
 				startP  = secp->AddDirect(OriginalPointsBSGS[k],point_aux);
 				uint32_t j = 0;
 				while( j < cycles && bsgs_found[k]== 0 )	{
-					int i;
-					for(i = 0; i < hLength; i++) {
-						dx[i].ModSub(&GSn[i].x,&startP.x);
-					}
-					dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-					dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-
-					// Grouped ModInv
-					grp->ModInv();
-					
-					/*
-					We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-					We compute key in the positive and negative way from the center of the group
-					*/
-
-					// center point
-					pts[CPU_GRP_SIZE / 2] = startP;
-					
-					for(i = 0; i<hLength; i++) {
-
-						pp = startP;
-						pn = startP;
-
-						// P = startP + i*G
-						dy.ModSub(&GSn[i].y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-						
-#if 0
-  pp.y.ModSub(&GSn[i].x,&pp.x);
-  pp.y.ModMulK1(&_s);
-  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-						// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-						_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-  pn.y.ModSub(&GSn[i].x,&pn.x);
-  pn.y.ModMulK1(&_s);
-  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-						pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-						pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
-					}
-
-					// First point (startP - (GRP_SZIE/2)*G)
-					pn = startP;
-					dyn.Set(&GSn[i].y);
-					dyn.ModNeg();
-					dyn.ModSub(&pn.y);
-
-					_s.ModMulK1(&dyn,&dx[i]);
-					_p.ModSquareK1(&_s);
-
-					pn.x.ModNeg();
-					pn.x.ModAdd(&_p);
-					pn.x.ModSub(&GSn[i].x);
-
-#if 0
-pn.y.ModSub(&GSn[i].x,&pn.x);
-pn.y.ModMulK1(&_s);
-pn.y.ModAdd(&GSn[i].y);
-#endif
-
-					pts[0] = pn;
+					bstep->Step(&startP);
+					bsgs_bloom_check_group(pts,cpu_grp_size,xpoints_raw,bloom_hits);
 					
-					for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-						pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-						r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-						if(r) {
-							r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
+					for(int i = 0; i<cpu_grp_size && bsgs_found[k]== 0; i++) {
+						if(bloom_hits[i]) {
+							point_candidate = bstep->Recover(i);
+							r = bsgs_secondcheck(&base_key,((j*cpu_grp_size) + i),k,&point_candidate,&keyfound);
 							if(r)	{
 								hextemp = keyfound.GetBase16();
 								printf("[+] Thread Key found privkey %s   \n",hextemp);
@@ -5297,28 +5155,15 @@ pn.y.ModAdd(&GSn[i].y);
 						
 					}// For for pts variable
 					
-					// Next start point (startP += (bsSize*GRP_SIZE).G)
-					
-					pp = startP;
-					dy.ModSub(&_2GSn.y,&pp.y);
-
-					_s.ModMulK1(&dy,&dx[i + 1]);
-					_p.ModSquareK1(&_s);
-
-					pp.x.ModNeg();
-					pp.x.ModAdd(&_p);
-					pp.x.ModSub(&_2GSn.x);
-
-					pp.y.ModSub(&_2GSn.x,&pp.x);
-					pp.y.ModMulK1(&_s);
-					pp.y.ModSub(&_2GSn.y);
-					startP = pp;
 					j++;
 				}//while all the aMP points
 			}// End if 
 		}
 		steps[thread_number]+=2;
 	}while(1);
+	free(xpoints_raw);
+	free(bloom_hits);
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -5330,39 +5175,34 @@ void *thread_process_bsgs_both(void *vargp)	{
 #endif
 	FILE *filekey;
 	struct tothread *tt;
-	char xpoint_raw[32],*aux_c,*hextemp;
+	char *aux_c,*hextemp;
 	Int base_key,keyfound;
 	Point base_point,point_aux,point_found;
 	uint32_t k,l,r,salir,thread_number,entrar,cycles;
 	
-	IntGroup *grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
 	Point startP;
 	
-	int hLength = (CPU_GRP_SIZE / 2 - 1);
-	
-	Int dx[CPU_GRP_SIZE / 2 + 1];
-	Point pts[CPU_GRP_SIZE];
+	Point point_candidate;
+	BatchStepBase *bstep = NewBatchStep(cpu_grp_size,false,&GSn[0],&_2GSn);
+	AffinePoint *pts = bstep->pts;
+	unsigned char *xpoints_raw = (unsigned char*) malloc(cpu_grp_size * 32);
+	uint8_t *bloom_hits = (uint8_t*) malloc(cpu_grp_size);
+	checkpointer((void *)xpoints_raw,__FILE__,"malloc","xpoints_raw" ,__LINE__ -2 );
+	checkpointer((void *)bloom_hits,__FILE__,"malloc","bloom_hits" ,__LINE__ -2 );
 
-	Int dy;
-	Int dyn;
-	Int _s;
-	Int _p;
 	Int km,intaux;
-	Point pp;
-	Point pn;
-	grp->Set(dx);
 
 	
 	tt = (struct tothread *)vargp;
 	thread_number = tt->nt;
 	free(tt);
 	
-	cycles = bsgs_aux / 1024;
-	if(bsgs_aux % 1024 != 0)	{
+	cycles = bsgs_aux / cpu_grp_size;
+	if(bsgs_aux % cpu_grp_size != 0)	{
 		cycles++;
 	}
 	intaux.Set(&BSGS_M_double);
-	intaux.Mult(CPU_GRP_SIZE/2);
+	intaux.Mult(cpu_grp_size/2);
 	intaux.Add(&BSGS_M);
 	
 	entrar = 1;
@@ -5453,95 +5293,13 @@ void *thread_process_bsgs_both(void *vargp)	{
 					startP  = secp->AddDirect(OriginalPointsBSGS[k],point_aux);
 					uint32_t j = 0;
 					while( j < cycles && bsgs_found[k]== 0 )	{
-						int i;
-						for(i = 0; i < hLength; i++) {
-							dx[i].ModSub(&GSn[i].x,&startP.x);
-						}
-						dx[i].ModSub(&GSn[i].x,&startP.x);  // For the first point
-						dx[i+1].ModSub(&_2GSn.x,&startP.x); // For the next center point
-
-						// Grouped ModInv
-						grp->ModInv();
-						
-						/*
-						We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
-						We compute key in the positive and negative way from the center of the group
-						*/
-
-						// center point
-						pts[CPU_GRP_SIZE / 2] = startP;
-						
-						for(i = 0; i<hLength; i++) {
-
-							pp = startP;
-							pn = startP;
-
-							// P = startP + i*G
-							dy.ModSub(&GSn[i].y,&pp.y);
-
-							_s.ModMulK1(&dy,&dx[i]);        // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-							_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-							pp.x.ModNeg();
-							pp.x.ModAdd(&_p);
-							pp.x.ModSub(&GSn[i].x);           // rx = pow2(s) - p1.x - p2.x;
-							
-#if 0
-	  pp.y.ModSub(&GSn[i].x,&pp.x);
-	  pp.y.ModMulK1(&_s);
-	  pp.y.ModSub(&GSn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-							// P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
-							dyn.Set(&GSn[i].y);
-							dyn.ModNeg();
-							dyn.ModSub(&pn.y);
-
-							_s.ModMulK1(&dyn,&dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
-							_p.ModSquareK1(&_s);            // _p = pow2(s)
-
-							pn.x.ModNeg();
-							pn.x.ModAdd(&_p);
-							pn.x.ModSub(&GSn[i].x);          // rx = pow2(s) - p1.x - p2.x;
-
-#if 0
-	  pn.y.ModSub(&GSn[i].x,&pn.x);
-	  pn.y.ModMulK1(&_s);
-	  pn.y.ModAdd(&GSn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);  
-#endif
-
-
-							pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
-							pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
-
-						}
-
-						// First point (startP - (GRP_SZIE/2)*G)
-						pn = startP;
-						dyn.Set(&GSn[i].y);
-						dyn.ModNeg();
-						dyn.ModSub(&pn.y);
-
-						_s.ModMulK1(&dyn,&dx[i]);
-						_p.ModSquareK1(&_s);
-
-						pn.x.ModNeg();
-						pn.x.ModAdd(&_p);
-						pn.x.ModSub(&GSn[i].x);
-
-#if 0
-	pn.y.ModSub(&GSn[i].x,&pn.x);
-	pn.y.ModMulK1(&_s);
-	pn.y.ModAdd(&GSn[i].y);
-#endif
-
-						pts[0] = pn;
+						bstep->Step(&startP);
+						bsgs_bloom_check_group(pts,cpu_grp_size,xpoints_raw,bloom_hits);
 						
-						for(int i = 0; i<CPU_GRP_SIZE && bsgs_found[k]== 0; i++) {
-							pts[i].x.Get32Bytes((unsigned char*)xpoint_raw);
-							r = bloom_check(&bloom_bP[((unsigned char)xpoint_raw[0])],xpoint_raw,32);
-							if(r) {
-								r = bsgs_secondcheck(&base_key,((j*1024) + i),k,&keyfound);
+						for(int i = 0; i<cpu_grp_size && bsgs_found[k]== 0; i++) {
+							if(bloom_hits[i]) {
+								point_candidate = bstep->Recover(i);
+								r = bsgs_secondcheck(&base_key,((j*cpu_grp_size) + i),k,&point_candidate,&keyfound);
 								if(r)	{
 									hextemp = keyfound.GetBase16();
 									printf("[+] Thread Key found privkey %s   \n",hextemp);
@@ -5581,22 +5339,6 @@ void *thread_process_bsgs_both(void *vargp)	{
 							
 						}// For for pts variable
 						
-						// Next start point (startP += (bsSize*GRP_SIZE).G)
-						
-						pp = startP;
-						dy.ModSub(&_2GSn.y,&pp.y);
-
-						_s.ModMulK1(&dy,&dx[i + 1]);
-						_p.ModSquareK1(&_s);
-
-						pp.x.ModNeg();
-						pp.x.ModAdd(&_p);
-						pp.x.ModSub(&_2GSn.x);
-
-						pp.y.ModSub(&_2GSn.x,&pp.x);
-						pp.y.ModMulK1(&_s);
-						pp.y.ModSub(&_2GSn.y);
-						startP = pp;
 						
 						j++;
 					}//while all the aMP points
@@ -5604,6 +5346,9 @@ void *thread_process_bsgs_both(void *vargp)	{
 		}
 		steps[thread_number]+=2;	
 	}while(1);
+	free(xpoints_raw);
+	free(bloom_hits);
+	delete bstep;
 	ends[thread_number] = 1;
 	return NULL;
 }
@@ -5762,6 +5507,13 @@ void menu() {
 	printf("-S          S is for SAVING in files BSGS data (Bloom filters and bPtable)\n");
 	printf("-6          to skip sha256 Checksum on data files");
 	printf("-t tn       Threads number, must be a positive integer\n");
+	printf("--gtable b  Window bits of the generator table (%i to %i), default %i\n",GTABLE_MIN_BITS,GTABLE_MAX_BITS,GTABLE_BITS);
+	printf("--fuse      bsgs: use a binary fuse filter (18 to 20 bits per element) instead of the 1st bloom filter\n");
+	printf("--mmap      bsgs: save the BSGS data in page aligned .map files and map them read-only, implies -S\n");
+	printf("--mmap-populate  Same as --mmap, read the whole files when they are mapped\n");
+	printf("--mmap-huge      Same as --mmap, ask for transparent huge pages on the mapped files\n");
+	printf("--tune      Time each group size for the selected mode and save the fastest one in %s\n",TUNE_FILE);
+	printf("--cpu-info  Print the CPU features and the backend selected for each kernel, then exit\n");
 	printf("-v value    Search for vanity Address, only with -m vanity\n");
 	printf("-z value    Bloom size multiplier, only address,rmd160,vanity, xpoint, value >= 1\n");
 	printf("\nExample:\n\n");
@@ -5772,6 +5524,44 @@ void menu() {
 	exit(EXIT_FAILURE);
 }
 
+/*
+	The kernels are built for every instruction set whatever -march says
+	and picked at runtime, this shows what was picked on this CPU.
+*/
+void cpu_info()	{
+	/* __builtin_cpu_supports only takes string literals */
+	__builtin_cpu_init();
+	const char *features[] = {"sse4.1","sse4.2","avx","avx2","bmi2","adx","sha","avx512f","avx512bw","avx512ifma"};
+	int supported[] = {__builtin_cpu_supports("sse4.1"),__builtin_cpu_supports("sse4.2"),__builtin_cpu_supports("avx"),__builtin_cpu_supports("avx2"),__builtin_cpu_supports("bmi2"),__builtin_cpu_supports("adx"),__builtin_cpu_supports("sha"),__builtin_cpu_supports("avx512f"),__builtin_cpu_supports("avx512bw"),__builtin_cpu_supports("avx512ifma")};
+	const char *baseline;
+	int i,lanes;
+#if defined(__AVX512F__)
+	baseline = "AVX-512";
+#elif defined(__AVX2__)
+	baseline = "AVX2";
+#elif defined(__SSE4_2__)
+	baseline = "SSE4.2";
+#else
+	baseline = "x86-64";
+#endif
+	printf("[+] Compiled for %s and newer CPUs\n",baseline);
+	printf("[+] CPU features:");
+	for(i = 0; i < (int)(sizeof(features) / sizeof(features[0])); i++)	{
+		printf(" %s%s",features[i],supported[i] ? "" : " (no)");
+	}
+	printf("\n");
+	printf("[+] Field multiplication: %s\n",Int::GetK1Backend());
+	printf("[+] Point group: %s\n",PointGroup::GetBackendName());
+	lanes = sha256_lanes();
+	printf("[+] SHA-256: %i lanes %s\n",lanes,lanes == 16 ? "AVX-512" : (lanes == 8 ? "AVX2" : (sha256_ni ? "SHA-NI" : "SSE")));
+	lanes = hash160_lanes();
+	printf("[+] Hash160: %i lanes %s\n",lanes,lanes == 16 ? "AVX-512 fused" : (lanes == 8 ? "AVX2 fused" : (sha256_ni ? "SHA-NI + SSE RIPEMD-160" : "SSE")));
+	lanes = keccak_lanes();
+	printf("[+] Keccak-256: %i lanes %s\n",lanes,lanes == 8 ? "AVX-512" : (lanes == 4 ? "AVX2" : "scalar"));
+	printf("[+] Bloom filter probe: %s\n",bloom_probe_backend());
+	exit(EXIT_SUCCESS);
+}
+
 bool vanityrmdmatch(unsigned char *rmdhash)	{
 	bool r = false;
 	int i,j,cmpA,cmpB,result;
@@ -6131,20 +5921,19 @@ bool readFileVanity(char *fileName)	{
 bool readFileAddress(char *fileName)	{
 	FILE *fileDescriptor;
 	char fileBloomName[30];	/* Actually it is Bloom and Table but just to keep the variable name short*/
-	uint8_t checksum[32],hexPrefix[9];
 	char dataChecksum[32],bloomChecksum[32];
 	size_t bytesRead;
 	uint64_t dataSize;
+	struct sha256_tree_batch bloomBatch,dataBatch;
+	int mismatch;
 	/*
 		if the FLAGSAVEREADFILE is Set to 1 we need to the checksum and check if we have that information already saved
 	*/
 	if(FLAGSAVEREADFILE)	{	/* if the flag is set to REAd and SAVE the file firs we need to check it the file exist*/
-		if(!sha256_file((const char*)fileName,checksum)){
-			fprintf(stderr,"[E] sha256_file error line %i\n",__LINE__ - 1);
+		if(!data_file_name((const char*)fileName,fileBloomName,true)){
+			fprintf(stderr,"[E] checksum_input_file error line %i\n",__LINE__ - 1);
 			return false;
 		}
-		tohex_dst((char*)checksum,4,(char*)hexPrefix); // we save the prefix (last fourt bytes) hexadecimal value
-		snprintf(fileBloomName,30,"data_%s.dat",hexPrefix);
 		fileDescriptor = fopen(fileBloomName,"rb");
 		if(fileDescriptor != NULL)	{
 			printf("[+] Reading file %s\n",fileBloomName);
@@ -6194,23 +5983,10 @@ bool readFileAddress(char *fileName)	{
 				return false;
 			}
 			if(FLAGSKIPCHECKSUM == 0){
-				
-				//calculate checksum of the current readed data
-				sha256((uint8_t*)bloom.bf,bloom.bytes,(uint8_t*)checksum);
-				
-				//Compare checksums
-				/*
-				if(FLAGDEBUG)	{
-					hextemp = tohex((char*)checksum,32);
-					printf("[D] Current Bloom checksum %s\n",hextemp);
-					free(hextemp);
-				}
-				*/
-				if(memcmp(checksum,bloomChecksum,32) != 0)	{
-					fprintf(stderr,"[E] Error checksum mismatch, code line %i\n",__LINE__ - 2);
-					fclose(fileDescriptor);
-					return false;
-				}
+				//calculate checksum of the current readed data while the data is read
+				sha256_tree_batch_init(&bloomBatch,1,NTHREADS);
+				sha256_tree_batch_add(&bloomBatch,bloom.bf,bloom.bytes,NULL,(uint8_t*)bloomChecksum);
+				sha256_tree_batch_start(&bloomBatch);
 			}
 			
 			/*
@@ -6226,6 +6002,9 @@ bool readFileAddress(char *fileName)	{
 			if(bytesRead != 32)	{
 				fprintf(stderr,"[E] Errore reading file, code line %i\n",__LINE__ - 2);
 				fclose(fileDescriptor);
+				if(FLAGSKIPCHECKSUM == 0)	{
+					sha256_tree_batch_wait(&bloomBatch);	/* The threads still read bloom.bf */
+				}
 				return false;
 			}
 			
@@ -6233,6 +6012,9 @@ bool readFileAddress(char *fileName)	{
 			if(bytesRead != sizeof(uint64_t))	{
 				fprintf(stderr,"[E] Errore reading file, code line %i\n",__LINE__ - 2);
 				fclose(fileDescriptor);
+				if(FLAGSKIPCHECKSUM == 0)	{
+					sha256_tree_batch_wait(&bloomBatch);
+				}
 				return false; 
 			}
 			N = dataSize / sizeof(struct address_value);
@@ -6243,6 +6025,9 @@ bool readFileAddress(char *fileName)	{
 			if(addressTable == NULL)	{
 				fprintf(stderr,"[E] Error allocating memory, code line %i\n",__LINE__ - 2);
 				fclose(fileDescriptor);
+				if(FLAGSKIPCHECKSUM == 0)	{
+					sha256_tree_batch_wait(&bloomBatch);
+				}
 				return false;
 			}
 			
@@ -6250,16 +6035,25 @@ bool readFileAddress(char *fileName)	{
 			if(bytesRead != dataSize)	{
 				fprintf(stderr,"[E] Error reading file, code line %i\n",__LINE__ - 2);
 				fclose(fileDescriptor);
+				if(FLAGSKIPCHECKSUM == 0)	{
+					sha256_tree_batch_wait(&bloomBatch);
+				}
 				return false;
 			}
 			if(FLAGSKIPCHECKSUM == 0)	{
-					
-				sha256((uint8_t*)addressTable,dataSize,(uint8_t*)checksum);
-				if(memcmp(checksum,dataChecksum,32) != 0)	{
+				sha256_tree_batch_init(&dataBatch,1,NTHREADS);
+				sha256_tree_batch_add(&dataBatch,(uint8_t*)addressTable,dataSize,NULL,(uint8_t*)dataChecksum);
+				//Compare checksums, wait for both batches to release them
+				mismatch = sha256_tree_batch_wait(&bloomBatch);
+				mismatch += sha256_tree_batch_wait(&dataBatch);
+				if(mismatch != 0)	{
 					fprintf(stderr,"[E] Error checksum mismatch, code line %i\n",__LINE__ - 2);
 					fclose(fileDescriptor);
 					return false;
 				}
+				if(bloomBatch.legacy || dataBatch.legacy)	{
+					fprintf(stderr,"[W] The file %s has the checksums of a previous version, delete it to save it again\n",fileBloomName);
+				}
 			}
 			//printf("[D] bloom.bf points to %p\n",bloom.bf);
 			FLAGREADEDFILE1 = 1;	/* We mark the file as readed*/
@@ -6575,21 +6369,77 @@ bool initBloomFilter(struct bloom *bloom_arg,uint64_t items_bloom)	{
 	return r;
 }
 
+/*
+	Checksum that names the data_ file of an input file, the file is mapped and
+	its chunks hashed by the NTHREADS threads
+*/
+bool checksum_input_file(const char *fileName,uint8_t *checksum)	{
+	struct mapfile mf;
+	struct sha256_tree_batch batch;
+	if(mapfile_open(&mf,fileName,0) != 0)	{
+		return sha256_file(fileName,checksum);	/* Empty file or not a regular file */
+	}
+	sha256_tree_batch_init(&batch,1,NTHREADS);
+	sha256_tree_batch_add(&batch,mf.base,mf.length,checksum,NULL);
+	sha256_tree_batch_wait(&batch);
+	mapfile_close(&mf);
+	return true;
+}
+
+/*
+	Name of the -S file of an input file, data_ and the first 4 bytes of its checksum.
+	The previous versions named it from the flat sha256 of the input file, with
+	rename_old such a file is renamed once to the current name, its checksums are
+	still accepted
+*/
+bool data_file_name(const char *fileName,char *fileBloomName,bool rename_old)	{
+	FILE *fd;
+	char oldName[30];
+	uint8_t checksum[32],hexPrefix[9];
+	if(!checksum_input_file(fileName,checksum))	{
+		return false;
+	}
+	tohex_dst((char*)checksum,4,(char*)hexPrefix); // we save the prefix (last fourt bytes) hexadecimal value
+	snprintf(fileBloomName,30,"data_%s.dat",hexPrefix);
+	if(!rename_old)	{
+		return true;
+	}
+	fd = fopen(fileBloomName,"rb");
+	if(fd != NULL)	{
+		fclose(fd);
+		return true;
+	}
+	if(!sha256_file(fileName,checksum))	{
+		return true;
+	}
+	tohex_dst((char*)checksum,4,(char*)hexPrefix);
+	snprintf(oldName,30,"data_%s.dat",hexPrefix);
+	if(strcmp(oldName,fileBloomName) == 0 || (fd = fopen(oldName,"rb")) == NULL)	{
+		return true;
+	}
+	fclose(fd);
+	if(rename(oldName,fileBloomName) == 0)	{
+		printf("[W] Renamed the file %s of a previous version to %s\n",oldName,fileBloomName);
+	}
+	else	{
+		fprintf(stderr,"[W] The file %s of a previous version can't be renamed to %s, it is not used anymore\n",oldName,fileBloomName);
+	}
+	return true;
+}
+
 void writeFileIfNeeded(const char *fileName)	{
 	//printf("[D] FLAGSAVEREADFILE %i, FLAGREADEDFILE1 %i\n",FLAGSAVEREADFILE,FLAGREADEDFILE1);
 	if(FLAGSAVEREADFILE && !FLAGREADEDFILE1)	{
 		FILE *fileDescriptor;
 		char fileBloomName[30];
-		uint8_t checksum[32],hexPrefix[9];
 		char dataChecksum[32],bloomChecksum[32];
 		size_t bytesWrite;
 		uint64_t dataSize;
-		if(!sha256_file((const char*)fileName,checksum)){
-			fprintf(stderr,"[E] sha256_file error line %i\n",__LINE__ - 1);
+		struct sha256_tree_batch batch;
+		if(!data_file_name((const char*)fileName,fileBloomName,false)){
+			fprintf(stderr,"[E] checksum_input_file error line %i\n",__LINE__ - 1);
 			exit(EXIT_FAILURE);
 		}
-		tohex_dst((char*)checksum,4,(char*)hexPrefix); // we save the prefix (last fourt bytes) hexadecimal value
-		snprintf(fileBloomName,30,"data_%s.dat",hexPrefix);
 		fileDescriptor = fopen(fileBloomName,"wb");
 		dataSize = N * (sizeof(struct address_value));
 		printf("[D] size data %li\n",dataSize);
@@ -6611,7 +6461,10 @@ void writeFileIfNeeded(const char *fileName)	{
 			
 			
 
-			sha256((uint8_t*)bloom.bf,bloom.bytes,(uint8_t*)bloomChecksum);
+			sha256_tree_batch_init(&batch,2,NTHREADS);
+			sha256_tree_batch_add(&batch,bloom.bf,bloom.bytes,(uint8_t*)bloomChecksum,NULL);
+			sha256_tree_batch_add(&batch,(uint8_t*)addressTable,dataSize,(uint8_t*)dataChecksum,NULL);
+			sha256_tree_batch_wait(&batch);
 			printf(".");
 			bytesWrite = fwrite(bloomChecksum,1,32,fileDescriptor);
 			if(bytesWrite != 32)	{
@@ -6646,7 +6499,6 @@ void writeFileIfNeeded(const char *fileName)	{
 
 			
 			
-			sha256((uint8_t*)addressTable,dataSize,(uint8_t*)dataChecksum);
 			printf(".");
 
 			bytesWrite = fwrite(dataChecksum,1,32,fileDescriptor);
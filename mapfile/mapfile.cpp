@@ -0,0 +1,128 @@
+/*
+ * Refer to mapfile.h for documentation on the public interfaces.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapfile.h"
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+
+int mapfile_open(struct mapfile * mf, const char * filename, int flags)
+{
+  LARGE_INTEGER size;
+  uint64_t i;
+  volatile uint8_t touch;
+
+  memset(mf, 0, sizeof(struct mapfile));
+  mf->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (mf->file == INVALID_HANDLE_VALUE) {
+    return (GetLastError() == ERROR_FILE_NOT_FOUND) ? -1 : 1;
+  }
+  if (!GetFileSizeEx(mf->file, &size) || size.QuadPart == 0) {
+    CloseHandle(mf->file);
+    return 1;
+  }
+  mf->length = size.QuadPart;
+  mf->mapping = CreateFileMappingA(mf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mf->mapping == NULL) {
+    CloseHandle(mf->file);
+    return 1;
+  }
+  mf->base = (uint8_t *)MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (mf->base == NULL) {
+    CloseHandle(mf->mapping);
+    CloseHandle(mf->file);
+    return 1;
+  }
+  if (flags & MAPFILE_POPULATE) {
+    for (i = 0; i < mf->length; i += MAPFILE_ALIGN) {
+      touch = mf->base[i];
+    }
+    (void)touch;
+  }
+  return 0;
+}
+
+void mapfile_close(struct mapfile * mf)
+{
+  if (mf->base != NULL) {
+    UnmapViewOfFile(mf->base);
+    CloseHandle(mf->mapping);
+    CloseHandle(mf->file);
+  }
+  mf->base = NULL;
+}
+
+#else
+
+int mapfile_open(struct mapfile * mf, const char * filename, int flags)
+{
+  struct stat st;
+  int fd, mflags = MAP_SHARED;
+
+  memset(mf, 0, sizeof(struct mapfile));
+  fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return (errno == ENOENT) ? -1 : 1;
+  }
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return 1;
+  }
+  mf->length = st.st_size;
+#ifdef MAP_POPULATE
+  if (flags & MAPFILE_POPULATE) {
+    mflags |= MAP_POPULATE;
+  }
+#endif
+  mf->base = (uint8_t *)mmap(NULL, mf->length, PROT_READ, mflags, fd, 0);
+  close(fd);
+  if (mf->base == (uint8_t *)MAP_FAILED) {
+    mf->base = NULL;
+    return 1;
+  }
+#ifdef MADV_HUGEPAGE
+  if (flags & MAPFILE_HUGEPAGE) {
+    madvise(mf->base, mf->length, MADV_HUGEPAGE);  // Only a hint, most file systems ignore it
+  }
+#endif
+  return 0;
+}
+
+void mapfile_close(struct mapfile * mf)
+{
+  if (mf->base != NULL) {
+    munmap(mf->base, mf->length);
+  }
+  mf->base = NULL;
+}
+
+#endif
+
+uint64_t mapfile_align(uint64_t offset)
+{
+  return (offset + MAPFILE_ALIGN - 1) & ~(uint64_t)(MAPFILE_ALIGN - 1);
+}
+
+uint64_t mapfile_pad(FILE * fd, uint64_t position)
+{
+  static const uint8_t zeros[MAPFILE_ALIGN] = {0};
+  uint64_t n = mapfile_align(position) - position;
+  if (n > 0 && fwrite(zeros, n, 1, fd) != 1) {
+    return 0;
+  }
+  return position + n;
+}
@@ -0,0 +1,81 @@
+/*
+ * Read-only memory mapped files for the bsgs tables: the filters and the bP
+ * table are used in place from the page cache instead of being copied into
+ * malloc'd buffers, so the processes mapping the same file share one copy.
+ */
+
+#ifndef _MAPFILE_H
+#define _MAPFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAPFILE_ALIGN 4096
+
+#define MAPFILE_POPULATE 1	// Read the whole file when it is mapped
+#define MAPFILE_HUGEPAGE 2	// Ask for transparent huge pages
+
+struct mapfile
+{
+  uint8_t *base;
+  uint64_t length;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  void *file;
+  void *mapping;
+#endif
+};
+
+
+/** ***************************************************************************
+ * Map the whole file read-only.
+ *
+ * Parameters:
+ * -----------
+ *     mf       - Pointer to the struct mapfile to fill.
+ *     filename - File to map.
+ *     flags    - MAPFILE_POPULATE and/or MAPFILE_HUGEPAGE, both are hints
+ *                ignored where the system doesn't have them.
+ *
+ * Return:
+ * -------
+ *     0 - on success
+ *    -1 - the file doesn't exist
+ *     1 - on failure
+ *
+ */
+int mapfile_open(struct mapfile * mf, const char * filename, int flags);
+
+
+/** ***************************************************************************
+ * Unmap the file.
+ *
+ */
+void mapfile_close(struct mapfile * mf);
+
+
+/** ***************************************************************************
+ * Offset rounded up to the next MAPFILE_ALIGN boundary.
+ *
+ */
+uint64_t mapfile_align(uint64_t offset);
+
+
+/** ***************************************************************************
+ * Write zeros from position up to mapfile_align(position).
+ *
+ * Return:
+ * -------
+ *     The new position, 0 on write error
+ *
+ */
+uint64_t mapfile_pad(FILE * fd, uint64_t position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
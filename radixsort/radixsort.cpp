@@ -0,0 +1,225 @@
+/*
+ * Refer to radixsort.h for documentation on the public interfaces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN64) && !defined(__CYGWIN__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "radixsort.h"
+
+#define RADIXSORT_SMALL 64  // Buckets up to this size end with an insertion sort
+
+struct radixsort_job
+{
+  uint8_t *base;
+  int size;
+  int key_length;
+  uint64_t start[257];  // Buckets of the first byte
+  uint64_t next;
+};
+
+// SIZE is the record size known at compile time, 0 for the generic one
+template <int SIZE>
+static inline void radixsort_swap(uint8_t * a, uint8_t * b, int size)
+{
+  uint8_t t[RADIXSORT_MAX_SIZE];
+  if (SIZE) {
+    size = SIZE;
+  }
+  memcpy(t, a, size);
+  memcpy(a, b, size);
+  memcpy(b, t, size);
+}
+
+template <int SIZE>
+static void radixsort_insertion(uint8_t * base, uint64_t n, int size, int key_length, int byte)
+{
+  uint8_t key[RADIXSORT_MAX_SIZE];
+  uint64_t i, j;
+  if (SIZE) {
+    size = SIZE;
+  }
+  // The first bytes are equal inside a bucket
+  key_length -= byte;
+  for (i = 1; i < n; i++) {
+    memcpy(key, base + i * size, size);
+    for (j = i; j > 0 && memcmp(base + (j - 1) * size + byte, key + byte, key_length) > 0; j--) {
+      memcpy(base + j * size, base + (j - 1) * size, size);
+    }
+    memcpy(base + j * size, key, size);
+  }
+}
+
+// Move every record to the bucket of its byte, start[] gets the 257 limits
+template <int SIZE>
+static void radixsort_split(uint8_t * base, uint64_t n, int size, int byte, uint64_t * start)
+{
+  uint64_t count[256], head[256], i;
+  int b, d;
+  if (SIZE) {
+    size = SIZE;
+  }
+  memset(count, 0, sizeof(count));
+  for (i = 0; i < n; i++) {
+    count[base[i * size + byte]]++;
+  }
+  start[0] = 0;
+  for (b = 0; b < 256; b++) {
+    head[b] = start[b];
+    start[b + 1] = start[b] + count[b];
+  }
+  for (b = 0; b < 256; b++) {
+    while (head[b] < start[b + 1]) {
+      d = base[head[b] * size + byte];
+      if (d == b) {
+        head[b]++;
+      }
+      else {
+        radixsort_swap<SIZE>(base + head[b] * size, base + head[d] * size, size);
+        head[d]++;
+      }
+    }
+  }
+}
+
+template <int SIZE>
+static void radixsort_msd(uint8_t * base, uint64_t n, int size, int key_length, int byte)
+{
+  uint64_t start[257];
+  int b;
+  if (SIZE) {
+    size = SIZE;
+  }
+  if (n <= RADIXSORT_SMALL) {
+    radixsort_insertion<SIZE>(base, n, size, key_length, byte);
+    return;
+  }
+  radixsort_split<SIZE>(base, n, size, byte, start);
+  if (byte + 1 == key_length) {
+    return;
+  }
+  for (b = 0; b < 256; b++) {
+    if (start[b + 1] - start[b] > 1) {
+      radixsort_msd<SIZE>(base + start[b] * size, start[b + 1] - start[b], size, key_length, byte + 1);
+    }
+  }
+}
+
+template <int SIZE>
+static void radixsort_bucket(struct radixsort_job * job, int b)
+{
+  uint64_t n = job->start[b + 1] - job->start[b];
+  if (n > 1 && job->key_length > 1) {
+    radixsort_msd<SIZE>(job->base + job->start[b] * job->size, n, job->size, job->key_length, 1);
+  }
+}
+
+// Threads take the buckets of the first byte one at a time
+#if defined(_WIN64) && !defined(__CYGWIN__)
+static DWORD WINAPI radixsort_thread(LPVOID vargp)
+#else
+static void *radixsort_thread(void *vargp)
+#endif
+{
+  struct radixsort_job *job = (struct radixsort_job *)vargp;
+  uint64_t b;
+  while ((b = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < 256) {
+    switch (job->size) {
+      case 11:
+        radixsort_bucket<11>(job, b);
+        break;
+      case 16:
+        radixsort_bucket<16>(job, b);
+        break;
+      case 20:
+        radixsort_bucket<20>(job, b);
+        break;
+      default:
+        radixsort_bucket<0>(job, b);
+        break;
+    }
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  return 0;
+#else
+  return NULL;
+#endif
+}
+
+void radixsort(void * base, uint64_t n, int size, int key_length, int nthreads)
+{
+  struct radixsort_job job;
+  int i;
+
+  if (size > RADIXSORT_MAX_SIZE || key_length > size) {
+    fprintf(stderr, "[E] radixsort: unsupported record of %i bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  if (n < 2 || key_length < 1) {
+    return;
+  }
+  job.base = (uint8_t *)base;
+  job.size = size;
+  job.key_length = key_length;
+  job.next = 0;
+  switch (size) {
+    case 11:
+      radixsort_split<11>(job.base, n, size, 0, job.start);
+      break;
+    case 16:
+      radixsort_split<16>(job.base, n, size, 0, job.start);
+      break;
+    case 20:
+      radixsort_split<20>(job.base, n, size, 0, job.start);
+      break;
+    default:
+      radixsort_split<0>(job.base, n, size, 0, job.start);
+      break;
+  }
+  if (nthreads < 1) {
+    nthreads = 1;
+  }
+  if (nthreads > 256) {
+    nthreads = 256;
+  }
+  if (nthreads == 1 || n < 65536) {
+    radixsort_thread(&job);
+    return;
+  }
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  HANDLE *tid = (HANDLE *)calloc(nthreads, sizeof(HANDLE));
+#else
+  pthread_t *tid = (pthread_t *)calloc(nthreads, sizeof(pthread_t));
+#endif
+  if (tid == NULL) {
+    fprintf(stderr, "[E] error calloc radixsort\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < nthreads; i++) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    tid[i] = CreateThread(NULL, 0, radixsort_thread, (void *)&job, 0, NULL);
+    if (tid[i] == NULL) {
+#else
+    if (pthread_create(&tid[i], NULL, radixsort_thread, (void *)&job) != 0) {
+#endif
+      fprintf(stderr, "[E] error creating the sort threads\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (i = 0; i < nthreads; i++) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+    WaitForSingleObject(tid[i], INFINITE);
+    CloseHandle(tid[i]);
+#else
+    pthread_join(tid[i], NULL);
+#endif
+  }
+  free(tid);
+}
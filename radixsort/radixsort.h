@@ -0,0 +1,42 @@
+/*
+ * In place MSD radix sort (American flag sort) for the tables of fixed size
+ * records sorted by a key of the first bytes: the addressTable values and
+ * the bP table of the bsgs mode. No comparison on the first levels and no
+ * extra memory, the records are moved with swaps.
+ *
+ * The first byte splits the table in 256 buckets with a single pass, then
+ * the buckets are sorted by several threads.
+ */
+
+#ifndef _RADIXSORT_H
+#define _RADIXSORT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADIXSORT_MAX_SIZE 64
+
+
+/** ***************************************************************************
+ * Sort n records of size bytes by their first key_length bytes, in memcmp()
+ * order. Records with the same key are left in any order.
+ *
+ * Parameters:
+ * -----------
+ *     base       - First record.
+ *     n          - Number of records.
+ *     size       - Size of each record, up to RADIXSORT_MAX_SIZE.
+ *     key_length - Bytes of the key, at the start of the record.
+ *     nthreads   - Threads that sort the 256 buckets of the first byte.
+ *
+ */
+void radixsort(void * base, uint64_t n, int size, int key_length, int nthreads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * This file is part of the BSGS distribution (https://github.com/JeanLucPons/BSGS).
+ * Copyright (c) 2020 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCHSTEPH
+#define BATCHSTEPH
+
+#include "Point.h"
+#include "FieldElem.h"
+#include "IntGroup.h"
+#include "PointGroup.h"
+
+// Batch stepping shared by all the scan loops.
+// With Gn[i] = (i+1).S and _2Gn = GRP_SIZE.S (S = G for the key scans,
+// S = the bsgs baby step for the bsgs giant steps), one grouped ModInv
+// gives the GRP_SIZE points around the center startP:
+//   pts[i] = startP + (i - GRP_SIZE/2).S
+// and moves startP to the next center startP + GRP_SIZE.S.
+// Only x (and y when CALC_Y is set) of pts[] are computed, startP is
+// always complete. Gn and pts are AffinePoint (64 bytes, aligned), a
+// group of 4096 points is 256 KB instead of 480 KB with Point.
+// Recover(i) rebuilds the full pts[i] of the last Step from the saved
+// center when a caller needs y for a rare candidate.
+
+class BatchStepBase {
+
+public:
+
+  virtual ~BatchStepBase() {}
+  virtual void Step(Point *startP) = 0;
+  virtual Point Recover(int i) = 0;
+
+  AffinePoint *pts;
+  int size;
+
+};
+
+template <int GRP_SIZE, bool CALC_Y>
+class BatchStep : public BatchStepBase {
+
+public:
+
+  BatchStep(AffinePoint *Gn, Point *_2Gn) : grp(GRP_SIZE / 2 + 1), pgrp(GRP_SIZE) {
+    this->Gn = Gn;
+    this->_2Gn = _2Gn;
+    size = GRP_SIZE;
+    pts = new AffinePoint[GRP_SIZE];
+    grp.Set(dx);
+    pgrp.Set(Gn, dx);
+  }
+
+  ~BatchStep() {
+    delete[] pts;
+  }
+
+  void Step(Point *startP) {
+
+    int i;
+    FieldElem sx;
+    FieldElem d;
+    center = *startP;
+    sx.Set(&startP->x);
+    for (i = 0; i < HLENGTH; i++) {
+      d.ModSub(&Gn[i].x, &sx);
+      d.Get(&dx[i]);
+    }
+    d.ModSub(&Gn[i].x, &sx);                  // For the first point
+    d.Get(&dx[i]);
+    dx[i + 1].ModSub(&_2Gn->x, &startP->x);   // For the next center point
+    grp.ModInv();
+
+    pgrp.ComputeGroup(pts, startP, CALC_Y);
+    NextCenter(startP);
+
+  }
+
+  // pts[i] = center + (i - GRP_SIZE/2).S with y, one ModInv
+  Point Recover(int i) {
+
+    int d = i - GRP_SIZE / 2;
+    if (d == 0)
+      return center;
+
+    Int dy;
+    Int dx;
+    Int _s;
+    Int _p;
+    Point r;
+    Point g = Gn[(d > 0 ? d : -d) - 1].GetPoint();
+    if (d < 0)
+      g.y.ModNeg();
+
+    dy.ModSub(&g.y, &center.y);
+    dx.ModSub(&g.x, &center.x);
+    dx.ModInv();
+    _s.ModMulK1(&dy, &dx);
+    _p.ModSquareK1(&_s);
+
+    r.x.ModSub(&_p, &center.x);
+    r.x.ModSub(&g.x);
+    r.y.ModSub(&g.x, &r.x);
+    r.y.ModMulK1(&_s);
+    r.y.ModSub(&g.y);
+    r.z.SetInt32(1);
+    return r;
+
+  }
+
+private:
+
+  static const int HLENGTH = GRP_SIZE / 2 - 1;
+
+  // startP += _2Gn, the inverse was computed with the group
+  void NextCenter(Point *startP) {
+
+    Int dy;
+    Int _s;
+    Int _p;
+    Point pp = *startP;
+
+    dy.ModSub(&_2Gn->y, &pp.y);
+    _s.ModMulK1(&dy, &dx[HLENGTH + 1]);
+    _p.ModSquareK1(&_s);
+
+    pp.x.ModNeg();
+    pp.x.ModAdd(&_p);
+    pp.x.ModSub(&_2Gn->x);
+
+    // The Y value of the next center always needs to be calculated
+    pp.y.ModSub(&_2Gn->x, &pp.x);
+    pp.y.ModMulK1(&_s);
+    pp.y.ModSub(&_2Gn->y);
+    *startP = pp;
+
+  }
+
+  Int dx[GRP_SIZE / 2 + 1];
+  IntGroup grp;
+  PointGroup pgrp;
+  Point center;            // startP of the last Step
+  AffinePoint *Gn;
+  Point *_2Gn;
+
+};
+
+// Group sizes having an instantiation (powers of 2)
+#define BATCHSTEP_MIN_SIZE 256
+#define BATCHSTEP_MAX_SIZE 4096
+
+template <int GRP_SIZE>
+BatchStepBase *NewBatchStep(bool calculate_y, AffinePoint *Gn, Point *_2Gn) {
+  if (calculate_y)
+    return new BatchStep<GRP_SIZE, true>(Gn, _2Gn);
+  return new BatchStep<GRP_SIZE, false>(Gn, _2Gn);
+}
+
+// Group size chosen at runtime, NULL if it has no instantiation
+inline BatchStepBase *NewBatchStep(int size, bool calculate_y, AffinePoint *Gn, Point *_2Gn) {
+  switch (size) {
+    case 256:
+      return NewBatchStep<256>(calculate_y, Gn, _2Gn);
+    case 512:
+      return NewBatchStep<512>(calculate_y, Gn, _2Gn);
+    case 1024:
+      return NewBatchStep<1024>(calculate_y, Gn, _2Gn);
+    case 2048:
+      return NewBatchStep<2048>(calculate_y, Gn, _2Gn);
+    case 4096:
+      return NewBatchStep<4096>(calculate_y, Gn, _2Gn);
+  }
+  return NULL;
+}
+
+#endif // BATCHSTEPH
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the BSGS distribution (https://github.com/JeanLucPons/BSGS).
+ * Copyright (c) 2020 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIELDELEMH
+#define FIELDELEMH
+
+#include "Int.h"
+#include "Point.h"
+
+// Element of the secp256k1 field on exactly 4x64 bits limbs.
+// Int carries NB64BLOCK limbs for scalars and generic arithmetic, FieldElem
+// is the tight storage for tables and loops that only do mod P operations.
+// Values are expected in [0,P) (ModMulK1/ModSquareK1 may return < 2^256
+// like their Int counterparts).
+
+class FieldElem {
+
+public:
+
+  void ModMulK1(FieldElem *a, FieldElem *b);
+  void ModMulK1(FieldElem *a);
+  void ModSquareK1(FieldElem *a);
+  void ModAdd(FieldElem *a, FieldElem *b);
+  void ModSub(FieldElem *a, FieldElem *b);
+  void ModNeg();
+
+  inline void Set(Int *a) {
+    v[0] = a->bits64[0];
+    v[1] = a->bits64[1];
+    v[2] = a->bits64[2];
+    v[3] = a->bits64[3];
+  }
+
+  inline void Get(Int *a) {
+    a->bits64[0] = v[0];
+    a->bits64[1] = v[1];
+    a->bits64[2] = v[2];
+    a->bits64[3] = v[3];
+    for (int i = 4; i < NB64BLOCK; i++)
+      a->bits64[i] = 0;
+  }
+
+  inline void SetOne() {
+    v[0] = 1;
+    v[1] = 0;
+    v[2] = 0;
+    v[3] = 0;
+  }
+
+  inline bool IsOdd() {
+    return (v[0] & 1) == 1;
+  }
+
+  // 32 bytes big endian, same as Int::Get32Bytes
+  inline void Get32Bytes(unsigned char *buff) {
+    uint64_t *ptr = (uint64_t *)buff;
+    ptr[3] = _byteswap_uint64(v[0]);
+    ptr[2] = _byteswap_uint64(v[1]);
+    ptr[1] = _byteswap_uint64(v[2]);
+    ptr[0] = _byteswap_uint64(v[3]);
+  }
+
+  // bits[] is the 32 bits view used by the hash message builders
+  union {
+    uint64_t v[4];
+    uint32_t bits[8];
+  };
+
+};
+
+// Affine point (x,y) on one cache line
+struct alignas(64) AffinePoint {
+
+  FieldElem x;
+  FieldElem y;
+
+  inline void Set(Point *p) {
+    x.Set(&p->x);
+    y.Set(&p->y);
+  }
+
+  // p = (x,y,1)
+  inline void Get(Point *p) {
+    x.Get(&p->x);
+    y.Get(&p->y);
+    p->z.SetInt32(1);
+  }
+
+  inline Point GetPoint() {
+    Point p;
+    Get(&p);
+    return p;
+  }
+
+  // (x,-y) of p
+  inline void SetNegation(AffinePoint *p) {
+    x = p->x;
+    y = p->y;
+    y.ModNeg();
+  }
+
+};
+
+#endif // FIELDELEMH
@@ -102,6 +102,7 @@ public:
   static Int *GetR3();                           // Return R3
   static Int *GetR4();                           // Return R4
   static Int* GetFieldCharacteristic();          // Return field characteristic
+  static bool UseSafegcd(bool use);              // Select safegcd or DRS62 for ModInv, false if built with NOSAFEGCD
 
   void GCD(Int *a);                          // this <- GCD(this,a)
   void Mod(Int *n);                          // this <- this (mod n)
@@ -126,6 +127,7 @@ public:
 
   // Specific SecpK1
   static void InitK1(Int *order);
+  static const char *GetK1Backend();           // Kernel of ModMulK1/ModSquareK1 selected for this CPU
   void ModMulK1(Int *a, Int *b);
   void ModMulK1(Int *a);
   void ModMulK1order(Int *a);
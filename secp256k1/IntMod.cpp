@@ -16,6 +16,7 @@
 */
 
 #include "Int.h"
+#include "FieldElem.h"
 #include <emmintrin.h>
 #include <string.h>
 
@@ -32,6 +33,15 @@ static uint32_t MM32;     // 32bits lsb negative inverse of P
 static uint64_t MM64;     // 64bits lsb negative inverse of P
 #define MSK62  0x3FFFFFFFFFFFFFFF
 
+// safegcd ModInv, build with -DNOSAFEGCD to keep DRS62 only
+#if defined(__SIZEOF_INT128__) && !defined(NOSAFEGCD)
+#define SAFEGCD62 1
+static int64_t  P62[5];   // Field characteristic in signed 62bits limbs (safegcd)
+static uint64_t PI62;     // 62bits lsb inverse of P (safegcd)
+static bool     P62Ok;    // P fits in 256bits, safegcd can be used
+static bool     P62Use = true; // cleared by UseSafegcd(false), DRS62 only
+#endif
+
 extern Int _ONE;
 
 // ------------------------------------------------
@@ -105,6 +115,254 @@ void Int::ModNeg() {
   Add(&_P);
 }
 
+
+#ifdef SAFEGCD62
+
+// ------------------------------------------------
+// Bernstein-Yang safegcd inverse (https://eprint.iacr.org/2019/266)
+// Constant iteration count: 10 rounds of 59 divsteps (590 > bound for 256bits).
+// Values are kept in 5 signed 62bits limbs, transition matrices are scaled by 2^62.
+
+typedef struct {
+  int64_t u, v, q, r;
+} trans2x2;
+
+static int64_t divsteps_59(int64_t zeta, uint64_t f0, uint64_t g0, trans2x2 *t) {
+
+  // Start from identity*8 so that after 59 shifts the matrix is scaled by 2^62
+  uint64_t u = 8, v = 0, q = 0, r = 8;
+  uint64_t c1, c2, mask1, mask2, x, y, z;
+  uint64_t f = f0, g = g0;
+
+  for (int i = 3; i < 62; i++) {
+    c1 = (uint64_t)(zeta >> 63);
+    mask1 = c1;
+    c2 = g & 1;
+    mask2 = -c2;
+    // Conditionally negated f,u,v
+    x = (f ^ mask1) - mask1;
+    y = (u ^ mask1) - mask1;
+    z = (v ^ mask1) - mask1;
+    // g odd: add them to g,q,r
+    g += x & mask2;
+    q += y & mask2;
+    r += z & mask2;
+    // zeta<0 and g odd: swap (zeta becomes -zeta-2) else zeta-1
+    mask1 &= mask2;
+    zeta = (zeta ^ (int64_t)mask1) - 1;
+    f += g & mask1;
+    u += q & mask1;
+    v += r & mask1;
+    g >>= 1;
+    u <<= 1;
+    v <<= 1;
+  }
+
+  t->u = (int64_t)u;
+  t->v = (int64_t)v;
+  t->q = (int64_t)q;
+  t->r = (int64_t)r;
+  return zeta;
+
+}
+
+// [d,e] <- (t*[d,e] + P*[md,me]) / 2^62 (mod P)
+static void update_de_62(int64_t *d, int64_t *e, const trans2x2 *t) {
+
+  const int64_t d0 = d[0], d1 = d[1], d2 = d[2], d3 = d[3], d4 = d[4];
+  const int64_t e0 = e[0], e1 = e[1], e2 = e[2], e3 = e[3], e4 = e[4];
+  const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+  int64_t md, me, sd, se;
+  __int128 cd, ce;
+
+  // md,me start as [u,q] if d<0 plus [v,r] if e<0, this keeps d,e in (-2P,P)
+  sd = d4 >> 63;
+  se = e4 >> 63;
+  md = (u & sd) + (v & se);
+  me = (q & sd) + (r & se);
+
+  cd = (__int128)u * d0 + (__int128)v * e0;
+  ce = (__int128)q * d0 + (__int128)r * e0;
+
+  // Choose md,me such that the 62 lsb vanish
+  md -= (int64_t)((PI62 * (uint64_t)cd + (uint64_t)md) & MSK62);
+  me -= (int64_t)((PI62 * (uint64_t)ce + (uint64_t)me) & MSK62);
+  cd += (__int128)P62[0] * md;
+  ce += (__int128)P62[0] * me;
+  cd >>= 62;
+  ce >>= 62;
+
+  // Middle limbs of P are zero for the secp256k1 field
+  cd += (__int128)u * d1 + (__int128)v * e1;
+  ce += (__int128)q * d1 + (__int128)r * e1;
+  if (P62[1]) {
+    cd += (__int128)P62[1] * md;
+    ce += (__int128)P62[1] * me;
+  }
+  d[0] = (int64_t)cd & MSK62; cd >>= 62;
+  e[0] = (int64_t)ce & MSK62; ce >>= 62;
+
+  cd += (__int128)u * d2 + (__int128)v * e2;
+  ce += (__int128)q * d2 + (__int128)r * e2;
+  if (P62[2]) {
+    cd += (__int128)P62[2] * md;
+    ce += (__int128)P62[2] * me;
+  }
+  d[1] = (int64_t)cd & MSK62; cd >>= 62;
+  e[1] = (int64_t)ce & MSK62; ce >>= 62;
+
+  cd += (__int128)u * d3 + (__int128)v * e3;
+  ce += (__int128)q * d3 + (__int128)r * e3;
+  if (P62[3]) {
+    cd += (__int128)P62[3] * md;
+    ce += (__int128)P62[3] * me;
+  }
+  d[2] = (int64_t)cd & MSK62; cd >>= 62;
+  e[2] = (int64_t)ce & MSK62; ce >>= 62;
+
+  cd += (__int128)u * d4 + (__int128)v * e4;
+  ce += (__int128)q * d4 + (__int128)r * e4;
+  cd += (__int128)P62[4] * md;
+  ce += (__int128)P62[4] * me;
+  d[3] = (int64_t)cd & MSK62; cd >>= 62;
+  e[3] = (int64_t)ce & MSK62; ce >>= 62;
+
+  d[4] = (int64_t)cd;
+  e[4] = (int64_t)ce;
+
+}
+
+// [f,g] <- t*[f,g] / 2^62 (exact division)
+static void update_fg_62(int64_t *f, int64_t *g, const trans2x2 *t) {
+
+  const int64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+  const int64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+  const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+  __int128 cf, cg;
+
+  cf = (__int128)u * f0 + (__int128)v * g0;
+  cg = (__int128)q * f0 + (__int128)r * g0;
+  cf >>= 62;
+  cg >>= 62;
+
+  cf += (__int128)u * f1 + (__int128)v * g1;
+  cg += (__int128)q * f1 + (__int128)r * g1;
+  f[0] = (int64_t)cf & MSK62; cf >>= 62;
+  g[0] = (int64_t)cg & MSK62; cg >>= 62;
+
+  cf += (__int128)u * f2 + (__int128)v * g2;
+  cg += (__int128)q * f2 + (__int128)r * g2;
+  f[1] = (int64_t)cf & MSK62; cf >>= 62;
+  g[1] = (int64_t)cg & MSK62; cg >>= 62;
+
+  cf += (__int128)u * f3 + (__int128)v * g3;
+  cg += (__int128)q * f3 + (__int128)r * g3;
+  f[2] = (int64_t)cf & MSK62; cf >>= 62;
+  g[2] = (int64_t)cg & MSK62; cg >>= 62;
+
+  cf += (__int128)u * f4 + (__int128)v * g4;
+  cg += (__int128)q * f4 + (__int128)r * g4;
+  f[3] = (int64_t)cf & MSK62; cf >>= 62;
+  g[3] = (int64_t)cg & MSK62; cg >>= 62;
+
+  f[4] = (int64_t)cf;
+  g[4] = (int64_t)cg;
+
+}
+
+// Bring r from (-2P,P) to [0,P), negate it first if sign < 0
+static void normalize_62(int64_t *r, int64_t sign) {
+
+  int64_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+  int64_t cond_add, cond_negate;
+
+  cond_add = r4 >> 63;
+  r0 += P62[0] & cond_add;
+  r1 += P62[1] & cond_add;
+  r2 += P62[2] & cond_add;
+  r3 += P62[3] & cond_add;
+  r4 += P62[4] & cond_add;
+  cond_negate = sign >> 63;
+  r0 = (r0 ^ cond_negate) - cond_negate;
+  r1 = (r1 ^ cond_negate) - cond_negate;
+  r2 = (r2 ^ cond_negate) - cond_negate;
+  r3 = (r3 ^ cond_negate) - cond_negate;
+  r4 = (r4 ^ cond_negate) - cond_negate;
+  r1 += r0 >> 62; r0 &= MSK62;
+  r2 += r1 >> 62; r1 &= MSK62;
+  r3 += r2 >> 62; r2 &= MSK62;
+  r4 += r3 >> 62; r3 &= MSK62;
+
+  cond_add = r4 >> 63;
+  r0 += P62[0] & cond_add;
+  r1 += P62[1] & cond_add;
+  r2 += P62[2] & cond_add;
+  r3 += P62[3] & cond_add;
+  r4 += P62[4] & cond_add;
+  r1 += r0 >> 62; r0 &= MSK62;
+  r2 += r1 >> 62; r1 &= MSK62;
+  r3 += r2 >> 62; r2 &= MSK62;
+  r4 += r3 >> 62; r3 &= MSK62;
+
+  r[0] = r0;
+  r[1] = r1;
+  r[2] = r2;
+  r[3] = r3;
+  r[4] = r4;
+
+}
+
+static void safegcd_inv(uint64_t *x) {
+
+  // d=0, e=1, f=P, g=x, zeta=-1 (delta=1/2)
+  int64_t d[5] = { 0,0,0,0,0 };
+  int64_t e[5] = { 1,0,0,0,0 };
+  int64_t f[5] = { P62[0],P62[1],P62[2],P62[3],P62[4] };
+  int64_t g[5];
+  int64_t zeta = -1;
+  trans2x2 t;
+
+  g[0] = (int64_t)(x[0] & MSK62);
+  g[1] = (int64_t)(((x[0] >> 62) | (x[1] << 2)) & MSK62);
+  g[2] = (int64_t)(((x[1] >> 60) | (x[2] << 4)) & MSK62);
+  g[3] = (int64_t)(((x[2] >> 58) | (x[3] << 6)) & MSK62);
+  g[4] = (int64_t)(x[3] >> 56);
+
+  for (int i = 0; i < 10; i++) {
+    zeta = divsteps_59(zeta, (uint64_t)f[0], (uint64_t)g[0], &t);
+    update_de_62(d, e, &t);
+    update_fg_62(f, g, &t);
+  }
+
+  // g is now 0 and f = +/-gcd(P,x), +/-1 when x has an inverse, d = +/-x^-1
+  if (!(f[0] == 1 && (f[1] | f[2] | f[3] | f[4]) == 0) &&
+      !((f[0] & f[1] & f[2] & f[3]) == MSK62 && f[4] == -1)) {
+    x[0] = x[1] = x[2] = x[3] = 0;  // x multiple of P, 0 like DRS62
+    return;
+  }
+  normalize_62(d, f[4]);
+
+  x[0] = (uint64_t)d[0] | ((uint64_t)d[1] << 62);
+  x[1] = ((uint64_t)d[1] >> 2) | ((uint64_t)d[2] << 60);
+  x[2] = ((uint64_t)d[2] >> 4) | ((uint64_t)d[3] << 58);
+  x[3] = ((uint64_t)d[3] >> 6) | ((uint64_t)d[4] << 56);
+
+}
+
+#endif
+
+// ------------------------------------------------
+
+bool Int::UseSafegcd(bool use) {
+#ifdef SAFEGCD62
+  P62Use = use;
+  return true;
+#else
+  (void)use;
+  return false;
+#endif
+}
+
 // ------------------------------------------------
 
 void Int::ModInv() {
@@ -119,6 +377,19 @@ void Int::ModInv() {
   //#define MONTGOMERY 1        // ~200 kOps/s
   //#define PENK 1              // ~179 kOps/s
   #define DRS62 1             // ~365 kOps/s
+  // SAFEGCD62 (int128 only)  // ~1.5x DRS62, used when P fits in 256bits
+
+#ifdef SAFEGCD62
+  // Only for 0 <= this < 2^256, negative or larger inputs go through DRS62
+  if (P62Ok && P62Use && bits64[4] == 0
+#if NB64BLOCK > 5
+      && (bits64[5] | bits64[6] | bits64[7] | bits64[8]) == 0
+#endif
+     ) {
+    safegcd_inv(bits64);
+    return;
+  }
+#endif
 
   Int u(&_P);
   Int v(this);
@@ -701,6 +972,25 @@ void Int::SetupField(Int *n, Int *R, Int *R2, Int *R3, Int *R4) {
   }
   _P.Set(n);
 
+#ifdef SAFEGCD62
+  // safegcd needs P in signed 62bits limbs, use sparse form for the secp256k1 field
+  P62Ok = !_P.IsNegative() && _P.IsOdd() && _P.GetBitLength() <= 256;
+  if (P62Ok) {
+    uint64_t *p = _P.bits64;
+    if (p[0] == 0xFFFFFFFEFFFFFC2FULL && p[1] == 0xFFFFFFFFFFFFFFFFULL &&
+        p[2] == 0xFFFFFFFFFFFFFFFFULL && p[3] == 0xFFFFFFFFFFFFFFFFULL) {
+      P62[0] = -0x1000003D1LL; P62[1] = 0; P62[2] = 0; P62[3] = 0; P62[4] = 256;
+    } else {
+      P62[0] = (int64_t)(p[0] & MSK62);
+      P62[1] = (int64_t)(((p[0] >> 62) | (p[1] << 2)) & MSK62);
+      P62[2] = (int64_t)(((p[1] >> 60) | (p[2] << 4)) & MSK62);
+      P62[3] = (int64_t)(((p[2] >> 58) | (p[3] << 6)) & MSK62);
+      P62[4] = (int64_t)(p[3] >> 56);
+    }
+    PI62 = (-MM64) & MSK62;
+  }
+#endif
+
   // Size of Montgomery mult (64bits digit)
   Msize = nSize/2;
 
@@ -850,8 +1140,223 @@ void Int::MontgomeryMult(Int *a, Int *b) {
 
 // SecpK1 specific section -----------------------------------------------------------------------------
 
+#if defined(__x86_64__) && !defined(_WIN64)
+
+// BMI2/ADX kernels: mulx does not touch the flags so two independent carry
+// chains (adcx on CF, adox on OF) can be interleaved in a row of partial products.
+// Selected at runtime, the generic code below is kept for other CPUs.
+
+static bool hasADX() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+}
+
+static const bool useADX = hasADX();
+
+// 512 to 256 bits reduction, p = 2^256 - 0x1000003D1
+static inline void reduceK1_adx(uint64_t *r, const uint64_t *t) {
+
+  uint64_t c0, c1, c2, c3, c4, lo, hi, zero;
+
+  __asm__ volatile (
+    "movq $0x1000003D1, %%rdx\n\t"
+    "xorl %k[zero], %k[zero]\n\t"
+    "movq 0(%[t]), %[c0]\n\t"
+    "movq 8(%[t]), %[c1]\n\t"
+    "movq 16(%[t]), %[c2]\n\t"
+    "movq 24(%[t]), %[c3]\n\t"
+    "mulxq 32(%[t]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[c0]\n\t"
+    "adcxq %[hi], %[c1]\n\t"
+    "mulxq 40(%[t]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[c1]\n\t"
+    "adcxq %[hi], %[c2]\n\t"
+    "mulxq 48(%[t]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[c2]\n\t"
+    "adcxq %[hi], %[c3]\n\t"
+    "mulxq 56(%[t]), %[lo], %[c4]\n\t"
+    "adoxq %[lo], %[c3]\n\t"
+    "adcxq %[zero], %[c4]\n\t"
+    "adoxq %[zero], %[c4]\n\t"
+    // 320 to 256, c4 <= 0x1000003D1
+    "mulxq %[c4], %[lo], %[hi]\n\t"
+    "addq %[lo], %[c0]\n\t"
+    "adcq %[hi], %[c1]\n\t"
+    "adcq $0, %[c2]\n\t"
+    "adcq $0, %[c3]\n\t"
+    "movq %[c0], 0(%[r])\n\t"
+    "movq %[c1], 8(%[r])\n\t"
+    "movq %[c2], 16(%[r])\n\t"
+    "movq %[c3], 24(%[r])\n\t"
+    : [c0] "=&r"(c0), [c1] "=&r"(c1), [c2] "=&r"(c2), [c3] "=&r"(c3), [c4] "=&r"(c4),
+      [lo] "=&r"(lo), [hi] "=&r"(hi), [zero] "=&r"(zero)
+    : [r] "r"(r), [t] "r"(t)
+    : "rdx", "cc", "memory");
+
+}
+
+// t = a*b (512 bits)
+static inline void mul256_adx(uint64_t *t, const uint64_t *a, const uint64_t *b) {
+
+  uint64_t r0, r1, r2, r3, r4, lo, hi, zero;
+
+  __asm__ volatile (
+    // b0
+    "movq 0(%[b]), %%rdx\n\t"
+    "mulxq 0(%[a]), %[r0], %[r1]\n\t"
+    "mulxq 8(%[a]), %[lo], %[r2]\n\t"
+    "addq %[lo], %[r1]\n\t"
+    "mulxq 16(%[a]), %[lo], %[r3]\n\t"
+    "adcq %[lo], %[r2]\n\t"
+    "mulxq 24(%[a]), %[lo], %[r4]\n\t"
+    "adcq %[lo], %[r3]\n\t"
+    "adcq $0, %[r4]\n\t"
+    "movq %[r0], 0(%[t])\n\t"
+    // b1, window r1..r4,r0
+    "xorl %k[zero], %k[zero]\n\t"
+    "movq 8(%[b]), %%rdx\n\t"
+    "mulxq 0(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r1]\n\t"
+    "adcxq %[hi], %[r2]\n\t"
+    "mulxq 8(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r2]\n\t"
+    "adcxq %[hi], %[r3]\n\t"
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r3]\n\t"
+    "adcxq %[hi], %[r4]\n\t"
+    "mulxq 24(%[a]), %[lo], %[r0]\n\t"
+    "adoxq %[lo], %[r4]\n\t"
+    "adcxq %[zero], %[r0]\n\t"
+    "adoxq %[zero], %[r0]\n\t"
+    "movq %[r1], 8(%[t])\n\t"
+    // b2, window r2..r4,r0,r1
+    "xorl %k[zero], %k[zero]\n\t"
+    "movq 16(%[b]), %%rdx\n\t"
+    "mulxq 0(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r2]\n\t"
+    "adcxq %[hi], %[r3]\n\t"
+    "mulxq 8(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r3]\n\t"
+    "adcxq %[hi], %[r4]\n\t"
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r4]\n\t"
+    "adcxq %[hi], %[r0]\n\t"
+    "mulxq 24(%[a]), %[lo], %[r1]\n\t"
+    "adoxq %[lo], %[r0]\n\t"
+    "adcxq %[zero], %[r1]\n\t"
+    "adoxq %[zero], %[r1]\n\t"
+    "movq %[r2], 16(%[t])\n\t"
+    // b3, window r3,r4,r0,r1,r2
+    "xorl %k[zero], %k[zero]\n\t"
+    "movq 24(%[b]), %%rdx\n\t"
+    "mulxq 0(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r3]\n\t"
+    "adcxq %[hi], %[r4]\n\t"
+    "mulxq 8(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r4]\n\t"
+    "adcxq %[hi], %[r0]\n\t"
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[r0]\n\t"
+    "adcxq %[hi], %[r1]\n\t"
+    "mulxq 24(%[a]), %[lo], %[r2]\n\t"
+    "adoxq %[lo], %[r1]\n\t"
+    "adcxq %[zero], %[r2]\n\t"
+    "adoxq %[zero], %[r2]\n\t"
+    "movq %[r3], 24(%[t])\n\t"
+    "movq %[r4], 32(%[t])\n\t"
+    "movq %[r0], 40(%[t])\n\t"
+    "movq %[r1], 48(%[t])\n\t"
+    "movq %[r2], 56(%[t])\n\t"
+    : [r0] "=&r"(r0), [r1] "=&r"(r1), [r2] "=&r"(r2), [r3] "=&r"(r3), [r4] "=&r"(r4),
+      [lo] "=&r"(lo), [hi] "=&r"(hi), [zero] "=&r"(zero)
+    : [t] "r"(t), [a] "r"(a), [b] "r"(b)
+    : "rdx", "cc", "memory");
+
+}
+
+// t = a^2 (512 bits), cross products computed once and doubled
+static inline void sqr256_adx(uint64_t *t, const uint64_t *a) {
+
+  uint64_t t1, t2, t3, t4, t5, t6, t7, lo, hi, zero;
+
+  __asm__ volatile (
+    // a0*a1, a0*a2, a0*a3
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq 8(%[a]), %[t1], %[t2]\n\t"
+    "mulxq 16(%[a]), %[lo], %[t3]\n\t"
+    "addq %[lo], %[t2]\n\t"
+    "mulxq 24(%[a]), %[lo], %[t4]\n\t"
+    "adcq %[lo], %[t3]\n\t"
+    "adcq $0, %[t4]\n\t"
+    // a1*a2, a1*a3
+    "xorl %k[zero], %k[zero]\n\t"
+    "movq 8(%[a]), %%rdx\n\t"
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+    "adoxq %[lo], %[t3]\n\t"
+    "adcxq %[hi], %[t4]\n\t"
+    "mulxq 24(%[a]), %[lo], %[t5]\n\t"
+    "adoxq %[lo], %[t4]\n\t"
+    "adcxq %[zero], %[t5]\n\t"
+    "adoxq %[zero], %[t5]\n\t"
+    // a2*a3
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq 24(%[a]), %[lo], %[t6]\n\t"
+    "addq %[lo], %[t5]\n\t"
+    "adcq $0, %[t6]\n\t"
+    // Double cross products
+    "xorl %k[t7], %k[t7]\n\t"
+    "addq %[t1], %[t1]\n\t"
+    "adcq %[t2], %[t2]\n\t"
+    "adcq %[t3], %[t3]\n\t"
+    "adcq %[t4], %[t4]\n\t"
+    "adcq %[t5], %[t5]\n\t"
+    "adcq %[t6], %[t6]\n\t"
+    "adcq $0, %[t7]\n\t"
+    // Add squares
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %[lo], %[hi]\n\t"
+    "movq %[lo], 0(%[t])\n\t"
+    "addq %[hi], %[t1]\n\t"
+    "movq 8(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %[lo], %[hi]\n\t"
+    "adcq %[lo], %[t2]\n\t"
+    "adcq %[hi], %[t3]\n\t"
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %[lo], %[hi]\n\t"
+    "adcq %[lo], %[t4]\n\t"
+    "adcq %[hi], %[t5]\n\t"
+    "movq 24(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %[lo], %[hi]\n\t"
+    "adcq %[lo], %[t6]\n\t"
+    "adcq %[hi], %[t7]\n\t"
+    "movq %[t1], 8(%[t])\n\t"
+    "movq %[t2], 16(%[t])\n\t"
+    "movq %[t3], 24(%[t])\n\t"
+    "movq %[t4], 32(%[t])\n\t"
+    "movq %[t5], 40(%[t])\n\t"
+    "movq %[t6], 48(%[t])\n\t"
+    "movq %[t7], 56(%[t])\n\t"
+    : [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3), [t4] "=&r"(t4), [t5] "=&r"(t5),
+      [t6] "=&r"(t6), [t7] "=&r"(t7), [lo] "=&r"(lo), [hi] "=&r"(hi), [zero] "=&r"(zero)
+    : [t] "r"(t), [a] "r"(a)
+    : "rdx", "cc", "memory");
+
+}
+
+#endif
+
 void Int::ModMulK1(Int *a, Int *b) {
 
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX) {
+    uint64_t r512[8];
+    mul256_adx(r512, a->bits64, b->bits64);
+    reduceK1_adx(bits64, r512);
+    bits64[4] = 0;
+    return;
+  }
+#endif
+
 #ifndef _WIN64
 #if (__GNUC__ > 7) || (__GNUC__ == 7 && (__GNUC_MINOR__ > 2))
   unsigned char c;
@@ -914,6 +1419,16 @@ void Int::ModMulK1(Int *a, Int *b) {
 
 void Int::ModMulK1(Int *a) {
 
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX) {
+    uint64_t r512[8];
+    mul256_adx(r512, a->bits64, bits64);
+    reduceK1_adx(bits64, r512);
+    bits64[4] = 0;
+    return;
+  }
+#endif
+
 #ifndef _WIN64
 #if (__GNUC__ > 7) || (__GNUC__ == 7 && (__GNUC_MINOR__ > 2))
   unsigned char c;
@@ -974,6 +1489,16 @@ void Int::ModMulK1(Int *a) {
 
 void Int::ModSquareK1(Int *a) {
 
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX) {
+    uint64_t r512[8];
+    sqr256_adx(r512, a->bits64);
+    reduceK1_adx(bits64, r512);
+    bits64[4] = 0;
+    return;
+  }
+#endif
+
 #ifndef _WIN64
 #if (__GNUC__ > 7) || (__GNUC__ == 7 && (__GNUC_MINOR__ > 2))
   unsigned char c;
@@ -1090,6 +1615,97 @@ void Int::ModSquareK1(Int *a) {
 
 }
 
+// FieldElem (4x64 bits) ------------------------------------------------------------------------------
+
+void FieldElem::ModMulK1(FieldElem *a, FieldElem *b) {
+
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX) {
+    uint64_t r512[8];
+    mul256_adx(r512, a->v, b->v);
+    reduceK1_adx(v, r512);
+    return;
+  }
+#endif
+  Int ia, ib, r;
+  a->Get(&ia);
+  b->Get(&ib);
+  r.ModMulK1(&ia, &ib);
+  Set(&r);
+
+}
+
+void FieldElem::ModMulK1(FieldElem *a) {
+  ModMulK1(this, a);
+}
+
+void FieldElem::ModSquareK1(FieldElem *a) {
+
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX) {
+    uint64_t r512[8];
+    sqr256_adx(r512, a->v);
+    reduceK1_adx(v, r512);
+    return;
+  }
+#endif
+  Int ia, r;
+  a->Get(&ia);
+  r.ModSquareK1(&ia);
+  Set(&r);
+
+}
+
+void FieldElem::ModAdd(FieldElem *a, FieldElem *b) {
+
+  unsigned char c, c2;
+  uint64_t r[4];
+  uint64_t t[4];
+
+  c = _addcarry_u64(0, a->v[0], b->v[0], r + 0);
+  c = _addcarry_u64(c, a->v[1], b->v[1], r + 1);
+  c = _addcarry_u64(c, a->v[2], b->v[2], r + 2);
+  c = _addcarry_u64(c, a->v[3], b->v[3], r + 3);
+
+  // r >= P <=> r + 0x1000003D1 >= 2^256, then r - P = r + 0x1000003D1 mod 2^256
+  c2 = _addcarry_u64(0, r[0], 0x1000003D1ULL, t + 0);
+  c2 = _addcarry_u64(c2, r[1], 0, t + 1);
+  c2 = _addcarry_u64(c2, r[2], 0, t + 2);
+  c2 = _addcarry_u64(c2, r[3], 0, t + 3);
+
+  if (c | c2) {
+    v[0] = t[0]; v[1] = t[1]; v[2] = t[2]; v[3] = t[3];
+  } else {
+    v[0] = r[0]; v[1] = r[1]; v[2] = r[2]; v[3] = r[3];
+  }
+
+}
+
+void FieldElem::ModSub(FieldElem *a, FieldElem *b) {
+
+  unsigned char c;
+  uint64_t r[4];
+
+  c = _subborrow_u64(0, a->v[0], b->v[0], r + 0);
+  c = _subborrow_u64(c, a->v[1], b->v[1], r + 1);
+  c = _subborrow_u64(c, a->v[2], b->v[2], r + 2);
+  c = _subborrow_u64(c, a->v[3], b->v[3], r + 3);
+
+  // Add P = subtract 0x1000003D1 mod 2^256
+  uint64_t m = 0ULL - (uint64_t)c;
+  c = _subborrow_u64(0, r[0], m & 0x1000003D1ULL, v + 0);
+  c = _subborrow_u64(c, r[1], 0, v + 1);
+  c = _subborrow_u64(c, r[2], 0, v + 2);
+  c = _subborrow_u64(c, r[3], 0, v + 3);
+
+}
+
+void FieldElem::ModNeg() {
+  FieldElem zero;
+  zero.v[0] = 0; zero.v[1] = 0; zero.v[2] = 0; zero.v[3] = 0;
+  ModSub(&zero, this);
+}
+
 static Int _R2o;                               // R^2 for SecpK1 order modular mult
 static uint64_t MM64o = 0x4B0DFF665588B13FULL; // 64bits lsb negative inverse of SecpK1 order
 static Int *_O;                                // SecpK1 order
@@ -1099,6 +1715,14 @@ void Int::InitK1(Int *order) {
   _R2o.SetBase16("9D671CD581C69BC5E697F5E45BCD07C6741496C20E7CF878896CF21467D7D140");
 }
 
+const char *Int::GetK1Backend() {
+#if defined(__x86_64__) && !defined(_WIN64)
+  if (useADX)
+    return "BMI2/ADX";
+#endif
+  return "mul/adc";
+}
+
 void Int::ModAddK1order(Int *a, Int *b) {
   Add(a,b);
   Sub(_O);
@@ -0,0 +1,742 @@
+/*
+ * This file is part of the BSGS distribution (https://github.com/JeanLucPons/BSGS).
+ * Copyright (c) 2020 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <immintrin.h>    // before Int.h which redefines _addcarry_u64
+#include "PointGroup.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#define IFMA_TARGET __attribute__((target("avx2,avx512f,avx512ifma")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+#define M52 0xFFFFFFFFFFFFFULL
+#define M48 0xFFFFFFFFFFFFULL
+#define M26 0x3FFFFFFULL
+#define M22 0x3FFFFFULL
+
+static int pgBackend = -1;
+
+// ------------------------------------------------
+// 8 lanes, 5x52 bits limbs, AVX-512 IFMA
+// Values are kept weakly normalized between operations:
+// limbs < 2^52 and value < 2^256 + 2^211 (always < 2P)
+
+namespace _fe52 {
+
+  static inline IFMA_TARGET void WeakNorm(__m512i *r) {
+
+    const __m512i m52 = _mm512_set1_epi64(M52);
+
+    // 2^256 = 0x1000003D1 (mod P)
+    __m512i x = _mm512_srli_epi64(r[4], 48);
+    r[4] = _mm512_and_si512(r[4], _mm512_set1_epi64(M48));
+    r[0] = _mm512_madd52lo_epu64(r[0], x, _mm512_set1_epi64(0x1000003D1ULL));
+    r[1] = _mm512_add_epi64(r[1], _mm512_srli_epi64(r[0], 52)); r[0] = _mm512_and_si512(r[0], m52);
+    r[2] = _mm512_add_epi64(r[2], _mm512_srli_epi64(r[1], 52)); r[1] = _mm512_and_si512(r[1], m52);
+    r[3] = _mm512_add_epi64(r[3], _mm512_srli_epi64(r[2], 52)); r[2] = _mm512_and_si512(r[2], m52);
+    r[4] = _mm512_add_epi64(r[4], _mm512_srli_epi64(r[3], 52)); r[3] = _mm512_and_si512(r[3], m52);
+
+  }
+
+  // Reduce a 10 limbs product
+  static inline IFMA_TARGET void Reduce(__m512i *r, __m512i *t) {
+
+    const __m512i m52 = _mm512_set1_epi64(M52);
+    // 2^260 = 0x1000003D10 (mod P)
+    const __m512i R = _mm512_set1_epi64(0x1000003D10ULL);
+
+    for (int k = 0; k < 9; k++) {
+      t[k + 1] = _mm512_add_epi64(t[k + 1], _mm512_srli_epi64(t[k], 52));
+      t[k] = _mm512_and_si512(t[k], m52);
+    }
+
+    __m512i c = _mm512_madd52hi_epu64(_mm512_setzero_si512(), t[9], R);
+    for (int k = 0; k < 5; k++)
+      r[k] = _mm512_madd52lo_epu64(t[k], t[k + 5], R);
+    for (int k = 0; k < 4; k++)
+      r[k + 1] = _mm512_madd52hi_epu64(r[k + 1], t[k + 5], R);
+    r[0] = _mm512_madd52lo_epu64(r[0], c, R);
+    r[1] = _mm512_madd52hi_epu64(r[1], c, R);
+
+    WeakNorm(r);
+
+  }
+
+  static inline IFMA_TARGET void Mul(__m512i *r, const __m512i *a, const __m512i *b) {
+
+    __m512i t[10];
+    for (int k = 0; k < 10; k++)
+      t[k] = _mm512_setzero_si512();
+
+    for (int i = 0; i < 5; i++) {
+      for (int j = 0; j < 5; j++) {
+        t[i + j] = _mm512_madd52lo_epu64(t[i + j], a[i], b[j]);
+        t[i + j + 1] = _mm512_madd52hi_epu64(t[i + j + 1], a[i], b[j]);
+      }
+    }
+
+    Reduce(r, t);
+
+  }
+
+  static inline IFMA_TARGET void Sqr(__m512i *r, const __m512i *a) {
+
+    __m512i t[10];
+    for (int k = 0; k < 10; k++)
+      t[k] = _mm512_setzero_si512();
+
+    // Cross products once, doubled
+    for (int i = 0; i < 5; i++) {
+      for (int j = i + 1; j < 5; j++) {
+        t[i + j] = _mm512_madd52lo_epu64(t[i + j], a[i], a[j]);
+        t[i + j + 1] = _mm512_madd52hi_epu64(t[i + j + 1], a[i], a[j]);
+      }
+    }
+    for (int k = 0; k < 10; k++)
+      t[k] = _mm512_slli_epi64(t[k], 1);
+    for (int i = 0; i < 5; i++) {
+      t[2 * i] = _mm512_madd52lo_epu64(t[2 * i], a[i], a[i]);
+      t[2 * i + 1] = _mm512_madd52hi_epu64(t[2 * i + 1], a[i], a[i]);
+    }
+
+    Reduce(r, t);
+
+  }
+
+  // Limbs of 4P and 8P, larger than any weakly normalized limb
+  static const uint64_t P4[5] = { 4 * 0xFFFFEFFFFFC2FULL,4 * M52,4 * M52,4 * M52,4 * M48 };
+  static const uint64_t P8[5] = { 8 * 0xFFFFEFFFFFC2FULL,8 * M52,8 * M52,8 * M52,8 * M48 };
+
+  // r = a - b
+  static inline IFMA_TARGET void Sub(__m512i *r, const __m512i *a, const __m512i *b) {
+    for (int k = 0; k < 5; k++)
+      r[k] = _mm512_sub_epi64(_mm512_add_epi64(a[k], _mm512_set1_epi64(P4[k])), b[k]);
+    WeakNorm(r);
+  }
+
+  // r = a - b - c
+  static inline IFMA_TARGET void Sub2(__m512i *r, const __m512i *a, const __m512i *b, const __m512i *c) {
+    for (int k = 0; k < 5; k++)
+      r[k] = _mm512_sub_epi64(_mm512_sub_epi64(_mm512_add_epi64(a[k], _mm512_set1_epi64(P8[k])), b[k]), c[k]);
+    WeakNorm(r);
+  }
+
+  // r = - a - b
+  static inline IFMA_TARGET void NegSub(__m512i *r, const __m512i *a, const __m512i *b) {
+    for (int k = 0; k < 5; k++)
+      r[k] = _mm512_sub_epi64(_mm512_sub_epi64(_mm512_set1_epi64(P8[k]), a[k]), b[k]);
+    WeakNorm(r);
+  }
+
+  // r = a + b
+  static inline IFMA_TARGET void Add(__m512i *r, const __m512i *a, const __m512i *b) {
+    for (int k = 0; k < 5; k++)
+      r[k] = _mm512_add_epi64(a[k], b[k]);
+    WeakNorm(r);
+  }
+
+  // Bring r to [0,P)
+  static inline IFMA_TARGET void Normalize(__m512i *r) {
+
+    const __m512i m52 = _mm512_set1_epi64(M52);
+    const __m512i m48 = _mm512_set1_epi64(M48);
+
+    WeakNorm(r);
+
+    __mmask8 m = _mm512_test_epi64_mask(r[4], _mm512_set1_epi64(~M48));
+    __mmask8 e = _mm512_cmpeq_epu64_mask(r[4], m48) &
+                 _mm512_cmpeq_epu64_mask(r[3], m52) &
+                 _mm512_cmpeq_epu64_mask(r[2], m52) &
+                 _mm512_cmpeq_epu64_mask(r[1], m52) &
+                 _mm512_cmpge_epu64_mask(r[0], _mm512_set1_epi64(0xFFFFEFFFFFC2FULL));
+    m |= e;
+
+    // r >= P: r - P = r + 0x1000003D1 - 2^256
+    r[0] = _mm512_mask_add_epi64(r[0], m, r[0], _mm512_set1_epi64(0x1000003D1ULL));
+    r[1] = _mm512_add_epi64(r[1], _mm512_srli_epi64(r[0], 52)); r[0] = _mm512_and_si512(r[0], m52);
+    r[2] = _mm512_add_epi64(r[2], _mm512_srli_epi64(r[1], 52)); r[1] = _mm512_and_si512(r[1], m52);
+    r[3] = _mm512_add_epi64(r[3], _mm512_srli_epi64(r[2], 52)); r[2] = _mm512_and_si512(r[2], m52);
+    r[4] = _mm512_add_epi64(r[4], _mm512_srli_epi64(r[3], 52)); r[3] = _mm512_and_si512(r[3], m52);
+    r[4] = _mm512_and_si512(r[4], m48);
+
+  }
+
+  // Gather 8 Int (idx = byte offsets from base)
+  static inline IFMA_TARGET void Load(__m512i *r, const uint64_t *base, __m512i idx, __mmask8 m) {
+
+    const __m512i m52 = _mm512_set1_epi64(M52);
+    const __m512i z = _mm512_setzero_si512();
+    __m512i a0 = _mm512_mask_i64gather_epi64(z, m, idx, base + 0, 1);
+    __m512i a1 = _mm512_mask_i64gather_epi64(z, m, idx, base + 1, 1);
+    __m512i a2 = _mm512_mask_i64gather_epi64(z, m, idx, base + 2, 1);
+    __m512i a3 = _mm512_mask_i64gather_epi64(z, m, idx, base + 3, 1);
+
+    r[0] = _mm512_and_si512(a0, m52);
+    r[1] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(a0, 52), _mm512_slli_epi64(a1, 12)), m52);
+    r[2] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(a1, 40), _mm512_slli_epi64(a2, 24)), m52);
+    r[3] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(a2, 28), _mm512_slli_epi64(a3, 36)), m52);
+    r[4] = _mm512_srli_epi64(a3, 16);
+
+  }
+
+  // Normalize and scatter to 8 FieldElem (idx = byte offsets from base)
+  static inline IFMA_TARGET void Store(uint64_t *base, __m512i idx, __mmask8 m, __m512i *r) {
+
+    Normalize(r);
+    __m512i o0 = _mm512_or_si512(r[0], _mm512_slli_epi64(r[1], 52));
+    __m512i o1 = _mm512_or_si512(_mm512_srli_epi64(r[1], 12), _mm512_slli_epi64(r[2], 40));
+    __m512i o2 = _mm512_or_si512(_mm512_srli_epi64(r[2], 24), _mm512_slli_epi64(r[3], 28));
+    __m512i o3 = _mm512_or_si512(_mm512_srli_epi64(r[3], 36), _mm512_slli_epi64(r[4], 16));
+    _mm512_mask_i64scatter_epi64(base + 0, m, idx, o0, 1);
+    _mm512_mask_i64scatter_epi64(base + 1, m, idx, o1, 1);
+    _mm512_mask_i64scatter_epi64(base + 2, m, idx, o2, 1);
+    _mm512_mask_i64scatter_epi64(base + 3, m, idx, o3, 1);
+
+  }
+
+  static inline IFMA_TARGET void Broadcast(__m512i *r, Int *a) {
+    uint64_t *s = a->bits64;
+    r[0] = _mm512_set1_epi64(s[0] & M52);
+    r[1] = _mm512_set1_epi64(((s[0] >> 52) | (s[1] << 12)) & M52);
+    r[2] = _mm512_set1_epi64(((s[1] >> 40) | (s[2] << 24)) & M52);
+    r[3] = _mm512_set1_epi64(((s[2] >> 28) | (s[3] << 36)) & M52);
+    r[4] = _mm512_set1_epi64(s[3] >> 16);
+  }
+
+}
+
+// ------------------------------------------------
+// 4 lanes, 10x26 bits limbs, AVX2 (_mm256_mul_epu32)
+// Weakly normalized: limbs < 2^26 except the top one < 2^22 + carry
+
+namespace _fe26 {
+
+  static inline AVX2_TARGET void WeakNorm(__m256i *r) {
+
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+
+    // 2^256 = 0x1000003D1 = 0x40*2^26 + 0x3D1 (mod P)
+    __m256i x = _mm256_srli_epi64(r[9], 22);
+    r[9] = _mm256_and_si256(r[9], _mm256_set1_epi64x(M22));
+    r[0] = _mm256_add_epi64(r[0], _mm256_mul_epu32(x, _mm256_set1_epi64x(0x3D1)));
+    r[1] = _mm256_add_epi64(r[1], _mm256_slli_epi64(x, 6));
+    for (int k = 0; k < 9; k++) {
+      r[k + 1] = _mm256_add_epi64(r[k + 1], _mm256_srli_epi64(r[k], 26));
+      r[k] = _mm256_and_si256(r[k], m26);
+    }
+
+  }
+
+  // Reduce a 19 limbs product
+  static inline AVX2_TARGET void Reduce(__m256i *r, __m256i *t) {
+
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    // 2^260 = 0x1000003D10 = 0x400*2^26 + 0x3D10 (mod P)
+    const __m256i R0 = _mm256_set1_epi64x(0x3D10);
+
+    for (int k = 0; k < 19; k++) {
+      t[k + 1] = _mm256_add_epi64(t[k + 1], _mm256_srli_epi64(t[k], 26));
+      t[k] = _mm256_and_si256(t[k], m26);
+    }
+
+    __m256i c = _mm256_slli_epi64(t[19], 10);
+    for (int k = 0; k < 10; k++)
+      r[k] = _mm256_add_epi64(t[k], _mm256_mul_epu32(t[k + 10], R0));
+    for (int k = 0; k < 9; k++)
+      r[k + 1] = _mm256_add_epi64(r[k + 1], _mm256_slli_epi64(t[k + 10], 10));
+    r[0] = _mm256_add_epi64(r[0], _mm256_mul_epu32(c, R0));
+    r[1] = _mm256_add_epi64(r[1], _mm256_slli_epi64(c, 10));
+
+    // First carry pass (r[0] may exceed 32 bits)
+    for (int k = 0; k < 9; k++) {
+      r[k + 1] = _mm256_add_epi64(r[k + 1], _mm256_srli_epi64(r[k], 26));
+      r[k] = _mm256_and_si256(r[k], m26);
+    }
+    WeakNorm(r);
+
+  }
+
+  static inline AVX2_TARGET void Mul(__m256i *r, const __m256i *a, const __m256i *b) {
+
+    __m256i t[20];
+    for (int k = 0; k < 20; k++)
+      t[k] = _mm256_setzero_si256();
+
+    for (int i = 0; i < 10; i++)
+      for (int j = 0; j < 10; j++)
+        t[i + j] = _mm256_add_epi64(t[i + j], _mm256_mul_epu32(a[i], b[j]));
+
+    Reduce(r, t);
+
+  }
+
+  static inline AVX2_TARGET void Sqr(__m256i *r, const __m256i *a) {
+
+    __m256i t[20];
+    __m256i a2[10];
+    for (int k = 0; k < 20; k++)
+      t[k] = _mm256_setzero_si256();
+    for (int k = 0; k < 10; k++)
+      a2[k] = _mm256_add_epi64(a[k], a[k]);
+
+    for (int i = 0; i < 10; i++) {
+      t[2 * i] = _mm256_add_epi64(t[2 * i], _mm256_mul_epu32(a[i], a[i]));
+      for (int j = i + 1; j < 10; j++)
+        t[i + j] = _mm256_add_epi64(t[i + j], _mm256_mul_epu32(a2[i], a[j]));
+    }
+
+    Reduce(r, t);
+
+  }
+
+  static const uint64_t P4[10] = {
+    4 * 0x3FFFC2FULL,4 * 0x3FFFFBFULL,4 * M26,4 * M26,4 * M26,
+    4 * M26,4 * M26,4 * M26,4 * M26,4 * M22
+  };
+  static const uint64_t P8[10] = {
+    8 * 0x3FFFC2FULL,8 * 0x3FFFFBFULL,8 * M26,8 * M26,8 * M26,
+    8 * M26,8 * M26,8 * M26,8 * M26,8 * M22
+  };
+
+  static inline AVX2_TARGET void Sub(__m256i *r, const __m256i *a, const __m256i *b) {
+    for (int k = 0; k < 10; k++)
+      r[k] = _mm256_sub_epi64(_mm256_add_epi64(a[k], _mm256_set1_epi64x(P4[k])), b[k]);
+    WeakNorm(r);
+  }
+
+  static inline AVX2_TARGET void Sub2(__m256i *r, const __m256i *a, const __m256i *b, const __m256i *c) {
+    for (int k = 0; k < 10; k++)
+      r[k] = _mm256_sub_epi64(_mm256_sub_epi64(_mm256_add_epi64(a[k], _mm256_set1_epi64x(P8[k])), b[k]), c[k]);
+    WeakNorm(r);
+  }
+
+  static inline AVX2_TARGET void NegSub(__m256i *r, const __m256i *a, const __m256i *b) {
+    for (int k = 0; k < 10; k++)
+      r[k] = _mm256_sub_epi64(_mm256_sub_epi64(_mm256_set1_epi64x(P8[k]), a[k]), b[k]);
+    WeakNorm(r);
+  }
+
+  static inline AVX2_TARGET void Add(__m256i *r, const __m256i *a, const __m256i *b) {
+    for (int k = 0; k < 10; k++)
+      r[k] = _mm256_add_epi64(a[k], b[k]);
+    WeakNorm(r);
+  }
+
+  static inline AVX2_TARGET void Normalize(__m256i *r) {
+
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    const __m256i m22 = _mm256_set1_epi64x(M22);
+
+    WeakNorm(r);
+
+    // r >= 2^256 or r >= P
+    __m256i m = _mm256_cmpgt_epi64(r[9], m22);
+    __m256i e = _mm256_cmpeq_epi64(r[9], m22);
+    for (int k = 2; k < 9; k++)
+      e = _mm256_and_si256(e, _mm256_cmpeq_epi64(r[k], m26));
+    __m256i lo = _mm256_add_epi64(_mm256_add_epi64(r[1], _mm256_set1_epi64x(0x40)),
+                                  _mm256_srli_epi64(_mm256_add_epi64(r[0], _mm256_set1_epi64x(0x3D1)), 26));
+    e = _mm256_and_si256(e, _mm256_cmpgt_epi64(lo, m26));
+    m = _mm256_or_si256(m, e);
+
+    r[0] = _mm256_add_epi64(r[0], _mm256_and_si256(m, _mm256_set1_epi64x(0x3D1)));
+    r[1] = _mm256_add_epi64(r[1], _mm256_and_si256(m, _mm256_set1_epi64x(0x40)));
+    for (int k = 0; k < 9; k++) {
+      r[k + 1] = _mm256_add_epi64(r[k + 1], _mm256_srli_epi64(r[k], 26));
+      r[k] = _mm256_and_si256(r[k], m26);
+    }
+    r[9] = _mm256_and_si256(r[9], m22);
+
+  }
+
+  static inline AVX2_TARGET void Split(__m256i *r, __m256i a0, __m256i a1, __m256i a2, __m256i a3) {
+
+    const __m256i m26 = _mm256_set1_epi64x(M26);
+    r[0] = _mm256_and_si256(a0, m26);
+    r[1] = _mm256_and_si256(_mm256_srli_epi64(a0, 26), m26);
+    r[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(a0, 52), _mm256_slli_epi64(a1, 12)), m26);
+    r[3] = _mm256_and_si256(_mm256_srli_epi64(a1, 14), m26);
+    r[4] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(a1, 40), _mm256_slli_epi64(a2, 24)), m26);
+    r[5] = _mm256_and_si256(_mm256_srli_epi64(a2, 2), m26);
+    r[6] = _mm256_and_si256(_mm256_srli_epi64(a2, 28), m26);
+    r[7] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(a2, 54), _mm256_slli_epi64(a3, 10)), m26);
+    r[8] = _mm256_and_si256(_mm256_srli_epi64(a3, 16), m26);
+    r[9] = _mm256_srli_epi64(a3, 42);
+
+  }
+
+  // Load 4 consecutive Int
+  static inline AVX2_TARGET void Load(__m256i *r, Int *a, int n) {
+
+    const __m256i idx = _mm256_set_epi64x(3 * sizeof(Int), 2 * sizeof(Int), sizeof(Int), 0);
+    const __m256i z = _mm256_setzero_si256();
+    __m256i m = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_set_epi64x(3, 2, 1, 0));
+    long long *base = (long long *)a->bits64;
+    Split(r,
+      _mm256_mask_i64gather_epi64(z, base + 0, idx, m, 1),
+      _mm256_mask_i64gather_epi64(z, base + 1, idx, m, 1),
+      _mm256_mask_i64gather_epi64(z, base + 2, idx, m, 1),
+      _mm256_mask_i64gather_epi64(z, base + 3, idx, m, 1));
+
+  }
+
+  // Normalize and write the 4 lanes to d[0],d[step],d[2*step],...
+  static inline AVX2_TARGET void Store(FieldElem *d, int step, int n, __m256i *r) {
+
+    uint64_t o[4][4];
+    Normalize(r);
+    _mm256_storeu_si256((__m256i *)o[0], _mm256_or_si256(_mm256_or_si256(r[0], _mm256_slli_epi64(r[1], 26)), _mm256_slli_epi64(r[2], 52)));
+    _mm256_storeu_si256((__m256i *)o[1], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(r[2], 12), _mm256_slli_epi64(r[3], 14)), _mm256_slli_epi64(r[4], 40)));
+    _mm256_storeu_si256((__m256i *)o[2], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(r[4], 24), _mm256_slli_epi64(r[5], 2)),
+                                                         _mm256_or_si256(_mm256_slli_epi64(r[6], 28), _mm256_slli_epi64(r[7], 54))));
+    _mm256_storeu_si256((__m256i *)o[3], _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi64(r[7], 10), _mm256_slli_epi64(r[8], 16)), _mm256_slli_epi64(r[9], 42)));
+    for (int l = 0; l < n; l++) {
+      uint64_t *b = ((FieldElem *)((char *)d + (ptrdiff_t)l * step))->v;
+      b[0] = o[0][l];
+      b[1] = o[1][l];
+      b[2] = o[2][l];
+      b[3] = o[3][l];
+    }
+
+  }
+
+  static inline AVX2_TARGET void Broadcast(__m256i *r, Int *a) {
+    uint64_t *s = a->bits64;
+    Split(r, _mm256_set1_epi64x(s[0]), _mm256_set1_epi64x(s[1]), _mm256_set1_epi64x(s[2]), _mm256_set1_epi64x(s[3]));
+  }
+
+}
+
+// ------------------------------------------------
+
+int PointGroup::GetBackend() {
+
+  if (pgBackend < 0) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma"))
+      pgBackend = PG_IFMA;
+    else if (__builtin_cpu_supports("avx2"))
+      pgBackend = PG_AVX2;
+    else
+      pgBackend = PG_SCALAR;
+  }
+  return pgBackend;
+
+}
+
+void PointGroup::SetBackend(int backend) {
+
+  __builtin_cpu_init();
+  if (backend == PG_IFMA && !(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma")))
+    backend = PG_SCALAR;
+  if (backend == PG_AVX2 && !__builtin_cpu_supports("avx2"))
+    backend = PG_SCALAR;
+  pgBackend = backend;
+
+}
+
+const char *PointGroup::GetBackendName() {
+
+  switch (GetBackend()) {
+    case PG_IFMA:
+      return "AVX-512 IFMA x8";
+    case PG_AVX2:
+      return "AVX2 x4";
+  }
+  return "scalar";
+
+}
+
+// ------------------------------------------------
+
+PointGroup::PointGroup(int size) {
+
+  this->size = size;
+  this->backend = GetBackend();
+  this->gSoA = NULL;
+  this->Gn = NULL;
+  this->dx = NULL;
+
+}
+
+PointGroup::~PointGroup() {
+  if (gSoA)
+    free(gSoA);
+}
+
+// Keep Gn and the inverse array, Gn is converted once to the SIMD layout:
+// per block of lanes, x limbs then y limbs, each limb holding all lanes.
+void PointGroup::Set(AffinePoint *Gn, Int *dx) {
+
+  this->Gn = Gn;
+  this->dx = dx;
+  if (gSoA) {
+    free(gSoA);
+    gSoA = NULL;
+  }
+
+  int half = size / 2;
+  int lanes, limbs;
+  switch (backend) {
+    case PG_IFMA:
+      lanes = 8; limbs = 5;
+      break;
+    case PG_AVX2:
+      lanes = 4; limbs = 10;
+      break;
+    default:
+      return;
+  }
+
+  int nbBlock = (half + lanes - 1) / lanes;
+  size_t length = (size_t)nbBlock * 2 * limbs * lanes * sizeof(uint64_t);
+  if (posix_memalign((void **)&gSoA, 64, length) != 0) {
+    gSoA = NULL;
+    backend = PG_SCALAR;
+    return;
+  }
+  memset(gSoA, 0, length);
+
+  for (int i = 0; i < half; i++) {
+    uint64_t *blk = gSoA + (size_t)(i / lanes) * 2 * limbs * lanes;
+    int l = i % lanes;
+    for (int c = 0; c < 2; c++) {
+      uint64_t *s = (c == 0) ? Gn[i].x.v : Gn[i].y.v;
+      uint64_t *d = blk + c * limbs * lanes + l;
+      if (limbs == 5) {
+        d[0 * lanes] = s[0] & M52;
+        d[1 * lanes] = ((s[0] >> 52) | (s[1] << 12)) & M52;
+        d[2 * lanes] = ((s[1] >> 40) | (s[2] << 24)) & M52;
+        d[3 * lanes] = ((s[2] >> 28) | (s[3] << 36)) & M52;
+        d[4 * lanes] = s[3] >> 16;
+      } else {
+        d[0 * lanes] = s[0] & M26;
+        d[1 * lanes] = (s[0] >> 26) & M26;
+        d[2 * lanes] = ((s[0] >> 52) | (s[1] << 12)) & M26;
+        d[3 * lanes] = (s[1] >> 14) & M26;
+        d[4 * lanes] = ((s[1] >> 40) | (s[2] << 24)) & M26;
+        d[5 * lanes] = (s[2] >> 2) & M26;
+        d[6 * lanes] = (s[2] >> 28) & M26;
+        d[7 * lanes] = ((s[2] >> 54) | (s[3] << 10)) & M26;
+        d[8 * lanes] = (s[3] >> 16) & M26;
+        d[9 * lanes] = s[3] >> 42;
+      }
+    }
+  }
+
+}
+
+void PointGroup::ComputeGroup(AffinePoint *pts, Point *startP, bool calculate_y) {
+
+  switch (backend) {
+    case PG_IFMA:
+      ComputeGroupIFMA(pts, startP, calculate_y);
+      break;
+    case PG_AVX2:
+      ComputeGroupAVX2(pts, startP, calculate_y);
+      break;
+    default:
+      ComputeGroupScalar(pts, startP, calculate_y);
+      break;
+  }
+
+}
+
+// ------------------------------------------------
+
+void PointGroup::ComputeGroupScalar(AffinePoint *pts, Point *startP, bool calculate_y) {
+
+  int half = size / 2;
+  int hLength = half - 1;
+  int i;
+  AffinePoint sp;
+  FieldElem ix;
+  FieldElem dy;
+  FieldElem _s;
+  FieldElem _p;
+  AffinePoint *r;
+
+  sp.Set(startP);
+  pts[half] = sp;
+
+  for (i = 0; i < half; i++) {
+
+    ix.Set(&dx[i]);
+
+    // P = startP + i*G, the last i only has startP - i*G (first point)
+    if (i < hLength) {
+      r = &pts[half + (i + 1)];
+      dy.ModSub(&Gn[i].y, &sp.y);
+      _s.ModMulK1(&dy, &ix);         // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+      _p.ModSquareK1(&_s);           // _p = pow2(s)
+      r->x.ModSub(&_p, &sp.x);
+      r->x.ModSub(&r->x, &Gn[i].x);  // rx = pow2(s) - p1.x - p2.x;
+      if (calculate_y) {
+        r->y.ModSub(&Gn[i].x, &r->x);
+        r->y.ModMulK1(&_s);
+        r->y.ModSub(&r->y, &Gn[i].y); // ry = - p2.y - s*(ret.x-p2.x);
+      }
+    }
+
+    // P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
+    r = &pts[half - (i + 1)];
+    dy.ModAdd(&Gn[i].y, &sp.y);
+    dy.ModNeg();
+    _s.ModMulK1(&dy, &ix);
+    _p.ModSquareK1(&_s);
+    r->x.ModSub(&_p, &sp.x);
+    r->x.ModSub(&r->x, &Gn[i].x);
+    if (calculate_y) {
+      r->y.ModSub(&Gn[i].x, &r->x);
+      r->y.ModMulK1(&_s);
+      r->y.ModAdd(&r->y, &Gn[i].y);
+    }
+
+  }
+
+}
+
+// ------------------------------------------------
+
+// gcc 12 reports the undefined __Y of _mm512_set1_epi64 inlined from _fe52
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+IFMA_TARGET void PointGroup::ComputeGroupIFMA(AffinePoint *pts, Point *startP, bool calculate_y) {
+
+  using namespace _fe52;
+
+  const int half = size / 2;
+  const __m512i dxIdx = _mm512_set_epi64(7 * sizeof(Int), 6 * sizeof(Int), 5 * sizeof(Int), 4 * sizeof(Int),
+                                         3 * sizeof(Int), 2 * sizeof(Int), sizeof(Int), 0);
+  const __m512i ppIdx = _mm512_set_epi64(7 * sizeof(AffinePoint), 6 * sizeof(AffinePoint), 5 * sizeof(AffinePoint), 4 * sizeof(AffinePoint),
+                                         3 * sizeof(AffinePoint), 2 * sizeof(AffinePoint), sizeof(AffinePoint), 0);
+  const __m512i pnIdx = _mm512_sub_epi64(_mm512_setzero_si512(), ppIdx);
+
+  __m512i sx[5], sy[5];
+  __m512i gx[5], gy[5], ix[5];
+  __m512i dy[5], s[5], p[5], rx[5], ry[5];
+
+  Broadcast(sx, &startP->x);
+  Broadcast(sy, &startP->y);
+
+  for (int i = 0; i < half; i += 8) {
+
+    int n = half - i;
+    // pts[half+i+1] exists only for i < half-1
+    __mmask8 mN = (n >= 8) ? 0xFF : (__mmask8)((1U << n) - 1);
+    __mmask8 mP = (n - 1 >= 8) ? 0xFF : (__mmask8)((1U << (n - 1)) - 1);
+
+    uint64_t *g = gSoA + (size_t)(i / 8) * 80;
+    for (int k = 0; k < 5; k++) {
+      gx[k] = _mm512_load_si512((__m512i *)(g + k * 8));
+      gy[k] = _mm512_load_si512((__m512i *)(g + 40 + k * 8));
+    }
+    Load(ix, dx[i].bits64, dxIdx, mN);
+
+    // P = startP + i*G
+    Sub(dy, gy, sy);
+    Mul(s, dy, ix);                  // s = (p2.y-p1.y)*inverse(p2.x-p1.x)
+    Sqr(p, s);
+    Sub2(rx, p, sx, gx);             // rx = pow2(s) - p1.x - p2.x
+    if (calculate_y) {
+      Sub(ry, gx, rx);
+      Mul(ry, ry, s);
+      Sub(ry, ry, gy);               // ry = - p2.y - s*(ret.x-p2.x)
+      Store(pts[half + i + 1].y.v, ppIdx, mP, ry);
+    }
+    Store(pts[half + i + 1].x.v, ppIdx, mP, rx);
+
+    // P = startP - i*G
+    NegSub(dy, gy, sy);
+    Mul(s, dy, ix);
+    Sqr(p, s);
+    Sub2(rx, p, sx, gx);
+    if (calculate_y) {
+      Sub(ry, gx, rx);
+      Mul(ry, ry, s);
+      Add(ry, ry, gy);
+      Store(pts[half - i - 1].y.v, pnIdx, mN, ry);
+    }
+    Store(pts[half - i - 1].x.v, pnIdx, mN, rx);
+
+  }
+
+  pts[half].Set(startP);
+
+}
+#pragma GCC diagnostic pop
+
+// ------------------------------------------------
+
+AVX2_TARGET void PointGroup::ComputeGroupAVX2(AffinePoint *pts, Point *startP, bool calculate_y) {
+
+  using namespace _fe26;
+
+  const int half = size / 2;
+
+  __m256i sx[10], sy[10];
+  __m256i gx[10], gy[10], ix[10];
+  __m256i dy[10], s[10], p[10], rx[10], ry[10];
+
+  Broadcast(sx, &startP->x);
+  Broadcast(sy, &startP->y);
+
+  for (int i = 0; i < half; i += 4) {
+
+    int n = half - i;
+    int nN = (n >= 4) ? 4 : n;
+    int nP = (n - 1 >= 4) ? 4 : n - 1;
+
+    uint64_t *g = gSoA + (size_t)(i / 4) * 80;
+    for (int k = 0; k < 10; k++) {
+      gx[k] = _mm256_load_si256((__m256i *)(g + k * 4));
+      gy[k] = _mm256_load_si256((__m256i *)(g + 40 + k * 4));
+    }
+    Load(ix, &dx[i], nN);
+
+    // P = startP + i*G
+    Sub(dy, gy, sy);
+    Mul(s, dy, ix);
+    Sqr(p, s);
+    Sub2(rx, p, sx, gx);
+    if (calculate_y) {
+      Sub(ry, gx, rx);
+      Mul(ry, ry, s);
+      Sub(ry, ry, gy);
+      Store(&pts[half + i + 1].y, (int)sizeof(AffinePoint), nP, ry);
+    }
+    Store(&pts[half + i + 1].x, (int)sizeof(AffinePoint), nP, rx);
+
+    // P = startP - i*G
+    NegSub(dy, gy, sy);
+    Mul(s, dy, ix);
+    Sqr(p, s);
+    Sub2(rx, p, sx, gx);
+    if (calculate_y) {
+      Sub(ry, gx, rx);
+      Mul(ry, ry, s);
+      Add(ry, ry, gy);
+      Store(&pts[half - i - 1].y, -(int)sizeof(AffinePoint), nN, ry);
+    }
+    Store(&pts[half - i - 1].x, -(int)sizeof(AffinePoint), nN, rx);
+
+  }
+
+  pts[half].Set(startP);
+
+}
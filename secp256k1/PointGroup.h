@@ -0,0 +1,64 @@
+/*
+ * This file is part of the BSGS distribution (https://github.com/JeanLucPons/BSGS).
+ * Copyright (c) 2020 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POINTGROUPH
+#define POINTGROUPH
+
+#include "Point.h"
+#include "FieldElem.h"
+
+#define PG_SCALAR 0   // ModMulK1/ModSquareK1, one point at a time
+#define PG_AVX2   1   // 4 lanes, 10x26 bits limbs
+#define PG_IFMA   2   // 8 lanes, 5x52 bits limbs (AVX-512 IFMA)
+
+// Affine additions startP +/- Gn[i] for a whole group once the
+// dx[i] = 1/(Gn[i].x - startP.x) have been computed by IntGroup.
+// Output layout is the one used by the scan loops:
+//   pts[size/2]       = startP
+//   pts[size/2+(i+1)] = startP + Gn[i]   i in [0,size/2-1[
+//   pts[size/2-(i+1)] = startP - Gn[i]   i in [0,size/2[
+// Only the x (and y if calculate_y is set) coordinates are written.
+// Gn and pts are AffinePoint, the scalar path works on FieldElem.
+
+class PointGroup {
+
+public:
+
+  PointGroup(int size);
+  ~PointGroup();
+  void Set(AffinePoint *Gn, Int *dx);
+  void ComputeGroup(AffinePoint *pts, Point *startP, bool calculate_y);
+
+  static int GetBackend();
+  static void SetBackend(int backend);
+  static const char *GetBackendName();
+
+private:
+
+  void ComputeGroupScalar(AffinePoint *pts, Point *startP, bool calculate_y);
+  void ComputeGroupAVX2(AffinePoint *pts, Point *startP, bool calculate_y);
+  void ComputeGroupIFMA(AffinePoint *pts, Point *startP, bool calculate_y);
+
+  AffinePoint *Gn;
+  Int *dx;
+  uint64_t *gSoA;   // Gn in SIMD layout (x limbs then y limbs per block)
+  int backend;
+  int size;
+
+};
+
+#endif // POINTGROUPH
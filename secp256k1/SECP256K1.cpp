@@ -19,14 +19,47 @@
 #include <cstring>
 #include "SECP256k1.h"
 #include "Point.h"
+#include "IntGroup.h"
 #include "../util.h"
 #include "../hash/sha256.h"
 #include "../hash/ripemd160.h"
 
+static AffinePoint *AllocGTable(size_t length) {
+  AffinePoint *t;
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  t = (AffinePoint *)_aligned_malloc(length, 64);
+#else
+  if (posix_memalign((void **)&t, 64, length) != 0)
+    t = NULL;
+#endif
+  if (t == NULL) {
+    ::fprintf(stderr, "[E] Can't alloc memory for the generator table\n");
+    exit(EXIT_FAILURE);
+  }
+  return t;
+}
+
+static void FreeGTable(AffinePoint *t) {
+#if defined(_WIN64) && !defined(__CYGWIN__)
+  _aligned_free(t);
+#else
+  free(t);
+#endif
+}
+
 Secp256K1::Secp256K1() {
+  GTable = NULL;
+  gBits = 0;
+  gWindows = 0;
+  gEntries = 0;
+  hashLanes = hash160_lanes();
 }
 
-void Secp256K1::Init() {
+int Secp256K1::GetHashLanes() {
+  return hashLanes;
+}
+
+void Secp256K1::Init(int gtableBits) {
   // Prime for the finite field
   P.SetBase16("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F");
 
@@ -41,46 +74,233 @@ void Secp256K1::Init() {
 
   Int::InitK1(&order);
 
-  // Compute Generator table
-  Point N(G);
-  for(int i = 0; i < 32; i++) {
-    GTable[i * 256] = N;
-    N = DoubleDirect(N);
-    for (int j = 1; j < 255; j++) {
-      GTable[i * 256 + j] = N;
-      N = AddDirect(N, GTable[i * 256]);
+  InitGTable(gtableBits);
+
+}
+
+Secp256K1::~Secp256K1() {
+  FreeGTable(GTable);
+}
+
+// p1 += p2 in Jacobian coordinates (x = X/Z^2, y = Y/Z^3), p2 affine.
+// p1 must not be the point at infinity nor +/-p2.
+static inline void AddJacobian(FieldElem *x, FieldElem *y, FieldElem *z, AffinePoint *p2) {
+  FieldElem z2;
+  FieldElem z3;
+  FieldElem u2;
+  FieldElem s2;
+  FieldElem h;
+  FieldElem r;
+  FieldElem h2;
+  FieldElem h3;
+  FieldElem v;
+  FieldElem t;
+  z2.ModSquareK1(z);
+  z3.ModMulK1(&z2, z);
+  u2.ModMulK1(&p2->x, &z2);
+  s2.ModMulK1(&p2->y, &z3);
+  h.ModSub(&u2, x);
+  r.ModSub(&s2, y);
+  h2.ModSquareK1(&h);
+  h3.ModMulK1(&h2, &h);
+  v.ModMulK1(x, &h2);
+
+  x->ModSquareK1(&r);
+  x->ModSub(x, &h3);
+  x->ModSub(x, &v);
+  x->ModSub(x, &v);          // X3 = r^2 - h^3 - 2.X1.h^2
+
+  t.ModSub(&v, x);
+  t.ModMulK1(&t, &r);
+  y->ModMulK1(y, &h3);
+  y->ModSub(&t, y);          // Y3 = r.(X1.h^2 - X3) - Y1.h^3
+
+  z->ModMulK1(z, &h);        // Z3 = Z1.h
+}
+
+// Window idx of the scalar k (bits [idx*bits,(idx+1)*bits) of the 256 lowest)
+static inline uint32_t GetWindow(Int *k, int idx, int bits) {
+  int pos = idx * bits;
+  int q = pos >> 6;
+  int r = pos & 63;
+  if (pos + bits > 256)
+    bits = 256 - pos;
+  uint64_t w = k->bits64[q] >> r;
+  if (r + bits > 64)
+    w |= k->bits64[q + 1] << (64 - r);
+  return (uint32_t)(w & ((1ULL << bits) - 1));
+}
+
+// Build the comb table: window i holds j.2^(bits.i).G for j = 1 .. 2^bits-1.
+// Each window is accumulated in Jacobian coordinates and converted to affine
+// with one grouped inversion.
+void Secp256K1::InitGTable(int bits) {
+
+  if (bits < GTABLE_MIN_BITS || bits > GTABLE_MAX_BITS) {
+    ::fprintf(stderr, "[E] Generator table window must be between %d and %d bits\n", GTABLE_MIN_BITS, GTABLE_MAX_BITS);
+    exit(EXIT_FAILURE);
+  }
+  if (GTable != NULL && bits == gBits)
+    return;
+
+  int entries = (1 << bits) - 1;
+  int windows = (256 + bits - 1) / bits;
+  AffinePoint *table = AllocGTable((size_t)windows * entries * sizeof(AffinePoint));
+
+  FieldElem *jx = new FieldElem[entries];
+  FieldElem *jy = new FieldElem[entries];
+  FieldElem *jz = new FieldElem[entries];
+  Int *zi = new Int[entries];
+  IntGroup grp(entries);
+  grp.Set(zi);
+
+  Point B(G);     // 2^(bits.i).G
+  Point D;
+  Point last;
+  FieldElem zi2;
+  FieldElem zi3;
+
+  for (int i = 0; i < windows; i++) {
+
+    AffinePoint *w = table + (size_t)i * entries;
+    w[0].x.Set(&B.x);
+    w[0].y.Set(&B.y);
+
+    D = DoubleDirect(B);
+    jx[1].Set(&D.x);
+    jy[1].Set(&D.y);
+    jz[1].SetOne();
+    for (int j = 2; j < entries; j++) {
+      jx[j] = jx[j - 1];
+      jy[j] = jy[j - 1];
+      jz[j] = jz[j - 1];
+      AddJacobian(&jx[j], &jy[j], &jz[j], &w[0]);
     }
-    GTable[i * 256 + 255] = N; // Dummy point for check function
+
+    zi[0].SetInt32(1);
+    for (int j = 1; j < entries; j++)
+      jz[j].Get(&zi[j]);
+    grp.ModInv();
+
+    for (int j = 1; j < entries; j++) {
+      zi3.Set(&zi[j]);
+      zi2.ModSquareK1(&zi3);
+      zi3.ModMulK1(&zi2, &zi3);
+      w[j].x.ModMulK1(&jx[j], &zi2);
+      w[j].y.ModMulK1(&jy[j], &zi3);
+    }
+
+    // Next window base 2^bits.B = (2^bits-1).B + B
+    w[entries - 1].x.Get(&last.x);
+    w[entries - 1].y.Get(&last.y);
+    last.z.SetInt32(1);
+    B = AddDirect(last, B);
+
   }
 
+  delete[] jx;
+  delete[] jy;
+  delete[] jz;
+  delete[] zi;
+
+  FreeGTable(GTable);
+  GTable = table;
+  gBits = bits;
+  gWindows = windows;
+  gEntries = entries;
+
 }
 
-Secp256K1::~Secp256K1() {
+int Secp256K1::GetGTableBits() {
+  return gBits;
 }
 
-Point Secp256K1::ComputePublicKey(Int *privKey) {
-  int i = 0;
-  uint8_t b;
-  Point Q;
-  Q.Clear();
-  // Search first significant byte
-  for (i = 0; i < 32; i++) {
-    b = privKey->GetByte(i);
-    if(b)
+// privKey.G in Jacobian coordinates, false for the point at infinity
+bool Secp256K1::ComputeJacobian(Int *privKey, FieldElem *x, FieldElem *y, FieldElem *z) {
+  int i;
+  uint32_t b = 0;
+  // Search first significant window
+  for (i = 0; i < gWindows; i++) {
+    b = GetWindow(privKey, i, gBits);
+    if (b)
       break;
   }
-  Q = GTable[256 * i + (b-1)];
+  if (i == gWindows)
+    return false;
+  AffinePoint *p = &GTable[(size_t)i * gEntries + (b - 1)];
+  *x = p->x;
+  *y = p->y;
+  z->SetOne();
   i++;
 
-  for(; i < 32; i++) {
-    b = privKey->GetByte(i);
-    if(b)
-      Q = Add2(Q, GTable[256 * i + (b-1)]);
+  for (; i < gWindows; i++) {
+    b = GetWindow(privKey, i, gBits);
+    if (b)
+      AddJacobian(x, y, z, &GTable[(size_t)i * gEntries + (b - 1)]);
   }
-  Q.Reduce();
+  return true;
+}
+
+Point Secp256K1::ComputePublicKey(Int *privKey) {
+  Point Q;
+  Int zinv;
+  FieldElem x, y, z, z2, z3;
+  if (!ComputeJacobian(privKey, &x, &y, &z)) {
+    Q.Clear();
+    return Q;
+  }
+  z.Get(&zinv);
+  zinv.ModInv();
+  z3.Set(&zinv);
+  z2.ModSquareK1(&z3);
+  z3.ModMulK1(&z2, &z3);
+  x.ModMulK1(&x, &z2);
+  y.ModMulK1(&y, &z3);
+  x.Get(&Q.x);
+  y.Get(&Q.y);
+  Q.z.SetInt32(1);
   return Q;
 }
 
+// pubKeys[i] = privKeys[i].G for i < n, sharing one inversion for the n
+// Jacobian to affine conversions
+void Secp256K1::ComputePublicKeys(int n, Int *privKeys, Point *pubKeys) {
+  FieldElem x, y, z, z2, z3;
+  Int *zinv = new Int[n];
+  IntGroup grp(n);
+
+  for (int i = 0; i < n; i++) {
+    if (ComputeJacobian(&privKeys[i], &x, &y, &z)) {
+      x.Get(&pubKeys[i].x);
+      y.Get(&pubKeys[i].y);
+      z.Get(&zinv[i]);
+      pubKeys[i].z.SetInt32(1);
+    } else {
+      pubKeys[i].Clear();
+      zinv[i].SetInt32(1);
+    }
+  }
+
+  grp.Set(zinv);
+  grp.ModInv();
+
+  for (int i = 0; i < n; i++) {
+    if (pubKeys[i].z.IsZero())
+      continue;
+    z3.Set(&zinv[i]);
+    z2.ModSquareK1(&z3);
+    z3.ModMulK1(&z2, &z3);
+    x.Set(&pubKeys[i].x);
+    y.Set(&pubKeys[i].y);
+    x.ModMulK1(&x, &z2);
+    y.ModMulK1(&y, &z3);
+    x.Get(&pubKeys[i].x);
+    y.Get(&pubKeys[i].y);
+  }
+
+  delete[] zinv;
+}
+
 Point Secp256K1::NextKey(Point &key) {
   // Input key must be reduced and different from G
   // in order to use AddDirect
@@ -265,6 +485,46 @@ Point Secp256K1::AddDirect(Point &p1,Point &p2) {
 }
 
 
+// r[i] = p1 + p2[i] for i < n, all the inversions grouped in one.
+// Same conditions as AddDirect, an entry with p2[i].x == p1.x can't be
+// computed and gets r[i].z = 0.
+void Secp256K1::AddDirect(Point &p1, Point *p2, int n, Point *r) {
+  Int _s;
+  Int _p;
+  Int dy;
+  Int *dx = new Int[n];
+  IntGroup grp(n);
+
+  for (int i = 0; i < n; i++) {
+    dx[i].ModSub(&p2[i].x, &p1.x);
+    if (dx[i].IsZero()) {
+      dx[i].SetInt32(1);
+      r[i].Clear();
+    } else {
+      r[i].z.SetInt32(1);
+    }
+  }
+  grp.Set(dx);
+  grp.ModInv();
+
+  for (int i = 0; i < n; i++) {
+    if (r[i].z.IsZero())
+      continue;
+    dy.ModSub(&p2[i].y, &p1.y);
+    _s.ModMulK1(&dy, &dx[i]);
+    _p.ModSquareK1(&_s);
+
+    r[i].x.ModSub(&_p, &p1.x);
+    r[i].x.ModSub(&p2[i].x);
+
+    r[i].y.ModSub(&p2[i].x, &r[i].x);
+    r[i].y.ModMulK1(&_s);
+    r[i].y.ModSub(&p2[i].y);
+  }
+
+  delete[] dx;
+}
+
 Point Secp256K1::Add2(Point &p1, Point &p2) {
   // P2.z = 1
   Int u;
@@ -788,3 +1048,102 @@ void Secp256K1::GetHash160_fromX(int type,unsigned char prefix,
   }
 }
 
+/*
+  Batches of 16 or 8 keys for the AVX-512 and AVX2 hash160, the message words
+  come straight from the limbs of the points. The tail and the CPUs without
+  AVX2 take the 4 lanes SSE (or SHA-NI) path on the serialized keys.
+*/
+void Secp256K1::GetHash160(bool compressed,AffinePoint *k,int n,uint8_t *h) {
+
+#ifdef WIN64
+  __declspec(align(64)) uint32_t b[4 * 32];
+  __declspec(align(64)) unsigned char sh[4 * 64];
+#else
+  uint32_t b[4 * 32] __attribute__((aligned(64)));
+  unsigned char sh[4 * 64] __attribute__((aligned(64)));
+#endif
+  int stride = sizeof(AffinePoint) / sizeof(uint32_t);
+  int i,l,lanes;
+
+  for (i = 0; i < n; i += lanes) {
+    lanes = hashLanes;
+    while (lanes > n - i)
+      lanes >>= 1;
+
+    switch (lanes) {
+    case 16:
+      if (compressed)
+        hash160avx512_comp(k[i].x.bits, k[i].y.bits, stride, h + i * 20);
+      else
+        hash160avx512_uncomp(k[i].x.bits, k[i].y.bits, stride, h + i * 20);
+      break;
+    case 8:
+      if (compressed)
+        hash160avx2_comp(k[i].x.bits, k[i].y.bits, stride, h + i * 20);
+      else
+        hash160avx2_uncomp(k[i].x.bits, k[i].y.bits, stride, h + i * 20);
+      break;
+    default:
+      if (!compressed) {
+        for (l = 0; l < 4; l++) {
+          KEYBUFFUNCOMP(b + l * 32, k[i + l]);
+        }
+        sha256sse_2B(b, b + 32, b + 64, b + 96, sh, sh + 64, sh + 128, sh + 192);
+      } else {
+        for (l = 0; l < 4; l++) {
+          KEYBUFFCOMP(b + l * 16, k[i + l]);
+        }
+        sha256sse_1B(b, b + 16, b + 32, b + 48, sh, sh + 64, sh + 128, sh + 192);
+      }
+      ripemd160sse_32(sh, sh + 64, sh + 128, sh + 192, h + i * 20, h + (i + 1) * 20, h + (i + 2) * 20, h + (i + 3) * 20);
+      break;
+    }
+  }
+}
+
+/*
+  The 02 and 03 hashes of the same x, the message words are built once from
+  the limbs and only the first one changes with the prefix.
+*/
+void Secp256K1::GetHash160_fromX(AffinePoint *k,int n,uint8_t *h02,uint8_t *h03) {
+
+#ifdef WIN64
+  __declspec(align(64)) uint32_t b[4 * 16];
+  __declspec(align(64)) unsigned char sh[4 * 64];
+#else
+  uint32_t b[4 * 16] __attribute__((aligned(64)));
+  unsigned char sh[4 * 64] __attribute__((aligned(64)));
+#endif
+  int stride = sizeof(AffinePoint) / sizeof(uint32_t);
+  FieldElem *x;
+  int i,l,lanes;
+  unsigned char prefix;
+  uint8_t *h;
+
+  for (i = 0; i < n; i += lanes) {
+    lanes = hashLanes;
+    while (lanes > n - i)
+      lanes >>= 1;
+
+    switch (lanes) {
+    case 16:
+      hash160avx512_fromX(k[i].x.bits, stride, h02 + i * 20, h03 + i * 20);
+      break;
+    case 8:
+      hash160avx2_fromX(k[i].x.bits, stride, h02 + i * 20, h03 + i * 20);
+      break;
+    default:
+      for (prefix = 0x02; prefix <= 0x03; prefix++) {
+        h = (prefix == 0x02 ? h02 : h03) + i * 20;
+        for (l = 0; l < 4; l++) {
+          x = &k[i + l].x;
+          KEYBUFFPREFIX(b + l * 16, x, prefix);
+        }
+        sha256sse_1B(b, b + 16, b + 32, b + 48, sh, sh + 64, sh + 128, sh + 192);
+        ripemd160sse_32(sh, sh + 64, sh + 128, sh + 192, h, h + 20, h + 40, h + 60);
+      }
+      break;
+    }
+  }
+}
+
@@ -19,6 +19,7 @@
 #define SECP256K1H
 
 #include "Point.h"
+#include "FieldElem.h"
 #include <vector>
 
 // Address type
@@ -26,6 +27,12 @@
 #define P2SH   1
 #define BECH32 2
 
+// Comb window of the generator table: ceil(256/bits) windows of 2^bits-1
+// affine points each (8 bits: 510 KB, 12 bits: 5.5 MB, 16 bits: 64 MB)
+#define GTABLE_BITS     8
+#define GTABLE_MIN_BITS 4
+#define GTABLE_MAX_BITS 16
+
 
 class Secp256K1 {
 
@@ -33,8 +40,11 @@ public:
 
   Secp256K1();
   ~Secp256K1();
-  void  Init();
+  void  Init(int gtableBits = GTABLE_BITS);
+  void  InitGTable(int bits);
+  int   GetGTableBits();
   Point ComputePublicKey(Int *privKey);
+  void  ComputePublicKeys(int n, Int *privKeys, Point *pubKeys);
   Point NextKey(Point &key);
   bool  EC(Point &p);
   
@@ -58,10 +68,18 @@ public:
   Int *k0,Int *k1,Int *k2,Int *k3,
   uint8_t *h0,uint8_t *h1,uint8_t *h2,uint8_t *h3);
 
+  // n P2PKH hashes (n multiple of 4) of consecutive points, 20 bytes apart in h,
+  // SHA-256 and RIPEMD-160 run on GetHashLanes() points per call
+  void GetHash160(bool compressed,AffinePoint *k,int n,uint8_t *h);
+  // Both the 02 and 03 hashes of the x coordinates
+  void GetHash160_fromX(AffinePoint *k,int n,uint8_t *h02,uint8_t *h03);
+  int  GetHashLanes();
+
 
   Point Add(Point &p1, Point &p2);
   Point Add2(Point &p1, Point &p2);
   Point AddDirect(Point &p1, Point &p2);
+  void  AddDirect(Point &p1, Point *p2, int n, Point *r);
   Point Double(Point &p);
   Point DoubleDirect(Point &p);
   Point Negation(Point &p);
@@ -74,7 +92,13 @@ private:
 
   uint8_t GetByte(char *str,int idx);
   Int GetY(Int x, bool isEven);
-  Point GTable[256*32];       // Generator table
+  bool ComputeJacobian(Int *privKey, FieldElem *x, FieldElem *y, FieldElem *z);
+
+  AffinePoint *GTable;     // Generator table (64 bytes per entry), read only once built
+  int gBits;               // Comb window size
+  int gWindows;            // Number of windows
+  int gEntries;            // Points per window
+  int hashLanes;           // SHA-256 lanes of the CPU: 16 (AVX-512), 8 (AVX2) or 4 (SSE)
 
 };
 
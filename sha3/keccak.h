@@ -31,4 +31,13 @@
 
 void	keccakf1600(uint64_t A[25]);
 
+/*
+ * Ethereum address (last 20 bytes of the Keccak-256 of x | y) of n public
+ * keys, x and y point to the 64 bits limbs of the first key and the next
+ * ones are stride words apart. Address i is written at h + 20*i.
+ */
+int	keccak_lanes(void);
+void	keccak256_eth(const uint64_t *x, const uint64_t *y, int stride, int n,
+	    uint8_t *h);
+
 #endif	/* KECCAK_H */
@@ -0,0 +1,263 @@
+/*
+ * Keccak-256 of the 64 bytes x | y of several public keys at once, for the
+ * ethereum addresses: 4 states in the AVX2 registers, 8 with AVX-512. The
+ * message is a single block built from the 64 bits limbs of the coordinates,
+ * the pad and the rate bit are constants.
+ *
+ * The SIMD functions are built for their target whatever -march says and
+ * only called when the CPU has it.
+ */
+
+#include <stdint.h>
+#include <string.h>
+/* GCC 12 flags the _mm512_undefined_epi32() used inside the intrinsics */
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#include <immintrin.h>
+
+#include "keccak.h"
+
+#define	KECCAK_AVX2	__attribute__((target("avx2")))
+#define	KECCAK_AVX512	__attribute__((target("avx512f,avx512bw")))
+
+static const uint64_t RC[24] = {
+	0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+	0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+	0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+	0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+	0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+	0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+	0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+	0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+/* Byte swap of every 64 bits word, the limbs are the big endian message */
+static const uint8_t BSWAP64[32] __attribute__((aligned(32))) = {
+	7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+	7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+};
+
+#define	ROL4(v, n)	_mm256_or_si256(_mm256_slli_epi64((v), (n)), _mm256_srli_epi64((v), 64 - (n)))
+#define	ROL8(v, n)	_mm512_rol_epi64((v), (n))
+
+static KECCAK_AVX2 void
+keccakf1600x4(__m256i A[25])
+{
+	__m256i B[5], C[5], D, T, U;
+	unsigned i, x, y;
+
+	for (i = 0; i < 24; i++) {
+		for (x = 0; x < 5; x++)
+			C[x] = _mm256_xor_si256(_mm256_xor_si256(A[x], A[x + 5]),
+			    _mm256_xor_si256(_mm256_xor_si256(A[x + 10], A[x + 15]), A[x + 20]));
+		for (x = 0; x < 5; x++) {
+			D = _mm256_xor_si256(C[(x + 4) % 5], ROL4(C[(x + 1) % 5], 1));
+			for (y = 0; y < 25; y += 5)
+				A[y + x] = _mm256_xor_si256(A[y + x], D);
+		}
+
+		U = A[ 1];                       T = U;
+		U = A[10]; A[10] = ROL4(T,  1); T = U;
+		U = A[ 7]; A[ 7] = ROL4(T,  3); T = U;
+		U = A[11]; A[11] = ROL4(T,  6); T = U;
+		U = A[17]; A[17] = ROL4(T, 10); T = U;
+		U = A[18]; A[18] = ROL4(T, 15); T = U;
+		U = A[ 3]; A[ 3] = ROL4(T, 21); T = U;
+		U = A[ 5]; A[ 5] = ROL4(T, 28); T = U;
+		U = A[16]; A[16] = ROL4(T, 36); T = U;
+		U = A[ 8]; A[ 8] = ROL4(T, 45); T = U;
+		U = A[21]; A[21] = ROL4(T, 55); T = U;
+		U = A[24]; A[24] = ROL4(T,  2); T = U;
+		U = A[ 4]; A[ 4] = ROL4(T, 14); T = U;
+		U = A[15]; A[15] = ROL4(T, 27); T = U;
+		U = A[23]; A[23] = ROL4(T, 41); T = U;
+		U = A[19]; A[19] = ROL4(T, 56); T = U;
+		U = A[13]; A[13] = ROL4(T,  8); T = U;
+		U = A[12]; A[12] = ROL4(T, 25); T = U;
+		U = A[ 2]; A[ 2] = ROL4(T, 43); T = U;
+		U = A[20]; A[20] = ROL4(T, 62); T = U;
+		U = A[14]; A[14] = ROL4(T, 18); T = U;
+		U = A[22]; A[22] = ROL4(T, 39); T = U;
+		U = A[ 9]; A[ 9] = ROL4(T, 61); T = U;
+		U = A[ 6]; A[ 6] = ROL4(T, 20); T = U;
+		           A[ 1] = ROL4(T, 44);
+
+		for (y = 0; y < 25; y += 5) {
+			for (x = 0; x < 5; x++)
+				B[x] = A[y + x];
+			for (x = 0; x < 5; x++)
+				A[y + x] = _mm256_xor_si256(B[x],
+				    _mm256_andnot_si256(B[(x + 1) % 5], B[(x + 2) % 5]));
+		}
+		A[0] = _mm256_xor_si256(A[0], _mm256_set1_epi64x(RC[i]));
+	}
+}
+
+static KECCAK_AVX512 void
+keccakf1600x8(__m512i A[25])
+{
+	__m512i B[5], C[5], D, T, U;
+	unsigned i, x, y;
+
+	for (i = 0; i < 24; i++) {
+		/* 0x96 is a ^ b ^ c, 0xD2 is a ^ (~b & c) */
+		for (x = 0; x < 5; x++)
+			C[x] = _mm512_ternarylogic_epi64(A[x], A[x + 5],
+			    _mm512_ternarylogic_epi64(A[x + 10], A[x + 15], A[x + 20], 0x96), 0x96);
+		for (x = 0; x < 5; x++) {
+			D = _mm512_xor_si512(C[(x + 4) % 5], ROL8(C[(x + 1) % 5], 1));
+			for (y = 0; y < 25; y += 5)
+				A[y + x] = _mm512_xor_si512(A[y + x], D);
+		}
+
+		U = A[ 1];                       T = U;
+		U = A[10]; A[10] = ROL8(T,  1); T = U;
+		U = A[ 7]; A[ 7] = ROL8(T,  3); T = U;
+		U = A[11]; A[11] = ROL8(T,  6); T = U;
+		U = A[17]; A[17] = ROL8(T, 10); T = U;
+		U = A[18]; A[18] = ROL8(T, 15); T = U;
+		U = A[ 3]; A[ 3] = ROL8(T, 21); T = U;
+		U = A[ 5]; A[ 5] = ROL8(T, 28); T = U;
+		U = A[16]; A[16] = ROL8(T, 36); T = U;
+		U = A[ 8]; A[ 8] = ROL8(T, 45); T = U;
+		U = A[21]; A[21] = ROL8(T, 55); T = U;
+		U = A[24]; A[24] = ROL8(T,  2); T = U;
+		U = A[ 4]; A[ 4] = ROL8(T, 14); T = U;
+		U = A[15]; A[15] = ROL8(T, 27); T = U;
+		U = A[23]; A[23] = ROL8(T, 41); T = U;
+		U = A[19]; A[19] = ROL8(T, 56); T = U;
+		U = A[13]; A[13] = ROL8(T,  8); T = U;
+		U = A[12]; A[12] = ROL8(T, 25); T = U;
+		U = A[ 2]; A[ 2] = ROL8(T, 43); T = U;
+		U = A[20]; A[20] = ROL8(T, 62); T = U;
+		U = A[14]; A[14] = ROL8(T, 18); T = U;
+		U = A[22]; A[22] = ROL8(T, 39); T = U;
+		U = A[ 9]; A[ 9] = ROL8(T, 61); T = U;
+		U = A[ 6]; A[ 6] = ROL8(T, 20); T = U;
+		           A[ 1] = ROL8(T, 44);
+
+		for (y = 0; y < 25; y += 5) {
+			for (x = 0; x < 5; x++)
+				B[x] = A[y + x];
+			for (x = 0; x < 5; x++)
+				A[y + x] = _mm512_ternarylogic_epi64(B[x],
+				    B[(x + 1) % 5], B[(x + 2) % 5], 0xD2);
+		}
+		A[0] = _mm512_xor_si512(A[0], _mm512_set1_epi64(RC[i]));
+	}
+}
+
+/*
+ * The last 20 bytes of the digest: the high half of lane 1, lanes 2 and 3.
+ */
+static void
+keccak_address(const uint64_t *d1, const uint64_t *d2, const uint64_t *d3,
+    uint8_t *h)
+{
+	uint32_t hi = (uint32_t)(*d1 >> 32);
+
+	memcpy(h, &hi, 4);
+	memcpy(h + 4, d2, 8);
+	memcpy(h + 12, d3, 8);
+}
+
+static KECCAK_AVX2 void
+keccak256_eth4(const uint64_t *x, const uint64_t *y, int stride, uint8_t *h)
+{
+	__m256i A[25];
+	__m256i idx = _mm256_setr_epi64x(0, stride, 2 * stride, 3 * stride);
+	__m256i bswap = _mm256_load_si256((const __m256i *)BSWAP64);
+	uint64_t d[4][4] __attribute__((aligned(32)));
+	unsigned i;
+
+	for (i = 0; i < 4; i++) {
+		A[i] = _mm256_shuffle_epi8(_mm256_i64gather_epi64((const long long *)(x + 3 - i), idx, 8), bswap);
+		A[4 + i] = _mm256_shuffle_epi8(_mm256_i64gather_epi64((const long long *)(y + 3 - i), idx, 8), bswap);
+	}
+	A[8] = _mm256_set1_epi64x(0x01);
+	for (i = 9; i < 25; i++)
+		A[i] = _mm256_setzero_si256();
+	A[16] = _mm256_set1_epi64x(0x8000000000000000ULL);
+
+	keccakf1600x4(A);
+
+	for (i = 1; i < 4; i++)
+		_mm256_store_si256((__m256i *)d[i], A[i]);
+	for (i = 0; i < 4; i++)
+		keccak_address(&d[1][i], &d[2][i], &d[3][i], h + 20 * i);
+}
+
+static KECCAK_AVX512 void
+keccak256_eth8(const uint64_t *x, const uint64_t *y, int stride, uint8_t *h)
+{
+	__m512i A[25];
+	__m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+	__m512i bswap = _mm512_broadcast_i64x4(_mm256_load_si256((const __m256i *)BSWAP64));
+	uint64_t d[4][8] __attribute__((aligned(64)));
+	unsigned i;
+
+	for (i = 0; i < 4; i++) {
+		A[i] = _mm512_shuffle_epi8(_mm512_i32gather_epi64(idx, (const void *)(x + 3 - i), 8), bswap);
+		A[4 + i] = _mm512_shuffle_epi8(_mm512_i32gather_epi64(idx, (const void *)(y + 3 - i), 8), bswap);
+	}
+	A[8] = _mm512_set1_epi64(0x01);
+	for (i = 9; i < 25; i++)
+		A[i] = _mm512_setzero_si512();
+	A[16] = _mm512_set1_epi64(0x8000000000000000ULL);
+
+	keccakf1600x8(A);
+
+	for (i = 1; i < 4; i++)
+		_mm512_store_si512((void *)d[i], A[i]);
+	for (i = 0; i < 8; i++)
+		keccak_address(&d[1][i], &d[2][i], &d[3][i], h + 20 * i);
+}
+
+static void
+keccak256_eth1(const uint64_t *x, const uint64_t *y, uint8_t *h)
+{
+	uint64_t A[25];
+	unsigned i;
+
+	for (i = 0; i < 4; i++) {
+		A[i] = __builtin_bswap64(x[3 - i]);
+		A[4 + i] = __builtin_bswap64(y[3 - i]);
+	}
+	A[8] = 0x01;
+	for (i = 9; i < 25; i++)
+		A[i] = 0;
+	A[16] = 0x8000000000000000ULL;
+
+	keccakf1600(A);
+
+	keccak_address(&A[1], &A[2], &A[3], h);
+}
+
+int
+keccak_lanes(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+		return 8;
+	if (__builtin_cpu_supports("avx2"))
+		return 4;
+#endif
+	return 1;
+}
+
+void
+keccak256_eth(const uint64_t *x, const uint64_t *y, int stride, int n,
+    uint8_t *h)
+{
+	static int lanes = keccak_lanes();
+	int i = 0;
+
+	if (lanes == 8)
+		for (; i + 8 <= n; i += 8)
+			keccak256_eth8(x + i * stride, y + i * stride, stride, h + 20 * i);
+	if (lanes >= 4)
+		for (; i + 4 <= n; i += 4)
+			keccak256_eth4(x + i * stride, y + i * stride, stride, h + 20 * i);
+	for (; i < n; i++)
+		keccak256_eth1(x + i * stride, y + i * stride, h + 20 * i);
+}